@@ -12,9 +12,27 @@
 layout (location = 0) in vec3 vertex;
 layout (location = 1) in vec3 normal;
 
-uniform mat4 vertex_model_to_world;
-uniform mat4 normal_model_to_world;
-uniform mat4 vertex_world_to_clip;
+// Nodes sharing this program and their geometry get drawn together, as
+// instances of a single draw (see `bonobo::render_queue`); the
+// model-to-world matrix of each one is then read from this per-instance
+// attribute, which spans locations 7 to 10, one per column, and its normal
+// matrix, computed once on the CPU, from locations 11 to 13.
+layout (location = 7) in mat4 instance_model_to_world;
+layout (location = 11) in mat3 instance_normal_model_to_world;
+
+layout (std140) uniform DrawUniforms
+{
+	mat4 vertex_model_to_world;
+	mat4 normal_model_to_world;
+	mat4 vertex_world_to_clip;
+	vec3 diffuse_colour;
+	float shininess_value;
+	vec3 specular_colour;
+	float index_of_refraction_value;
+	vec3 ambient_colour;
+	float opacity_value;
+	vec3 emissive_colour;
+};
 
 // This is the custom output of this shader. If you want to retrieve this data
 // from another shader further down the pipeline, you need to declare the exact
@@ -29,10 +47,10 @@ out VS_OUT {
 
 void main()
 {
-	vs_out.vertex = vec3(vertex_model_to_world * vec4(vertex, 1.0));
-	vs_out.normal = vec3(normal_model_to_world * vec4(normal, 0.0));
+	vs_out.vertex = vec3(instance_model_to_world * vec4(vertex, 1.0));
+	vs_out.normal = instance_normal_model_to_world * normal;
 
-	gl_Position = vertex_world_to_clip * vertex_model_to_world * vec4(vertex, 1.0);
+	gl_Position = vertex_world_to_clip * vec4(vs_out.vertex, 1.0);
 }
 
 
@@ -13,11 +13,12 @@ layout (std140) uniform CameraViewProjTransforms
 
 uniform mat4 vertex_model_to_world;
 
+// Sponza is loaded using the compact vertex format, see
+// `bonobo::vertex_format::compact`.
 layout (location = 0) in vec3 vertex;
-layout (location = 1) in vec3 normal;
-layout (location = 2) in vec3 texcoord;
-layout (location = 3) in vec3 tangent;
-layout (location = 4) in vec3 binormal;
+layout (location = 2) in vec2 texcoord;
+layout (location = 5) in vec2 packed_normal;
+layout (location = 6) in vec4 packed_tangent; // xy: tangent, z: binormal sign
 
 out VS_OUT {
 	vec3 normal;
@@ -26,12 +27,19 @@ out VS_OUT {
 	vec3 binormal;
 } vs_out;
 
+vec3 decode_octahedral(vec2 e)
+{
+	vec3 v = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-v.z, 0.0);
+	v.xy += vec2(v.x >= 0.0 ? -t : t, v.y >= 0.0 ? -t : t);
+	return normalize(v);
+}
 
 void main() {
-	vs_out.normal   = normalize(normal);
-	vs_out.texcoord = texcoord.xy;
-	vs_out.tangent  = normalize(tangent);
-	vs_out.binormal = normalize(binormal);
+	vs_out.normal   = decode_octahedral(packed_normal);
+	vs_out.texcoord = texcoord;
+	vs_out.tangent  = decode_octahedral(packed_tangent.xy);
+	vs_out.binormal = cross(vs_out.normal, vs_out.tangent) * packed_tangent.z;
 
 	gl_Position = camera.view_projection * vertex_model_to_world * vec4(vertex, 1.0);
 }
@@ -1,7 +1,18 @@
 #version 410
 
-uniform mat4 vertex_model_to_world;
-uniform mat4 vertex_world_to_clip;
+layout (std140) uniform DrawUniforms
+{
+	mat4 vertex_model_to_world;
+	mat4 normal_model_to_world;
+	mat4 vertex_world_to_clip;
+	vec3 diffuse_colour;
+	float shininess_value;
+	vec3 specular_colour;
+	float index_of_refraction_value;
+	vec3 ambient_colour;
+	float opacity_value;
+	vec3 emissive_colour;
+};
 
 layout (location = 0) in vec3 vertex;
 
@@ -21,7 +21,8 @@ CelestialBody::CelestialBody(bonobo::mesh_data const &shape,
 glm::mat4 CelestialBody::render(std::chrono::microseconds elapsed_time,
                                 glm::mat4 const &view_projection,
                                 glm::mat4 const &parent_transform,
-                                bool show_basis) {
+                                bool show_basis,
+                                bonobo::render_queue *queue) {
   // Convert the duration from microseconds to seconds.
   auto const elapsed_time_s =
       std::chrono::duration<float>(elapsed_time).count();
@@ -63,15 +64,21 @@ glm::mat4 CelestialBody::render(std::chrono::microseconds elapsed_time,
   // manage all the local transforms ourselves, so the internal transform
   // of the node is just the identity matrix and we can forward the whole
   // world matrix.
-  _body.node.render(view_projection, world * model);
+  if (queue != nullptr)
+    _body.node.submit(*queue, view_projection, world * model);
+  else
+    _body.node.render(view_projection, world * model);
 
   if (_ring.is_set) {
-    _ring.node.render(
-        view_projection,
+    auto const ring_transform =
         world *
-            glm::rotate(glm::mat4{1.0f}, glm::half_pi<float>(),
-                        glm::vec3(1.0f, 0.0f, 0.0f)) *
-            glm::scale(glm::mat4{1.0f}, glm::vec3{_ring.scale, 0.0f}));
+        glm::rotate(glm::mat4{1.0f}, glm::half_pi<float>(),
+                    glm::vec3(1.0f, 0.0f, 0.0f)) *
+        glm::scale(glm::mat4{1.0f}, glm::vec3{_ring.scale, 0.0f});
+    if (queue != nullptr)
+      _ring.node.submit(*queue, view_projection, ring_transform);
+    else
+      _ring.node.render(view_projection, ring_transform);
   }
 
   return world * axisTilt;
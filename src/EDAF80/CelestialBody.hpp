@@ -2,6 +2,7 @@
 
 #include "core/helpers.hpp"
 #include "core/node.hpp"
+#include "core/render_queue.hpp"
 
 #include <glm/mat4x4.hpp>
 #include <glm/vec3.hpp>
@@ -44,12 +45,15 @@ public:
 	//!             local space to world space
 	//! @param [in] show_basis Show a 3D basis transformed by the world matrix
 	//!             of this celestial body
+	//! @param [in] queue If not null, the body and its ring are submitted
+	//!             to this queue instead of being rendered right away
 	//! @return Matrix transforming from this celestial body’s local space
 	//!         to world space
 	glm::mat4 render(std::chrono::microseconds elapsed_time,
 	                 glm::mat4 const& view_projection,
 	                 glm::mat4 const& parent_transform = glm::mat4(1.0f),
-	                 bool show_basis = false);
+	                 bool show_basis = false,
+	                 bonobo::render_queue* queue = nullptr);
 
 	//! \brief Mark another celestial body as being “attached” to the current one.
 	void add_child(CelestialBody* child);
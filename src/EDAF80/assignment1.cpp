@@ -3,8 +3,10 @@
 #include "core/Bonobo.h"
 #include "core/FPSCamera.h"
 #include "core/ShaderProgramManager.hpp"
+#include "core/gl_state.hpp"
 #include "core/helpers.hpp"
 #include "core/node.hpp"
+#include "core/render_queue.hpp"
 #include "parametric_shapes.hpp"
 
 #include <glm/fwd.hpp>
@@ -60,18 +62,22 @@ int main() {
   bonobo::init();
 
   //
-  // Load the sphere geometry
+  // Start loading the sphere geometry and all textures; they get read and
+  // decoded concurrently in the background while the shader programs are
+  // being compiled.
   //
-  std::vector<bonobo::mesh_data> const objects =
-      bonobo::loadObjects(config::resources_path("scenes/sphere.obj"));
-  if (objects.empty()) {
-    LogError("Failed to load the sphere geometry: exiting.");
-
-    bonobo::deinit();
-
-    return EXIT_FAILURE;
-  }
-  bonobo::mesh_data const &sphere = objects.front();
+  auto const planet_texture = [](std::string const &name) {
+    return bonobo::texture_request{config::resources_path("planets/" + name)};
+  };
+  auto assets = bonobo::loadAssetsAsync(
+      {planet_texture("2k_sun.jpg"), planet_texture("2k_mercury.jpg"),
+       planet_texture("2k_venus_atmosphere.jpg"),
+       planet_texture("2k_earth_daymap.jpg"), planet_texture("2k_moon.jpg"),
+       planet_texture("2k_mars.jpg"), planet_texture("2k_jupiter.jpg"),
+       planet_texture("2k_saturn.jpg"),
+       planet_texture("2k_saturn_ring_alpha.png"),
+       planet_texture("2k_uranus.jpg"), planet_texture("2k_neptune.jpg")},
+      {bonobo::objects_request{config::resources_path("scenes/sphere.obj")}});
   auto const saturn_ring_shape =
       parametric_shapes::createCircleRing(0.675f, 0.45f, 80u, 8u);
 
@@ -89,6 +95,9 @@ int main() {
     LogError(
         "Failed to generate the “Celestial Body” shader program: exiting.");
 
+    // The background decoding stages into the upload ring that
+    // `bonobo::deinit()` frees, so it has to be over by then.
+    assets.reset();
     bonobo::deinit();
 
     return EXIT_FAILURE;
@@ -103,6 +112,7 @@ int main() {
     LogError(
         "Failed to generate the “Celestial Ring” shader program: exiting.");
 
+    assets.reset();
     bonobo::deinit();
 
     return EXIT_FAILURE;
@@ -171,30 +181,32 @@ int main() {
                                          glm::two_pi<float>() / 3200.0f};
 
   //
-  // Load all textures.
+  // Finish loading the sphere geometry and all textures.
   //
-  GLuint const sun_texture =
-      bonobo::loadTexture2D(config::resources_path("planets/2k_sun.jpg"));
-  GLuint const mercury_texture =
-      bonobo::loadTexture2D(config::resources_path("planets/2k_mercury.jpg"));
-  GLuint const venus_texture = bonobo::loadTexture2D(
-      config::resources_path("planets/2k_venus_atmosphere.jpg"));
-  GLuint const earth_texture = bonobo::loadTexture2D(
-      config::resources_path("planets/2k_earth_daymap.jpg"));
-  GLuint const moon_texture =
-      bonobo::loadTexture2D(config::resources_path("planets/2k_moon.jpg"));
-  GLuint const mars_texture =
-      bonobo::loadTexture2D(config::resources_path("planets/2k_mars.jpg"));
-  GLuint const jupiter_texture =
-      bonobo::loadTexture2D(config::resources_path("planets/2k_jupiter.jpg"));
-  GLuint const saturn_texture =
-      bonobo::loadTexture2D(config::resources_path("planets/2k_saturn.jpg"));
-  GLuint const saturn_ring_texture = bonobo::loadTexture2D(
-      config::resources_path("planets/2k_saturn_ring_alpha.png"));
-  GLuint const uranus_texture =
-      bonobo::loadTexture2D(config::resources_path("planets/2k_uranus.jpg"));
-  GLuint const neptune_texture =
-      bonobo::loadTexture2D(config::resources_path("planets/2k_neptune.jpg"));
+  assets->wait();
+  std::vector<bonobo::mesh_data> const objects =
+      assets->get_scene(0u).get_objects();
+  if (objects.empty()) {
+    LogError("Failed to load the sphere geometry: exiting.");
+
+    assets.reset();
+    bonobo::deinit();
+
+    return EXIT_FAILURE;
+  }
+  bonobo::mesh_data const &sphere = objects.front();
+  // In the order they were requested.
+  GLuint const sun_texture = assets->get_texture(0u);
+  GLuint const mercury_texture = assets->get_texture(1u);
+  GLuint const venus_texture = assets->get_texture(2u);
+  GLuint const earth_texture = assets->get_texture(3u);
+  GLuint const moon_texture = assets->get_texture(4u);
+  GLuint const mars_texture = assets->get_texture(5u);
+  GLuint const jupiter_texture = assets->get_texture(6u);
+  GLuint const saturn_texture = assets->get_texture(7u);
+  GLuint const saturn_ring_texture = assets->get_texture(8u);
+  GLuint const uranus_texture = assets->get_texture(9u);
+  GLuint const neptune_texture = assets->get_texture(10u);
 
   //
   // Set up the celestial bodies.
@@ -266,7 +278,7 @@ int main() {
   //
   glClearDepthf(1.0f);
   glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-  glEnable(GL_DEPTH_TEST);
+  bonobo::state::enable(GL_DEPTH_TEST);
 
   auto last_time = std::chrono::high_resolution_clock::now();
 
@@ -276,6 +288,8 @@ int main() {
   bool show_basis = false;
   float time_scale = 1.0f;
 
+  bonobo::render_queue render_queue;
+
   while (!glfwWindowShouldClose(window)) {
     //
     // Compute timings information
@@ -317,7 +331,7 @@ int main() {
     // being toggled.
     int framebuffer_width, framebuffer_height;
     glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
-    glViewport(0, 0, framebuffer_width, framebuffer_height);
+    bonobo::state::viewport(0, 0, framebuffer_width, framebuffer_height);
 
     //
     // Start a new frame for Dear ImGui
@@ -348,15 +362,19 @@ int main() {
       auto &&top = bodies.top();
       bodies.pop();
 
-      auto transform = top.body->render(animation_delta_time_us,
-                                        camera.GetWorldToClipMatrix(),
-                                        top.parent_transform, show_basis);
+      auto transform = top.body->render(
+          animation_delta_time_us, camera.GetWorldToClipMatrix(),
+          top.parent_transform, show_basis, &render_queue);
 
       for (auto *child : top.body->get_children()) {
         bodies.push({child, transform});
       }
     }
 
+    // Issue the draws of all bodies, grouped by program, texture and
+    // geometry rather than in traversal order.
+    render_queue.flush();
+
     //
     // Add controls to the scene.
     //
@@ -383,18 +401,19 @@ int main() {
     glfwSwapBuffers(window);
   }
 
-  glDeleteTextures(1, &neptune_texture);
-  glDeleteTextures(1, &uranus_texture);
-  glDeleteTextures(1, &saturn_ring_texture);
-  glDeleteTextures(1, &saturn_texture);
-  glDeleteTextures(1, &jupiter_texture);
-  glDeleteTextures(1, &mars_texture);
-  glDeleteTextures(1, &moon_texture);
-  glDeleteTextures(1, &earth_texture);
-  glDeleteTextures(1, &venus_texture);
-  glDeleteTextures(1, &mars_texture);
-  glDeleteTextures(1, &sun_texture);
-
+  bonobo::releaseTexture(neptune_texture);
+  bonobo::releaseTexture(uranus_texture);
+  bonobo::releaseTexture(saturn_ring_texture);
+  bonobo::releaseTexture(saturn_texture);
+  bonobo::releaseTexture(jupiter_texture);
+  bonobo::releaseTexture(mars_texture);
+  bonobo::releaseTexture(moon_texture);
+  bonobo::releaseTexture(earth_texture);
+  bonobo::releaseTexture(venus_texture);
+  bonobo::releaseTexture(mercury_texture);
+  bonobo::releaseTexture(sun_texture);
+
+  assets.reset();
   bonobo::deinit();
 
   return EXIT_SUCCESS;
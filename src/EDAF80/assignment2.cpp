@@ -6,7 +6,9 @@
 #include "core/Bonobo.h"
 #include "core/FPSCamera.h"
 #include "core/ShaderProgramManager.hpp"
+#include "core/gl_state.hpp"
 #include "core/node.hpp"
+#include "core/render_queue.hpp"
 #include <imgui.h>
 
 #include <glm/glm.hpp>
@@ -181,7 +183,7 @@ void edaf80::Assignment2::run() {
 
   glClearDepthf(1.0f);
   glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-  glEnable(GL_DEPTH_TEST);
+  bonobo::state::enable(GL_DEPTH_TEST);
 
   auto const control_point_sphere =
       parametric_shapes::createSphere(0.1f, 10u, 10u);
@@ -197,9 +199,14 @@ void edaf80::Assignment2::run() {
     auto &control_point = control_points[i];
     control_point.set_geometry(control_point_sphere);
     control_point.set_program(&diffuse_shader, set_uniforms);
+    // All control points set the same light uniforms, so
+    // they can be drawn as instances of a single draw.
+    control_point.set_shared_uniforms(true);
     control_point.get_transform().SetTranslate(control_point_locations[i]);
   }
 
+  bonobo::render_queue render_queue;
+
   auto lastTime = std::chrono::high_resolution_clock::now();
 
   std::int32_t program_index = 1;
@@ -262,7 +269,7 @@ void edaf80::Assignment2::run() {
     // being toggled.
     int framebuffer_width, framebuffer_height;
     glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
-    glViewport(0, 0, framebuffer_width, framebuffer_height);
+    bonobo::state::viewport(0, 0, framebuffer_width, framebuffer_height);
 
     mWindowManager.NewImGuiFrame();
 
@@ -302,9 +309,12 @@ void edaf80::Assignment2::run() {
 
     demo_sphere.render(mCamera.GetWorldToClipMatrix());
     if (show_control_points) {
+      // The control points share their geometry and program, so the
+      // queue draws them all at once.
       for (auto const &control_point : control_points) {
-        control_point.render(mCamera.GetWorldToClipMatrix());
+        control_point.submit(render_queue, mCamera.GetWorldToClipMatrix());
       }
+      render_queue.flush();
     }
 
     bool const opened =
@@ -337,7 +347,7 @@ void edaf80::Assignment2::run() {
     }
     ImGui::End();
 
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    bonobo::state::polygonMode(GL_FRONT_AND_BACK, GL_FILL);
     if (show_basis)
       bonobo::renderBasis(basis_thickness_scale, basis_length_scale,
                           mCamera.GetWorldToClipMatrix());
@@ -7,6 +7,7 @@
 #include "core/Bonobo.h"
 #include "core/FPSCamera.h"
 #include "core/ShaderProgramManager.hpp"
+#include "core/gl_state.hpp"
 #include "core/node.hpp"
 
 #include <glm/glm.hpp>
@@ -187,7 +188,7 @@ void edaf80::Assignment3::run() {
 
   glClearDepthf(1.0f);
   glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-  glEnable(GL_DEPTH_TEST);
+  bonobo::state::enable(GL_DEPTH_TEST);
 
   auto lastTime = std::chrono::high_resolution_clock::now();
 
@@ -248,7 +249,7 @@ void edaf80::Assignment3::run() {
     // being toggled.
     int framebuffer_width, framebuffer_height;
     glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
-    glViewport(0, 0, framebuffer_width, framebuffer_height);
+    bonobo::state::viewport(0, 0, framebuffer_width, framebuffer_height);
 
     mWindowManager.NewImGuiFrame();
 
@@ -258,7 +259,7 @@ void edaf80::Assignment3::run() {
     skybox.render(mCamera.GetWorldToClipMatrix());
     demo_sphere.render(mCamera.GetWorldToClipMatrix());
 
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    bonobo::state::polygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
     bool opened = ImGui::Begin("Scene Control", nullptr, ImGuiWindowFlags_None);
     if (opened) {
@@ -5,6 +5,7 @@
 #include "core/Bonobo.h"
 #include "core/FPSCamera.h"
 #include "core/ShaderProgramManager.hpp"
+#include "core/gl_state.hpp"
 #include "core/helpers.hpp"
 #include "core/node.hpp"
 
@@ -129,7 +130,7 @@ void edaf80::Assignment4::run() {
 
   glClearDepthf(1.0f);
   glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-  glEnable(GL_DEPTH_TEST);
+  bonobo::state::enable(GL_DEPTH_TEST);
 
   auto lastTime = std::chrono::high_resolution_clock::now();
 
@@ -193,7 +194,7 @@ void edaf80::Assignment4::run() {
     // being toggled.
     int framebuffer_width, framebuffer_height;
     glfwGetFramebufferSize(window, &framebuffer_width, &framebuffer_height);
-    glViewport(0, 0, framebuffer_width, framebuffer_height);
+    bonobo::state::viewport(0, 0, framebuffer_width, framebuffer_height);
 
     //
     // Todo: If you need to handle inputs, you can do it here
@@ -209,7 +210,7 @@ void edaf80::Assignment4::run() {
       skyboxNode.render(mCamera.GetWorldToClipMatrix());
     }
 
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    bonobo::state::polygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
     //
     // Todo: If you want a custom ImGUI window, you can set it up
@@ -1,6 +1,8 @@
 #include "parametric_shapes.hpp"
 #include "core/Log.h"
+#include "core/gl_state.hpp"
 #include "core/helpers.hpp"
+#include "core/mesh_optimisation.hpp"
 
 #include <cstdio>
 #include <glm/ext/quaternion_geometric.hpp>
@@ -9,10 +11,41 @@
 #include <array>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
 #include <glm/gtc/constants.hpp>
 #include <iostream>
 #include <vector>
 
+namespace {
+// Create the index buffer of a shape, holding its triangles followed by
+// the ones of its levels of detail; the VAO of the shape has to be bound.
+void uploadIndices(std::vector<glm::vec3> const &vertices,
+                   std::vector<glm::uvec3> const &index_sets,
+                   bonobo::mesh_data &data) {
+  auto indices = std::vector<std::uint32_t>{};
+  indices.reserve(index_sets.size() * 3u);
+  for (auto const &index_set : index_sets) {
+    indices.push_back(index_set.x);
+    indices.push_back(index_set.y);
+    indices.push_back(index_set.z);
+  }
+
+  data.box = bonobo::computeBoundingBox(vertices.data(), vertices.size());
+  data.sphere = bonobo::computeBoundingSphere(vertices.data(),
+                                              vertices.size(), data.box);
+  data.lods = bonobo::generateLods(
+      vertices.data(), static_cast<std::uint32_t>(vertices.size()), indices);
+  data.indices_nb = static_cast<GLsizei>(index_sets.size() * 3u);
+
+  glGenBuffers(1, &data.ibo);
+  assert(data.ibo != 0u);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, data.ibo);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+               static_cast<GLsizeiptr>(indices.size() * sizeof(indices[0])),
+               indices.data(), GL_STATIC_DRAW);
+}
+} // namespace
+
 bonobo::mesh_data
 parametric_shapes::createQuad(float const width, float const height,
                               unsigned int const horizontal_split_count,
@@ -88,7 +121,7 @@ parametric_shapes::createQuad(float const width, float const height,
 
   // To be able to store information, the Vertex Array has to be bound
   // first.
-  glBindVertexArray(data.vao);
+  bonobo::state::bindVertexArray(data.vao);
 
   // To store the data, we need to allocate buffers on the GPU. Let's
   // allocate a first one for the vertices.
@@ -166,6 +199,10 @@ parametric_shapes::createQuad(float const width, float const height,
   // Now, let's allocate a second one for the indices.
   //
   // Have the buffer's name stored into `data.ibo`.
+  //
+  // Quads get no levels of detail: a flat grid simplifies at no error,
+  // which would strip the vertices shaders displace, as for waves or
+  // terrain.
   glGenBuffers(1, &data.ibo);
 
   // We still want a 1D-array, but this time it should be a 1D-array of
@@ -181,7 +218,7 @@ parametric_shapes::createQuad(float const width, float const height,
   data.indices_nb = indexSets.size() * 3;
 
   // All the data has been recorded, we can unbind them.
-  glBindVertexArray(0u);
+  bonobo::state::bindVertexArray(0u);
   glBindBuffer(GL_ARRAY_BUFFER, 0u);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0u);
 
@@ -316,7 +353,7 @@ parametric_shapes::createSphere(float const radius,
   auto data = bonobo::mesh_data{};
 
   glGenVertexArrays(1, &data.vao);
-  glBindVertexArray(data.vao);
+  bonobo::state::bindVertexArray(data.vao);
 
   glGenBuffers(1, &data.bo);
   glBindBuffer(GL_ARRAY_BUFFER, data.bo);
@@ -379,14 +416,9 @@ parametric_shapes::createSphere(float const radius,
       GL_FLOAT, GL_FALSE, 0,
       reinterpret_cast<GLvoid const *>(textureCoordOffset));
 
-  glGenBuffers(1, &data.ibo);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, data.ibo);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-               vertexIndices.size() * sizeof(vertexIndices[0]),
-               vertexIndices.data(), GL_STATIC_DRAW);
-  data.indices_nb = vertexIndices.size() * 3;
+  uploadIndices(vertices, vertexIndices, data);
 
-  glBindVertexArray(0u);
+  bonobo::state::bindVertexArray(0u);
   glBindBuffer(GL_ARRAY_BUFFER, 0u);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0u);
 
@@ -470,7 +502,7 @@ parametric_shapes::createTorus(float const major_radius,
   auto data = bonobo::mesh_data{};
 
   glGenVertexArrays(1, &data.vao);
-  glBindVertexArray(data.vao);
+  bonobo::state::bindVertexArray(data.vao);
 
   glGenBuffers(1, &data.bo);
   glBindBuffer(GL_ARRAY_BUFFER, data.bo);
@@ -533,14 +565,9 @@ parametric_shapes::createTorus(float const major_radius,
       GL_FLOAT, GL_FALSE, 0,
       reinterpret_cast<GLvoid const *>(textureCoordOffset));
 
-  glGenBuffers(1, &data.ibo);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, data.ibo);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-               vertexIndices.size() * sizeof(vertexIndices[0]),
-               vertexIndices.data(), GL_STATIC_DRAW);
-  data.indices_nb = vertexIndices.size() * 3;
+  uploadIndices(vertices, vertexIndices, data);
 
-  glBindVertexArray(0u);
+  bonobo::state::bindVertexArray(0u);
   glBindBuffer(GL_ARRAY_BUFFER, 0u);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0u);
 
@@ -636,7 +663,7 @@ parametric_shapes::createCircleRing(float const radius,
   bonobo::mesh_data data;
   glGenVertexArrays(1, &data.vao);
   assert(data.vao != 0u);
-  glBindVertexArray(data.vao);
+  bonobo::state::bindVertexArray(data.vao);
 
   auto const vertices_offset = 0u;
   auto const vertices_size =
@@ -705,16 +732,9 @@ parametric_shapes::createCircleRing(float const radius,
 
   glBindBuffer(GL_ARRAY_BUFFER, 0u);
 
-  data.indices_nb = static_cast<GLsizei>(index_sets.size() * 3u);
-  glGenBuffers(1, &data.ibo);
-  assert(data.ibo != 0u);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, data.ibo);
-  glBufferData(GL_ELEMENT_ARRAY_BUFFER,
-               static_cast<GLsizeiptr>(index_sets.size() * sizeof(glm::uvec3)),
-               reinterpret_cast<GLvoid const *>(index_sets.data()),
-               GL_STATIC_DRAW);
+  uploadIndices(vertices, index_sets, data);
 
-  glBindVertexArray(0u);
+  bonobo::state::bindVertexArray(0u);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0u);
 
   return data;
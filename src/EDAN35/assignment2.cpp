@@ -7,9 +7,11 @@
 #include "config.hpp"
 #include "core/Bonobo.h"
 #include "core/FPSCamera.h"
+#include "core/gl_state.hpp"
 #include "core/helpers.hpp"
 #include "core/node.hpp"
 #include "core/opengl.hpp"
+#include "core/scene_snapshot.hpp"
 #include "core/ShaderProgramManager.hpp"
 
 #include <imgui.h>
@@ -21,7 +23,9 @@
 #include <array>
 #include <clocale>
 #include <cstdlib>
+#include <limits>
 #include <stdexcept>
+#include <utility>
 
 namespace constant
 {
@@ -186,38 +190,75 @@ void
 edan35::Assignment2::run()
 {
 	// Load the geometry of Sponza
-	auto const sponza_geometry = bonobo::loadObjects(config::resources_path("sponza/sponza.obj"));
-	if (sponza_geometry.empty()) {
-		LogError("Failed to load the Sponza model");
-		return;
-	}
-	std::vector<GeometryTextureData> sponza_geometry_texture_data;
-	sponza_geometry_texture_data.reserve(sponza_geometry.size());
-	for (auto const& geometry : sponza_geometry) {
-		auto const diffuse_texture = geometry.bindings.find("diffuse_texture");
-		auto const specular_texture = geometry.bindings.find("specular_texture");
-		auto const normals_texture = geometry.bindings.find("normals_texture");
-		auto const opacity_texture = geometry.bindings.find("opacity_texture");
+	// The G-buffer and shadow map passes are bound by vertex fetching, so
+	// use the compact vertex format; the shaders are written accordingly.
+	// All meshes are also packed in the same buffers, so that the VAO only
+	// needs to be bound once per pass.
+	bonobo::mesh_load_options sponza_load_options;
+	sponza_load_options.vertices_format = bonobo::vertex_format::compact;
+	sponza_load_options.share_buffers = true;
+	// The G-buffer pass only rebinds textures when the material changes.
+	sponza_load_options.sort_by_material = true;
+	// Sponza's textures take most of its memory, and barely suffer from
+	// block compression.
+	sponza_load_options.textures_compression = bonobo::texture_compression::automatic;
+	// The model is streamed in, so that frames get rendered while it is
+	// being read and its textures decoded; see the start of the render
+	// loop.
+	auto const sponza_loading = bonobo::loadObjectsAsync(config::resources_path("sponza/sponza.obj"), sponza_load_options);
+	bonobo::upload_budget sponza_upload_budget;
+	// Once streamed in, Sponza can be saved as a single snapshot archive,
+	// which can then be loaded back in one go and gets drawn instead.
+	auto const sponza_snapshot_path = config::resources_path("sponza/sponza.snapshot");
+	bonobo::scene_snapshot sponza_snapshot;
+	bool use_sponza_snapshot = false;
+	// Textures of each material, followed by an entry without any texture
+	// for the meshes which have no material. Meshes come sorted by
+	// material, so textures only get rebound when the material changes.
+	std::vector<GeometryTextureData> sponza_material_texture_data;
+	auto const get_material_texture_data_index = [&sponza_material_texture_data](bonobo::mesh_data const& geometry) {
+		auto const materials_nb = sponza_material_texture_data.size() - 1u;
+		return geometry.material_index < materials_nb ? static_cast<std::size_t>(geometry.material_index) : materials_nb;
+	};
+	auto const get_material_texture_data = [](bonobo::texture_bindings const& bindings) {
+		auto const diffuse_texture = bindings.find("diffuse_texture");
+		auto const specular_texture = bindings.find("specular_texture");
+		auto const normals_texture = bindings.find("normals_texture");
+		auto const opacity_texture = bindings.find("opacity_texture");
 
 		GeometryTextureData data;
-		if (diffuse_texture != geometry.bindings.end())
+		if (diffuse_texture != bindings.end())
 		{
 			data.diffuse_texture_id = diffuse_texture->second;
 		}
-		if (specular_texture != geometry.bindings.end())
+		if (specular_texture != bindings.end())
 		{
 			data.specular_texture_id = specular_texture->second;
 		}
-		if (normals_texture != geometry.bindings.end())
+		if (normals_texture != bindings.end())
 		{
 			data.normals_texture_id = normals_texture->second;
 		}
-		if (opacity_texture != geometry.bindings.end())
+		if (opacity_texture != bindings.end())
 		{
 			data.opacity_texture_id = opacity_texture->second;
 		}
-		sponza_geometry_texture_data.emplace_back(std::move(data));
-	}
+		return data;
+	};
+	// Levels of detail picked during the previous frame, for the camera
+	// and for each light, so that switching between them is hysteretic.
+	std::vector<std::size_t> sponza_camera_lods;
+	std::array<std::vector<std::size_t>, constant::lights_nb> sponza_light_lods;
+	auto const set_sponza_content = [&](std::vector<bonobo::scene_material> const& materials, std::size_t geometry_nb) {
+		sponza_material_texture_data.clear();
+		for (auto const& material : materials)
+			sponza_material_texture_data.push_back(get_material_texture_data(material.bindings));
+		sponza_material_texture_data.push_back(GeometryTextureData());
+		sponza_camera_lods.resize(geometry_nb, 0u);
+		for (auto& light_lods : sponza_light_lods)
+			light_lods.resize(geometry_nb, 0u);
+	};
+	bonobo::cluster_draw_list cluster_draws;
 
 	auto const cone_geometry = loadCone();
 	Node cone;
@@ -321,10 +362,10 @@ edan35::Assignment2::run()
 	const GLuint debug_texture_id = bonobo::getDebugTextureID();
 
 	auto const bind_texture_with_sampler = [](GLenum target, unsigned int slot, GLuint program, std::string const& name, GLuint texture, GLuint sampler){
-		glActiveTexture(GL_TEXTURE0 + slot);
-		glBindTexture(target, texture);
+		bonobo::state::activeTexture(GL_TEXTURE0 + slot);
+		bonobo::state::bindTexture(target, texture);
 		glUniform1i(glGetUniformLocation(program, name.c_str()), static_cast<GLint>(slot));
-		glBindSampler(slot, sampler);
+		bonobo::state::bindSampler(slot, sampler);
 	};
 
 
@@ -358,11 +399,11 @@ edan35::Assignment2::run()
 
 	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 	glClearDepthf(1.0f);
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_CULL_FACE);
+	bonobo::state::enable(GL_DEPTH_TEST);
+	bonobo::state::enable(GL_CULL_FACE);
 
 
-	glBindFramebuffer(GL_READ_FRAMEBUFFER, fbos[toU(FBO::Resolve)]);
+	bonobo::state::bindFramebuffer(GL_READ_FRAMEBUFFER, fbos[toU(FBO::Resolve)]);
 
 
 	auto seconds_nb = 0.0f;
@@ -377,6 +418,7 @@ edan35::Assignment2::run()
 	bool copy_elapsed_times = true;
 	bool first_frame = true;
 	bool show_basis = false;
+	bool use_cluster_culling = true;
 	float basis_thickness_scale = 40.0f;
 	float basis_length_scale = 400.0f;
 
@@ -392,12 +434,21 @@ edan35::Assignment2::run()
 
 		glfwPollEvents();
 		inputHandler.Advance();
+
+		if (sponza_loading->has_failed()) {
+			LogError("Failed to load the Sponza model");
+			break;
+		}
+		if (sponza_loading->upload(sponza_upload_budget) && !use_sponza_snapshot)
+			set_sponza_content(sponza_loading->get_materials(), sponza_loading->get_objects().size());
+		auto const& sponza_geometry = use_sponza_snapshot ? sponza_snapshot.meshes : sponza_loading->get_objects();
 		mCamera.Update(deltaTimeUs, inputHandler);
 
 		camera_view_proj_transforms.view_projection = mCamera.GetWorldToClipMatrix();
 		camera_view_proj_transforms.view_projection_inverse = mCamera.GetClipToWorldMatrix();
 
 		auto const view_projection = camera_view_proj_transforms.view_projection;
+		std::size_t gbuffer_drawn_clusters_nb = 0u, gbuffer_clusters_nb = 0u;
 
 		if (inputHandler.GetKeycodeState(GLFW_KEY_R) & JUST_PRESSED) {
 			shader_reload_failed = !program_manager.ReloadAllPrograms();
@@ -460,20 +511,21 @@ edan35::Assignment2::run()
 			utils::opengl::debug::beginDebugGroup("Fill G-buffer");
 			glBeginQuery(GL_TIME_ELAPSED, elapsed_time_queries[toU(ElapsedTimeQuery::GbufferGeneration)]);
 
-			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[toU(FBO::GBuffer)]);
-			glViewport(0, 0, framebuffer_width, framebuffer_height);
+			bonobo::state::bindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[toU(FBO::GBuffer)]);
+			bonobo::state::viewport(0, 0, framebuffer_width, framebuffer_height);
 			glClear(GL_DEPTH_BUFFER_BIT);
 			// XXX: Is any other clearing needed?
 
-			glUseProgram(fill_gbuffer_shader);
+			bonobo::state::useProgram(fill_gbuffer_shader);
 			glUniform1i(fill_gbuffer_shader_locations.diffuse_texture, 0);
 			glUniform1i(fill_gbuffer_shader_locations.specular_texture, 1);
 			glUniform1i(fill_gbuffer_shader_locations.normals_texture, 2);
 			glUniform1i(fill_gbuffer_shader_locations.opacity_texture, 3);
+			GLuint bound_vao = 0u;
+			auto bound_material = std::numeric_limits<std::size_t>::max();
 			for (std::size_t i = 0; i < sponza_geometry.size(); ++i)
 			{
 				auto const& geometry = sponza_geometry[i];
-				auto const& texture_data = sponza_geometry_texture_data[i];
 
 				utils::opengl::debug::beginDebugGroup(geometry.name);
 
@@ -483,41 +535,53 @@ edan35::Assignment2::run()
 				glUniformMatrix4fv(fill_gbuffer_shader_locations.vertex_model_to_world, 1, GL_FALSE, glm::value_ptr(vertex_model_to_world));
 				glUniformMatrix4fv(fill_gbuffer_shader_locations.normal_model_to_world, 1, GL_FALSE, glm::value_ptr(normal_model_to_world));
 
-				auto const default_sampler = samplers[toU(Sampler::Nearest)];
-				auto const mipmap_sampler = samplers[toU(Sampler::Mipmaps)];
-
-				glUniform1i(fill_gbuffer_shader_locations.has_diffuse_texture, texture_data.diffuse_texture_id != 0u ? 1 : 0);
-				glBindSampler(0u, texture_data.diffuse_texture_id != 0u ? mipmap_sampler : default_sampler);
-				glActiveTexture(GL_TEXTURE0);
-				glBindTexture(GL_TEXTURE_2D, texture_data.diffuse_texture_id != 0u ? texture_data.diffuse_texture_id : debug_texture_id);
-
-				glUniform1i(fill_gbuffer_shader_locations.has_specular_texture, texture_data.specular_texture_id != 0u ? 1 : 0);
-				glBindSampler(1u, texture_data.specular_texture_id != 0u ? mipmap_sampler : default_sampler);
-				glActiveTexture(GL_TEXTURE1);
-				glBindTexture(GL_TEXTURE_2D, texture_data.specular_texture_id != 0u ? texture_data.specular_texture_id : debug_texture_id);
-
-				glUniform1i(fill_gbuffer_shader_locations.has_normals_texture, texture_data.normals_texture_id != 0u ? 1 : 0);
-				glBindSampler(2u, texture_data.normals_texture_id != 0u ? mipmap_sampler : default_sampler);
-				glActiveTexture(GL_TEXTURE2);
-				glBindTexture(GL_TEXTURE_2D, texture_data.normals_texture_id != 0u ? texture_data.normals_texture_id : debug_texture_id);
-
-				glUniform1i(fill_gbuffer_shader_locations.has_opacity_texture, texture_data.opacity_texture_id != 0u ? 1 : 0);
-				glBindSampler(3u, texture_data.opacity_texture_id != 0u ? mipmap_sampler : default_sampler);
-				glActiveTexture(GL_TEXTURE3);
-				glBindTexture(GL_TEXTURE_2D, texture_data.opacity_texture_id != 0u ? texture_data.opacity_texture_id : debug_texture_id);
+				auto const material = get_material_texture_data_index(geometry);
+				if (material != bound_material) {
+					auto const& texture_data = sponza_material_texture_data[material];
+					auto const default_sampler = samplers[toU(Sampler::Nearest)];
+					auto const mipmap_sampler = samplers[toU(Sampler::Mipmaps)];
+
+					glUniform1i(fill_gbuffer_shader_locations.has_diffuse_texture, texture_data.diffuse_texture_id != 0u ? 1 : 0);
+					bonobo::state::bindSampler(0u, texture_data.diffuse_texture_id != 0u ? mipmap_sampler : default_sampler);
+					bonobo::state::activeTexture(GL_TEXTURE0);
+					bonobo::state::bindTexture(GL_TEXTURE_2D, texture_data.diffuse_texture_id != 0u ? texture_data.diffuse_texture_id : debug_texture_id);
+
+					glUniform1i(fill_gbuffer_shader_locations.has_specular_texture, texture_data.specular_texture_id != 0u ? 1 : 0);
+					bonobo::state::bindSampler(1u, texture_data.specular_texture_id != 0u ? mipmap_sampler : default_sampler);
+					bonobo::state::activeTexture(GL_TEXTURE1);
+					bonobo::state::bindTexture(GL_TEXTURE_2D, texture_data.specular_texture_id != 0u ? texture_data.specular_texture_id : debug_texture_id);
+
+					glUniform1i(fill_gbuffer_shader_locations.has_normals_texture, texture_data.normals_texture_id != 0u ? 1 : 0);
+					bonobo::state::bindSampler(2u, texture_data.normals_texture_id != 0u ? mipmap_sampler : default_sampler);
+					bonobo::state::activeTexture(GL_TEXTURE2);
+					bonobo::state::bindTexture(GL_TEXTURE_2D, texture_data.normals_texture_id != 0u ? texture_data.normals_texture_id : debug_texture_id);
+
+					glUniform1i(fill_gbuffer_shader_locations.has_opacity_texture, texture_data.opacity_texture_id != 0u ? 1 : 0);
+					bonobo::state::bindSampler(3u, texture_data.opacity_texture_id != 0u ? mipmap_sampler : default_sampler);
+					bonobo::state::activeTexture(GL_TEXTURE3);
+					bonobo::state::bindTexture(GL_TEXTURE_2D, texture_data.opacity_texture_id != 0u ? texture_data.opacity_texture_id : debug_texture_id);
+					bound_material = material;
+				}
 
-				glBindVertexArray(geometry.vao);
-				if (geometry.ibo != 0u)
-					glDrawElements(geometry.drawing_mode, geometry.indices_nb, GL_UNSIGNED_INT, reinterpret_cast<GLvoid const*>(0x0));
-				else
-					glDrawArrays(geometry.drawing_mode, 0, geometry.vertices_nb);
+				if (geometry.vao != bound_vao) {
+					bonobo::state::bindVertexArray(geometry.vao);
+					bound_vao = geometry.vao;
+				}
+				sponza_camera_lods[i] = bonobo::selectLod(geometry.lods, geometry.sphere, camera_view_proj_transforms.view_projection,
+				                                          vertex_model_to_world, sponza_camera_lods[i]);
+				if (use_cluster_culling && sponza_camera_lods[i] == 0u && !geometry.clusters.empty()) {
+					gbuffer_drawn_clusters_nb += bonobo::cullClusters(geometry, camera_view_proj_transforms.view_projection, vertex_model_to_world,
+					                                                  mCamera.mWorld.GetTranslation(), cluster_draws);
+					gbuffer_clusters_nb += geometry.clusters.size();
+					bonobo::drawClusters(geometry, cluster_draws);
+				} else {
+					bonobo::drawMesh(geometry, sponza_camera_lods[i]);
+				}
 
 
 				utils::opengl::debug::endDebugGroup();
 			}
-			glBindTexture(GL_TEXTURE_2D, 0);
-			glBindVertexArray(0u);
-			glUseProgram(0u);
+			bonobo::state::bindTexture(GL_TEXTURE_2D, 0);
 
 			glEndQuery(GL_TIME_ELAPSED);
 			utils::opengl::debug::endDebugGroup();
@@ -527,8 +591,8 @@ edan35::Assignment2::run()
 			//
 			// Pass 2: Generate shadowmaps and accumulate lights' contribution
 			//
-			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[toU(FBO::LightAccumulation)]);
-			glViewport(0, 0, framebuffer_width, framebuffer_height);
+			bonobo::state::bindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[toU(FBO::LightAccumulation)]);
+			bonobo::state::viewport(0, 0, framebuffer_width, framebuffer_height);
 			// XXX: Is any clearing needed?
 			for (size_t i = 0; i < static_cast<size_t>(lights_nb); ++i) {
 				auto const& lightTransform = lightTransforms[i];
@@ -542,59 +606,75 @@ edan35::Assignment2::run()
 				utils::opengl::debug::beginDebugGroup("Create shadow map " + std::to_string(i));
 				glBeginQuery(GL_TIME_ELAPSED, elapsed_time_queries[toU(ElapsedTimeQuery::ShadowMap0Generation) + i]);
 
-				glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[toU(FBO::ShadowMap)]);
-				glViewport(0, 0, constant::shadowmap_res_x, constant::shadowmap_res_y);
+				bonobo::state::bindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[toU(FBO::ShadowMap)]);
+				bonobo::state::viewport(0, 0, constant::shadowmap_res_x, constant::shadowmap_res_y);
 				// XXX: Is any clearing needed?
 
-				glUseProgram(fill_shadowmap_shader);
+				bonobo::state::useProgram(fill_shadowmap_shader);
 				glUniform1i(fill_shadowmap_shader_locations.light_index, static_cast<int>(i));
 				glUniform1i(fill_shadowmap_shader_locations.opacity_texture, 0);
+				auto& light_lods = sponza_light_lods[i];
+				auto const light_position = glm::vec3(light_world_matrix[3]);
+				GLuint bound_vao = 0u;
+				GLuint bound_opacity_texture = std::numeric_limits<GLuint>::max();
 				for (std::size_t i = 0; i < sponza_geometry.size(); ++i)
 				{
 					auto const& geometry = sponza_geometry[i];
-					auto const& texture_data = sponza_geometry_texture_data[i];
+					auto const& texture_data = sponza_material_texture_data[get_material_texture_data_index(geometry)];
 
 					utils::opengl::debug::beginDebugGroup(geometry.name);
 
 					auto const vertex_model_to_world = glm::mat4(1.0f);
 					glUniformMatrix4fv(fill_shadowmap_shader_locations.vertex_model_to_world, 1, GL_FALSE, glm::value_ptr(vertex_model_to_world));
 
-					glUniform1i(fill_shadowmap_shader_locations.has_opacity_texture, texture_data.opacity_texture_id != 0u ? 1 : 0);
-					glBindSampler(0u, texture_data.opacity_texture_id != 0u ? samplers[toU(Sampler::Mipmaps)] : samplers[toU(Sampler::Nearest)]);
-					glActiveTexture(GL_TEXTURE0);
-					glBindTexture(GL_TEXTURE_2D, texture_data.opacity_texture_id != 0u ? texture_data.opacity_texture_id : debug_texture_id);
-
-					glBindVertexArray(geometry.vao);
-					if (geometry.ibo != 0u)
-						glDrawElements(geometry.drawing_mode, geometry.indices_nb, GL_UNSIGNED_INT, reinterpret_cast<GLvoid const*>(0x0));
-					else
-						glDrawArrays(geometry.drawing_mode, 0, geometry.vertices_nb);
+					// Only the opacity texture matters here, so materials
+					// sharing it do not need any rebinding.
+					if (texture_data.opacity_texture_id != bound_opacity_texture) {
+						glUniform1i(fill_shadowmap_shader_locations.has_opacity_texture, texture_data.opacity_texture_id != 0u ? 1 : 0);
+						bonobo::state::bindSampler(0u, texture_data.opacity_texture_id != 0u ? samplers[toU(Sampler::Mipmaps)] : samplers[toU(Sampler::Nearest)]);
+						bonobo::state::activeTexture(GL_TEXTURE0);
+						bonobo::state::bindTexture(GL_TEXTURE_2D, texture_data.opacity_texture_id != 0u ? texture_data.opacity_texture_id : debug_texture_id);
+						bound_opacity_texture = texture_data.opacity_texture_id;
+					}
+
+					if (geometry.vao != bound_vao) {
+						bonobo::state::bindVertexArray(geometry.vao);
+						bound_vao = geometry.vao;
+					}
+					light_lods[i] = bonobo::selectLod(geometry.lods, geometry.sphere, light_world_to_clip_matrix,
+					                                  vertex_model_to_world, light_lods[i]);
+					// Back faces are culled when rendering the shadow maps too,
+					// so clusters facing away from the light can be skipped.
+					if (use_cluster_culling && light_lods[i] == 0u && !geometry.clusters.empty()) {
+						bonobo::cullClusters(geometry, light_world_to_clip_matrix, vertex_model_to_world, light_position, cluster_draws);
+						bonobo::drawClusters(geometry, cluster_draws);
+					} else {
+						bonobo::drawMesh(geometry, light_lods[i]);
+					}
 
 
 					utils::opengl::debug::endDebugGroup();
 				}
-				glBindTexture(GL_TEXTURE_2D, 0);
-				glBindVertexArray(0u);
-				glUseProgram(0u);
+				bonobo::state::bindTexture(GL_TEXTURE_2D, 0);
 
 				glEndQuery(GL_TIME_ELAPSED);
 				utils::opengl::debug::endDebugGroup();
 
 
-				glCullFace(GL_FRONT);
-				glEnable(GL_BLEND);
-				glDepthFunc(GL_GREATER);
-				glDepthMask(GL_FALSE);
-				glBlendEquationSeparate(GL_FUNC_ADD, GL_MIN);
-				glBlendFuncSeparate(GL_ONE, GL_ONE, GL_ONE, GL_ONE);
+				bonobo::state::cullFace(GL_FRONT);
+				bonobo::state::enable(GL_BLEND);
+				bonobo::state::depthFunc(GL_GREATER);
+				bonobo::state::depthMask(GL_FALSE);
+				bonobo::state::blendEquationSeparate(GL_FUNC_ADD, GL_MIN);
+				bonobo::state::blendFuncSeparate(GL_ONE, GL_ONE, GL_ONE, GL_ONE);
 				//
 				// Pass 2.2: Accumulate light i contribution
 				utils::opengl::debug::beginDebugGroup("Accumulate light " + std::to_string(i));
 				glBeginQuery(GL_TIME_ELAPSED, elapsed_time_queries[toU(ElapsedTimeQuery::Light0Accumulation) + i]);
 
-				glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[toU(FBO::LightAccumulation)]);
-				glUseProgram(accumulate_lights_shader);
-				glViewport(0, 0, framebuffer_width, framebuffer_height);
+				bonobo::state::bindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[toU(FBO::LightAccumulation)]);
+				bonobo::state::useProgram(accumulate_lights_shader);
+				bonobo::state::viewport(0, 0, framebuffer_width, framebuffer_height);
 				// XXX: Is any clearing needed?
 
 				glUniform1i(accumulate_light_shader_locations.light_index, static_cast<int>(i));
@@ -609,37 +689,35 @@ edan35::Assignment2::run()
 				glUniform1f(accumulate_light_shader_locations.light_intensity, constant::light_intensity);
 				glUniform1f(accumulate_light_shader_locations.light_angle_falloff, constant::light_angle_falloff);
 
-				glActiveTexture(GL_TEXTURE0);
-				glBindTexture(GL_TEXTURE_2D, textures[toU(Texture::DepthBuffer)]);
+				bonobo::state::activeTexture(GL_TEXTURE0);
+				bonobo::state::bindTexture(GL_TEXTURE_2D, textures[toU(Texture::DepthBuffer)]);
 				glUniform1i(accumulate_light_shader_locations.depth_texture, 0);
-				glBindSampler(0, samplers[toU(Sampler::Linear)]);
+				bonobo::state::bindSampler(0, samplers[toU(Sampler::Linear)]);
 
-				glActiveTexture(GL_TEXTURE1);
-				glBindTexture(GL_TEXTURE_2D, textures[toU(Texture::GBufferWorldSpaceNormal)]);
+				bonobo::state::activeTexture(GL_TEXTURE1);
+				bonobo::state::bindTexture(GL_TEXTURE_2D, textures[toU(Texture::GBufferWorldSpaceNormal)]);
 				glUniform1i(accumulate_light_shader_locations.normal_texture, 1);
-				glBindSampler(1, samplers[toU(Sampler::Linear)]);
+				bonobo::state::bindSampler(1, samplers[toU(Sampler::Linear)]);
 
-				glActiveTexture(GL_TEXTURE2);
-				glBindTexture(GL_TEXTURE_2D, textures[toU(Texture::ShadowMap)]);
+				bonobo::state::activeTexture(GL_TEXTURE2);
+				bonobo::state::bindTexture(GL_TEXTURE_2D, textures[toU(Texture::ShadowMap)]);
 				glUniform1i(accumulate_light_shader_locations.shadow_texture, 2);
-				glBindSampler(2, samplers[toU(Sampler::Linear)]);
+				bonobo::state::bindSampler(2, samplers[toU(Sampler::Linear)]);
 
-				glBindVertexArray(cone_geometry.vao);
+				bonobo::state::bindVertexArray(cone_geometry.vao);
 				glDrawArrays(cone_geometry.drawing_mode, 0, cone_geometry.vertices_nb);
 
-				glBindVertexArray(0u);
-				glUseProgram(0u);
-				glBindSampler(2u, 0u);
-				glBindSampler(1u, 0u);
-				glBindSampler(0u, 0u);
+				bonobo::state::bindSampler(2u, 0u);
+				bonobo::state::bindSampler(1u, 0u);
+				bonobo::state::bindSampler(0u, 0u);
 
 				glEndQuery(GL_TIME_ELAPSED);
 				utils::opengl::debug::endDebugGroup();
 
-				glDepthMask(GL_TRUE);
-				glDepthFunc(GL_LESS);
-				glDisable(GL_BLEND);
-				glCullFace(GL_BACK);
+				bonobo::state::depthMask(GL_TRUE);
+				bonobo::state::depthFunc(GL_LESS);
+				bonobo::state::disable(GL_BLEND);
+				bonobo::state::cullFace(GL_BACK);
 			}
 
 
@@ -649,9 +727,9 @@ edan35::Assignment2::run()
 			utils::opengl::debug::beginDebugGroup("Resolve");
 			glBeginQuery(GL_TIME_ELAPSED, elapsed_time_queries[toU(ElapsedTimeQuery::Resolve)]);
 
-			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[toU(FBO::Resolve)]);
-			glUseProgram(resolve_deferred_shader);
-			glViewport(0, 0, framebuffer_width, framebuffer_height);
+			bonobo::state::bindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[toU(FBO::Resolve)]);
+			bonobo::state::useProgram(resolve_deferred_shader);
+			bonobo::state::viewport(0, 0, framebuffer_width, framebuffer_height);
 			// XXX: Is any clearing needed?
 
 			bind_texture_with_sampler(GL_TEXTURE_2D, 0, resolve_deferred_shader, "diffuse_texture", textures[toU(Texture::GBufferDiffuse)], samplers[toU(Sampler::Nearest)]);
@@ -661,11 +739,10 @@ edan35::Assignment2::run()
 
 			bonobo::drawFullscreen();
 
-			glBindSampler(3, 0u);
-			glBindSampler(2, 0u);
-			glBindSampler(1, 0u);
-			glBindSampler(0, 0u);
-			glUseProgram(0u);
+			bonobo::state::bindSampler(3, 0u);
+			bonobo::state::bindSampler(2, 0u);
+			bonobo::state::bindSampler(1, 0u);
+			bonobo::state::bindSampler(0, 0u);
 
 			glEndQuery(GL_TIME_ELAPSED);
 			utils::opengl::debug::endDebugGroup();
@@ -674,7 +751,7 @@ edan35::Assignment2::run()
 
 		auto const show_debug_elements = show_cone_wireframe || show_basis;
 		if (show_debug_elements) {
-			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[toU(FBO::FinalWithDepth)]);
+			bonobo::state::bindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[toU(FBO::FinalWithDepth)]);
 		}
 
 
@@ -685,15 +762,15 @@ edan35::Assignment2::run()
 		if (show_cone_wireframe) {
 			utils::opengl::debug::beginDebugGroup("Draw cone wireframe");
 
-			glDisable(GL_CULL_FACE);
-			glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+			bonobo::state::disable(GL_CULL_FACE);
+			bonobo::state::polygonMode(GL_FRONT_AND_BACK, GL_LINE);
 			for (size_t i = 0; i < lights_nb; ++i) {
 				cone.render(view_projection,
 				            lightTransforms[i].GetMatrix() * lightOffsetTransform.GetMatrix() * coneScaleTransform.GetMatrix(),
 				            render_light_cones_shader, set_uniforms);
 			}
-			glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-			glEnable(GL_CULL_FACE);
+			bonobo::state::polygonMode(GL_FRONT_AND_BACK, GL_FILL);
+			bonobo::state::enable(GL_CULL_FACE);
 			utils::opengl::debug::endDebugGroup();
 		}
 		glEndQuery(GL_TIME_ELAPSED);
@@ -712,7 +789,7 @@ edan35::Assignment2::run()
 		// If the basis and cone wireframe were not shown, FBO::Resolve
 		// is still bound so there is no need to rebind it.
 		if (show_debug_elements) {
-			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[toU(FBO::Resolve)]);
+			bonobo::state::bindFramebuffer(GL_DRAW_FRAMEBUFFER, fbos[toU(FBO::Resolve)]);
 		}
 
 		//
@@ -731,13 +808,23 @@ edan35::Assignment2::run()
 		//
 		// Reset viewport back to normal
 		//
-		glViewport(0, 0, framebuffer_width, framebuffer_height);
+		bonobo::state::viewport(0, 0, framebuffer_width, framebuffer_height);
 
 		bool opened = ImGui::Begin("Render Time", nullptr, ImGuiWindowFlags_None);
 		if (opened) {
 			ImGui::Text("Frame CPU time: %.3f ms", std::chrono::duration<float, std::milli>(deltaTimeUs).count());
 
 			ImGui::Checkbox("Copy elapsed times back to CPU", &copy_elapsed_times);
+			if (!sponza_loading->is_complete()) {
+				ImGui::Text("Sponza meshes streamed in: %zu", sponza_geometry.size());
+				ImGui::SliderFloat("Streaming budget [ms]", &sponza_upload_budget.max_duration, 0.5f, 16.0f);
+			}
+			if (use_cluster_culling)
+				ImGui::Text("G-buffer clusters drawn: %zu / %zu", gbuffer_drawn_clusters_nb, gbuffer_clusters_nb);
+			auto const& state_statistics = bonobo::state::getStatistics();
+			ImGui::Text("Redundant state changes elided: %llu / %llu",
+			            static_cast<unsigned long long>(state_statistics.elided_calls_nb),
+			            static_cast<unsigned long long>(state_statistics.elided_calls_nb + state_statistics.forwarded_calls_nb));
 
 			if (ImGui::BeginTable("Pass durations", 2, ImGuiTableFlags_SizingFixedFit))
 			{
@@ -798,6 +885,34 @@ edan35::Assignment2::run()
 			ImGui::SliderInt("Number of lights", &lights_nb, 1, static_cast<int>(constant::lights_nb));
 			ImGui::Checkbox("Show textures", &show_textures);
 			ImGui::Checkbox("Show light cones wireframe", &show_cone_wireframe);
+			ImGui::Checkbox("Cull clusters", &use_cluster_culling);
+			ImGui::Separator();
+			if (use_sponza_snapshot || sponza_loading->is_complete())
+			{
+				if (ImGui::Button("Save Sponza snapshot"))
+				{
+					bonobo::scene_snapshot snapshot;
+					snapshot.meshes = sponza_geometry;
+					snapshot.materials = use_sponza_snapshot ? sponza_snapshot.materials : sponza_loading->get_materials();
+					if (!bonobo::saveSceneSnapshot(sponza_snapshot_path, snapshot))
+						tinyfd_notifyPopup("Scene Snapshot Error", "Sponza could not be saved; see the logs for details.", "error");
+				}
+			}
+			if (ImGui::Button("Load Sponza snapshot"))
+			{
+				bonobo::scene_snapshot snapshot;
+				if (bonobo::loadSceneSnapshot(sponza_snapshot_path, snapshot))
+				{
+					bonobo::releaseSceneSnapshot(sponza_snapshot);
+					sponza_snapshot = std::move(snapshot);
+					use_sponza_snapshot = true;
+					set_sponza_content(sponza_snapshot.materials, sponza_snapshot.meshes.size());
+				}
+				else
+				{
+					tinyfd_notifyPopup("Scene Snapshot Error", "Sponza could not be loaded; see the logs for details.", "error");
+				}
+			}
 			ImGui::Separator();
 			ImGui::Checkbox("Show basis", &show_basis);
 			ImGui::SliderFloat("Basis thickness scale", &basis_thickness_scale, 0.0f, 100.0f);
@@ -808,6 +923,7 @@ edan35::Assignment2::run()
 		if (show_logs)
 			Log::View::Render();
 		mWindowManager.RenderImGuiFrame(show_gui);
+		bonobo::state::resetStatistics();
 
 		glEndQuery(GL_TIME_ELAPSED);
 		utils::opengl::debug::endDebugGroup();
@@ -820,7 +936,7 @@ edan35::Assignment2::run()
 
 		// FBO::Resolve has already been bound to GL_READ_FRAMEBUFFER before rendering the first frame,
 		// as no other frame buffer gets bound to it.
-		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0u);
+		bonobo::state::bindFramebuffer(GL_DRAW_FRAMEBUFFER, 0u);
 		glBlitFramebuffer(0, 0, framebuffer_width, framebuffer_height, 0, 0, framebuffer_width, framebuffer_height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
 
 		glEndQuery(GL_TIME_ELAPSED);
@@ -831,11 +947,12 @@ edan35::Assignment2::run()
 		first_frame = false;
 	}
 
+	bonobo::releaseSceneSnapshot(sponza_snapshot);
 	glDeleteBuffers(static_cast<GLsizei>(ubos.size()), ubos.data());
 	glDeleteQueries(static_cast<GLsizei>(elapsed_time_queries.size()), elapsed_time_queries.data());
-	glDeleteSamplers(static_cast<GLsizei>(samplers.size()), samplers.data());
-	glDeleteFramebuffers(static_cast<GLsizei>(fbos.size()), fbos.data());
-	glDeleteTextures(static_cast<GLsizei>(textures.size()), textures.data());
+	bonobo::state::deleteSamplers(static_cast<GLsizei>(samplers.size()), samplers.data());
+	bonobo::state::deleteFramebuffers(static_cast<GLsizei>(fbos.size()), fbos.data());
+	bonobo::state::deleteTextures(static_cast<GLsizei>(textures.size()), textures.data());
 
 	glDeleteProgram(resolve_deferred_shader);
 	resolve_deferred_shader = 0u;
@@ -870,39 +987,39 @@ Textures createTextures(GLsizei framebuffer_width, GLsizei framebuffer_height)
 	Textures textures;
 	glGenTextures(static_cast<GLsizei>(textures.size()), textures.data());
 
-	glBindTexture(GL_TEXTURE_2D, textures[toU(Texture::DepthBuffer)]);
+	bonobo::state::bindTexture(GL_TEXTURE_2D, textures[toU(Texture::DepthBuffer)]);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH24_STENCIL8, framebuffer_width, framebuffer_height, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
 	utils::opengl::debug::nameObject(GL_TEXTURE, textures[toU(Texture::DepthBuffer)], "Depth buffer");
 
-	glBindTexture(GL_TEXTURE_2D, textures[toU(Texture::ShadowMap)]);
+	bonobo::state::bindTexture(GL_TEXTURE_2D, textures[toU(Texture::ShadowMap)]);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT32F, constant::shadowmap_res_x, constant::shadowmap_res_y, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
 	utils::opengl::debug::nameObject(GL_TEXTURE, textures[toU(Texture::ShadowMap)], "Shadow map");
 
-	glBindTexture(GL_TEXTURE_2D, textures[toU(Texture::GBufferDiffuse)]);
+	bonobo::state::bindTexture(GL_TEXTURE_2D, textures[toU(Texture::GBufferDiffuse)]);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, framebuffer_width, framebuffer_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
 	utils::opengl::debug::nameObject(GL_TEXTURE, textures[toU(Texture::GBufferDiffuse)], "GBuffer diffuse");
 
-	glBindTexture(GL_TEXTURE_2D, textures[toU(Texture::GBufferSpecular)]);
+	bonobo::state::bindTexture(GL_TEXTURE_2D, textures[toU(Texture::GBufferSpecular)]);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, framebuffer_width, framebuffer_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
 	utils::opengl::debug::nameObject(GL_TEXTURE, textures[toU(Texture::GBufferSpecular)], "GBuffer specular");
 
-	glBindTexture(GL_TEXTURE_2D, textures[toU(Texture::GBufferWorldSpaceNormal)]);
+	bonobo::state::bindTexture(GL_TEXTURE_2D, textures[toU(Texture::GBufferWorldSpaceNormal)]);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, framebuffer_width, framebuffer_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
 	utils::opengl::debug::nameObject(GL_TEXTURE, textures[toU(Texture::GBufferWorldSpaceNormal)], "GBuffer normals");
 
-	glBindTexture(GL_TEXTURE_2D, textures[toU(Texture::LightDiffuseContribution)]);
+	bonobo::state::bindTexture(GL_TEXTURE_2D, textures[toU(Texture::LightDiffuseContribution)]);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, framebuffer_width, framebuffer_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
 	utils::opengl::debug::nameObject(GL_TEXTURE, textures[toU(Texture::LightDiffuseContribution)], "Light diffuse contribution");
 
-	glBindTexture(GL_TEXTURE_2D, textures[toU(Texture::LightSpecularContribution)]);
+	bonobo::state::bindTexture(GL_TEXTURE_2D, textures[toU(Texture::LightSpecularContribution)]);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, framebuffer_width, framebuffer_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
 	utils::opengl::debug::nameObject(GL_TEXTURE, textures[toU(Texture::LightSpecularContribution)], "Light specular contribution");
 
-	glBindTexture(GL_TEXTURE_2D, textures[toU(Texture::Result)]);
+	bonobo::state::bindTexture(GL_TEXTURE_2D, textures[toU(Texture::Result)]);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, framebuffer_width, framebuffer_height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
 	utils::opengl::debug::nameObject(GL_TEXTURE, textures[toU(Texture::Result)], "Final result");
 
-	glBindTexture(GL_TEXTURE_2D, 0u);
+	bonobo::state::bindTexture(GL_TEXTURE_2D, 0u);
 	return textures;
 }
 
@@ -942,7 +1059,7 @@ FBOs createFramebufferObjects(Textures const& textures)
 	FBOs fbos;
 	glGenFramebuffers(static_cast<GLsizei>(fbos.size()), fbos.data());
 
-	glBindFramebuffer(GL_FRAMEBUFFER, fbos[toU(FBO::GBuffer)]);
+	bonobo::state::bindFramebuffer(GL_FRAMEBUFFER, fbos[toU(FBO::GBuffer)]);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[toU(Texture::GBufferDiffuse)], 0);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, textures[toU(Texture::GBufferSpecular)], 0);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, textures[toU(Texture::GBufferWorldSpaceNormal)], 0);
@@ -958,12 +1075,12 @@ FBOs createFramebufferObjects(Textures const& textures)
 	validate_fbo("GBuffer");
 	utils::opengl::debug::nameObject(GL_FRAMEBUFFER, fbos[toU(FBO::GBuffer)], "GBuffer");
 
-	glBindFramebuffer(GL_FRAMEBUFFER, fbos[toU(FBO::ShadowMap)]);
+	bonobo::state::bindFramebuffer(GL_FRAMEBUFFER, fbos[toU(FBO::ShadowMap)]);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[toU(Texture::ShadowMap)], 0);
 	validate_fbo("Shadow map generation");
 	utils::opengl::debug::nameObject(GL_FRAMEBUFFER, fbos[toU(FBO::ShadowMap)], "Shadow map generation");
 
-	glBindFramebuffer(GL_FRAMEBUFFER, fbos[toU(FBO::LightAccumulation)]);
+	bonobo::state::bindFramebuffer(GL_FRAMEBUFFER, fbos[toU(FBO::LightAccumulation)]);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[toU(Texture::LightDiffuseContribution)], 0);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, textures[toU(Texture::LightSpecularContribution)], 0);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[toU(Texture::DepthBuffer)], 0);
@@ -977,14 +1094,14 @@ FBOs createFramebufferObjects(Textures const& textures)
 	validate_fbo("Light accumulation");
 	utils::opengl::debug::nameObject(GL_FRAMEBUFFER, fbos[toU(FBO::LightAccumulation)], "Light acccumulation");
 
-	glBindFramebuffer(GL_FRAMEBUFFER, fbos[toU(FBO::Resolve)]);
+	bonobo::state::bindFramebuffer(GL_FRAMEBUFFER, fbos[toU(FBO::Resolve)]);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[toU(Texture::Result)], 0);
 	glReadBuffer(GL_COLOR_ATTACHMENT0); // Colour attachment result 0 (i.e. the rendering result texture) will be blitted to the screen.
 	glDrawBuffer(GL_COLOR_ATTACHMENT0); // The fragment shader output at location 0 will be written to colour attachment 0 (i.e. the rendering result texture).
 	validate_fbo("Resolve");
 	utils::opengl::debug::nameObject(GL_FRAMEBUFFER, fbos[toU(FBO::Resolve)], "Resolve");
 
-	glBindFramebuffer(GL_FRAMEBUFFER, fbos[toU(FBO::FinalWithDepth)]);
+	bonobo::state::bindFramebuffer(GL_FRAMEBUFFER, fbos[toU(FBO::FinalWithDepth)]);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, textures[toU(Texture::Result)], 0);
 	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, textures[toU(Texture::DepthBuffer)], 0);
 	glReadBuffer(GL_NONE); // Disable reading back from the colour attachments, as unnecessary in this assignment.
@@ -992,7 +1109,7 @@ FBOs createFramebufferObjects(Textures const& textures)
 	validate_fbo("Final with depth");
 	utils::opengl::debug::nameObject(GL_FRAMEBUFFER, fbos[toU(FBO::FinalWithDepth)], "Cone wireframe");
 
-	glBindFramebuffer(GL_FRAMEBUFFER, 0u);
+	bonobo::state::bindFramebuffer(GL_FRAMEBUFFER, 0u);
 	return fbos;
 }
 
@@ -1183,7 +1300,7 @@ loadCone()
 
 	glGenVertexArrays(1, &cone.vao);
 	assert(cone.vao != 0u);
-	glBindVertexArray(cone.vao);
+	bonobo::state::bindVertexArray(cone.vao);
 	{
 		utils::opengl::debug::nameObject(GL_VERTEX_ARRAY, cone.vao, "Cone VAO");
 
@@ -1198,7 +1315,7 @@ loadCone()
 
 		glBindBuffer(GL_ARRAY_BUFFER, 0u);
 	}
-	glBindVertexArray(0u);
+	bonobo::state::bindVertexArray(0u);
 
 	return cone;
 }
@@ -0,0 +1,141 @@
+// Compare building mip chains on the GPU through glGenerateMipmap(), as
+// textures used to be, against building them on the CPU with
+// bonobo::buildMipChain().
+
+#include "core/mipmap.hpp"
+#include "core/thread_pool.hpp"
+
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <future>
+#include <vector>
+
+namespace
+{
+	std::uint32_t const image_size = 2048u;
+	int const repetitions_nb = 5;
+	std::size_t const images_nb = 16u; // for the thread pool runs
+
+	std::vector<std::uint8_t> createImage(std::uint32_t size)
+	{
+		// Smooth gradients with sharp edges and an alpha-tested pattern,
+		// so that all filters and options have something to do.
+		std::vector<std::uint8_t> image(static_cast<std::size_t>(size) * size * 4u);
+		for (std::uint32_t y = 0u; y < size; ++y)
+			for (std::uint32_t x = 0u; x < size; ++x) {
+				auto texel = image.data() + 4u * (static_cast<std::size_t>(y) * size + x);
+				texel[0] = static_cast<std::uint8_t>(x * 255u / size);
+				texel[1] = static_cast<std::uint8_t>(y * 255u / size);
+				texel[2] = ((x / 16u) + (y / 16u)) % 2u == 0u ? 255u : 0u;
+				texel[3] = ((x ^ y) & 0x20u) != 0u ? 255u : 0u;
+			}
+		return image;
+	}
+
+	//! \brief Best time over |repetitions_nb| runs of |run|, in milliseconds.
+	double measure(std::function<void()> const& run)
+	{
+		auto best = 0.0;
+		for (int i = 0; i < repetitions_nb; ++i) {
+			auto const start_time = std::chrono::high_resolution_clock::now();
+			run();
+			auto const end_time = std::chrono::high_resolution_clock::now();
+			auto const duration = std::chrono::duration<double, std::milli>(end_time - start_time).count();
+			best = i == 0 ? duration : std::min(best, duration);
+		}
+		return best;
+	}
+
+	void report(char const* name, double duration, std::size_t images_nb)
+	{
+		std::printf("%-42s %9.2f ms %9.2f ms/image\n", name, duration, duration / static_cast<double>(images_nb));
+	}
+}
+
+int main()
+{
+	auto const image = createImage(image_size);
+	std::printf("Building the mip chain of %u×%u RGBA8 images, best of %d runs:\n", image_size, image_size, repetitions_nb);
+
+	// GPU path, as previously done when loading any texture: upload the
+	// full-resolution level, then let the driver generate the others.
+	if (glfwInit() == GLFW_TRUE) {
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef __APPLE__
+		glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+		glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+		glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+		auto const window = glfwCreateWindow(64, 64, "Mipmap benchmark", nullptr, nullptr);
+		if (window != nullptr) {
+			glfwMakeContextCurrent(window);
+			if (gladLoadGLLoader(reinterpret_cast<GLADloadproc>(glfwGetProcAddress))) {
+				GLuint texture = 0u;
+				glGenTextures(1, &texture);
+				glBindTexture(GL_TEXTURE_2D, texture);
+				auto const generate = [&image, &texture]() {
+					glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image_size, image_size, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.data());
+					glGenerateMipmap(GL_TEXTURE_2D);
+					glFinish();
+				};
+				auto const upload_only = [&image]() {
+					glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, image_size, image_size, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.data());
+					glFinish();
+				};
+				generate(); // warm up the driver
+				report("glTexImage2D", measure(upload_only), 1u);
+				report("glTexImage2D + glGenerateMipmap", measure(generate), 1u);
+				glDeleteTextures(1, &texture);
+			} else {
+				std::printf("Failed to load OpenGL; skipping glGenerateMipmap.\n");
+			}
+			glfwDestroyWindow(window);
+		} else {
+			std::printf("Failed to create an OpenGL 4.1 context; skipping glGenerateMipmap.\n");
+		}
+		glfwTerminate();
+	}
+
+	// CPU paths; these run on the loading workers, off the render thread.
+	struct configuration {
+		char const* name;
+		bonobo::mipmap_options options;
+	};
+	std::vector<configuration> configurations(4u);
+	configurations[0].name = "buildMipChain, box";
+	configurations[1].name = "buildMipChain, box, sRGB";
+	configurations[1].options.is_srgb = true;
+	configurations[2].name = "buildMipChain, Kaiser, sRGB";
+	configurations[2].options.filter = bonobo::mipmap_filter::kaiser;
+	configurations[2].options.is_srgb = true;
+	configurations[3].name = "buildMipChain, Kaiser, sRGB, alpha coverage";
+	configurations[3].options = configurations[2].options;
+	configurations[3].options.preserve_alpha_coverage = true;
+
+	for (auto const& configuration : configurations)
+		report(configuration.name, measure([&image, &configuration]() {
+			bonobo::buildMipChain(image.data(), image_size, image_size, configuration.options);
+		}), 1u);
+
+	auto& thread_pool = utils::get_shared_thread_pool();
+	std::printf("\nBuilding %zu chains on %zu worker threads:\n", images_nb, thread_pool.size());
+	for (auto const& configuration : configurations)
+		report(configuration.name, measure([&image, &configuration, &thread_pool]() {
+			std::vector<std::future<std::vector<bonobo::image_level>>> chains;
+			for (std::size_t i = 0u; i < images_nb; ++i)
+				chains.push_back(thread_pool.submit([&image, &configuration]() {
+					return bonobo::buildMipChain(image.data(), image_size, image_size, configuration.options);
+				}));
+			for (auto& chain : chains)
+				chain.get();
+		}), images_nb);
+
+	return 0;
+}
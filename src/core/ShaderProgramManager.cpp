@@ -14,6 +14,7 @@ ShaderProgramManager::~ShaderProgramManager()
 {
 	for (auto const& i : program_entries) {
 		if (i.first != 0u) {
+			utils::opengl::shader::forget_uniform_locations(i.first);
 			glDeleteProgram(i.first);
 			i.first = 0u;
 		}
@@ -55,8 +56,10 @@ bool ShaderProgramManager::ReloadAllPrograms()
 	bool encountered_failures = false;
 	for (std::size_t i = 0; i < program_entries.size(); ++i) {
 		auto& program = program_entries[i].first;
-		if (program != 0u)
+		if (program != 0u) {
+			utils::opengl::shader::forget_uniform_locations(program);
 			glDeleteProgram(program);
+		}
 		program = 0u;
 		ProcessProgram(i);
 		encountered_failures |= program == 0u;
@@ -79,6 +82,22 @@ ShaderProgramManager::SelectedProgram ShaderProgramManager::SelectProgram(std::s
 	return selection_result;
 }
 
+char const* ShaderProgramManager::GetProgramName(GLuint const* program) const
+{
+	for (std::size_t i = 0; i < program_entries.size(); ++i)
+		if (&program_entries[i].first == program)
+			return program_names[i];
+	return nullptr;
+}
+
+GLuint const* ShaderProgramManager::GetProgram(std::string const& name) const
+{
+	for (std::size_t i = 0; i < program_entries.size(); ++i)
+		if (name == program_names[i])
+			return &program_entries[i].first;
+	return nullptr;
+}
+
 void ShaderProgramManager::ProcessProgram(std::size_t const program_index)
 {
 	auto& program_entry = program_entries[program_index];
@@ -90,13 +109,17 @@ void ShaderProgramManager::ProcessProgram(std::size_t const program_index)
 
 	for (auto const& i : program_data) {
 		std::string const full_filename = config::shaders_path(i.second);
-		auto const shader_source = utils::slurp_file(full_filename);
-		if (shader_source.empty()) {
-			LogError("Retrieval of shader '%s' failed; see previous message for details.", full_filename.c_str());
+		utils::mapped_file const shader_source(full_filename);
+		if (!shader_source.is_open() || shader_source.size() == 0u) {
+			for (auto& shader : shaders)
+				glDeleteShader(shader);
+			LogError("Retrieval of shader '%s' failed.", full_filename.c_str());
 			return;
 		}
 
-		GLuint shader = utils::opengl::shader::generate_shader(static_cast<std::underlying_type<ShaderType>::type>(i.first), shader_source);
+		GLuint shader = utils::opengl::shader::generate_shader(static_cast<std::underlying_type<ShaderType>::type>(i.first),
+		                                                       reinterpret_cast<char const*>(shader_source.data()),
+		                                                       shader_source.size());
 		if (shader == 0u) {
 			for (auto& shader : shaders)
 				glDeleteShader(shader);
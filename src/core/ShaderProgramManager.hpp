@@ -34,6 +34,14 @@ public:
 	bool ReloadAllPrograms();
 	SelectedProgram SelectProgram(std::string const& label, std::int32_t& program_index);
 
+	//! \brief Name |program| was registered under, or nullptr if it does
+	//!        not point to a registered program.
+	char const* GetProgramName(GLuint const* program) const;
+
+	//! \brief Program registered under |name|, or nullptr if there is
+	//!        none; the pointee gets updated when the program is reloaded.
+	GLuint const* GetProgram(std::string const& name) const;
+
 private:
 	void ProcessProgram(std::size_t program_index);
 	using ProgramEntry = std::pair<GLuint&, ProgramData>;
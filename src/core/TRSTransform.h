@@ -72,6 +72,8 @@ public:
 
 	// Rotate around vector (x, y, z)
 	void SetRotate(T angle, glm::tvec3<T, P> v);
+	// Replace the rotation by |rotation|, e.g. one from `GetRotation()`
+	void SetRotate(glm::tmat3x3<T, P> rotation);
 	void SetRotateX(T angle);
 	void SetRotateY(T angle);
 	void SetRotateZ(T angle);
@@ -180,6 +180,14 @@ void TRSTransform<T, P>::SetRotate(T angle, glm::tvec3<T, P> v)
 
 /*----------------------------------------------------------------------------*/
 
+template<typename T, glm::precision P>
+void TRSTransform<T, P>::SetRotate(glm::tmat3x3<T, P> rotation)
+{
+	mR = rotation;
+}
+
+/*----------------------------------------------------------------------------*/
+
 template<typename T, glm::precision P>
 void TRSTransform<T, P>::SetRotateX(T angle)
 {
@@ -1,7 +1,9 @@
 #include "WindowManager.hpp"
 
+#include "gl_state.hpp"
 #include "Log.h"
 #include "opengl.hpp"
+#include "render_queue.hpp"
 
 #include <glad/glad.h>
 #include <imgui.h>
@@ -220,6 +222,9 @@ void WindowManager::DestroyWindow(GLFWwindow* const window)
 
 void WindowManager::NewImGuiFrame()
 {
+	// Every render loop goes through here once per frame.
+	bonobo::beginDrawUniformsFrame();
+
 	ImGui_ImplOpenGL3_NewFrame();
 	ImGui_ImplGlfw_NewFrame();
 	ImGui::NewFrame();
@@ -228,8 +233,13 @@ void WindowManager::NewImGuiFrame()
 void WindowManager::RenderImGuiFrame(bool show_gui)
 {
 	ImGui::Render();
-	if (show_gui)
+	if (show_gui) {
 		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+
+		// The renderer binds its own objects behind the back of the
+		// state tracker.
+		bonobo::state::invalidate();
+	}
 }
 
 void WindowManager::ToggleFullscreenStatusForWindow(GLFWwindow* const window) noexcept
@@ -0,0 +1,315 @@
+#include "gl_state.hpp"
+
+#include <array>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	GLuint const unknown_name = ~0u;
+	GLenum const unknown_enum = GL_NONE;
+
+	std::array<GLenum, 11> const texture_targets = {
+		GL_TEXTURE_1D, GL_TEXTURE_2D, GL_TEXTURE_3D,
+		GL_TEXTURE_1D_ARRAY, GL_TEXTURE_2D_ARRAY, GL_TEXTURE_RECTANGLE,
+		GL_TEXTURE_CUBE_MAP, GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_BUFFER,
+		GL_TEXTURE_2D_MULTISAMPLE, GL_TEXTURE_2D_MULTISAMPLE_ARRAY
+	};
+
+	struct texture_unit {
+		texture_unit() { textures.fill(unknown_name); }
+
+		std::array<GLuint, texture_targets.size()> textures;
+		GLuint sampler{unknown_name};
+	};
+
+	struct tracked_state {
+		GLuint program{unknown_name};
+		GLuint vao{unknown_name};
+		GLenum active_texture{unknown_enum};
+		std::vector<texture_unit> units; // grown on demand
+		GLuint draw_framebuffer{unknown_name};
+		GLuint read_framebuffer{unknown_name};
+		bool is_viewport_known{false};
+		std::array<GLint, 4> viewport{};
+		std::unordered_map<GLenum, bool> capabilities; // only those set through this layer
+		GLenum cull_face{unknown_enum};
+		GLenum polygon_mode{unknown_enum};
+		GLenum depth_func{unknown_enum};
+		bool is_depth_mask_known{false};
+		GLboolean depth_mask{GL_TRUE};
+		std::array<GLenum, 2> blend_equations{{unknown_enum, unknown_enum}};
+		std::array<GLenum, 4> blend_funcs{{unknown_enum, unknown_enum, unknown_enum, unknown_enum}};
+	};
+
+	tracked_state current;
+	bonobo::state::statistics counters;
+
+	//! \brief Record |value| as the new one, and return whether the call
+	//!        setting it needs to be forwarded.
+	template<typename T>
+	bool update(T& tracked, T const& value)
+	{
+		if (tracked == value) {
+			++counters.elided_calls_nb;
+			return false;
+		}
+		tracked = value;
+		++counters.forwarded_calls_nb;
+		return true;
+	}
+
+	std::size_t get_target_index(GLenum target)
+	{
+		for (std::size_t i = 0u; i < texture_targets.size(); ++i)
+			if (texture_targets[i] == target)
+				return i;
+		return texture_targets.size();
+	}
+
+	texture_unit& get_unit(GLuint unit)
+	{
+		if (unit >= current.units.size())
+			current.units.resize(unit + 1u);
+		return current.units[unit];
+	}
+}
+
+void
+bonobo::state::useProgram(GLuint program)
+{
+	if (update(current.program, program))
+		glUseProgram(program);
+}
+
+void
+bonobo::state::bindVertexArray(GLuint vao)
+{
+	if (update(current.vao, vao))
+		glBindVertexArray(vao);
+}
+
+void
+bonobo::state::activeTexture(GLenum unit)
+{
+	if (update(current.active_texture, unit))
+		glActiveTexture(unit);
+}
+
+void
+bonobo::state::bindTexture(GLenum target, GLuint texture)
+{
+	auto const target_index = get_target_index(target);
+	if (current.active_texture == unknown_enum || target_index == texture_targets.size()) {
+		++counters.forwarded_calls_nb;
+		glBindTexture(target, texture);
+		return;
+	}
+
+	auto& unit = get_unit(current.active_texture - GL_TEXTURE0);
+	if (update(unit.textures[target_index], texture))
+		glBindTexture(target, texture);
+}
+
+void
+bonobo::state::bindTextureToUnit(GLuint unit, GLenum target, GLuint texture)
+{
+	activeTexture(GL_TEXTURE0 + unit);
+	bindTexture(target, texture);
+}
+
+void
+bonobo::state::bindSampler(GLuint unit, GLuint sampler)
+{
+	if (update(get_unit(unit).sampler, sampler))
+		glBindSampler(unit, sampler);
+}
+
+void
+bonobo::state::bindFramebuffer(GLenum target, GLuint framebuffer)
+{
+	switch (target) {
+	case GL_DRAW_FRAMEBUFFER:
+		if (update(current.draw_framebuffer, framebuffer))
+			glBindFramebuffer(target, framebuffer);
+		break;
+	case GL_READ_FRAMEBUFFER:
+		if (update(current.read_framebuffer, framebuffer))
+			glBindFramebuffer(target, framebuffer);
+		break;
+	default:
+		if (current.draw_framebuffer == framebuffer && current.read_framebuffer == framebuffer) {
+			++counters.elided_calls_nb;
+			break;
+		}
+		current.draw_framebuffer = framebuffer;
+		current.read_framebuffer = framebuffer;
+		++counters.forwarded_calls_nb;
+		glBindFramebuffer(target, framebuffer);
+		break;
+	}
+}
+
+void
+bonobo::state::viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	std::array<GLint, 4> const value = {{ x, y, width, height }};
+	if (current.is_viewport_known && current.viewport == value) {
+		++counters.elided_calls_nb;
+		return;
+	}
+	current.is_viewport_known = true;
+	current.viewport = value;
+	++counters.forwarded_calls_nb;
+	glViewport(x, y, width, height);
+}
+
+void
+bonobo::state::enable(GLenum capability)
+{
+	auto const it = current.capabilities.find(capability);
+	if (it != current.capabilities.end() && it->second) {
+		++counters.elided_calls_nb;
+		return;
+	}
+	current.capabilities[capability] = true;
+	++counters.forwarded_calls_nb;
+	glEnable(capability);
+}
+
+void
+bonobo::state::disable(GLenum capability)
+{
+	auto const it = current.capabilities.find(capability);
+	if (it != current.capabilities.end() && !it->second) {
+		++counters.elided_calls_nb;
+		return;
+	}
+	current.capabilities[capability] = false;
+	++counters.forwarded_calls_nb;
+	glDisable(capability);
+}
+
+void
+bonobo::state::cullFace(GLenum mode)
+{
+	if (update(current.cull_face, mode))
+		glCullFace(mode);
+}
+
+void
+bonobo::state::polygonMode(GLenum face, GLenum mode)
+{
+	// Core profiles only accept GL_FRONT_AND_BACK; anything else is
+	// forwarded as is for OpenGL to report it.
+	if (face != GL_FRONT_AND_BACK) {
+		current.polygon_mode = unknown_enum;
+		++counters.forwarded_calls_nb;
+		glPolygonMode(face, mode);
+		return;
+	}
+	if (update(current.polygon_mode, mode))
+		glPolygonMode(face, mode);
+}
+
+void
+bonobo::state::depthFunc(GLenum func)
+{
+	if (update(current.depth_func, func))
+		glDepthFunc(func);
+}
+
+void
+bonobo::state::depthMask(GLboolean flag)
+{
+	if (current.is_depth_mask_known && current.depth_mask == flag) {
+		++counters.elided_calls_nb;
+		return;
+	}
+	current.is_depth_mask_known = true;
+	current.depth_mask = flag;
+	++counters.forwarded_calls_nb;
+	glDepthMask(flag);
+}
+
+void
+bonobo::state::blendEquationSeparate(GLenum mode_rgb, GLenum mode_alpha)
+{
+	std::array<GLenum, 2> const value = {{ mode_rgb, mode_alpha }};
+	if (update(current.blend_equations, value))
+		glBlendEquationSeparate(mode_rgb, mode_alpha);
+}
+
+void
+bonobo::state::blendFuncSeparate(GLenum source_rgb, GLenum destination_rgb,
+                                 GLenum source_alpha, GLenum destination_alpha)
+{
+	std::array<GLenum, 4> const value = {{ source_rgb, destination_rgb, source_alpha, destination_alpha }};
+	if (update(current.blend_funcs, value))
+		glBlendFuncSeparate(source_rgb, destination_rgb, source_alpha, destination_alpha);
+}
+
+// Deleting an object bound to the current context unbinds it, which is
+// mirrored here; otherwise a later object reusing the same name would
+// never get bound.
+
+void
+bonobo::state::deleteTextures(GLsizei n, GLuint const* textures)
+{
+	for (GLsizei i = 0; i < n; ++i)
+		for (auto& unit : current.units)
+			for (auto& texture : unit.textures)
+				if (texture == textures[i])
+					texture = 0u;
+	glDeleteTextures(n, textures);
+}
+
+void
+bonobo::state::deleteVertexArrays(GLsizei n, GLuint const* vaos)
+{
+	for (GLsizei i = 0; i < n; ++i)
+		if (current.vao == vaos[i])
+			current.vao = 0u;
+	glDeleteVertexArrays(n, vaos);
+}
+
+void
+bonobo::state::deleteSamplers(GLsizei n, GLuint const* samplers)
+{
+	for (GLsizei i = 0; i < n; ++i)
+		for (auto& unit : current.units)
+			if (unit.sampler == samplers[i])
+				unit.sampler = 0u;
+	glDeleteSamplers(n, samplers);
+}
+
+void
+bonobo::state::deleteFramebuffers(GLsizei n, GLuint const* framebuffers)
+{
+	for (GLsizei i = 0; i < n; ++i) {
+		if (current.draw_framebuffer == framebuffers[i])
+			current.draw_framebuffer = 0u;
+		if (current.read_framebuffer == framebuffers[i])
+			current.read_framebuffer = 0u;
+	}
+	glDeleteFramebuffers(n, framebuffers);
+}
+
+void
+bonobo::state::invalidate()
+{
+	current = tracked_state();
+}
+
+bonobo::state::statistics const&
+bonobo::state::getStatistics()
+{
+	return counters;
+}
+
+void
+bonobo::state::resetStatistics()
+{
+	counters = bonobo::state::statistics();
+}
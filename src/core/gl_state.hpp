@@ -0,0 +1,72 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstdint>
+
+namespace bonobo
+{
+	//! \brief Shadow of the OpenGL state most often changed while
+	//!        rendering, dropping the calls which would not change
+	//!        anything.
+	//!
+	//! Each function mirrors the OpenGL call of the same name, and only
+	//! forwards it if the value differs from the one last set through
+	//! this layer; until a value was set through it, it is considered
+	//! unknown and the call is always forwarded. Tracked are: the
+	//! program in use, the vertex array, the active texture unit and the
+	//! textures and samplers bound to each unit, the draw and read
+	//! framebuffers, the viewport, the enabled capabilities, and the
+	//! cull face, polygon mode, depth and blend settings.
+	//!
+	//! Everything has to happen on the thread owning the OpenGL context.
+	//! Code changing any of that state directly, such as the Dear ImGui
+	//! renderer, needs to call `invalidate()` afterwards; objects should
+	//! be deleted through the functions below, so that bindings to them
+	//! get reset as OpenGL does.
+	namespace state
+	{
+		//! \brief Number of calls that were forwarded to OpenGL, and that
+		//!        were dropped for being redundant.
+		struct statistics {
+			std::uint64_t forwarded_calls_nb{0u};
+			std::uint64_t elided_calls_nb{0u};
+		};
+
+		void useProgram(GLuint program);
+		void bindVertexArray(GLuint vao);
+		void activeTexture(GLenum unit);
+
+		//! \brief Bind |texture| to the active texture unit.
+		void bindTexture(GLenum target, GLuint texture);
+
+		//! \brief Make |unit| (from 0, rather than from GL_TEXTURE0) the
+		//!        active texture unit, and bind |texture| to it.
+		void bindTextureToUnit(GLuint unit, GLenum target, GLuint texture);
+
+		void bindSampler(GLuint unit, GLuint sampler);
+		void bindFramebuffer(GLenum target, GLuint framebuffer);
+		void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+		void enable(GLenum capability);
+		void disable(GLenum capability);
+		void cullFace(GLenum mode);
+		void polygonMode(GLenum face, GLenum mode);
+		void depthFunc(GLenum func);
+		void depthMask(GLboolean flag);
+		void blendEquationSeparate(GLenum mode_rgb, GLenum mode_alpha);
+		void blendFuncSeparate(GLenum source_rgb, GLenum destination_rgb,
+		                       GLenum source_alpha, GLenum destination_alpha);
+
+		void deleteTextures(GLsizei n, GLuint const* textures);
+		void deleteVertexArrays(GLsizei n, GLuint const* vaos);
+		void deleteSamplers(GLsizei n, GLuint const* samplers);
+		void deleteFramebuffers(GLsizei n, GLuint const* framebuffers);
+
+		//! \brief Forget everything, so that the next call for each piece
+		//!        of state gets forwarded.
+		void invalidate();
+
+		statistics const& getStatistics();
+		void resetStatistics();
+	}
+}
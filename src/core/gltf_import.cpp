@@ -0,0 +1,1145 @@
+#include "gltf_import.hpp"
+
+#include "core/Log.h"
+#include "core/various.hpp"
+
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	//! \brief Kinds of values found in a JSON document.
+	enum class json_type : std::uint8_t {
+		null,
+		boolean,
+		number,
+		string,
+		array,
+		object
+	};
+
+	//! \brief Value of a JSON document; arrays and objects refer to their
+	//!        elements by their index in the document.
+	struct json_node {
+		json_type type{json_type::null};
+		bool boolean{false};
+		double number{0.0};
+		std::string string;
+		std::vector<std::uint32_t> elements;
+		std::vector<std::pair<std::string, std::uint32_t>> members;
+	};
+
+	//! \brief Recursive-descent parser for RFC 8259 JSON, storing all
+	//!        values in a single array with the root first.
+	//!
+	//! Numbers are parsed by hand rather than with `std::strtod()`, whose
+	//! decimal separator depends on the current locale.
+	class json_parser
+	{
+	public:
+		json_parser(char const* text, std::size_t length, std::vector<json_node>& nodes)
+			: _begin(text), _position(text), _end(text + length), _nodes(nodes)
+		{
+		}
+
+		bool parse()
+		{
+			skip_whitespace();
+			if (!parse_value(0u))
+				return false;
+			skip_whitespace();
+			return _position == _end;
+		}
+
+		//! \brief Offset of the byte where parsing stopped.
+		std::size_t get_offset() const { return static_cast<std::size_t>(_position - _begin); }
+
+	private:
+		//! \brief Deepest nesting accepted, to keep the recursion bounded
+		//!        on malicious or corrupted files.
+		static unsigned int const max_depth = 256u;
+
+		void skip_whitespace()
+		{
+			while (_position != _end && (*_position == ' ' || *_position == '\t' || *_position == '\n' || *_position == '\r'))
+				++_position;
+		}
+
+		bool consume(char expected)
+		{
+			if (_position == _end || *_position != expected)
+				return false;
+			++_position;
+			return true;
+		}
+
+		bool consume_literal(char const* literal)
+		{
+			auto const length = std::strlen(literal);
+			if (static_cast<std::size_t>(_end - _position) < length || std::memcmp(_position, literal, length) != 0)
+				return false;
+			_position += length;
+			return true;
+		}
+
+		bool parse_value(unsigned int depth)
+		{
+			if (depth > max_depth || _position == _end)
+				return false;
+
+			// Children get appended to |_nodes| while parsing, so the node
+			// is always accessed through its index.
+			auto const index = static_cast<std::uint32_t>(_nodes.size());
+			_nodes.emplace_back();
+			switch (*_position) {
+				case '{':
+				{
+					++_position;
+					_nodes[index].type = json_type::object;
+					skip_whitespace();
+					if (consume('}'))
+						return true;
+					do {
+						skip_whitespace();
+						std::string key;
+						if (!parse_string(key))
+							return false;
+						skip_whitespace();
+						if (!consume(':'))
+							return false;
+						skip_whitespace();
+						auto const child = static_cast<std::uint32_t>(_nodes.size());
+						if (!parse_value(depth + 1u))
+							return false;
+						_nodes[index].members.emplace_back(std::move(key), child);
+						skip_whitespace();
+					} while (consume(','));
+					return consume('}');
+				}
+				case '[':
+				{
+					++_position;
+					_nodes[index].type = json_type::array;
+					skip_whitespace();
+					if (consume(']'))
+						return true;
+					do {
+						skip_whitespace();
+						auto const child = static_cast<std::uint32_t>(_nodes.size());
+						if (!parse_value(depth + 1u))
+							return false;
+						_nodes[index].elements.push_back(child);
+						skip_whitespace();
+					} while (consume(','));
+					return consume(']');
+				}
+				case '"':
+					_nodes[index].type = json_type::string;
+					return parse_string(_nodes[index].string);
+				case 't':
+					_nodes[index].type = json_type::boolean;
+					_nodes[index].boolean = true;
+					return consume_literal("true");
+				case 'f':
+					_nodes[index].type = json_type::boolean;
+					return consume_literal("false");
+				case 'n':
+					return consume_literal("null");
+				default:
+					_nodes[index].type = json_type::number;
+					return parse_number(_nodes[index].number);
+			}
+		}
+
+		bool parse_hex4(std::uint32_t& value)
+		{
+			if (_end - _position < 4)
+				return false;
+			value = 0u;
+			for (int i = 0; i < 4; ++i) {
+				auto const c = *_position++;
+				value <<= 4;
+				if (c >= '0' && c <= '9')
+					value |= static_cast<std::uint32_t>(c - '0');
+				else if (c >= 'a' && c <= 'f')
+					value |= static_cast<std::uint32_t>(c - 'a' + 10);
+				else if (c >= 'A' && c <= 'F')
+					value |= static_cast<std::uint32_t>(c - 'A' + 10);
+				else
+					return false;
+			}
+			return true;
+		}
+
+		static void append_utf8(std::uint32_t code_point, std::string& destination)
+		{
+			if (code_point < 0x80u) {
+				destination += static_cast<char>(code_point);
+			} else if (code_point < 0x800u) {
+				destination += static_cast<char>(0xC0u | (code_point >> 6));
+				destination += static_cast<char>(0x80u | (code_point & 0x3Fu));
+			} else if (code_point < 0x10000u) {
+				destination += static_cast<char>(0xE0u | (code_point >> 12));
+				destination += static_cast<char>(0x80u | ((code_point >> 6) & 0x3Fu));
+				destination += static_cast<char>(0x80u | (code_point & 0x3Fu));
+			} else {
+				destination += static_cast<char>(0xF0u | (code_point >> 18));
+				destination += static_cast<char>(0x80u | ((code_point >> 12) & 0x3Fu));
+				destination += static_cast<char>(0x80u | ((code_point >> 6) & 0x3Fu));
+				destination += static_cast<char>(0x80u | (code_point & 0x3Fu));
+			}
+		}
+
+		bool parse_string(std::string& value)
+		{
+			if (!consume('"'))
+				return false;
+			while (_position != _end) {
+				// Copy runs of plain characters at once.
+				auto const run_start = _position;
+				while (_position != _end && *_position != '"' && *_position != '\\')
+					++_position;
+				value.append(run_start, _position);
+				if (_position == _end)
+					return false;
+				if (*_position++ == '"')
+					return true;
+
+				if (_position == _end)
+					return false;
+				switch (*_position++) {
+					case '"':  value += '"';  break;
+					case '\\': value += '\\'; break;
+					case '/':  value += '/';  break;
+					case 'b':  value += '\b'; break;
+					case 'f':  value += '\f'; break;
+					case 'n':  value += '\n'; break;
+					case 'r':  value += '\r'; break;
+					case 't':  value += '\t'; break;
+					case 'u':
+					{
+						std::uint32_t code_point = 0u;
+						if (!parse_hex4(code_point))
+							return false;
+						// Characters outside of the basic multilingual plane
+						// are encoded as a pair of UTF-16 surrogates.
+						if (code_point >= 0xD800u && code_point < 0xDC00u) {
+							std::uint32_t low_surrogate = 0u;
+							if (!consume('\\') || !consume('u') || !parse_hex4(low_surrogate)
+							 || low_surrogate < 0xDC00u || low_surrogate >= 0xE000u)
+								return false;
+							code_point = 0x10000u + ((code_point - 0xD800u) << 10) + (low_surrogate - 0xDC00u);
+						}
+						append_utf8(code_point, value);
+						break;
+					}
+					default:
+						return false;
+				}
+			}
+			return false;
+		}
+
+		bool parse_number(double& value)
+		{
+			auto const is_digit = [this]() {
+				return _position != _end && *_position >= '0' && *_position <= '9';
+			};
+
+			bool const is_negative = consume('-');
+			if (!is_digit())
+				return false;
+
+			// Digits past what a 64-bit integer holds only shift the
+			// exponent, which is plenty for the precision of a double.
+			std::uint64_t mantissa = 0u;
+			int exponent = 0;
+			auto const accumulate = [&mantissa, &exponent](char digit, bool is_fractional) {
+				if (mantissa < (std::numeric_limits<std::uint64_t>::max() - 9u) / 10u) {
+					mantissa = mantissa * 10u + static_cast<std::uint64_t>(digit - '0');
+					if (is_fractional)
+						--exponent;
+				} else if (!is_fractional) {
+					++exponent;
+				}
+			};
+			while (is_digit())
+				accumulate(*_position++, false);
+			if (consume('.')) {
+				if (!is_digit())
+					return false;
+				while (is_digit())
+					accumulate(*_position++, true);
+			}
+			if (_position != _end && (*_position == 'e' || *_position == 'E')) {
+				++_position;
+				bool const is_exponent_negative = consume('-');
+				if (!is_exponent_negative)
+					consume('+');
+				if (!is_digit())
+					return false;
+				int explicit_exponent = 0;
+				while (is_digit()) {
+					if (explicit_exponent < 100000)
+						explicit_exponent = explicit_exponent * 10 + (*_position - '0');
+					++_position;
+				}
+				exponent += is_exponent_negative ? -explicit_exponent : explicit_exponent;
+			}
+
+			value = static_cast<double>(mantissa) * std::pow(10.0, static_cast<double>(exponent));
+			if (is_negative)
+				value = -value;
+			return true;
+		}
+
+		char const* _begin;
+		char const* _position;
+		char const* _end;
+		std::vector<json_node>& _nodes;
+	};
+
+	//! \brief Read-only handle to a value of a parsed JSON document.
+	//!
+	//! Looking up a missing member or element gives an invalid handle,
+	//! from which every accessor returns its fallback value, so optional
+	//! glTF properties can be read without checking each level.
+	class json_value
+	{
+	public:
+		json_value() = default;
+		json_value(std::vector<json_node> const* nodes, std::uint32_t index) : _nodes(nodes), _node(&(*nodes)[index])
+		{
+		}
+
+		bool is_valid() const { return _node != nullptr; }
+		bool is_array() const { return _node != nullptr && _node->type == json_type::array; }
+		bool is_object() const { return _node != nullptr && _node->type == json_type::object; }
+		bool is_string() const { return _node != nullptr && _node->type == json_type::string; }
+
+		std::size_t size() const
+		{
+			if (_node == nullptr)
+				return 0u;
+			return _node->type == json_type::array ? _node->elements.size() : _node->members.size();
+		}
+
+		json_value operator[](std::size_t index) const
+		{
+			if (!is_array() || index >= _node->elements.size())
+				return json_value();
+			return json_value(_nodes, _node->elements[index]);
+		}
+
+		json_value operator[](char const* key) const
+		{
+			if (!is_object())
+				return json_value();
+			for (auto const& member : _node->members)
+				if (member.first == key)
+					return json_value(_nodes, member.second);
+			return json_value();
+		}
+
+		double as_number(double fallback) const
+		{
+			return _node != nullptr && _node->type == json_type::number ? _node->number : fallback;
+		}
+
+		//! \brief Read a glTF index, i.e. a non-negative integer.
+		//!
+		//! @return the index, or ~0u if the value is missing or not an index
+		std::uint32_t as_index() const
+		{
+			auto const number = as_number(-1.0);
+			if (number < 0.0 || number >= static_cast<double>(~0u) || number != std::floor(number))
+				return ~0u;
+			return static_cast<std::uint32_t>(number);
+		}
+
+		bool as_bool(bool fallback) const
+		{
+			return _node != nullptr && _node->type == json_type::boolean ? _node->boolean : fallback;
+		}
+
+		std::string const& as_string() const
+		{
+			static std::string const empty;
+			return is_string() ? _node->string : empty;
+		}
+
+	private:
+		std::vector<json_node> const* _nodes{nullptr};
+		json_node const* _node{nullptr};
+	};
+
+	std::uint32_t const glb_magic = 0x46546C67u; // "glTF"
+	std::uint32_t const glb_json_chunk = 0x4E4F534Au; // "JSON"
+	std::uint32_t const glb_binary_chunk = 0x004E4942u; // "BIN\0"
+
+	//! \brief Content of a glTF buffer, pointing either into a mapped
+	//!        file or into data decoded from a data URI.
+	struct gltf_buffer {
+		utils::mapped_file file;
+		std::vector<std::uint8_t> decoded;
+		std::uint8_t const* data{nullptr};
+		std::size_t size{0u};
+	};
+
+	struct gltf_file {
+		std::string filename;
+		std::string parent_folder; //!< ends with a separator
+		utils::mapped_file container; //!< the .gltf or .glb file itself
+		std::vector<json_node> nodes;
+		json_value root;
+		std::uint8_t const* binary_chunk{nullptr}; //!< of a .glb file, if any
+		std::size_t binary_chunk_size{0u};
+		std::vector<gltf_buffer> buffers;
+	};
+
+	//! \brief Range of a buffer read by an accessor.
+	struct accessor_view {
+		std::uint8_t const* data{nullptr};
+		std::size_t count{0u};
+		std::size_t stride{0u};           //!< in bytes, between consecutive elements
+		std::uint32_t component_type{0u}; //!< e.g. GL_FLOAT, which glTF uses the values of
+		std::uint32_t components_nb{0u};
+		bool normalized{false};
+	};
+
+	bool has_suffix(std::string const& value, char const* suffix)
+	{
+		auto const length = std::strlen(suffix);
+		if (value.size() < length)
+			return false;
+		for (std::size_t i = 0u; i < length; ++i) {
+			auto const c = value[value.size() - length + i];
+			auto const lower = c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c;
+			if (lower != suffix[i])
+				return false;
+		}
+		return true;
+	}
+
+	std::uint32_t read_u32(std::uint8_t const* source)
+	{
+		std::uint32_t value;
+		std::memcpy(&value, source, sizeof(value));
+		return value;
+	}
+
+	//! \brief Turn the "%XX" escapes of a relative URI back into bytes.
+	std::string decode_uri(std::string const& uri)
+	{
+		std::string path;
+		path.reserve(uri.size());
+		for (std::size_t i = 0u; i < uri.size(); ++i) {
+			auto const hex_value = [](char c) {
+				if (c >= '0' && c <= '9') return c - '0';
+				if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+				if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+				return -1;
+			};
+			if (uri[i] == '%' && i + 2u < uri.size() && hex_value(uri[i + 1u]) >= 0 && hex_value(uri[i + 2u]) >= 0) {
+				path += static_cast<char>(hex_value(uri[i + 1u]) * 16 + hex_value(uri[i + 2u]));
+				i += 2u;
+			} else {
+				path += uri[i];
+			}
+		}
+		return path;
+	}
+
+	//! \brief Decode the payload of a base64 data URI.
+	//!
+	//! @param [in] uri of the form "data:<media type>;base64,<payload>"
+	//! @param [out] media_type e.g. "image/png"
+	//! @param [out] data the decoded payload
+	//! @return whether |uri| is a well-formed base64 data URI
+	bool decode_data_uri(std::string const& uri, std::string& media_type, std::vector<std::uint8_t>& data)
+	{
+		auto const marker = uri.find(";base64,");
+		if (uri.compare(0u, 5u, "data:") != 0 || marker == std::string::npos)
+			return false;
+		media_type = uri.substr(5u, marker - 5u);
+
+		auto const sextet = [](char c) -> int {
+			if (c >= 'A' && c <= 'Z') return c - 'A';
+			if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+			if (c >= '0' && c <= '9') return c - '0' + 52;
+			if (c == '+') return 62;
+			if (c == '/') return 63;
+			return -1;
+		};
+		data.clear();
+		data.reserve((uri.size() - marker) * 3u / 4u);
+		std::uint32_t bits = 0u;
+		int bits_nb = 0;
+		for (auto i = marker + 8u; i < uri.size() && uri[i] != '='; ++i) {
+			auto const value = sextet(uri[i]);
+			if (value < 0)
+				return false;
+			bits = (bits << 6) | static_cast<std::uint32_t>(value);
+			bits_nb += 6;
+			if (bits_nb >= 8) {
+				bits_nb -= 8;
+				data.push_back(static_cast<std::uint8_t>((bits >> bits_nb) & 0xFFu));
+			}
+		}
+		return true;
+	}
+
+	//! \brief Map the glTF file, and parse its JSON content.
+	bool open_file(std::string const& filename, gltf_file& file)
+	{
+		file.filename = filename;
+		auto const end_of_basedir = filename.find_last_of("/\\");
+		file.parent_folder = end_of_basedir != std::string::npos ? filename.substr(0u, end_of_basedir + 1u) : std::string("./");
+
+		file.container = utils::mapped_file(filename);
+		if (!file.container.is_open() || file.container.size() == 0u) {
+			LogError("Failed to open \"%s\".", filename.c_str());
+			return false;
+		}
+
+		auto const data = file.container.data();
+		auto const size = file.container.size();
+		char const* json = reinterpret_cast<char const*>(data);
+		std::size_t json_size = size;
+		if (size >= 12u && read_u32(data) == glb_magic) {
+			// Binary container: a 12-byte header, followed by the JSON
+			// chunk and an optional binary chunk, each of them starting
+			// with its length and type.
+			if (read_u32(data + 4u) != 2u || read_u32(data + 8u) > size || size < 20u
+			 || read_u32(data + 16u) != glb_json_chunk || read_u32(data + 12u) > size - 20u) {
+				LogError("\"%s\" is not a valid glTF 2.0 binary file.", filename.c_str());
+				return false;
+			}
+			json = reinterpret_cast<char const*>(data + 20u);
+			json_size = read_u32(data + 12u);
+
+			auto const binary_chunk_offset = 20u + ((json_size + 3u) & ~std::size_t(3u));
+			if (binary_chunk_offset + 8u <= size && read_u32(data + binary_chunk_offset + 4u) == glb_binary_chunk) {
+				file.binary_chunk = data + binary_chunk_offset + 8u;
+				file.binary_chunk_size = std::min<std::size_t>(read_u32(data + binary_chunk_offset), size - binary_chunk_offset - 8u);
+			}
+		}
+
+		json_parser parser(json, json_size, file.nodes);
+		if (!parser.parse()) {
+			LogError("Failed to parse the JSON content of \"%s\", around byte %zu.", filename.c_str(), parser.get_offset());
+			return false;
+		}
+		file.root = json_value(&file.nodes, 0u);
+		if (!file.root.is_object()) {
+			LogError("\"%s\" does not contain a glTF JSON object.", filename.c_str());
+			return false;
+		}
+
+		auto const& version = file.root["asset"]["version"].as_string();
+		if (version.compare(0u, 2u, "2.") != 0) {
+			LogWarning("\"%s\" uses glTF version \"%s\", instead of 2.x.", filename.c_str(), version.c_str());
+			return false;
+		}
+		auto const required_extensions = file.root["extensionsRequired"];
+		if (required_extensions.size() > 0u) {
+			LogWarning("\"%s\" requires the glTF extension \"%s\", which is not supported.",
+			           filename.c_str(), required_extensions[std::size_t(0u)].as_string().c_str());
+			return false;
+		}
+		return true;
+	}
+
+	bool load_buffers(gltf_file& file, std::vector<std::string>& dependencies)
+	{
+		auto const buffers = file.root["buffers"];
+		file.buffers.resize(buffers.size());
+		for (std::size_t i = 0u; i < buffers.size(); ++i) {
+			auto& buffer = file.buffers[i];
+			auto const byte_length = static_cast<std::size_t>(buffers[i]["byteLength"].as_number(0.0));
+			auto const& uri = buffers[i]["uri"].as_string();
+			std::string media_type;
+			if (uri.empty()) {
+				if (i != 0u || file.binary_chunk == nullptr) {
+					LogError("Buffer %zu of \"%s\" has no data.", i, file.filename.c_str());
+					return false;
+				}
+				buffer.data = file.binary_chunk;
+				buffer.size = file.binary_chunk_size;
+			} else if (decode_data_uri(uri, media_type, buffer.decoded)) {
+				buffer.data = buffer.decoded.data();
+				buffer.size = buffer.decoded.size();
+			} else {
+				auto const path = file.parent_folder + decode_uri(uri);
+				buffer.file = utils::mapped_file(path);
+				if (!buffer.file.is_open()) {
+					LogError("Failed to open \"%s\", buffer %zu of \"%s\".", path.c_str(), i, file.filename.c_str());
+					return false;
+				}
+				buffer.data = buffer.file.data();
+				buffer.size = buffer.file.size();
+				dependencies.push_back(path);
+			}
+			if (buffer.size < byte_length) {
+				LogError("Buffer %zu of \"%s\" holds %zu bytes instead of %zu.", i, file.filename.c_str(), buffer.size, byte_length);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::uint32_t get_component_size(std::uint32_t component_type)
+	{
+		switch (component_type) {
+			case GL_BYTE:
+			case GL_UNSIGNED_BYTE:
+				return 1u;
+			case GL_SHORT:
+			case GL_UNSIGNED_SHORT:
+				return 2u;
+			case GL_UNSIGNED_INT:
+			case GL_FLOAT:
+				return 4u;
+			default:
+				return 0u;
+		}
+	}
+
+	std::uint32_t get_components_nb(std::string const& type)
+	{
+		if (type == "SCALAR") return 1u;
+		if (type == "VEC2") return 2u;
+		if (type == "VEC3") return 3u;
+		if (type == "VEC4") return 4u;
+		return 0u;
+	}
+
+	//! \brief Locate the elements read by an accessor, checking that they
+	//!        lie within their buffer.
+	bool get_accessor(gltf_file const& file, std::uint32_t index, accessor_view& view)
+	{
+		auto const accessor = file.root["accessors"][index];
+		if (!accessor.is_object()) {
+			LogError("Accessor %u of \"%s\" does not exist.", index, file.filename.c_str());
+			return false;
+		}
+		if (accessor["sparse"].is_valid()) {
+			LogWarning("Accessor %u of \"%s\" is sparse, which is not supported.", index, file.filename.c_str());
+			return false;
+		}
+
+		view.count = static_cast<std::size_t>(accessor["count"].as_number(0.0));
+		view.component_type = accessor["componentType"].as_index();
+		view.components_nb = get_components_nb(accessor["type"].as_string());
+		view.normalized = accessor["normalized"].as_bool(false);
+		auto const component_size = get_component_size(view.component_type);
+		auto const buffer_view = file.root["bufferViews"][accessor["bufferView"].as_index()];
+		auto const buffer_index = buffer_view["buffer"].as_index();
+		if (component_size == 0u || view.components_nb == 0u || !buffer_view.is_object() || buffer_index >= file.buffers.size()) {
+			LogError("Accessor %u of \"%s\" is invalid or not supported.", index, file.filename.c_str());
+			return false;
+		}
+
+		auto const element_size = static_cast<std::size_t>(component_size) * view.components_nb;
+		auto const view_offset = static_cast<std::size_t>(buffer_view["byteOffset"].as_number(0.0));
+		auto const view_length = static_cast<std::size_t>(buffer_view["byteLength"].as_number(0.0));
+		auto const accessor_offset = static_cast<std::size_t>(accessor["byteOffset"].as_number(0.0));
+		auto const stride = static_cast<std::size_t>(buffer_view["byteStride"].as_number(0.0));
+		view.stride = stride != 0u ? stride : element_size;
+
+		auto const& buffer = file.buffers[buffer_index];
+		auto const read_size = view.count == 0u ? 0u : accessor_offset + view.stride * (view.count - 1u) + element_size;
+		if (view_offset > buffer.size || view_length > buffer.size - view_offset || read_size > view_length) {
+			LogError("Accessor %u of \"%s\" reads past the end of its buffer.", index, file.filename.c_str());
+			return false;
+		}
+		view.data = buffer.data + view_offset + accessor_offset;
+		return true;
+	}
+
+	float read_component(std::uint8_t const* source, std::uint32_t component_type, bool normalized)
+	{
+		// Normalised integers follow the conversion rules of the glTF
+		// specification, which match those of OpenGL.
+		switch (component_type) {
+			case GL_BYTE:
+			{
+				auto const value = static_cast<std::int8_t>(*source);
+				return normalized ? std::max(static_cast<float>(value) / 127.0f, -1.0f) : static_cast<float>(value);
+			}
+			case GL_UNSIGNED_BYTE:
+				return normalized ? static_cast<float>(*source) / 255.0f : static_cast<float>(*source);
+			case GL_SHORT:
+			{
+				std::int16_t value;
+				std::memcpy(&value, source, sizeof(value));
+				return normalized ? std::max(static_cast<float>(value) / 32767.0f, -1.0f) : static_cast<float>(value);
+			}
+			case GL_UNSIGNED_SHORT:
+			{
+				std::uint16_t value;
+				std::memcpy(&value, source, sizeof(value));
+				return normalized ? static_cast<float>(value) / 65535.0f : static_cast<float>(value);
+			}
+			case GL_UNSIGNED_INT:
+				return static_cast<float>(read_u32(source));
+			default:
+			{
+				float value;
+				std::memcpy(&value, source, sizeof(value));
+				return value;
+			}
+		}
+	}
+
+	//! \brief Copy the elements of an accessor into a stream of
+	//!        |components_nb| floats per element.
+	//!
+	//! Components missing from the accessor are left untouched, and extra
+	//! ones are dropped. Tightly packed floats with the same number of
+	//! components, the usual case for positions and normals, are copied
+	//! with a single `memcpy()`.
+	void copy_floats(accessor_view const& accessor, std::uint32_t components_nb, float* destination)
+	{
+		auto const element_size = static_cast<std::size_t>(components_nb) * sizeof(float);
+		if (accessor.component_type == GL_FLOAT && accessor.components_nb == components_nb && accessor.stride == element_size) {
+			std::memcpy(destination, accessor.data, accessor.count * element_size);
+			return;
+		}
+
+		auto const component_size = get_component_size(accessor.component_type);
+		auto const copied_nb = std::min(accessor.components_nb, components_nb);
+		for (std::size_t i = 0u; i < accessor.count; ++i) {
+			auto const source = accessor.data + i * accessor.stride;
+			for (std::uint32_t k = 0u; k < copied_nb; ++k)
+				destination[i * components_nb + k] = read_component(source + k * component_size, accessor.component_type, accessor.normalized);
+		}
+	}
+
+	bool copy_indices(accessor_view const& accessor, std::vector<std::uint32_t>& indices)
+	{
+		if (accessor.components_nb != 1u
+		 || (accessor.component_type != GL_UNSIGNED_BYTE && accessor.component_type != GL_UNSIGNED_SHORT && accessor.component_type != GL_UNSIGNED_INT))
+			return false;
+
+		indices.resize(accessor.count);
+		if (accessor.component_type == GL_UNSIGNED_INT && accessor.stride == sizeof(std::uint32_t)) {
+			std::memcpy(indices.data(), accessor.data, accessor.count * sizeof(std::uint32_t));
+			return true;
+		}
+		for (std::size_t i = 0u; i < accessor.count; ++i)
+			indices[i] = static_cast<std::uint32_t>(read_component(accessor.data + i * accessor.stride, accessor.component_type, false));
+		return true;
+	}
+
+	//! \brief Turn the indices of a glTF primitive into points, lines or
+	//!        triangles, as `aiProcess_Triangulate` would.
+	//!
+	//! @param [in] mode of the primitive, as defined by glTF
+	//! @param [in,out] indices of the primitive, replaced by those of the
+	//!                 list of points, lines or triangles
+	//! @param [out] drawing_mode to use for the new indices
+	//! @return whether |mode| is known
+	bool convert_to_lists(std::uint32_t mode, std::vector<std::uint32_t>& indices, GLenum& drawing_mode)
+	{
+		std::vector<std::uint32_t> lists;
+		auto const count = indices.size();
+		switch (mode) {
+			case 0u: // points
+				drawing_mode = GL_POINTS;
+				return true;
+			case 1u: // lines
+				drawing_mode = GL_LINES;
+				indices.resize(count - count % 2u);
+				return true;
+			case 2u: // line loop
+			case 3u: // line strip
+				drawing_mode = GL_LINES;
+				for (std::size_t i = 0u; i + 1u < count; ++i) {
+					lists.push_back(indices[i]);
+					lists.push_back(indices[i + 1u]);
+				}
+				if (mode == 2u && count > 2u) {
+					lists.push_back(indices[count - 1u]);
+					lists.push_back(indices[0u]);
+				}
+				break;
+			case 4u: // triangles
+				drawing_mode = GL_TRIANGLES;
+				indices.resize(count - count % 3u);
+				return true;
+			case 5u: // triangle strip
+				drawing_mode = GL_TRIANGLES;
+				// Every other triangle is flipped to keep the winding.
+				for (std::size_t i = 0u; i + 2u < count; ++i) {
+					lists.push_back(indices[i]);
+					lists.push_back(indices[i + 1u + i % 2u]);
+					lists.push_back(indices[i + 2u - i % 2u]);
+				}
+				break;
+			case 6u: // triangle fan
+				drawing_mode = GL_TRIANGLES;
+				for (std::size_t i = 0u; i + 2u < count; ++i) {
+					lists.push_back(indices[i + 1u]);
+					lists.push_back(indices[i + 2u]);
+					lists.push_back(indices[0u]);
+				}
+				break;
+			default:
+				return false;
+		}
+		indices = std::move(lists);
+		return true;
+	}
+
+	//! \brief Compute per-vertex tangents and binormals from the texture
+	//!        coordinates, as `aiProcess_CalcTangentSpace` would.
+	void compute_tangents(bonobo::imported_mesh& mesh)
+	{
+		auto const vertices_nb = mesh.vertices.size();
+		mesh.tangents.assign(vertices_nb, glm::vec3(0.0f));
+		mesh.binormals.assign(vertices_nb, glm::vec3(0.0f));
+		for (std::size_t i = 0u; i + 2u < mesh.indices.size(); i += 3u) {
+			auto const a = mesh.indices[i], b = mesh.indices[i + 1u], c = mesh.indices[i + 2u];
+			auto const edge1 = mesh.vertices[b] - mesh.vertices[a];
+			auto const edge2 = mesh.vertices[c] - mesh.vertices[a];
+			auto const uv1 = mesh.texcoords[b] - mesh.texcoords[a];
+			auto const uv2 = mesh.texcoords[c] - mesh.texcoords[a];
+			auto const determinant = uv1.x * uv2.y - uv2.x * uv1.y;
+			if (std::abs(determinant) < 1e-12f)
+				continue;
+			auto const tangent = (edge1 * uv2.y - edge2 * uv1.y) / determinant;
+			auto const binormal = (edge2 * uv1.x - edge1 * uv2.x) / determinant;
+			for (auto const vertex : { a, b, c }) {
+				mesh.tangents[vertex] += tangent;
+				mesh.binormals[vertex] += binormal;
+			}
+		}
+
+		// Make the basis orthogonal to the normal, keeping the handedness
+		// given by the texture coordinates.
+		for (std::size_t i = 0u; i < vertices_nb; ++i) {
+			auto const& normal = mesh.normals[i];
+			auto tangent = mesh.tangents[i] - normal * glm::dot(normal, mesh.tangents[i]);
+			if (glm::dot(tangent, tangent) < 1e-20f) {
+				// Any direction orthogonal to the normal will do.
+				tangent = std::abs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+				tangent -= normal * glm::dot(normal, tangent);
+			}
+			tangent = glm::normalize(tangent);
+			auto const binormal = glm::cross(normal, tangent);
+			mesh.tangents[i] = tangent;
+			mesh.binormals[i] = glm::dot(binormal, mesh.binormals[i]) < 0.0f ? -binormal : binormal;
+		}
+	}
+
+	bool process_primitive(gltf_file const& file, json_value const& primitive, std::string const& name,
+	                       bonobo::imported_mesh& mesh)
+	{
+		mesh.name = name;
+		auto const attributes = primitive["attributes"];
+		auto const position_index = attributes["POSITION"].as_index();
+		if (position_index == ~0u) {
+			LogError("Unsupported mesh \"%s\": has no positions", name.c_str());
+			return false;
+		}
+		accessor_view positions;
+		if (!get_accessor(file, position_index, positions))
+			return false;
+		if (positions.count == 0u || positions.count > std::numeric_limits<std::uint32_t>::max()) {
+			LogError("Unsupported mesh \"%s\": has %zu vertices", name.c_str(), positions.count);
+			return false;
+		}
+		auto const vertices_nb = positions.count;
+
+		// Optional attributes are dropped if they can not be read, rather
+		// than losing the whole mesh.
+		auto const read_attribute = [&](char const* semantic, std::uint32_t components_nb, std::vector<glm::vec3>& stream,
+		                                std::vector<float>* extra = nullptr) {
+			auto const index = attributes[semantic].as_index();
+			accessor_view accessor;
+			if (index == ~0u || !get_accessor(file, index, accessor))
+				return false;
+			if (accessor.count != vertices_nb) {
+				LogWarning("Mesh \"%s\" has %zu %s values for %zu vertices; ignoring them.",
+				           name.c_str(), accessor.count, semantic, vertices_nb);
+				return false;
+			}
+			if (extra == nullptr) {
+				stream.assign(vertices_nb, glm::vec3(0.0f));
+				copy_floats(accessor, components_nb, &stream[0].x);
+			} else {
+				extra->assign(vertices_nb * components_nb, 0.0f);
+				copy_floats(accessor, components_nb, extra->data());
+			}
+			return true;
+		};
+
+		mesh.vertices.resize(vertices_nb);
+		copy_floats(positions, 3u, &mesh.vertices[0].x);
+		read_attribute("NORMAL", 3u, mesh.normals);
+
+		std::vector<float> texcoords;
+		if (read_attribute("TEXCOORD_0", 2u, mesh.texcoords, &texcoords)) {
+			// glTF puts the origin of texture coordinates at the top-left
+			// corner of images, while they get loaded bottom-up.
+			mesh.texcoords.resize(vertices_nb);
+			for (std::size_t i = 0u; i < vertices_nb; ++i)
+				mesh.texcoords[i] = glm::vec3(texcoords[2u * i], 1.0f - texcoords[2u * i + 1u], 0.0f);
+		}
+
+		std::vector<float> tangents;
+		if (!mesh.normals.empty() && read_attribute("TANGENT", 4u, mesh.tangents, &tangents)) {
+			// The fourth component gives the handedness of the basis in
+			// glTF's texture space, whose vertical axis got flipped above.
+			mesh.tangents.resize(vertices_nb);
+			mesh.binormals.resize(vertices_nb);
+			for (std::size_t i = 0u; i < vertices_nb; ++i) {
+				mesh.tangents[i] = glm::vec3(tangents[4u * i], tangents[4u * i + 1u], tangents[4u * i + 2u]);
+				mesh.binormals[i] = glm::cross(mesh.normals[i], mesh.tangents[i]) * -tangents[4u * i + 3u];
+			}
+		}
+
+		auto const indices_index = primitive["indices"].as_index();
+		if (indices_index != ~0u) {
+			accessor_view indices;
+			if (!get_accessor(file, indices_index, indices) || !copy_indices(indices, mesh.indices)) {
+				LogError("Unsupported mesh \"%s\": its indices can not be read", name.c_str());
+				return false;
+			}
+			if (std::any_of(mesh.indices.begin(), mesh.indices.end(),
+			                [vertices_nb](std::uint32_t index) { return index >= vertices_nb; })) {
+				LogError("Unsupported mesh \"%s\": has indices past its %zu vertices", name.c_str(), vertices_nb);
+				return false;
+			}
+		} else {
+			mesh.indices.resize(vertices_nb);
+			for (std::size_t i = 0u; i < vertices_nb; ++i)
+				mesh.indices[i] = static_cast<std::uint32_t>(i);
+		}
+
+		auto const mode = static_cast<std::uint32_t>(primitive["mode"].as_number(4.0));
+		if (!convert_to_lists(mode, mesh.indices, mesh.drawing_mode)) {
+			LogError("Unsupported mesh \"%s\": uses primitive mode %u", name.c_str(), mode);
+			return false;
+		}
+		if (mesh.indices.empty()) {
+			LogError("Unsupported mesh \"%s\": has no faces", name.c_str());
+			return false;
+		}
+
+		if (mesh.drawing_mode == GL_TRIANGLES && mesh.tangents.empty() && !mesh.normals.empty() && !mesh.texcoords.empty())
+			compute_tangents(mesh);
+
+		return true;
+	}
+
+	//! \brief Write |data| to |path|, unless the file already holds it.
+	bool write_if_changed(std::string const& path, std::uint8_t const* data, std::size_t size)
+	{
+		{
+			utils::mapped_file const existing(path);
+			if (existing.is_open() && existing.size() == size && (size == 0u || std::memcmp(existing.data(), data, size) == 0))
+				return true;
+		}
+
+		std::ofstream output(utils::widen(path), std::ios::binary | std::ios::trunc);
+		output.write(reinterpret_cast<char const*>(data), static_cast<std::streamsize>(size));
+		return static_cast<bool>(output);
+	}
+
+	//! \brief Find the image used by a glTF texture, extracting it next to
+	//!        the glTF file if it is embedded.
+	//!
+	//! @return the path of the image relative to the folder of the glTF
+	//!         file, or an empty string if it can not be used
+	std::string resolve_texture(gltf_file const& file, json_value const& texture_info)
+	{
+		auto const texture_index = texture_info["index"].as_index();
+		if (texture_index == ~0u)
+			return std::string();
+		if (texture_info["texCoord"].as_number(0.0) != 0.0)
+			LogWarning("Texture %u of \"%s\" uses a second set of texture coordinates, which is not supported.",
+			           texture_index, file.filename.c_str());
+
+		auto const image_index = file.root["textures"][texture_index]["source"].as_index();
+		auto const image = file.root["images"][image_index];
+		if (!image.is_object()) {
+			LogWarning("Texture %u of \"%s\" has no supported image.", texture_index, file.filename.c_str());
+			return std::string();
+		}
+
+		auto const& uri = image["uri"].as_string();
+		std::string media_type = image["mimeType"].as_string();
+		std::vector<std::uint8_t> decoded;
+		std::uint8_t const* data = nullptr;
+		std::size_t size = 0u;
+		if (!uri.empty() && !decode_data_uri(uri, media_type, decoded))
+			return decode_uri(uri);
+		if (!uri.empty()) {
+			data = decoded.data();
+			size = decoded.size();
+		} else {
+			auto const buffer_view = file.root["bufferViews"][image["bufferView"].as_index()];
+			auto const buffer_index = buffer_view["buffer"].as_index();
+			auto const offset = static_cast<std::size_t>(buffer_view["byteOffset"].as_number(0.0));
+			size = static_cast<std::size_t>(buffer_view["byteLength"].as_number(0.0));
+			if (buffer_index >= file.buffers.size() || offset > file.buffers[buffer_index].size
+			 || size > file.buffers[buffer_index].size - offset) {
+				LogWarning("Image %u of \"%s\" lies outside of its buffer.", image_index, file.filename.c_str());
+				return std::string();
+			}
+			data = file.buffers[buffer_index].data + offset;
+		}
+
+		char const* extension = nullptr;
+		if (media_type == "image/png")
+			extension = "png";
+		else if (media_type == "image/jpeg")
+			extension = "jpg";
+		if (extension == nullptr || size == 0u) {
+			LogWarning("Image %u of \"%s\" is of type \"%s\", which is not supported.",
+			           image_index, file.filename.c_str(), media_type.c_str());
+			return std::string();
+		}
+
+		auto const scene_name = file.filename.substr(file.filename.find_last_of("/\\") + 1u);
+		auto const image_name = scene_name + ".image" + std::to_string(image_index) + "." + extension;
+		if (!write_if_changed(file.parent_folder + image_name, data, size)) {
+			LogWarning("Failed to extract image %u of \"%s\" to \"%s\".",
+			           image_index, file.filename.c_str(), (file.parent_folder + image_name).c_str());
+			return std::string();
+		}
+		return image_name;
+	}
+
+	//! \brief Approximate a metallic-roughness material with the constants
+	//!        used by the shaders, which are those of a Blinn-Phong model.
+	void process_material(gltf_file const& file, json_value const& material, std::size_t index,
+	                      bonobo::material_description& description)
+	{
+		description.name = material["name"].as_string();
+		if (description.name.empty())
+			description.name = "material" + std::to_string(index);
+
+		auto const read_vec = [](json_value const& values, glm::vec4 value) {
+			for (glm::length_t i = 0; i < 4; ++i)
+				value[i] = static_cast<float>(values[static_cast<std::size_t>(i)].as_number(value[i]));
+			return value;
+		};
+		auto const pbr = material["pbrMetallicRoughness"];
+		auto const base_colour = read_vec(pbr["baseColorFactor"], glm::vec4(1.0f));
+		auto const metallic = static_cast<float>(pbr["metallicFactor"].as_number(1.0));
+		auto const roughness = static_cast<float>(pbr["roughnessFactor"].as_number(1.0));
+		auto const emissive = read_vec(material["emissiveFactor"], glm::vec4(0.0f));
+		auto const emissive_strength = static_cast<float>(material["extensions"]["KHR_materials_emissive_strength"]["emissiveStrength"].as_number(1.0));
+
+		// Metals have no diffuse reflection, and reflect their base colour
+		// specularly; dielectrics reflect about 4% at normal incidence.
+		auto& constants = description.constants;
+		auto const colour = glm::vec3(base_colour);
+		constants.diffuse = colour * (1.0f - metallic);
+		constants.specular = glm::mix(glm::vec3(0.04f), colour, metallic);
+		constants.emissive = glm::vec3(emissive) * emissive_strength;
+		// Blinn-Phong exponent giving a similar highlight to a GGX lobe of
+		// roughness alpha = roughness².
+		auto const alpha = std::max(roughness * roughness, 0.03f);
+		constants.shininess = std::max(2.0f / (alpha * alpha) - 2.0f, 1.0f);
+		constants.indexOfRefraction = static_cast<float>(material["extensions"]["KHR_materials_ior"]["ior"].as_number(1.5));
+		constants.opacity = material["alphaMode"].as_string() == "BLEND" ? base_colour.w : 1.0f;
+
+		auto const add_texture = [&file, &description](json_value const& texture_info, char const* type_name, char const* sampler_name) {
+			if (!texture_info.is_valid())
+				return;
+			auto const path = resolve_texture(file, texture_info);
+			if (!path.empty())
+				description.textures.push_back({ sampler_name, type_name, path });
+		};
+		add_texture(pbr["baseColorTexture"], "diffuse", "diffuse_texture");
+		add_texture(material["normalTexture"], "normals", "normals_texture");
+	}
+}
+
+bool
+bonobo::isGltfFile(std::string const& filename)
+{
+	return has_suffix(filename, ".gltf") || has_suffix(filename, ".glb");
+}
+
+bool
+bonobo::importGltfScene(std::string const& filename, imported_scene& scene)
+{
+	scene = imported_scene();
+	scene.dependencies.push_back(filename);
+
+	gltf_file file;
+	if (!open_file(filename, file))
+		return false;
+
+	// Sparse accessors are not supported; rather than dropping the
+	// primitives using them, leave the whole file to assimp.
+	auto const accessors = file.root["accessors"];
+	for (std::size_t i = 0u; i < accessors.size(); ++i)
+		if (accessors[i]["sparse"].is_valid()) {
+			LogInfo("Accessor %zu of \"%s\" is sparse, which is not supported.", i, filename.c_str());
+			return false;
+		}
+
+	if (!load_buffers(file, scene.dependencies))
+		return false;
+
+	auto const meshes = file.root["meshes"];
+	auto const materials = file.root["materials"];
+
+	// Only keep the materials which are referenced by at least one
+	// primitive, and remap the indices accordingly; primitives without a
+	// material get the default one from the specification.
+	std::vector<std::uint32_t> material_remapping(materials.size() + 1u, ~0u);
+	auto const get_material = [&](std::uint32_t material_index) {
+		auto const slot = material_index < materials.size() ? material_index : static_cast<std::uint32_t>(materials.size());
+		if (material_remapping[slot] == ~0u) {
+			material_remapping[slot] = static_cast<std::uint32_t>(scene.materials.size());
+			scene.materials.emplace_back();
+			auto& description = scene.materials.back();
+			process_material(file, materials[slot], slot, description);
+			if (slot == materials.size()) {
+				// The default material of the specification is fully
+				// metallic, which renders black without any environment
+				// lighting; use a white dielectric instead, as assimp does.
+				description.name = "default";
+				description.constants.diffuse = glm::vec3(1.0f);
+				description.constants.specular = glm::vec3(0.04f);
+			}
+		}
+		return material_remapping[slot];
+	};
+
+	for (std::size_t j = 0u; j < meshes.size(); ++j) {
+		auto const primitives = meshes[j]["primitives"];
+		auto name = meshes[j]["name"].as_string();
+		if (name.empty())
+			name = "mesh" + std::to_string(j);
+		for (std::size_t k = 0u; k < primitives.size(); ++k) {
+			imported_mesh mesh;
+			if (!process_primitive(file, primitives[k], primitives.size() > 1u ? name + "-" + std::to_string(k) : name, mesh))
+				continue;
+			mesh.material_index = get_material(primitives[k]["material"].as_index());
+			scene.meshes.push_back(std::move(mesh));
+		}
+	}
+
+	if (scene.meshes.empty()) {
+		LogError("No mesh available; loading \"%s\" must have had issues", filename.c_str());
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "core/mesh_import.hpp"
+
+#include <string>
+
+namespace bonobo
+{
+	//! \brief Whether |filename| is a glTF 2.0 file, i.e. ends with
+	//!        ".gltf" or ".glb", which `importGltfScene()` can read.
+	bool isGltfFile(std::string const& filename);
+
+	//! \brief Read a glTF 2.0 file (JSON or binary) without going through
+	//!        assimp; no OpenGL call is made.
+	//!
+	//! The buffers are mapped, and the ranges covered by the accessors of
+	//! each primitive are copied in bulk into the vertex streams and
+	//! indices, which end up as assimp would have produced them with
+	//! `aiProcess_Triangulate | aiProcess_SortByPType |
+	//! aiProcess_CalcTangentSpace`: one mesh per primitive, in the space of
+	//! the mesh, with strips and fans turned into lists and tangents
+	//! computed when missing. The metallic-roughness materials get
+	//! approximated by `material_data` constants, and their base colour and
+	//! normal textures referenced by path.
+	//!
+	//! Images embedded in the file are extracted next to it, as
+	//! "<filename>.image<index>.png" or ".jpg", so that they go through
+	//! the same decoding and caching as any other texture. Sparse
+	//! accessors and required extensions are not supported; files using
+	//! them are rejected so that the caller can fall back to
+	//! `importScene()`.
+	//!
+	//! @param [in] filename of the glTF file to load
+	//! @param [out] scene filled in with the imported materials and meshes
+	//! @return whether the file could be imported
+	bool importGltfScene(std::string const& filename, imported_scene& scene);
+}
@@ -2,20 +2,40 @@
 #include "config.hpp"
 
 #include "core/Log.h"
+#include "core/gl_state.hpp"
+#include "core/gltf_import.hpp"
+#include "core/mesh_cache.hpp"
+#include "core/mesh_import.hpp"
+#include "core/mesh_optimisation.hpp"
+#include "core/mipmap.hpp"
 #include "core/opengl.hpp"
+#include "core/render_queue.hpp"
+#include "core/texture_compression.hpp"
+#include "core/texture_upload_ring.hpp"
+#include "core/thread_pool.hpp"
 #include "core/various.hpp"
 
-#include <assimp/Importer.hpp>
 #include <assimp/postprocess.h>
-#include <assimp/scene.h>
 #include <glm/gtc/type_ptr.hpp>
 #include <imgui.h>
 #include <stb_image.h>
 
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <chrono>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <limits>
 #include <memory>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
 
 namespace {
 struct {
@@ -34,6 +54,27 @@ struct {
 
 GLuint debug_texture_id{0u};
 
+// Textures loaded from files are shared between all their users: they
+// are identified by the canonical path of the file and by the options
+// that were used to load them.
+struct registered_texture {
+  GLuint id{0u};
+  std::size_t references_nb{0u};
+  std::size_t memory_size{0u}; // in bytes, including the mipmap chain
+};
+struct {
+  std::unordered_map<std::string, registered_texture> textures;
+  std::unordered_map<GLuint, std::string> keys;
+  std::size_t memory_saved{0u}; // in bytes, over the whole run
+} texture_registry;
+
+// Staging memory for textures decoded on worker threads; a 1024×1024
+// RGBA texture with its mipmap chain, or a 2048×2048 BC3 one, fits in a
+// slot. Larger textures are uploaded from client memory.
+std::size_t const texture_upload_slot_size = 8u * 1024u * 1024u;
+std::size_t const texture_upload_slots_nb = 4u;
+std::unique_ptr<bonobo::texture_upload_ring> shared_texture_upload_ring;
+
 void setupBasisData();
 void createDebugTexture();
 } // namespace
@@ -60,384 +101,1602 @@ void bonobo::init() {
 }
 
 void bonobo::deinit() {
-  glDeleteTextures(1, &debug_texture_id);
+  bonobo::state::deleteTextures(1, &debug_texture_id);
   debug_texture_id = 0u;
 
+  auto const stats = getTextureRegistryStats();
+  if (stats.memory_saved > 0u)
+    LogInfo("Sharing textures loaded from files saved %.1f MiB of video "
+            "memory; %zu of them were still in use.",
+            static_cast<float>(stats.memory_saved) / (1024.0f * 1024.0f),
+            stats.textures_nb);
+  for (auto const &entry : texture_registry.textures)
+    bonobo::state::deleteTextures(1, &entry.second.id);
+  texture_registry.textures.clear();
+  texture_registry.keys.clear();
+  shared_texture_upload_ring.reset();
+  texture_registry.memory_saved = 0u;
+  bonobo::releaseDrawUniforms();
+
   glDeleteProgram(basis.shader);
   glDeleteBuffers(1, &basis.ibo);
   glDeleteBuffers(1, &basis.vbo);
-  glDeleteVertexArrays(1, &basis.vao);
+  bonobo::state::deleteVertexArrays(1, &basis.vao);
 
   glDeleteProgram(local::fullscreen_shader);
-  glDeleteVertexArrays(1, &local::display_vao);
+  bonobo::state::deleteVertexArrays(1, &local::display_vao);
 }
 
-static std::vector<std::uint8_t> getTextureData(std::string const &filename,
-                                                std::uint32_t &width,
-                                                std::uint32_t &height,
-                                                bool flip) {
+namespace {
+// From EXT_texture_compression_s3tc, which the loader was not generated
+// with.
+GLenum const compressed_rgb_s3tc_dxt1 = 0x83F0;
+GLenum const compressed_rgba_s3tc_dxt5 = 0x83F3;
+
+// Texels as decoded by stb_image, owned without being copied into a
+// container of their own.
+class decoded_pixels {
+public:
+  decoded_pixels() = default;
+  decoded_pixels(std::uint8_t *pixels, std::size_t size,
+                 void (*deleter)(void *))
+      : _pixels(pixels, deleter), _size(pixels != nullptr ? size : 0u) {}
+  decoded_pixels(decoded_pixels &&other) noexcept
+      : _pixels(std::move(other._pixels)), _size(other._size) {
+    other._size = 0u;
+  }
+  decoded_pixels &operator=(decoded_pixels &&other) noexcept {
+    _pixels = std::move(other._pixels);
+    _size = other._size;
+    other._size = 0u;
+    return *this;
+  }
+
+  std::uint8_t const *data() const { return _pixels.get(); }
+  std::size_t size() const { return _size; }
+  bool empty() const { return _size == 0u; }
+  void clear() {
+    _pixels.reset();
+    _size = 0u;
+  }
+
+private:
+  std::unique_ptr<std::uint8_t, void (*)(void *)> _pixels{nullptr,
+                                                          &std::free};
+  std::size_t _size{0u};
+};
+
+// Decodes the image from a mapping of its file, so that its encoded
+// bytes are not copied either.
+decoded_pixels getTextureData(std::string const &filename,
+                              std::uint32_t &width, std::uint32_t &height,
+                              bool flip, bool *is_decoded = nullptr) {
   auto const channels_nb = 4u;
-  stbi_set_flip_vertically_on_load_thread(flip ? 1 : 0);
-  unsigned char *image_data =
-      stbi_load(filename.c_str(), reinterpret_cast<int *>(&width),
-                reinterpret_cast<int *>(&height), nullptr, channels_nb);
+  std::uint8_t *image_data = nullptr;
+  utils::mapped_file const file(filename);
+  if (file.is_open() && file.size() > 0u &&
+      file.size() <= static_cast<std::size_t>(
+                         std::numeric_limits<int>::max())) {
+    stbi_set_flip_vertically_on_load_thread(flip ? 1 : 0);
+    image_data = stbi_load_from_memory(
+        file.data(), static_cast<int>(file.size()),
+        reinterpret_cast<int *>(&width), reinterpret_cast<int *>(&height),
+        nullptr, channels_nb);
+  }
+  if (is_decoded != nullptr)
+    *is_decoded = image_data != nullptr;
   if (image_data == nullptr) {
     LogWarning("Couldn't load or decode image file %s", filename.c_str());
 
     // Provide a small empty image instead in case of failure.
     width = 16;
     height = 16;
-    return std::vector<unsigned char>(width * height * channels_nb);
+    auto const size = static_cast<std::size_t>(width) * height * channels_nb;
+    return decoded_pixels(static_cast<std::uint8_t *>(std::calloc(size, 1u)),
+                          size, &std::free);
   }
 
-  std::vector<unsigned char> image(width * height * channels_nb);
-  std::memcpy(image.data(), image_data, image.size());
-  stbi_image_free(image_data);
+  return decoded_pixels(
+      image_data, static_cast<std::size_t>(width) * height * channels_nb,
+      &stbi_image_free);
+}
+
+struct decoded_image {
+  decoded_pixels data; // empty if the image got compressed
+  std::uint32_t width{0u};
+  std::uint32_t height{0u};
+  std::vector<bonobo::image_level> mipmaps; // levels below |data|, if any
+  bonobo::compressed_texture compressed; // no levels if not compressed
+  bool is_valid{false}; // false if |data| is a placeholder
+  bool is_cached{false}; // whether |compressed| was read from its cache
+  float decoding_duration{0.0f}; // in milliseconds
+  float compression_duration{0.0f}; // in milliseconds, part of the above
+
+  // Copy of all levels, one after the other, in the order they get
+  // uploaded; invalid if they have to be read from client memory.
+  bonobo::texture_upload_ring::slot staging;
+};
+
+struct texture_load_options {
+  bool generate_mipmap{true};
+  bonobo::mipmap_options mipmap{};
+  bonobo::texture_compression compression{bonobo::texture_compression::none};
+};
+
+// Whether the OpenGL implementation can sample the block-compressed
+// formats used by |compression|; BC5 is part of core OpenGL, unlike BC1
+// and BC3 which come from EXT_texture_compression_s3tc.
+bool isTextureCompressionSupported(bonobo::texture_compression compression) {
+  static int is_s3tc_supported = -1;
+  if (compression != bonobo::texture_compression::automatic)
+    return true;
+  if (is_s3tc_supported < 0) {
+    GLint formats_nb = 0;
+    glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &formats_nb);
+    std::vector<GLint> formats(static_cast<size_t>(std::max(formats_nb, 0)));
+    if (!formats.empty())
+      glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, formats.data());
+    is_s3tc_supported =
+        std::find(formats.begin(), formats.end(),
+                  static_cast<GLint>(compressed_rgb_s3tc_dxt1)) !=
+            formats.end() &&
+        std::find(formats.begin(), formats.end(),
+                  static_cast<GLint>(compressed_rgba_s3tc_dxt5)) !=
+            formats.end();
+    if (!is_s3tc_supported)
+      LogWarning("BC1 and BC3 textures are not supported; textures will "
+                 "be left uncompressed.");
+  }
+  return is_s3tc_supported == 1;
+}
+
+// Only touches the CPU, so it can be called from any thread; this
+// includes building the mip chain, which is therefore done by the
+// caller's thread rather than by the driver.
+decoded_image decodeImage(std::string const &filename, bool flip,
+                          texture_load_options const &options) {
+  auto const decoding_start_time = std::chrono::high_resolution_clock::now();
+
+  auto const compression = options.compression;
+  decoded_image image;
+  if (compression == bonobo::texture_compression::automatic) {
+    if (!bonobo::readCompressedTextureCache(filename,
+                                            bonobo::block_format::bc1, flip,
+                                            options.mipmap, image.compressed))
+      bonobo::readCompressedTextureCache(filename, bonobo::block_format::bc3,
+                                         flip, options.mipmap,
+                                         image.compressed);
+  } else if (compression == bonobo::texture_compression::two_channels)
+    bonobo::readCompressedTextureCache(filename, bonobo::block_format::bc5,
+                                       flip, options.mipmap,
+                                       image.compressed);
+
+  if (!image.compressed.levels.empty()) {
+    image.width = image.compressed.width;
+    image.height = image.compressed.height;
+    image.is_valid = true;
+    image.is_cached = true;
+  } else {
+    bool is_decoded = false;
+    image.data = getTextureData(filename, image.width, image.height, flip,
+                                &is_decoded);
+    image.is_valid = is_decoded;
+    if (is_decoded && compression != bonobo::texture_compression::none) {
+      auto const format =
+          compression == bonobo::texture_compression::two_channels
+              ? bonobo::block_format::bc5
+              : bonobo::selectBlockFormat(
+                    image.data.data(),
+                    static_cast<size_t>(image.width) * image.height);
+      auto const compression_start_time =
+          std::chrono::high_resolution_clock::now();
+      image.compressed = bonobo::compressTexture(
+          image.data.data(), image.width, image.height, format,
+          /* generate_mipmap */ true, options.mipmap);
+      image.compression_duration =
+          std::chrono::duration<float, std::milli>(
+              std::chrono::high_resolution_clock::now() -
+              compression_start_time)
+              .count();
+      bonobo::writeCompressedTextureCache(filename, flip, options.mipmap,
+                                          image.compressed);
+      image.data.clear();
+    } else if (options.generate_mipmap) {
+      image.mipmaps = bonobo::buildMipChain(image.data.data(), image.width,
+                                            image.height, options.mipmap);
+    }
+  }
 
+  auto const decoding_end_time = std::chrono::high_resolution_clock::now();
+  image.decoding_duration = std::chrono::duration<float, std::milli>(
+                                decoding_end_time - decoding_start_time)
+                                .count();
   return image;
 }
 
-std::vector<bonobo::mesh_data>
-bonobo::loadObjects(std::string const &filename) {
-  auto const scene_start_time = std::chrono::high_resolution_clock::now();
+// Created on first use, as it requires a current OpenGL context; it
+// is invalid without OpenGL 4.4, or if the buffer could not be mapped.
+bonobo::texture_upload_ring &getTextureUploadRing() {
+  if (shared_texture_upload_ring == nullptr)
+    shared_texture_upload_ring = std::unique_ptr<bonobo::texture_upload_ring>(
+        new bonobo::texture_upload_ring(texture_upload_slot_size,
+                                        texture_upload_slots_nb));
+  return *shared_texture_upload_ring;
+}
 
-  std::vector<bonobo::mesh_data> objects;
+// Copy all levels of |image| to a slot of |ring|, if one is free and
+// large enough; can be called from any thread.
+void stageImage(decoded_image &image, bonobo::texture_upload_ring &ring) {
+  std::vector<std::pair<std::uint8_t const *, std::size_t>> levels;
+  if (!image.compressed.levels.empty()) {
+    for (auto const &level : image.compressed.levels)
+      levels.emplace_back(level.data(), level.size());
+  } else if (!image.data.empty()) {
+    levels.emplace_back(image.data.data(), image.data.size());
+    for (auto const &level : image.mipmaps)
+      levels.emplace_back(level.data.data(), level.data.size());
+  }
 
-  auto const end_of_basedir = filename.rfind("/");
-  auto const parent_folder =
-      (end_of_basedir != std::string::npos ? filename.substr(0, end_of_basedir)
-                                           : ".") +
-      "/";
-  Assimp::Importer importer;
-  auto const assimp_scene = importer.ReadFile(
-      filename, aiProcess_Triangulate | aiProcess_SortByPType |
-                    aiProcess_CalcTangentSpace);
-  if (assimp_scene == nullptr ||
-      assimp_scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE ||
-      assimp_scene->mRootNode == nullptr) {
-    LogError("Assimp failed to load \"%s\": %s", filename.c_str(),
-             importer.GetErrorString());
-    return objects;
+  std::size_t size = 0u;
+  for (auto const &level : levels)
+    size += level.second;
+  auto staging = ring.acquire(size);
+  if (!staging.is_valid())
+    return;
+  auto destination = staging.data();
+  for (auto const &level : levels) {
+    std::memcpy(destination, level.first, level.second);
+    destination += level.second;
   }
+  image.staging = std::move(staging);
+}
 
-  if (assimp_scene->mNumMeshes == 0u) {
-    LogError("No mesh available; loading \"%s\" must have had issues",
-             filename.c_str());
-    return objects;
+// Hands out, in upload order, where each level of an image is to be
+// read from: its staging slot, which gets bound for the lifetime of the
+// source, or client memory.
+class texel_source {
+public:
+  explicit texel_source(decoded_image &image)
+      : _staging(std::move(image.staging)) {
+    if (!_staging.is_valid())
+      return;
+    auto &ring = getTextureUploadRing();
+    _base = reinterpret_cast<std::uintptr_t>(ring.bind(_staging));
+  }
+  ~texel_source() {
+    if (_staging.is_valid())
+      getTextureUploadRing().submit(std::move(_staging));
+  }
+  texel_source(texel_source const &) = delete;
+  texel_source &operator=(texel_source const &) = delete;
+
+  GLvoid const *next(std::uint8_t const *client_data, std::size_t size) {
+    if (!_staging.is_valid())
+      return reinterpret_cast<GLvoid const *>(client_data);
+    auto const offset = _offset;
+    _offset += size;
+    return reinterpret_cast<GLvoid const *>(_base + offset);
   }
 
-  LogInfo("┭ Loading \"%s\"…", filename.c_str());
+private:
+  bonobo::texture_upload_ring::slot _staging;
+  std::uintptr_t _base{0u};
+  std::size_t _offset{0u};
+};
+
+GLuint uploadCompressedTexture2D(bonobo::compressed_texture const &image,
+                                 texel_source &source, bool generate_mipmap) {
+  GLenum internal_format = GL_COMPRESSED_RG_RGTC2;
+  switch (image.format) {
+  case bonobo::block_format::bc1:
+    internal_format = compressed_rgb_s3tc_dxt1;
+    break;
+  case bonobo::block_format::bc3:
+    internal_format = compressed_rgba_s3tc_dxt5;
+    break;
+  case bonobo::block_format::bc5:
+    break;
+  }
+  auto const levels_nb = generate_mipmap ? image.levels.size() : 1u;
 
-  std::vector<bool> are_materials_used(assimp_scene->mNumMaterials, false);
-  for (size_t j = 0; j < assimp_scene->mNumMeshes; ++j) {
-    auto const assimp_object_mesh = assimp_scene->mMeshes[j];
-    auto const material_id = assimp_object_mesh->mMaterialIndex;
-    if (material_id >= assimp_scene->mNumMaterials)
-      LogError("Mesh \"%s\" has a material index of %u, but only %u materials "
-               "are present.",
-               assimp_object_mesh->mName.C_Str(), material_id,
-               assimp_scene->mNumMaterials);
-    else
-      are_materials_used[material_id] = true;
+  GLuint texture = 0u;
+  glGenTextures(1, &texture);
+  assert(texture != 0u);
+  bonobo::state::bindTexture(GL_TEXTURE_2D, texture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL,
+                  static_cast<GLint>(levels_nb) - 1);
+  for (size_t i = 0u; i < levels_nb; ++i) {
+    auto const &level = image.levels[i];
+    glCompressedTexImage2D(
+        GL_TEXTURE_2D, static_cast<GLint>(i), internal_format,
+        static_cast<GLsizei>(std::max(image.width >> i, 1u)),
+        static_cast<GLsizei>(std::max(image.height >> i, 1u)), 0,
+        static_cast<GLsizei>(level.size()),
+        source.next(level.data(), level.size()));
   }
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                  levels_nb > 1u ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  bonobo::state::bindTexture(GL_TEXTURE_2D, 0u);
 
-  auto const materials_start_time = std::chrono::high_resolution_clock::now();
-  std::vector<texture_bindings> materials_bindings(assimp_scene->mNumMaterials);
-  std::vector<material_data> material_constants(assimp_scene->mNumMaterials);
-  uint32_t texture_count = 0u;
-  for (size_t i = 0; i < assimp_scene->mNumMaterials; ++i) {
-    if (!are_materials_used[i])
-      continue;
+  return texture;
+}
 
-    auto const material_start_time = std::chrono::high_resolution_clock::now();
-    texture_bindings &bindings = materials_bindings[i];
-    material_data &constants = material_constants[i];
-    auto const material = assimp_scene->mMaterials[i];
-
-    auto const process_texture = [&bindings, &material, i, &parent_folder,
-                                  &texture_count](
-                                     aiTextureType type,
-                                     std::string const &type_as_str,
-                                     std::string const &name) {
-      if (material->GetTextureCount(type)) {
-        auto const texture_start_time =
-            std::chrono::high_resolution_clock::now();
-
-        if (material->GetTextureCount(type) > 1)
-          LogWarning("Material \"%s\" has more than one %s texture: discarding "
-                     "all but the first one.",
-                     material->GetName().C_Str(), type_as_str.c_str());
-        aiString path;
-        material->GetTexture(type, 0, &path);
-        auto const id =
-            bonobo::loadTexture2D(parent_folder + std::string(path.C_Str()));
-        if (id == 0u) {
-          LogWarning("Failed to load the %s texture for material \"%s\".",
-                     type_as_str.c_str(), material->GetName().C_Str());
-          return;
-        }
-        bindings.emplace(name, id);
-        ++texture_count;
-
-        utils::opengl::debug::nameObject(
-            GL_TEXTURE, id,
-            std::string(material->GetName().C_Str()) + " " + type_as_str);
-
-        auto const texture_end_time = std::chrono::high_resolution_clock::now();
-        LogTrivia("│ %s Texture \"%s\" loaded in %.3f ms",
-                  bindings.size() == 1 ? "┌" : "├", path.C_Str(),
-                  std::chrono::duration<float, std::milli>(texture_end_time -
-                                                           texture_start_time)
-                      .count());
-      }
-    };
-
-    aiColor3D color;
-
-    material->Get(AI_MATKEY_COLOR_DIFFUSE, color);
-    constants.diffuse = glm::vec3(color.r, color.g, color.b);
-    material->Get(AI_MATKEY_COLOR_SPECULAR, color);
-    constants.specular = glm::vec3(color.r, color.g, color.b);
-    material->Get(AI_MATKEY_COLOR_AMBIENT, color);
-    constants.ambient = glm::vec3(color.r, color.g, color.b);
-    material->Get(AI_MATKEY_COLOR_EMISSIVE, color);
-    constants.emissive = glm::vec3(color.r, color.g, color.b);
-    material->Get(AI_MATKEY_SHININESS, constants.shininess);
-    material->Get(AI_MATKEY_REFRACTI, constants.indexOfRefraction);
-    material->Get(AI_MATKEY_OPACITY, constants.opacity);
-
-    process_texture(aiTextureType_DIFFUSE, "diffuse", "diffuse_texture");
-    process_texture(aiTextureType_SPECULAR, "specular", "specular_texture");
-    process_texture(aiTextureType_NORMALS, "normals", "normals_texture");
-    process_texture(aiTextureType_OPACITY, "opacity", "opacity_texture");
+// Uploads from the staging slot of |image| if it has one, in which case
+// the slot is taken from it.
+GLuint uploadTexture2D(decoded_image &image, bool generate_mipmap) {
+  if (shared_texture_upload_ring != nullptr)
+    shared_texture_upload_ring->reclaim();
+
+  texel_source source(image);
+  if (!image.compressed.levels.empty())
+    return uploadCompressedTexture2D(image.compressed, source,
+                                     generate_mipmap);
+  if (image.data.empty())
+    return 0u;
 
-    auto const material_end_time = std::chrono::high_resolution_clock::now();
-    LogTrivia("│ %s Material \"%s\" loaded in %.3f ms",
-              bindings.empty() ? "╺" : "┕", material->GetName().C_Str(),
-              std::chrono::duration<float, std::milli>(material_end_time -
-                                                       material_start_time)
-                  .count());
+  GLuint texture = bonobo::createTexture(
+      image.width, image.height, GL_TEXTURE_2D, GL_RGBA, GL_RGBA,
+      GL_UNSIGNED_BYTE, source.next(image.data.data(), image.data.size()));
+  bonobo::state::bindTexture(GL_TEXTURE_2D, texture);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                  generate_mipmap ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  if (generate_mipmap && !image.mipmaps.empty()) {
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL,
+                    static_cast<GLint>(image.mipmaps.size()));
+    for (size_t i = 0u; i < image.mipmaps.size(); ++i) {
+      auto const &level = image.mipmaps[i];
+      glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i + 1u), GL_RGBA,
+                   static_cast<GLsizei>(level.width),
+                   static_cast<GLsizei>(level.height), 0, GL_RGBA,
+                   GL_UNSIGNED_BYTE,
+                   source.next(level.data.data(), level.data.size()));
+    }
+  } else if (generate_mipmap) {
+    // The mip chain was not built on the CPU.
+    glGenerateMipmap(GL_TEXTURE_2D);
   }
-  auto const materials_end_time = std::chrono::high_resolution_clock::now();
+  bonobo::state::bindTexture(GL_TEXTURE_2D, 0u);
 
-  auto const meshes_start_time = std::chrono::high_resolution_clock::now();
-  objects.reserve(assimp_scene->mNumMeshes);
-  for (size_t j = 0; j < assimp_scene->mNumMeshes; ++j) {
-    auto const mesh_start_time = std::chrono::high_resolution_clock::now();
+  return texture;
+}
 
-    auto const assimp_object_mesh = assimp_scene->mMeshes[j];
+std::string getTextureKey(std::string const &filename, bool flip,
+                          texture_load_options const &options) {
+  char const *const compression_names[] = {"", "|bc", "|bc5"};
+  std::string mipmap_name = "|nomipmap";
+  if (options.generate_mipmap) {
+    mipmap_name = options.mipmap.filter == bonobo::mipmap_filter::kaiser
+                      ? "|mipmap-kaiser"
+                      : "|mipmap";
+    if (options.mipmap.is_srgb)
+      mipmap_name += "-srgb";
+    if (options.mipmap.preserve_alpha_coverage)
+      mipmap_name +=
+          "-coverage" + std::to_string(options.mipmap.alpha_reference);
+  }
+  return utils::get_canonical_path(filename) + (flip ? "|flip" : "|noflip") +
+         mipmap_name +
+         compression_names[static_cast<unsigned int>(options.compression)];
+}
 
-    if (!assimp_object_mesh->HasFaces()) {
-      LogError("Unsupported mesh \"%s\": has no faces",
-               assimp_object_mesh->mName.C_Str());
-      continue;
-    }
-    if ((assimp_object_mesh->mPrimitiveTypes &
-         ~static_cast<uint32_t>(aiPrimitiveType_POINT |
-                                aiPrimitiveType_NGONEncodingFlag)) != 0u &&
-        (assimp_object_mesh->mPrimitiveTypes &
-         ~static_cast<uint32_t>(aiPrimitiveType_LINE |
-                                aiPrimitiveType_NGONEncodingFlag)) != 0u &&
-        (assimp_object_mesh->mPrimitiveTypes &
-         ~static_cast<uint32_t>(aiPrimitiveType_TRIANGLE |
-                                aiPrimitiveType_NGONEncodingFlag)) != 0u) {
-      LogError("Unsupported mesh \"%s\": uses multiple primitive types",
-               assimp_object_mesh->mName.C_Str());
-      continue;
+// Options used for the textures of a scene: colours are sRGB-encoded
+// and may be alpha-tested, and the sharper filter is worth its cost as
+// it is only paid once per texture, on a worker thread.
+texture_load_options getSceneTextureLoadOptions(
+    std::string const &type_name,
+    bonobo::texture_compression compression) {
+  texture_load_options options;
+  options.mipmap.filter = bonobo::mipmap_filter::kaiser;
+  options.compression = compression;
+  if (type_name == "diffuse") {
+    options.mipmap.is_srgb = true;
+    options.mipmap.preserve_alpha_coverage = true;
+  } else if (type_name == "normals") {
+    options.compression = bonobo::texture_compression::none;
+  }
+  return options;
+}
+
+std::size_t computeTextureMemorySize(decoded_image const &image,
+                                     bool generate_mipmap) {
+  std::size_t size = 0u;
+  if (!image.compressed.levels.empty()) {
+    for (auto const &level : image.compressed.levels) {
+      size += level.size();
+      if (!generate_mipmap)
+        break;
     }
-    if ((assimp_object_mesh->mPrimitiveTypes &
-         static_cast<uint32_t>(aiPrimitiveType_POLYGON)) ==
-        static_cast<uint32_t>(aiPrimitiveType_POLYGON)) {
-      LogError("Unsupported mesh \"%s\": uses polygons",
-               assimp_object_mesh->mName.C_Str());
-      continue;
+    return size;
+  }
+
+  std::size_t width = image.width, height = image.height;
+  for (;;) {
+    size += width * height * 4u;
+    if (!generate_mipmap || (width == 1u && height == 1u))
+      break;
+    width = std::max<std::size_t>(width / 2u, 1u);
+    height = std::max<std::size_t>(height / 2u, 1u);
+  }
+  return size;
+}
+
+// Return the registered texture matching |key| after having added a
+// reference to it, or 0 if there is none.
+GLuint acquireRegisteredTexture(std::string const &key) {
+  auto const it = texture_registry.textures.find(key);
+  if (it == texture_registry.textures.end())
+    return 0u;
+
+  ++it->second.references_nb;
+  texture_registry.memory_saved += it->second.memory_size;
+  return it->second.id;
+}
+
+void registerTexture(std::string const &key, GLuint id,
+                     std::size_t memory_size) {
+  if (id == 0u)
+    return;
+
+  registered_texture texture;
+  texture.id = id;
+  texture.references_nb = 1u;
+  texture.memory_size = memory_size;
+  texture_registry.textures.emplace(key, texture);
+  texture_registry.keys.emplace(id, key);
+}
+} // namespace
+
+namespace {
+// Statistics of a mesh whose triangles got reordered.
+struct triangle_order_statistics {
+  bonobo::vertex_cache_statistics before, after;
+};
+
+// Scene read from its mesh cache, or freshly imported and processed; only
+// the CPU is touched while filling it in, so it can be done on any thread.
+struct scene_source {
+  // Either the content of the cache, or of the freshly imported scene, is
+  // used; |meshes| point into whichever one was filled.
+  bonobo::cached_scene cached_scene;
+  bonobo::imported_scene imported_scene;
+  std::vector<bonobo::mesh_view> meshes;
+  bool is_cached{false};
+
+  std::vector<triangle_order_statistics> triangle_orders; // empty if the triangles were not reordered
+  float triangle_order_duration{0.0f}; // in milliseconds
+  float lods_duration{-1.0f}; // in milliseconds; negative if no levels of detail were generated
+  float reading_duration{0.0f}; // in seconds
+
+  // Distinct materials of the scene, sorted by program hint and texture
+  // set; |meshes| index into them, and are sorted the same way.
+  std::vector<bonobo::material_description> materials;
+  std::vector<bonobo::program_hint> material_hints;
+};
+
+bonobo::program_hint
+getProgramHint(bonobo::material_description const &material) {
+  auto const has_opacity_texture =
+      std::any_of(material.textures.begin(), material.textures.end(),
+                  [](bonobo::texture_reference const &texture) {
+                    return texture.type_name == "opacity";
+                  });
+  if (has_opacity_texture)
+    return bonobo::program_hint::alpha_tested;
+  return material.constants.opacity < 1.0f ? bonobo::program_hint::translucent
+                                            : bonobo::program_hint::opaque;
+}
+
+// Merge the materials of |source| which are identical but for their name,
+// and order them, then the meshes if |sort_meshes| is set, by program hint
+// and texture set, so that drawing the meshes in order switches programs
+// and textures as rarely as possible.
+void sortSceneMaterials(
+    std::vector<bonobo::material_description> const &scene_materials,
+    bool sort_meshes, scene_source &source) {
+  struct material_key {
+    bonobo::program_hint hint;
+    std::vector<std::tuple<std::string, std::string, std::string>> textures;
+    std::array<float, 15> constants;
+
+    bool operator<(material_key const &other) const {
+      return std::tie(hint, textures, constants) <
+             std::tie(other.hint, other.textures, other.constants);
     }
-    if (!assimp_object_mesh->HasPositions()) {
-      LogError("Unsupported mesh \"%s\": has no positions",
-               assimp_object_mesh->mName.C_Str());
-      continue;
+    bool operator==(material_key const &other) const {
+      return hint == other.hint && textures == other.textures &&
+             constants == other.constants;
     }
+  };
+  std::vector<material_key> keys(scene_materials.size());
+  for (std::size_t i = 0u; i < scene_materials.size(); ++i) {
+    auto const &material = scene_materials[i];
+    auto &key = keys[i];
+    key.hint = getProgramHint(material);
+    for (auto const &texture : material.textures)
+      key.textures.emplace_back(texture.sampler_name, texture.type_name,
+                                texture.path);
+    auto const &c = material.constants;
+    key.constants = {{c.diffuse.x, c.diffuse.y, c.diffuse.z, c.specular.x,
+                      c.specular.y, c.specular.z, c.ambient.x, c.ambient.y,
+                      c.ambient.z, c.emissive.x, c.emissive.y, c.emissive.z,
+                      c.shininess, c.indexOfRefraction, c.opacity}};
+  }
 
-    bonobo::mesh_data object;
-    if (assimp_object_mesh->mName.length != 0) {
-      object.name = std::string(assimp_object_mesh->mName.C_Str());
+  std::vector<std::uint32_t> order(scene_materials.size());
+  for (std::size_t i = 0u; i < order.size(); ++i)
+    order[i] = static_cast<std::uint32_t>(i);
+  std::stable_sort(order.begin(), order.end(),
+                   [&keys](std::uint32_t a, std::uint32_t b) {
+                     return keys[a] < keys[b];
+                   });
+
+  std::vector<std::uint32_t> remapping(scene_materials.size(), ~0u);
+  source.materials.clear();
+  source.material_hints.clear();
+  for (std::size_t i = 0u; i < order.size(); ++i) {
+    auto const index = order[i];
+    if (i == 0u || !(keys[index] == keys[order[i - 1u]])) {
+      source.materials.push_back(scene_materials[index]);
+      source.material_hints.push_back(keys[index].hint);
     }
+    remapping[index] = static_cast<std::uint32_t>(source.materials.size() - 1u);
+  }
 
-    glGenVertexArrays(1, &object.vao);
-    assert(object.vao != 0u);
-    glBindVertexArray(object.vao);
-
-    auto const vertices_offset = 0u;
-    auto const vertices_size = static_cast<GLsizeiptr>(
-        assimp_object_mesh->mNumVertices * sizeof(glm::vec3));
-
-    auto const normals_offset = vertices_size;
-    auto const normals_size =
-        assimp_object_mesh->HasNormals() ? vertices_size : 0u;
-
-    auto const texcoords_offset = normals_offset + normals_size;
-    auto const texcoords_size =
-        assimp_object_mesh->HasTextureCoords(0u) ? vertices_size : 0u;
-
-    auto const tangents_offset = texcoords_offset + texcoords_size;
-    auto const tangents_size =
-        assimp_object_mesh->HasTangentsAndBitangents() ? vertices_size : 0u;
-
-    auto const binormals_offset = tangents_offset + tangents_size;
-    auto const binormals_size =
-        assimp_object_mesh->HasTangentsAndBitangents() ? vertices_size : 0u;
-
-    auto const bo_size =
-        static_cast<GLsizeiptr>(vertices_size + normals_size + texcoords_size +
-                                tangents_size + binormals_size);
-    glGenBuffers(1, &object.bo);
-    assert(object.bo != 0u);
-    glBindBuffer(GL_ARRAY_BUFFER, object.bo);
-    glBufferData(GL_ARRAY_BUFFER, bo_size, nullptr, GL_STATIC_DRAW);
-
-    glBufferSubData(GL_ARRAY_BUFFER, vertices_offset, vertices_size,
-                    static_cast<GLvoid const *>(assimp_object_mesh->mVertices));
-    glEnableVertexAttribArray(
-        static_cast<unsigned int>(bonobo::shader_bindings::vertices));
-    glVertexAttribPointer(
-        static_cast<unsigned int>(bonobo::shader_bindings::vertices), 3,
-        GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const *>(0x0));
-
-    if (assimp_object_mesh->HasNormals()) {
-      glBufferSubData(
-          GL_ARRAY_BUFFER, normals_offset, normals_size,
-          static_cast<GLvoid const *>(assimp_object_mesh->mNormals));
-      glEnableVertexAttribArray(
-          static_cast<unsigned int>(bonobo::shader_bindings::normals));
-      glVertexAttribPointer(
-          static_cast<unsigned int>(bonobo::shader_bindings::normals), 3,
-          GL_FLOAT, GL_FALSE, 0,
-          reinterpret_cast<GLvoid const *>(normals_offset));
-    }
+  for (auto &mesh : source.meshes)
+    mesh.material_index = mesh.material_index < remapping.size()
+                              ? remapping[mesh.material_index]
+                              : ~0u;
+  if (!sort_meshes)
+    return;
 
-    if (assimp_object_mesh->HasTextureCoords(0u)) {
-      glBufferSubData(
-          GL_ARRAY_BUFFER, texcoords_offset, texcoords_size,
-          static_cast<GLvoid const *>(assimp_object_mesh->mTextureCoords[0u]));
-      glEnableVertexAttribArray(
-          static_cast<unsigned int>(bonobo::shader_bindings::texcoords));
-      glVertexAttribPointer(
-          static_cast<unsigned int>(bonobo::shader_bindings::texcoords), 3,
-          GL_FLOAT, GL_FALSE, 0,
-          reinterpret_cast<GLvoid const *>(texcoords_offset));
-    }
+  // Meshes without a material come last.
+  std::vector<std::size_t> mesh_order(source.meshes.size());
+  for (std::size_t j = 0u; j < mesh_order.size(); ++j)
+    mesh_order[j] = j;
+  std::stable_sort(mesh_order.begin(), mesh_order.end(),
+                   [&source](std::size_t a, std::size_t b) {
+                     auto const get_key = [&source](std::size_t j) {
+                       auto const index = source.meshes[j].material_index;
+                       auto const hint =
+                           index < source.material_hints.size()
+                               ? source.material_hints[index]
+                               : bonobo::program_hint::opaque;
+                       return std::make_pair(hint, index);
+                     };
+                     return get_key(a) < get_key(b);
+                   });
+  std::vector<bonobo::mesh_view> sorted_meshes;
+  std::vector<triangle_order_statistics> sorted_triangle_orders;
+  sorted_meshes.reserve(mesh_order.size());
+  for (auto const j : mesh_order) {
+    sorted_meshes.push_back(std::move(source.meshes[j]));
+    if (!source.triangle_orders.empty())
+      sorted_triangle_orders.push_back(source.triangle_orders[j]);
+  }
+  source.meshes = std::move(sorted_meshes);
+  source.triangle_orders = std::move(sorted_triangle_orders);
+}
 
-    if (assimp_object_mesh->HasTangentsAndBitangents()) {
-      glBufferSubData(
-          GL_ARRAY_BUFFER, tangents_offset, tangents_size,
-          static_cast<GLvoid const *>(assimp_object_mesh->mTangents));
-      glEnableVertexAttribArray(
-          static_cast<unsigned int>(bonobo::shader_bindings::tangents));
-      glVertexAttribPointer(
-          static_cast<unsigned int>(bonobo::shader_bindings::tangents), 3,
-          GL_FLOAT, GL_FALSE, 0,
-          reinterpret_cast<GLvoid const *>(tangents_offset));
-
-      glBufferSubData(
-          GL_ARRAY_BUFFER, binormals_offset, binormals_size,
-          static_cast<GLvoid const *>(assimp_object_mesh->mBitangents));
-      glEnableVertexAttribArray(
-          static_cast<unsigned int>(bonobo::shader_bindings::binormals));
-      glVertexAttribPointer(
-          static_cast<unsigned int>(bonobo::shader_bindings::binormals), 3,
-          GL_FLOAT, GL_FALSE, 0,
-          reinterpret_cast<GLvoid const *>(binormals_offset));
+bool readSceneSource(std::string const &filename,
+                     bonobo::mesh_load_options const &options,
+                     scene_source &source) {
+  auto const reading_start_time = std::chrono::high_resolution_clock::now();
+
+  auto const assimp_flags = static_cast<unsigned int>(
+      aiProcess_Triangulate | aiProcess_SortByPType |
+      aiProcess_CalcTangentSpace);
+  std::uint32_t processing_flags = 0u;
+  if (options.optimise_triangle_order)
+    processing_flags |= bonobo::optimised_triangle_order;
+  if (options.lods_nb > 1u)
+    processing_flags |= bonobo::generated_lods |
+                        (options.lods_nb << bonobo::generated_lods_nb_shift);
+  if (options.build_clusters)
+    processing_flags |= bonobo::built_clusters;
+
+  source.is_cached =
+      options.use_cache &&
+      bonobo::readMeshCache(filename, assimp_flags, processing_flags,
+                            source.cached_scene);
+  if (source.is_cached) {
+    source.meshes = source.cached_scene.meshes;
+  } else {
+    auto &imported_scene = source.imported_scene;
+    // glTF files are laid out for direct uploads, so they are read
+    // without going through assimp whenever possible.
+    bool is_imported = false;
+    if (bonobo::isGltfFile(filename)) {
+      is_imported = bonobo::importGltfScene(filename, imported_scene);
+      if (!is_imported)
+        LogInfo("Falling back to assimp for importing \"%s\".",
+                filename.c_str());
+    }
+    if (!is_imported &&
+        !bonobo::importScene(filename, assimp_flags, imported_scene))
+      return false;
+    if (options.optimise_triangle_order) {
+      auto const optimisation_start_time =
+          std::chrono::high_resolution_clock::now();
+      source.triangle_orders.resize(imported_scene.meshes.size());
+      for (size_t j = 0u; j < imported_scene.meshes.size(); ++j)
+        bonobo::optimiseTriangleOrder(imported_scene.meshes[j], 16u, 1.05f,
+                                      &source.triangle_orders[j].before,
+                                      &source.triangle_orders[j].after);
+      source.triangle_order_duration =
+          std::chrono::duration<float, std::milli>(
+              std::chrono::high_resolution_clock::now() -
+              optimisation_start_time)
+              .count();
+    }
+    if (options.lods_nb > 1u) {
+      auto const lods_start_time = std::chrono::high_resolution_clock::now();
+      for (auto &mesh : imported_scene.meshes)
+        bonobo::generateLods(mesh, options.lods_nb);
+      source.lods_duration = std::chrono::duration<float, std::milli>(
+                                 std::chrono::high_resolution_clock::now() -
+                                 lods_start_time)
+                                 .count();
     }
+    if (options.build_clusters)
+      for (auto &mesh : imported_scene.meshes)
+        bonobo::buildClusters(mesh);
+    if (options.use_cache &&
+        bonobo::writeMeshCache(filename, assimp_flags, processing_flags,
+                               imported_scene))
+      LogTrivia("Mesh cache written to \"%s\"",
+                bonobo::getMeshCachePath(filename).c_str());
+
+    source.meshes.reserve(imported_scene.meshes.size());
+    for (auto const &mesh : imported_scene.meshes)
+      source.meshes.push_back(mesh.view());
+  }
+  sortSceneMaterials(source.is_cached ? source.cached_scene.materials
+                                      : source.imported_scene.materials,
+                     options.sort_by_material, source);
+
+  source.reading_duration = std::chrono::duration<float>(
+                                std::chrono::high_resolution_clock::now() -
+                                reading_start_time)
+                                .count();
+  return true;
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, 0u);
-
-    auto const num_vertices_per_face =
-        assimp_object_mesh->mFaces[0u].mNumIndices;
-    object.indices_nb = assimp_object_mesh->mNumFaces * num_vertices_per_face;
-    auto object_indices =
-        std::make_unique<GLuint[]>(static_cast<size_t>(object.indices_nb));
-    for (size_t i = 0u; i < assimp_object_mesh->mNumFaces; ++i) {
-      auto const &face = assimp_object_mesh->mFaces[i];
-      assert(face.mNumIndices <= 3);
-      object_indices[num_vertices_per_face * i + 0u] = face.mIndices[0u];
-      if (num_vertices_per_face > 1u)
-        object_indices[num_vertices_per_face * i + 1u] = face.mIndices[1u];
-      if (num_vertices_per_face > 2u)
-        object_indices[num_vertices_per_face * i + 2u] = face.mIndices[2u];
+void logSceneSource(std::string const &filename, scene_source const &source) {
+  auto const &meshes = source.meshes;
+
+  LogInfo("┭ Loading \"%s\"%s…", filename.c_str(),
+          source.is_cached ? " from its mesh cache" : "");
+  auto const &triangle_orders = source.triangle_orders;
+  if (!triangle_orders.empty()) {
+    LogTrivia("│ ┌ Triangles reordered in %.3f ms",
+              source.triangle_order_duration);
+    for (size_t j = 0u; j < triangle_orders.size(); ++j) {
+      auto const &statistics = triangle_orders[j];
+      LogTrivia("│ %s Mesh \"%s\": ACMR %.3f → %.3f, ATVR %.3f → %.3f",
+                j == triangle_orders.size() - 1 ? "└" : "├",
+                meshes[j].name.c_str(), statistics.before.acmr,
+                statistics.after.acmr, statistics.before.atvr,
+                statistics.after.atvr);
     }
-    glGenBuffers(1, &object.ibo);
-    assert(object.ibo != 0u);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, object.ibo);
-    glBufferData(
-        GL_ELEMENT_ARRAY_BUFFER,
-        static_cast<unsigned int>(object.indices_nb) * sizeof(GL_UNSIGNED_INT),
-        reinterpret_cast<GLvoid const *>(object_indices.get()), GL_STATIC_DRAW);
-    object_indices.reset(nullptr);
-
-    utils::opengl::debug::nameObject(GL_VERTEX_ARRAY, object.vao,
-                                     object.name + " VAO");
-    utils::opengl::debug::nameObject(GL_BUFFER, object.bo,
-                                     object.name + " VBO");
-    utils::opengl::debug::nameObject(GL_BUFFER, object.ibo,
-                                     object.name + " IBO");
-
-    glBindVertexArray(0u);
-    glBindBuffer(GL_ARRAY_BUFFER, 0u);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0u);
-
-    auto const material_id = assimp_object_mesh->mMaterialIndex;
-    if (material_id < materials_bindings.size()) {
-      object.bindings = materials_bindings[material_id];
-      object.material = material_constants[material_id];
+  }
+  if (source.lods_duration >= 0.0f) {
+    auto const meshes_with_lods_nb =
+        std::count_if(meshes.begin(), meshes.end(),
+                      [](bonobo::mesh_view const &mesh) {
+                        return mesh.lods_nb > 0u;
+                      });
+    LogTrivia("│ ╶ Levels of detail generated for %zu out of %zu meshes in "
+              "%.3f ms",
+              static_cast<size_t>(meshes_with_lods_nb), meshes.size(),
+              source.lods_duration);
+  }
+  size_t clusters_nb = 0u;
+  for (auto const &mesh : meshes)
+    clusters_nb += mesh.clusters_nb;
+  if (clusters_nb > 0u)
+    LogTrivia("│ ╶ Meshes split into %zu clusters in total", clusters_nb);
+}
+
+// Textures of a scene, decoded on worker threads in the order of their
+// materials; only the final upload is done on the thread owning the
+// OpenGL context. The number of decoded images waiting for their upload
+// is bounded, to keep the memory usage in check on large scenes.
+// Textures already registered, or used several times within the scene,
+// are only decoded once.
+struct texture_job {
+  bonobo::texture_reference const *texture;
+  std::size_t material_index;
+  std::string key;
+  std::future<decoded_image> image; // invalid if no decoding is needed
+};
+struct texture_job_queue {
+  std::vector<bonobo::material_description> const *materials{nullptr};
+  std::string parent_folder;
+  bonobo::texture_compression compression{bonobo::texture_compression::none};
+  bonobo::texture_upload_ring *upload_ring{nullptr}; // null if not valid
+  std::deque<texture_job> jobs;
+  std::unordered_set<std::string> keys_being_decoded;
+  size_t next_material{0u}, next_texture{0u};
+
+  texture_job_queue(std::vector<bonobo::material_description> const &scene_materials,
+                    std::string const &filename,
+                    bonobo::texture_compression textures_compression)
+      : materials(&scene_materials),
+        compression(isTextureCompressionSupported(textures_compression)
+                        ? textures_compression
+                        : bonobo::texture_compression::none) {
+    auto &ring = getTextureUploadRing();
+    if (ring.is_valid())
+      upload_ring = &ring;
+    auto const end_of_basedir = filename.rfind("/");
+    parent_folder = (end_of_basedir != std::string::npos
+                         ? filename.substr(0, end_of_basedir)
+                         : ".") +
+                    "/";
+  }
+
+  // Whether all textures have been submitted, and taken out of |jobs|.
+  bool is_done() const {
+    return jobs.empty() && next_material >= materials->size();
+  }
+
+  void submit() {
+    auto &thread_pool = utils::get_shared_thread_pool();
+    auto const max_jobs_in_flight = 2u * thread_pool.size();
+    auto const ring = upload_ring;
+    while (jobs.size() < max_jobs_in_flight &&
+           next_material < materials->size()) {
+      auto const &textures = (*materials)[next_material].textures;
+      if (next_texture >= textures.size()) {
+        ++next_material;
+        next_texture = 0u;
+        continue;
+      }
+      auto const &texture = textures[next_texture++];
+      auto const path = parent_folder + texture.path;
+      auto const load_options =
+          getSceneTextureLoadOptions(texture.type_name, compression);
+      texture_job job{&texture, next_material,
+                      getTextureKey(path, /* flip */ true, load_options), {}};
+      if (texture_registry.textures.find(job.key) ==
+              texture_registry.textures.end() &&
+          keys_being_decoded.insert(job.key).second)
+        job.image = thread_pool.submit([path, load_options, ring]() {
+          auto image = decodeImage(path, /* flip */ true, load_options);
+          if (ring != nullptr)
+            stageImage(image, *ring);
+          return image;
+        });
+      jobs.push_back(std::move(job));
     }
+  }
+
+  texture_job pop() {
+    assert(!jobs.empty());
+    auto job = std::move(jobs.front());
+    jobs.pop_front();
+    submit();
+    return job;
+  }
+};
+} // namespace
+
+std::vector<bonobo::mesh_data>
+bonobo::loadObjects(std::string const &filename,
+                    mesh_load_options const &options) {
+  std::vector<scene_material> materials;
+  return loadObjects(filename, materials, options);
+}
+
+std::vector<bonobo::mesh_data>
+bonobo::loadObjects(std::string const &filename,
+                    std::vector<scene_material> &scene_materials,
+                    mesh_load_options const &options) {
+  auto const scene_start_time = std::chrono::high_resolution_clock::now();
+
+  std::vector<bonobo::mesh_data> objects;
+  scene_materials.clear();
+
+  scene_source source;
+  if (!readSceneSource(filename, options, source))
+    return objects;
+  auto const &materials = source.materials;
+  auto const &meshes = source.meshes;
+  logSceneSource(filename, source);
+
+  // Decode the textures on worker threads while the meshes get uploaded.
+  auto &thread_pool = utils::get_shared_thread_pool();
+  texture_job_queue texture_jobs(materials, filename,
+                                 options.textures_compression);
+  texture_jobs.submit();
 
-    objects.push_back(object);
+  auto const meshes_start_time = std::chrono::high_resolution_clock::now();
+  if (options.share_buffers) {
+    objects = bonobo::uploadMeshesToSharedBuffers(
+        meshes, options.vertices_format, filename);
+    if (!objects.empty())
+      LogTrivia("│ ╶ %zu meshes packed into shared buffers in %.3f ms",
+                objects.size(),
+                std::chrono::duration<float, std::milli>(
+                    std::chrono::high_resolution_clock::now() -
+                    meshes_start_time)
+                    .count());
+  }
+  for (size_t j = objects.size(); j < meshes.size(); ++j) {
+    auto const mesh_start_time = std::chrono::high_resolution_clock::now();
+
+    auto const &mesh = meshes[j];
+    objects.push_back(bonobo::uploadMesh(mesh, options.vertices_format));
 
     auto const mesh_end_time = std::chrono::high_resolution_clock::now();
 
-    std::string attributes = assimp_object_mesh->HasNormals() ? "normals" : "";
+    std::string attributes = mesh.normals != nullptr ? "normals" : "";
     if (!attributes.empty())
       attributes += " | ";
-    if (assimp_object_mesh->HasTangentsAndBitangents())
+    if (mesh.tangents != nullptr && mesh.binormals != nullptr)
       attributes += "tangents&bitangents";
     if (!attributes.empty())
       attributes += " | ";
-    if (assimp_object_mesh->HasTextureCoords(0))
+    if (mesh.texcoords != nullptr)
       attributes += "texture coordinates";
-    LogTrivia(
-        "│ %s Mesh \"%s\" loaded with attributes [%s] in %.3f ms",
-        (assimp_scene->mNumMeshes == 1u)
-            ? "╶"
-            : (j == 0 ? "┌" : (j == assimp_scene->mNumMeshes - 1 ? "└" : "├")),
-        assimp_object_mesh->mName.C_Str(), attributes.c_str(),
-        std::chrono::duration<float, std::milli>(mesh_end_time -
-                                                 mesh_start_time)
-            .count());
+    LogTrivia("│ %s Mesh \"%s\" loaded with attributes [%s] in %.3f ms",
+              (meshes.size() == 1u)
+                  ? "╶"
+                  : (j == 0 ? "┌" : (j == meshes.size() - 1 ? "└" : "├")),
+              mesh.name.c_str(), attributes.c_str(),
+              std::chrono::duration<float, std::milli>(mesh_end_time -
+                                                       mesh_start_time)
+                  .count());
   }
   auto const meshes_end_time = std::chrono::high_resolution_clock::now();
 
+  auto const materials_start_time = std::chrono::high_resolution_clock::now();
+  scene_materials.resize(materials.size());
+  uint32_t texture_count = 0u, shared_texture_count = 0u;
+  float decoding_duration = 0.0f, waiting_duration = 0.0f;
+  for (size_t i = 0; i < materials.size(); ++i) {
+    auto const material_start_time = std::chrono::high_resolution_clock::now();
+    auto const &material = materials[i];
+    scene_materials[i].name = material.name;
+    scene_materials[i].constants = material.constants;
+    scene_materials[i].hint = source.material_hints[i];
+    texture_bindings &bindings = scene_materials[i].bindings;
+
+    for (size_t k = 0; k < material.textures.size(); ++k) {
+      auto const wait_start_time = std::chrono::high_resolution_clock::now();
+      auto job = texture_jobs.pop();
+      auto const &texture = *job.texture;
+
+      if (!job.image.valid()) {
+        auto const id = acquireRegisteredTexture(job.key);
+        if (id == 0u) {
+          LogWarning("Failed to load the %s texture for material \"%s\".",
+                     texture.type_name.c_str(), material.name.c_str());
+          continue;
+        }
+        bindings.emplace(texture.sampler_name, id);
+        ++shared_texture_count;
+        LogTrivia("│ %s Texture \"%s\" shared with a previous user",
+                  bindings.size() == 1 ? "┌" : "├", texture.path.c_str());
+        continue;
+      }
+
+      auto image = job.image.get();
+      auto const upload_start_time = std::chrono::high_resolution_clock::now();
+
+      auto const id = uploadTexture2D(image, /* generate_mipmap */ true);
+      registerTexture(job.key, id,
+                      computeTextureMemorySize(image,
+                                               /* generate_mipmap */ true));
+      if (id == 0u) {
+        LogWarning("Failed to load the %s texture for material \"%s\".",
+                   texture.type_name.c_str(), material.name.c_str());
+        continue;
+      }
+      bindings.emplace(texture.sampler_name, id);
+      ++texture_count;
+
+      utils::opengl::debug::nameObject(GL_TEXTURE, id,
+                                       material.name + " " + texture.type_name);
+
+      auto const upload_end_time = std::chrono::high_resolution_clock::now();
+      auto const waited = std::chrono::duration<float, std::milli>(
+                              upload_start_time - wait_start_time)
+                              .count();
+      decoding_duration += image.decoding_duration;
+      waiting_duration += waited;
+      LogTrivia("│ %s Texture \"%s\" decoded in %.3f ms on a worker, waited "
+                "%.3f ms for it, and uploaded in %.3f ms",
+                bindings.size() == 1 ? "┌" : "├", texture.path.c_str(),
+                image.decoding_duration, waited,
+                std::chrono::duration<float, std::milli>(upload_end_time -
+                                                         upload_start_time)
+                    .count());
+    }
+
+    auto const material_end_time = std::chrono::high_resolution_clock::now();
+    LogTrivia("│ %s Material \"%s\" loaded in %.3f ms",
+              bindings.empty() ? "╺" : "┕", material.name.c_str(),
+              std::chrono::duration<float, std::milli>(material_end_time -
+                                                       material_start_time)
+                  .count());
+  }
+  auto const materials_end_time = std::chrono::high_resolution_clock::now();
+
+  for (size_t j = 0; j < meshes.size(); ++j) {
+    auto const material_index = meshes[j].material_index;
+    if (material_index < scene_materials.size()) {
+      objects[j].material_index = material_index;
+      objects[j].bindings = scene_materials[material_index].bindings;
+      objects[j].material = scene_materials[material_index].constants;
+    }
+  }
+
   auto const scene_end_time = std::chrono::high_resolution_clock::now();
   LogInfo(
-      "┕ Scene loaded in %.3f s: %u textures loaded in %.3f s and %zu meshes "
-      "in %.3f s",
+      "┕ Scene loaded in %.3f s: %s in %.3f s, %zu meshes in %.3f s and %u "
+      "textures in %.3f s (%.3f s of decoding spread over %zu workers, of "
+      "which %.3f s were waited for; %u more textures were shared)",
       std::chrono::duration<float>(scene_end_time - scene_start_time).count(),
+      source.is_cached ? "cache read" : "imported", source.reading_duration,
+      objects.size(),
+      std::chrono::duration<float>(meshes_end_time - meshes_start_time)
+          .count(),
       texture_count,
       std::chrono::duration<float>(materials_end_time - materials_start_time)
           .count(),
-      objects.size(),
-      std::chrono::duration<float>(meshes_end_time - meshes_start_time)
-          .count());
+      decoding_duration / 1000.0f, thread_pool.size(),
+      waiting_duration / 1000.0f, shared_texture_count);
 
   return objects;
 }
 
+namespace {
+// Amount of vertex and index data read from |mesh| when uploading it, in
+// bytes; this ignores any conversion done by the vertex format.
+std::size_t computeMeshSize(bonobo::mesh_view const &mesh) {
+  std::size_t attributes_nb = 0u;
+  for (auto const attribute : {mesh.vertices, mesh.normals, mesh.texcoords,
+                               mesh.tangents, mesh.binormals})
+    if (attribute != nullptr)
+      ++attributes_nb;
+  return mesh.vertices_nb * attributes_nb * sizeof(glm::vec3) +
+         mesh.indices_nb * sizeof(std::uint32_t);
+}
+} // namespace
+
+struct bonobo::streamed_objects::state {
+  std::string filename;
+  mesh_load_options options;
+  std::chrono::high_resolution_clock::time_point start_time;
+
+  // Reading the scene runs on a thread of its own rather than on the
+  // shared thread pool, as it can take seconds and would otherwise hold
+  // up the decoding of textures, including those of other scenes.
+  std::future<std::unique_ptr<scene_source>> reading;
+  std::unique_ptr<scene_source> source; // set once |reading| is over
+  bool has_failed{false};
+
+  std::unique_ptr<shared_mesh_buffers> shared_buffers; // null if not used
+  std::unique_ptr<texture_job_queue> texture_jobs;
+  std::vector<scene_material> materials;
+  std::vector<mesh_data> objects;
+
+  std::uint32_t texture_count{0u}, shared_texture_count{0u};
+  std::size_t uploads_nb{0u}; // calls to upload() which uploaded something
+};
+
+bonobo::streamed_objects::streamed_objects(std::unique_ptr<state> state)
+    : _state(std::move(state)) {}
+
+bonobo::streamed_objects::~streamed_objects() {
+  // As for asset_batch, staged images have to give their slot back
+  // before the ring may go; futures from the thread pool do not wait
+  // on destruction.
+  if (_state->texture_jobs == nullptr)
+    return;
+  for (auto &job : _state->texture_jobs->jobs)
+    if (job.image.valid())
+      job.image.wait();
+}
+
+bool bonobo::streamed_objects::upload(upload_budget const &budget) {
+  auto &state = *_state;
+  if (state.has_failed || is_complete())
+    return false;
+
+  if (state.source == nullptr) {
+    if (state.reading.wait_for(std::chrono::seconds(0)) !=
+        std::future_status::ready)
+      return false;
+    state.source = state.reading.get();
+    if (state.source == nullptr) {
+      LogError("Failed to load \"%s\".", state.filename.c_str());
+      state.has_failed = true;
+      return false;
+    }
+
+    auto const &source = *state.source;
+    logSceneSource(state.filename, source);
+    state.objects.reserve(source.meshes.size());
+    state.materials.resize(source.materials.size());
+    for (std::size_t i = 0u; i < source.materials.size(); ++i) {
+      state.materials[i].name = source.materials[i].name;
+      state.materials[i].constants = source.materials[i].constants;
+      state.materials[i].hint = source.material_hints[i];
+    }
+    if (state.options.share_buffers && !source.meshes.empty()) {
+      state.shared_buffers = std::unique_ptr<shared_mesh_buffers>(
+          new shared_mesh_buffers(source.meshes, state.options.vertices_format,
+                                  state.filename));
+      if (!state.shared_buffers->is_valid())
+        state.shared_buffers.reset();
+    }
+    state.texture_jobs = std::unique_ptr<texture_job_queue>(
+        new texture_job_queue(source.materials, state.filename,
+                              state.options.textures_compression));
+    state.texture_jobs->submit();
+  }
+
+  auto const &meshes = state.source->meshes;
+  auto const &materials = state.source->materials;
+  auto &objects = state.objects;
+  auto &texture_jobs = *state.texture_jobs;
+
+  auto const upload_start_time = std::chrono::high_resolution_clock::now();
+  std::size_t uploaded_size = 0u;
+  bool has_uploaded = false, have_objects_changed = false;
+  auto const is_within_budget = [&]() {
+    return !has_uploaded ||
+           (uploaded_size < budget.max_bytes &&
+            std::chrono::duration<float, std::milli>(
+                std::chrono::high_resolution_clock::now() - upload_start_time)
+                    .count() < budget.max_duration);
+  };
+
+  // Meshes go first, so that the scene takes shape as early as possible;
+  // they get whatever textures of their material are already there.
+  while (objects.size() < meshes.size() && is_within_budget()) {
+    auto const j = objects.size();
+    auto const &mesh = meshes[j];
+    objects.push_back(state.shared_buffers != nullptr
+                          ? state.shared_buffers->upload(j)
+                          : bonobo::uploadMesh(mesh, state.options.vertices_format));
+    if (mesh.material_index < materials.size()) {
+      objects.back().material_index = mesh.material_index;
+      objects.back().bindings = state.materials[mesh.material_index].bindings;
+      objects.back().material = materials[mesh.material_index].constants;
+    }
+    uploaded_size += computeMeshSize(mesh);
+    has_uploaded = have_objects_changed = true;
+  }
+
+  // Textures are taken in order, without waiting for those still being
+  // decoded.
+  while (!texture_jobs.jobs.empty() && is_within_budget()) {
+    auto const &front = texture_jobs.jobs.front();
+    if (front.image.valid() &&
+        front.image.wait_for(std::chrono::seconds(0)) !=
+            std::future_status::ready)
+      break;
+
+    auto job = texture_jobs.pop();
+    auto const &texture = *job.texture;
+    auto const &material = materials[job.material_index];
+    GLuint id = 0u;
+    if (!job.image.valid()) {
+      id = acquireRegisteredTexture(job.key);
+      if (id != 0u)
+        ++state.shared_texture_count;
+    } else {
+      auto image = job.image.get();
+      id = uploadTexture2D(image, /* generate_mipmap */ true);
+      auto const memory_size =
+          computeTextureMemorySize(image, /* generate_mipmap */ true);
+      registerTexture(job.key, id, memory_size);
+      if (id != 0u) {
+        ++state.texture_count;
+        utils::opengl::debug::nameObject(GL_TEXTURE, id,
+                                         material.name + " " +
+                                             texture.type_name);
+      }
+      uploaded_size += memory_size;
+      has_uploaded = true;
+    }
+    if (id == 0u) {
+      LogWarning("Failed to load the %s texture for material \"%s\".",
+                 texture.type_name.c_str(), material.name.c_str());
+      continue;
+    }
+
+    state.materials[job.material_index].bindings.emplace(texture.sampler_name,
+                                                         id);
+    for (size_t j = 0; j < objects.size(); ++j)
+      if (meshes[j].material_index == job.material_index) {
+        objects[j].bindings.emplace(texture.sampler_name, id);
+        have_objects_changed = true;
+      }
+  }
+
+  if (has_uploaded)
+    ++state.uploads_nb;
+  if (is_complete())
+    LogInfo("┕ Scene streamed in %.3f s: %s in %.3f s, then %zu meshes and "
+            "%u textures uploaded over %zu frames (%u more textures were "
+            "shared)",
+            std::chrono::duration<float>(
+                std::chrono::high_resolution_clock::now() - state.start_time)
+                .count(),
+            state.source->is_cached ? "cache read" : "imported",
+            state.source->reading_duration, objects.size(),
+            state.texture_count, state.uploads_nb,
+            state.shared_texture_count);
+
+  return have_objects_changed;
+}
+
+std::vector<bonobo::mesh_data> const &
+bonobo::streamed_objects::get_objects() const {
+  return _state->objects;
+}
+
+std::vector<bonobo::scene_material> const &
+bonobo::streamed_objects::get_materials() const {
+  return _state->materials;
+}
+
+bool bonobo::streamed_objects::is_complete() const {
+  return _state->source != nullptr &&
+         _state->objects.size() == _state->source->meshes.size() &&
+         _state->texture_jobs->is_done();
+}
+
+bool bonobo::streamed_objects::has_failed() const {
+  return _state->has_failed;
+}
+
+std::unique_ptr<bonobo::streamed_objects>
+bonobo::loadObjectsAsync(std::string const &filename,
+                         mesh_load_options const &options) {
+  std::unique_ptr<streamed_objects::state> state(new streamed_objects::state);
+  state->filename = filename;
+  state->options = options;
+  state->start_time = std::chrono::high_resolution_clock::now();
+  state->reading = std::async(std::launch::async, [filename, options]() {
+    std::unique_ptr<scene_source> source(new scene_source);
+    if (!readSceneSource(filename, options, *source))
+      source.reset();
+    return source;
+  });
+
+  return std::unique_ptr<streamed_objects>(
+      new streamed_objects(std::move(state)));
+}
+
+struct bonobo::asset_batch::state {
+  std::chrono::high_resolution_clock::time_point start_time;
+
+  std::vector<texture_request> texture_requests;
+  std::vector<std::string> texture_keys;
+  // Images decoded for each texture request; invalid for those sharing
+  // a texture that was already loaded, or requested earlier on.
+  std::vector<std::future<decoded_image>> images;
+  std::vector<GLuint> textures; // 0 until uploaded
+  std::size_t next_texture{0u};
+
+  std::vector<std::unique_ptr<streamed_objects>> scenes;
+
+  asset_batch_callback on_complete;
+  batch_load_report report;
+  bool is_complete{false};
+};
+
+bonobo::asset_batch::asset_batch(std::unique_ptr<state> state)
+    : _state(std::move(state)) {}
+
+bonobo::asset_batch::~asset_batch() {
+  // Staged images have to give their slot back before the ring may go.
+  for (auto &image : _state->images)
+    if (image.valid())
+      image.wait();
+}
+
+bool bonobo::asset_batch::upload(upload_budget const &budget) {
+  auto &state = *_state;
+  if (state.is_complete)
+    return false;
+
+  auto const upload_start_time = std::chrono::high_resolution_clock::now();
+  auto const get_elapsed_time = [&upload_start_time]() {
+    return std::chrono::duration<float, std::milli>(
+               std::chrono::high_resolution_clock::now() - upload_start_time)
+        .count();
+  };
+  std::size_t uploaded_size = 0u;
+  bool has_uploaded = false;
+  auto const is_within_budget = [&]() {
+    return !has_uploaded || (uploaded_size < budget.max_bytes &&
+                             get_elapsed_time() < budget.max_duration);
+  };
+
+  // Textures are taken in order, without waiting for those still being
+  // decoded.
+  auto &report = state.report;
+  while (state.next_texture < state.texture_requests.size() &&
+         is_within_budget()) {
+    auto const i = state.next_texture;
+    auto &image_future = state.images[i];
+    if (image_future.valid() &&
+        image_future.wait_for(std::chrono::seconds(0)) !=
+            std::future_status::ready)
+      break;
+    ++state.next_texture;
+
+    auto const &request = state.texture_requests[i];
+    GLuint id = 0u;
+    if (!image_future.valid()) {
+      id = acquireRegisteredTexture(state.texture_keys[i]);
+      if (id != 0u) {
+        ++report.shared_textures_nb;
+      } else {
+        // It got released in the meantime.
+        id = bonobo::loadTexture2D(request.filename, request.generate_mipmap,
+                                   request.compression);
+        ++report.textures_nb;
+      }
+    } else {
+      auto image = image_future.get();
+      id = uploadTexture2D(image, request.generate_mipmap);
+      auto const memory_size =
+          computeTextureMemorySize(image, request.generate_mipmap);
+      registerTexture(state.texture_keys[i], id, memory_size);
+      utils::opengl::debug::nameObject(GL_TEXTURE, id, request.filename);
+      report.decoding_duration += image.decoding_duration;
+      ++report.textures_nb;
+      if (!image.is_valid)
+        ++report.failed_textures_nb;
+      uploaded_size += memory_size;
+    }
+    state.textures[i] = id;
+    has_uploaded = true;
+  }
+
+  // Scenes share what is left of the time budget.
+  bool have_objects_changed = false;
+  for (auto const &scene : state.scenes) {
+    if (scene->is_complete() || scene->has_failed())
+      continue;
+    auto const elapsed_time = get_elapsed_time();
+    if (has_uploaded && (elapsed_time >= budget.max_duration ||
+                         uploaded_size >= budget.max_bytes))
+      break;
+    upload_budget scene_budget = budget;
+    scene_budget.max_duration = budget.max_duration - elapsed_time;
+    scene_budget.max_bytes = budget.max_bytes - uploaded_size;
+    if (scene->upload(scene_budget))
+      has_uploaded = have_objects_changed = true;
+  }
+
+  auto const is_done = [](std::unique_ptr<streamed_objects> const &scene) {
+    return scene->is_complete() || scene->has_failed();
+  };
+  if (state.next_texture < state.texture_requests.size() ||
+      !std::all_of(state.scenes.begin(), state.scenes.end(), is_done))
+    return has_uploaded;
+
+  state.is_complete = true;
+  report.duration = std::chrono::duration<float>(
+                        std::chrono::high_resolution_clock::now() -
+                        state.start_time)
+                        .count();
+  for (auto const &scene : state.scenes) {
+    if (scene->has_failed()) {
+      ++report.failed_scenes_nb;
+      continue;
+    }
+    ++report.scenes_nb;
+    report.objects_nb += scene->get_objects().size();
+  }
+  LogInfo("Batch of %zu textures and %zu scenes loaded in %.3f s: %zu "
+          "textures decoded in %.3f s spread over %zu workers (%zu more were "
+          "shared), %zu objects; %zu textures and %zu scenes failed to load",
+          state.texture_requests.size(), state.scenes.size(),
+          report.duration, report.textures_nb,
+          report.decoding_duration / 1000.0f,
+          utils::get_shared_thread_pool().size(), report.shared_textures_nb,
+          report.objects_nb, report.failed_textures_nb,
+          report.failed_scenes_nb);
+  if (state.on_complete)
+    state.on_complete(*this);
+
+  return has_uploaded;
+}
+
+void bonobo::asset_batch::wait() {
+  upload_budget unlimited;
+  unlimited.max_bytes = std::numeric_limits<std::size_t>::max();
+  unlimited.max_duration = std::numeric_limits<float>::max();
+  while (!_state->is_complete) {
+    // Textures are waited for in order, scenes by polling them.
+    auto &state = *_state;
+    if (state.next_texture < state.images.size() &&
+        state.images[state.next_texture].valid())
+      state.images[state.next_texture].wait();
+    if (!upload(unlimited) && !_state->is_complete)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+bool bonobo::asset_batch::is_complete() const { return _state->is_complete; }
+
+GLuint bonobo::asset_batch::get_texture(std::size_t index) const {
+  assert(index < _state->textures.size());
+  return _state->textures[index];
+}
+
+bonobo::streamed_objects const &
+bonobo::asset_batch::get_scene(std::size_t index) const {
+  assert(index < _state->scenes.size());
+  return *_state->scenes[index];
+}
+
+bonobo::batch_load_report const &bonobo::asset_batch::get_report() const {
+  return _state->report;
+}
+
+std::unique_ptr<bonobo::asset_batch>
+bonobo::loadAssetsAsync(std::vector<texture_request> const &textures,
+                        std::vector<objects_request> const &scenes,
+                        asset_batch_callback on_complete) {
+  std::unique_ptr<asset_batch::state> state(new asset_batch::state);
+  state->start_time = std::chrono::high_resolution_clock::now();
+  state->on_complete = std::move(on_complete);
+
+  // Scenes take the longest to read, so they get started first.
+  for (auto const &scene : scenes)
+    state->scenes.push_back(loadObjectsAsync(scene.filename, scene.options));
+
+  auto &thread_pool = utils::get_shared_thread_pool();
+  auto &ring = getTextureUploadRing();
+  auto const upload_ring = ring.is_valid() ? &ring : nullptr;
+  std::unordered_set<std::string> keys_being_decoded;
+  state->texture_requests = textures;
+  state->images.resize(textures.size());
+  state->textures.resize(textures.size(), 0u);
+  for (std::size_t i = 0u; i < textures.size(); ++i) {
+    auto &request = state->texture_requests[i];
+    if (!isTextureCompressionSupported(request.compression))
+      request.compression = texture_compression::none;
+    texture_load_options options;
+    options.generate_mipmap = request.generate_mipmap;
+    options.compression = request.compression;
+    state->texture_keys.push_back(
+        getTextureKey(request.filename, /* flip */ true, options));
+    if (texture_registry.textures.find(state->texture_keys.back()) !=
+            texture_registry.textures.end() ||
+        !keys_being_decoded.insert(state->texture_keys.back()).second)
+      continue;
+
+    auto const path = request.filename;
+    state->images[i] = thread_pool.submit([path, options, upload_ring]() {
+      auto image = decodeImage(path, /* flip */ true, options);
+      if (upload_ring != nullptr)
+        stageImage(image, *upload_ring);
+      return image;
+    });
+  }
+
+  return std::unique_ptr<asset_batch>(new asset_batch(std::move(state)));
+}
+
+bool bonobo::bakeSceneMeshes(std::string const &filename,
+                             mesh_load_options const &options,
+                             scene_bake_report &report) {
+  report = scene_bake_report();
+
+  scene_source source;
+  if (!readSceneSource(filename, options, source))
+    return false;
+
+  report.was_cached = source.is_cached;
+  report.reading_duration = source.reading_duration;
+  report.triangle_order_duration = source.triangle_order_duration;
+  report.lods_duration = std::max(source.lods_duration, 0.0f);
+  report.meshes_nb = source.meshes.size();
+  for (auto const &mesh : source.meshes) {
+    report.vertices_nb += mesh.vertices_nb;
+    report.triangles_nb +=
+        (mesh.lods_nb > 0u ? mesh.lods[0].indices_nb : mesh.indices_nb) / 3u;
+  }
+
+  // Same paths and options as used by texture_job_queue.
+  auto const end_of_basedir = filename.rfind("/");
+  auto const parent_folder = (end_of_basedir != std::string::npos
+                                  ? filename.substr(0, end_of_basedir)
+                                  : ".") +
+                             "/";
+  std::unordered_set<std::string> keys;
+  for (auto const &material : source.materials)
+    for (auto const &texture : material.textures) {
+      auto const path = parent_folder + texture.path;
+      auto const load_options = getSceneTextureLoadOptions(
+          texture.type_name, options.textures_compression);
+      if (load_options.compression == texture_compression::none ||
+          !keys.insert(getTextureKey(path, /* flip */ true, load_options))
+               .second)
+        continue;
+      report.textures.push_back(
+          {path, texture.type_name, options.textures_compression});
+    }
+
+  return true;
+}
+
+bonobo::texture_bake_report
+bonobo::bakeTexture(texture_bake_job const &job) {
+  auto const image =
+      decodeImage(job.path, /* flip */ true,
+                  getSceneTextureLoadOptions(job.type_name, job.compression));
+
+  texture_bake_report report;
+  report.has_failed = !image.is_valid;
+  report.was_cached = image.is_cached;
+  report.compression_duration = image.compression_duration;
+  report.decoding_duration =
+      image.decoding_duration - image.compression_duration;
+  report.texels_nb = static_cast<std::size_t>(image.width) * image.height;
+  for (auto const &level : image.compressed.levels)
+    report.compressed_size += level.size();
+  return report;
+}
+
+void bonobo::drawMesh(mesh_data const &mesh, std::size_t lod) {
+  if (mesh.ibo == 0u) {
+    glDrawArrays(mesh.drawing_mode, mesh.base_vertex, mesh.vertices_nb);
+    return;
+  }
+
+  auto first_index = static_cast<std::uintptr_t>(mesh.first_index);
+  auto indices_nb = mesh.indices_nb;
+  if (lod < mesh.lods.size()) {
+    first_index += mesh.lods[lod].first_index;
+    indices_nb = static_cast<GLsizei>(mesh.lods[lod].indices_nb);
+  }
+
+  auto const index_size =
+      mesh.indices_type == GL_UNSIGNED_SHORT ? sizeof(GLushort)
+                                             : sizeof(GLuint);
+  glDrawElementsBaseVertex(
+      mesh.drawing_mode, indices_nb, mesh.indices_type,
+      reinterpret_cast<GLvoid const *>(first_index * index_size),
+      mesh.base_vertex);
+}
+
+std::size_t bonobo::selectLod(std::vector<mesh_lod> const &lods,
+                              bounding_sphere const &sphere,
+                              glm::mat4 const &view_projection,
+                              glm::mat4 const &world,
+                              std::size_t current_lod) {
+  // Errors are compared in normalised device coordinates, where the
+  // viewport is two units high: a pixel at 1080p is therefore 2/1080.
+  float const max_screen_error = 2.0f / 1080.0f;
+  float const coarsening_hysteresis = 0.75f;
+
+  if (lods.size() < 2u || sphere.radius <= 0.0f)
+    return 0u;
+
+  auto const world_radius =
+      sphere.radius * std::max(glm::length(glm::vec3(world[0])),
+                               std::max(glm::length(glm::vec3(world[1])),
+                                        glm::length(glm::vec3(world[2]))));
+  auto const clip_centre =
+      view_projection * (world * glm::vec4(sphere.centre, 1.0f));
+  if (clip_centre.w <= world_radius)
+    return 0u; // the viewer is inside, or very close to, the mesh
+
+  // For a perspective (or orthographic) projection following a rigid
+  // view transform, the length of the second row is the vertical
+  // scaling applied by the projection.
+  auto const projection_scale =
+      glm::length(glm::vec3(view_projection[0][1], view_projection[1][1],
+                            view_projection[2][1]));
+  auto const projected_radius =
+      world_radius * projection_scale / clip_centre.w;
+
+  auto lod = std::min(current_lod, lods.size() - 1u);
+  while (lod > 0u && lods[lod].error * projected_radius > max_screen_error)
+    --lod;
+  while (lod + 1u < lods.size() &&
+         lods[lod + 1u].error * projected_radius <=
+             coarsening_hysteresis * max_screen_error)
+    ++lod;
+  return lod;
+}
+
+std::size_t bonobo::cullClusters(mesh_data const &mesh,
+                                 glm::mat4 const &view_projection,
+                                 glm::mat4 const &world,
+                                 glm::vec3 const &viewer_position,
+                                 cluster_draw_list &draws) {
+  draws.counts.clear();
+  draws.offsets.clear();
+  draws.base_vertices.clear();
+
+  // Both tests are done in model-space, which avoids transforming every
+  // cluster: the frustum planes are extracted from the model-to-clip
+  // matrix (Gribb and Hartmann), and the viewer brought into model-space.
+  auto const model_to_clip = view_projection * world;
+  std::array<glm::vec4, 6> planes;
+  for (int k = 0; k < 3; ++k) {
+    auto const row = glm::vec4(model_to_clip[0][k], model_to_clip[1][k],
+                               model_to_clip[2][k], model_to_clip[3][k]);
+    auto const w_row = glm::vec4(model_to_clip[0][3], model_to_clip[1][3],
+                                 model_to_clip[2][3], model_to_clip[3][3]);
+    planes[2 * k] = w_row + row;
+    planes[2 * k + 1] = w_row - row;
+  }
+  for (auto &plane : planes)
+    plane /= glm::length(glm::vec3(plane));
+  auto const viewer =
+      glm::vec3(glm::inverse(world) * glm::vec4(viewer_position, 1.0f));
+
+  auto const index_size = mesh.indices_type == GL_UNSIGNED_SHORT
+                              ? sizeof(GLushort)
+                              : sizeof(GLuint);
+  std::size_t kept_clusters_nb = 0u;
+  std::uint32_t range_end = 0u;
+  for (auto const &cluster : mesh.clusters) {
+    auto const &centre = cluster.sphere.centre;
+    auto const radius = cluster.sphere.radius;
+
+    bool is_outside = false;
+    for (auto const &plane : planes)
+      is_outside |= glm::dot(glm::vec3(plane), centre) + plane.w < -radius;
+    if (is_outside)
+      continue;
+
+    auto const to_cluster = centre - viewer;
+    if (glm::dot(to_cluster, cluster.cone_axis) >=
+        cluster.cone_cutoff * glm::length(to_cluster) + radius)
+      continue;
+
+    ++kept_clusters_nb;
+    if (!draws.counts.empty() && cluster.first_index == range_end) {
+      draws.counts.back() += static_cast<GLsizei>(cluster.indices_nb);
+    } else {
+      draws.counts.push_back(static_cast<GLsizei>(cluster.indices_nb));
+      draws.offsets.push_back(reinterpret_cast<GLvoid const *>(
+          (static_cast<std::uintptr_t>(mesh.first_index) +
+           cluster.first_index) *
+          index_size));
+      draws.base_vertices.push_back(mesh.base_vertex);
+    }
+    range_end = cluster.first_index + cluster.indices_nb;
+  }
+
+  return kept_clusters_nb;
+}
+
+void bonobo::drawClusters(mesh_data const &mesh,
+                          cluster_draw_list const &draws) {
+  if (draws.counts.empty())
+    return;
+
+  glMultiDrawElementsBaseVertex(
+      mesh.drawing_mode, draws.counts.data(), mesh.indices_type,
+      draws.offsets.data(), static_cast<GLsizei>(draws.counts.size()),
+      draws.base_vertices.data());
+}
+
 GLuint bonobo::createTexture(uint32_t width, uint32_t height, GLenum target,
                              GLint internal_format, GLenum format, GLenum type,
                              GLvoid const *data) {
   GLuint texture = 0u;
   glGenTextures(1, &texture);
   assert(texture != 0u);
-  glBindTexture(target, texture);
+  bonobo::state::bindTexture(target, texture);
   glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
   glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
   switch (target) {
@@ -450,44 +1709,120 @@ GLuint bonobo::createTexture(uint32_t width, uint32_t height, GLenum target,
                  static_cast<GLsizei>(height), 0, format, type, data);
     break;
   default:
-    glDeleteTextures(1, &texture);
+    bonobo::state::deleteTextures(1, &texture);
     LogError("Non-handled texture target: %08x.\n", target);
     return 0u;
   }
-  glBindTexture(target, 0u);
+  bonobo::state::bindTexture(target, 0u);
 
   return texture;
 }
 
 GLuint bonobo::loadTexture2D(std::string const &filename,
-                             bool generate_mipmap) {
-  std::uint32_t width, height;
-  auto const data = getTextureData(filename, width, height, true);
-  if (data.empty())
-    return 0u;
-
-  GLuint texture = bonobo::createTexture(
-      width, height, GL_TEXTURE_2D, GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE,
-      reinterpret_cast<GLvoid const *>(data.data()));
-  glBindTexture(GL_TEXTURE_2D, texture);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
-                  generate_mipmap ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  if (generate_mipmap)
-    glGenerateMipmap(GL_TEXTURE_2D);
-  glBindTexture(GL_TEXTURE_2D, 0u);
+                             bool generate_mipmap,
+                             texture_compression compression) {
+  if (!isTextureCompressionSupported(compression))
+    compression = texture_compression::none;
+  texture_load_options options;
+  options.generate_mipmap = generate_mipmap;
+  options.compression = compression;
+  auto const key = getTextureKey(filename, /* flip */ true, options);
+  auto const registered_texture = acquireRegisteredTexture(key);
+  if (registered_texture != 0u) {
+    LogTrivia("Reusing the already loaded texture \"%s\"", filename.c_str());
+    return registered_texture;
+  }
 
+  auto image = decodeImage(filename, /* flip */ true, options);
+  auto const texture = uploadTexture2D(image, generate_mipmap);
+  registerTexture(key, texture,
+                  computeTextureMemorySize(image, generate_mipmap));
   return texture;
 }
 
+void bonobo::releaseTexture(GLuint texture) {
+  if (texture == 0u)
+    return;
+
+  auto const key_it = texture_registry.keys.find(texture);
+  if (key_it == texture_registry.keys.end()) {
+    bonobo::state::deleteTextures(1, &texture);
+    return;
+  }
+
+  auto const texture_it = texture_registry.textures.find(key_it->second);
+  assert(texture_it != texture_registry.textures.end());
+  if (--texture_it->second.references_nb > 0u)
+    return;
+
+  bonobo::state::deleteTextures(1, &texture);
+  texture_registry.textures.erase(texture_it);
+  texture_registry.keys.erase(key_it);
+}
+
+bonobo::texture_registry_stats bonobo::getTextureRegistryStats() {
+  texture_registry_stats stats;
+  stats.textures_nb = texture_registry.textures.size();
+  for (auto const &entry : texture_registry.textures) {
+    stats.references_nb += entry.second.references_nb;
+    stats.memory_used += entry.second.memory_size;
+  }
+  stats.memory_saved = texture_registry.memory_saved;
+  return stats;
+}
+
 GLuint
 bonobo::loadTextureCubeMap(std::string const &posx, std::string const &negx,
                            std::string const &posy, std::string const &negy,
                            std::string const &posz, std::string const &negz,
                            bool generate_mipmap) {
+  // Reading and decoding the images takes far longer than sending them
+  // to the GPU, so all six faces are decoded at the same time, each on a
+  // thread of its own, and only then handed over to OpenGL. Their mipmap
+  // hierarchies, if any, get computed on those threads as well.
+  struct face {
+    GLenum target;
+    std::string const &path;
+    std::future<decoded_image> image;
+  };
+  std::array<face, 6> faces = {{{GL_TEXTURE_CUBE_MAP_POSITIVE_X, posx, {}},
+                                {GL_TEXTURE_CUBE_MAP_NEGATIVE_X, negx, {}},
+                                {GL_TEXTURE_CUBE_MAP_POSITIVE_Y, posy, {}},
+                                {GL_TEXTURE_CUBE_MAP_NEGATIVE_Y, negy, {}},
+                                {GL_TEXTURE_CUBE_MAP_POSITIVE_Z, posz, {}},
+                                {GL_TEXTURE_CUBE_MAP_NEGATIVE_Z, negz, {}}}};
+  texture_load_options options;
+  options.generate_mipmap = generate_mipmap;
+  auto &thread_pool = utils::get_shared_thread_pool();
+  for (auto &face : faces) {
+    auto const path = face.path;
+    face.image = thread_pool.submit([path, options]() {
+      return decodeImage(path, /* flip */ false, options);
+    });
+  }
+
+  std::array<decoded_image, 6> images;
+  for (size_t i = 0u; i < faces.size(); ++i)
+    images[i] = faces[i].image.get();
+
+  // All faces of a cube map have to be square and of the same size.
+  auto const width = images[0].width, height = images[0].height;
+  for (size_t i = 0u; i < images.size(); ++i) {
+    auto const &image = images[i];
+    if (!image.is_valid || image.width != width || image.height != height ||
+        width != height) {
+      LogError("Failed to load cube map face \"%s\": all six faces need to "
+               "be decoded successfully, be square, and be of the same size.",
+               faces[i].path.c_str());
+      return 0u;
+    }
+  }
+  auto const levels_nb =
+      generate_mipmap ? 1u + images[0].mipmaps.size() : std::size_t(1u);
+
   GLuint texture = 0u;
   // Create an OpenGL texture object. Similarly to `glGenVertexArrays()`
-  // and `glGenBuffers()` that were used in assignment 2,
+  // and `glGenBuffers()` that were used in assignment 2,
   // `glGenTextures()` can create `n` texture objects at once. Here we
   // only one texture object that will contain our whole cube map.
   glGenTextures(1, &texture);
@@ -498,7 +1833,7 @@ bonobo::loadTextureCubeMap(std::string const &posx, std::string const &negx,
   // GL_TEXTURE_CUBE_MAP target to indicate we want a cube map. If you
   // look at `bonobo::loadTexture2D()` just above, you will see that
   // GL_TEXTURE_2D is used there, as we want a simple 2D-texture.
-  glBindTexture(GL_TEXTURE_CUBE_MAP, texture);
+  bonobo::state::bindTexture(GL_TEXTURE_CUBE_MAP, texture);
 
   // Set the wrapping properties of the texture; you can have a look on
   // http://docs.gl to learn more about them
@@ -510,156 +1845,71 @@ bonobo::loadTextureCubeMap(std::string const &posx, std::string const &negx,
   // you can have a look on http://docs.gl to lear more about them, or
   // attend EDAN35 in the next period ;-)
   glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER,
-                  generate_mipmap ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+                  levels_nb > 1u ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
   glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-  // We need to fill in the cube map using the images passed in as
-  // argument. The function `getTextureData()` uses stb to read in the
-  // image files and return a `std::vector<std::uint8_t>` containing all the
-  // texels.
-  std::uint32_t width, height;
-  auto data = getTextureData(negx, width, height, false);
-  if (data.empty()) {
-    glDeleteTextures(1, &texture);
-    return 0u;
-  }
+  // Allocate the memory for all faces and all mipmap levels at once;
+  // such immutable storage lets the driver skip checking whether the
+  // texture is complete every time it is used. It is only part of core
+  // OpenGL since 4.2, so older implementations allocate each face and
+  // level separately instead, using `glTexImage2D()`.
+  auto const has_immutable_storage = GLAD_GL_VERSION_4_2 != 0;
+  if (has_immutable_storage)
+    glTexStorage2D(GL_TEXTURE_CUBE_MAP, static_cast<GLsizei>(levels_nb),
+                   GL_RGBA8, static_cast<GLsizei>(width),
+                   static_cast<GLsizei>(height));
+  else
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAX_LEVEL,
+                    static_cast<GLint>(levels_nb) - 1);
+
   // With all the texels available on the CPU, we now want to push them
-  // to the GPU: this is done using `glTexImage2D()` (among others). You
-  // might have thought that the target used here would be the same as
-  // the one passed to `glBindTexture()` or `glTexParameteri()`, similar
-  // to what is done `bonobo::loadTexture2D()`. However, we want to fill
-  // in a cube map, which has six different faces, so instead we specify
-  // as the target the face we want to fill in. In this case, we will
-  // start by filling the face sitting on the negative side of the
-  // x-axis by specifying GL_TEXTURE_CUBE_MAP_NEGATIVE_X.
-  glTexImage2D(
-      GL_TEXTURE_CUBE_MAP_NEGATIVE_X,
-      /* mipmap level, you'll see that in EDAN35 */ 0,
-      /* how are the components internally stored */ GL_RGBA,
-      /* the width of the cube map's face */ static_cast<GLsizei>(width),
-      /* the height of the cube map's face */ static_cast<GLsizei>(height),
-      /* must always be 0 */ 0,
-      /* the format of the pixel data: which components are available */
-      GL_RGBA,
-      /* the type of each component */ GL_UNSIGNED_BYTE,
-      /* the pointer to the actual data on the CPU */
-      reinterpret_cast<GLvoid const *>(data.data()));
-
-  data = getTextureData(negy, width, height, false);
-  if (data.empty()) {
-    glDeleteTextures(1, &texture);
-    return 0u;
-  }
-  glTexImage2D(
-      GL_TEXTURE_CUBE_MAP_NEGATIVE_Y,
-      /* mipmap level, you'll see that in EDAN35 */ 0,
-      /* how are the components internally stored */ GL_RGBA,
-      /* the width of the cube map's face */ static_cast<GLsizei>(width),
-      /* the height of the cube map's face */ static_cast<GLsizei>(height),
-      /* must always be 0 */ 0,
-      /* the format of the pixel data: which components are available */
-      GL_RGBA,
-      /* the type of each component */ GL_UNSIGNED_BYTE,
-      /* the pointer to the actual data on the CPU */
-      reinterpret_cast<GLvoid const *>(data.data()));
-
-  data = getTextureData(negz, width, height, false);
-  if (data.empty()) {
-    glDeleteTextures(1, &texture);
-    return 0u;
-  }
-  glTexImage2D(
-      GL_TEXTURE_CUBE_MAP_NEGATIVE_Z,
-      /* mipmap level, you'll see that in EDAN35 */ 0,
-      /* how are the components internally stored */ GL_RGBA,
-      /* the width of the cube map's face */ static_cast<GLsizei>(width),
-      /* the height of the cube map's face */ static_cast<GLsizei>(height),
-      /* must always be 0 */ 0,
-      /* the format of the pixel data: which components are available */
-      GL_RGBA,
-      /* the type of each component */ GL_UNSIGNED_BYTE,
-      /* the pointer to the actual data on the CPU */
-      reinterpret_cast<GLvoid const *>(data.data()));
-
-  data = getTextureData(posx, width, height, false);
-  if (data.empty()) {
-    glDeleteTextures(1, &texture);
-    return 0u;
-  }
-  glTexImage2D(
-      GL_TEXTURE_CUBE_MAP_POSITIVE_X,
-      /* mipmap level, you'll see that in EDAN35 */ 0,
-      /* how are the components internally stored */ GL_RGBA,
-      /* the width of the cube map's face */ static_cast<GLsizei>(width),
-      /* the height of the cube map's face */ static_cast<GLsizei>(height),
-      /* must always be 0 */ 0,
-      /* the format of the pixel data: which components are available */
-      GL_RGBA,
-      /* the type of each component */ GL_UNSIGNED_BYTE,
-      /* the pointer to the actual data on the CPU */
-      reinterpret_cast<GLvoid const *>(data.data()));
-
-  data = getTextureData(posy, width, height, false);
-  if (data.empty()) {
-    glDeleteTextures(1, &texture);
-    return 0u;
-  }
-  glTexImage2D(
-      GL_TEXTURE_CUBE_MAP_POSITIVE_Y,
-      /* mipmap level, you'll see that in EDAN35 */ 0,
-      /* how are the components internally stored */ GL_RGBA,
-      /* the width of the cube map's face */ static_cast<GLsizei>(width),
-      /* the height of the cube map's face */ static_cast<GLsizei>(height),
-      /* must always be 0 */ 0,
-      /* the format of the pixel data: which components are available */
-      GL_RGBA,
-      /* the type of each component */ GL_UNSIGNED_BYTE,
-      /* the pointer to the actual data on the CPU */
-      reinterpret_cast<GLvoid const *>(data.data()));
-
-  data = getTextureData(posz, width, height, false);
-  if (data.empty()) {
-    glDeleteTextures(1, &texture);
-    return 0u;
+  // to the GPU. You might have thought that the target used here would
+  // be the same as the one passed to `glBindTexture()` or
+  // `glTexParameteri()`, similar to what is done in
+  // `bonobo::loadTexture2D()`. However, we want to fill in a cube map,
+  // which has six different faces, so instead we specify as the target
+  // the face we want to fill in, e.g. GL_TEXTURE_CUBE_MAP_NEGATIVE_X for
+  // the face sitting on the negative side of the x-axis.
+  for (size_t i = 0u; i < faces.size(); ++i) {
+    for (size_t level = 0u; level < levels_nb; ++level) {
+      auto const level_width =
+          level == 0u ? width : images[i].mipmaps[level - 1u].width;
+      auto const level_height =
+          level == 0u ? height : images[i].mipmaps[level - 1u].height;
+      auto const data = level == 0u ? images[i].data.data()
+                                    : images[i].mipmaps[level - 1u].data.data();
+      if (has_immutable_storage)
+        glTexSubImage2D(faces[i].target, static_cast<GLint>(level), 0, 0,
+                        static_cast<GLsizei>(level_width),
+                        static_cast<GLsizei>(level_height), GL_RGBA,
+                        GL_UNSIGNED_BYTE,
+                        reinterpret_cast<GLvoid const *>(data));
+      else
+        glTexImage2D(faces[i].target, static_cast<GLint>(level), GL_RGBA8,
+                     static_cast<GLsizei>(level_width),
+                     static_cast<GLsizei>(level_height), 0, GL_RGBA,
+                     GL_UNSIGNED_BYTE, reinterpret_cast<GLvoid const *>(data));
+    }
   }
-  glTexImage2D(
-      GL_TEXTURE_CUBE_MAP_POSITIVE_Z,
-      /* mipmap level, you'll see that in EDAN35 */ 0,
-      /* how are the components internally stored */ GL_RGBA,
-      /* the width of the cube map's face */ static_cast<GLsizei>(width),
-      /* the height of the cube map's face */ static_cast<GLsizei>(height),
-      /* must always be 0 */ 0,
-      /* the format of the pixel data: which components are available */
-      GL_RGBA,
-      /* the type of each component */ GL_UNSIGNED_BYTE,
-      /* the pointer to the actual data on the CPU */
-      reinterpret_cast<GLvoid const *>(data.data()));
-
-  if (generate_mipmap)
-    // Generate the mipmap hierarchy; wait for EDAN35 to understand
-    // what it does
-    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-
-  glBindTexture(GL_TEXTURE_CUBE_MAP, 0u);
+
+  bonobo::state::bindTexture(GL_TEXTURE_CUBE_MAP, 0u);
 
   return texture;
 }
 
 GLuint bonobo::createProgram(std::string const &vert_shader_source_path,
                              std::string const &frag_shader_source_path) {
-  auto const vertex_shader_source =
-      utils::slurp_file(config::shaders_path(vert_shader_source_path));
-  GLuint vertex_shader = utils::opengl::shader::generate_shader(
-      GL_VERTEX_SHADER, vertex_shader_source);
+  GLuint vertex_shader = utils::opengl::shader::generate_shader_from_file(
+      GL_VERTEX_SHADER, config::shaders_path(vert_shader_source_path));
   if (vertex_shader == 0u)
     return 0u;
 
-  auto const fragment_shader_source =
-      utils::slurp_file(config::shaders_path(frag_shader_source_path));
-  GLuint fragment_shader = utils::opengl::shader::generate_shader(
-      GL_FRAGMENT_SHADER, fragment_shader_source);
-  if (fragment_shader == 0u)
+  GLuint fragment_shader = utils::opengl::shader::generate_shader_from_file(
+      GL_FRAGMENT_SHADER, config::shaders_path(frag_shader_source_path));
+  if (fragment_shader == 0u) {
+    glDeleteShader(vertex_shader);
     return 0u;
+  }
 
   GLuint program =
       utils::opengl::shader::generate_program({vertex_shader, fragment_shader});
@@ -684,13 +1934,12 @@ void bonobo::displayTexture(glm::vec2 const &lower_left,
                  relative_to_absolute(upper_right.y, window_size.y)) -
       viewport_origin;
 
-  glViewport(viewport_origin.x, viewport_origin.y, viewport_size.x,
-             viewport_size.y);
-  glUseProgram(local::fullscreen_shader);
-  glBindVertexArray(local::display_vao);
-  glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, texture);
-  glBindSampler(0, sampler);
+  bonobo::state::viewport(viewport_origin.x, viewport_origin.y,
+                          viewport_size.x, viewport_size.y);
+  bonobo::state::useProgram(local::fullscreen_shader);
+  bonobo::state::bindVertexArray(local::display_vao);
+  bonobo::state::bindTextureToUnit(0u, GL_TEXTURE_2D, texture);
+  bonobo::state::bindSampler(0, sampler);
   glUniform1i(glGetUniformLocation(local::fullscreen_shader, "tex"), 0);
   glUniform4iv(glGetUniformLocation(local::fullscreen_shader, "swizzle"), 1,
                glm::value_ptr(swizzle));
@@ -700,9 +1949,11 @@ void bonobo::displayTexture(glm::vec2 const &lower_left,
               nearPlane);
   glUniform1f(glGetUniformLocation(local::fullscreen_shader, "far"), farPlane);
   glDrawArrays(GL_TRIANGLES, 0, 3);
-  glBindSampler(0, 0u);
-  glBindTexture(GL_TEXTURE_2D, 0);
-  glUseProgram(0);
+  // The program, vertex array and texture are left bound, as the same
+  // ones are used for displaying the next texture; the sampler would
+  // override the parameters of whatever texture gets bound to unit 0
+  // next though.
+  bonobo::state::bindSampler(0, 0u);
 }
 
 GLuint bonobo::createFBO(std::vector<GLuint> const &color_attachments,
@@ -718,12 +1969,12 @@ GLuint bonobo::createFBO(std::vector<GLuint> const &color_attachments,
   GLuint fbo = 0u;
   glGenFramebuffers(1, &fbo);
   assert(fbo != 0u);
-  glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+  bonobo::state::bindFramebuffer(GL_FRAMEBUFFER, fbo);
   for (size_t i = 0; i < color_attachments.size(); ++i)
     attach(static_cast<GLenum>(GL_COLOR_ATTACHMENT0 + i), color_attachments[i]);
   if (depth_attachment != 0u)
     attach(GL_DEPTH_ATTACHMENT, depth_attachment);
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  bonobo::state::bindFramebuffer(GL_FRAMEBUFFER, 0);
 
   return fbo;
 }
@@ -737,9 +1988,8 @@ GLuint bonobo::createSampler(std::function<void(GLuint)> const &setup) {
 }
 
 void bonobo::drawFullscreen() {
-  glBindVertexArray(local::display_vao);
+  bonobo::state::bindVertexArray(local::display_vao);
   glDrawArrays(GL_TRIANGLES, 0, 3);
-  glBindVertexArray(0u);
 }
 
 GLuint bonobo::getDebugTextureID() { return debug_texture_id; }
@@ -750,8 +2000,8 @@ void bonobo::renderBasis(float thickness_scale, float length_scale,
   if (basis.shader == 0u)
     return;
 
-  glUseProgram(basis.shader);
-  glBindVertexArray(basis.vao);
+  bonobo::state::useProgram(basis.shader);
+  bonobo::state::bindVertexArray(basis.vao);
   glUniformMatrix4fv(basis.shader_locations.world, 1, GL_FALSE,
                      glm::value_ptr(world));
   glUniformMatrix4fv(basis.shader_locations.view_proj, 1, GL_FALSE,
@@ -760,8 +2010,6 @@ void bonobo::renderBasis(float thickness_scale, float length_scale,
   glUniform1f(basis.shader_locations.length_scale, length_scale);
   glDrawElementsInstanced(GL_TRIANGLES, basis.index_count, GL_UNSIGNED_INT,
                           nullptr, 3);
-  glBindVertexArray(0u);
-  glUseProgram(0u);
 }
 
 bool bonobo::uiSelectCullMode(std::string const &label,
@@ -777,15 +2025,15 @@ bool bonobo::uiSelectCullMode(std::string const &label,
 void bonobo::changeCullMode(enum cull_mode_t const cull_mode) noexcept {
   switch (cull_mode) {
   case bonobo::cull_mode_t::disabled:
-    glDisable(GL_CULL_FACE);
+    bonobo::state::disable(GL_CULL_FACE);
     break;
   case bonobo::cull_mode_t::back_faces:
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
+    bonobo::state::enable(GL_CULL_FACE);
+    bonobo::state::cullFace(GL_BACK);
     break;
   case bonobo::cull_mode_t::front_faces:
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_FRONT);
+    bonobo::state::enable(GL_CULL_FACE);
+    bonobo::state::cullFace(GL_FRONT);
     break;
   }
 }
@@ -804,13 +2052,13 @@ void bonobo::changePolygonMode(
     enum polygon_mode_t const polygon_mode) noexcept {
   switch (polygon_mode) {
   case bonobo::polygon_mode_t::fill:
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    bonobo::state::polygonMode(GL_FRONT_AND_BACK, GL_FILL);
     break;
   case bonobo::polygon_mode_t::line:
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    bonobo::state::polygonMode(GL_FRONT_AND_BACK, GL_LINE);
     break;
   case bonobo::polygon_mode_t::point:
-    glPolygonMode(GL_FRONT_AND_BACK, GL_POINT);
+    bonobo::state::polygonMode(GL_FRONT_AND_BACK, GL_POINT);
     break;
   }
 }
@@ -819,7 +2067,7 @@ namespace {
 void setupBasisData() {
   glGenVertexArrays(1, &basis.vao);
   assert(basis.vao != 0);
-  glBindVertexArray(basis.vao);
+  bonobo::state::bindVertexArray(basis.vao);
 
   glGenBuffers(1, &basis.vbo);
   assert(basis.vbo != 0);
@@ -878,7 +2126,7 @@ void setupBasisData() {
 
   basis.index_count = static_cast<GLsizei>(indices.size() * 3);
 
-  glBindVertexArray(0u);
+  bonobo::state::bindVertexArray(0u);
   glBindBuffer(GL_ARRAY_BUFFER, 0U);
   glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0U);
 
@@ -918,13 +2166,13 @@ void createDebugTexture() {
       debug_texture_content;
   debug_texture_content.fill(0xFFE935DAu);
   glGenTextures(1, &debug_texture_id);
-  glBindTexture(GL_TEXTURE_2D, debug_texture_id);
+  bonobo::state::bindTexture(GL_TEXTURE_2D, debug_texture_id);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
   glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, debug_texture_width,
                debug_texture_height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
                debug_texture_content.data());
-  glBindTexture(GL_TEXTURE_2D, 0u);
+  bonobo::state::bindTexture(GL_TEXTURE_2D, 0u);
 
   utils::opengl::debug::nameObject(GL_TEXTURE, debug_texture_id,
                                    "Debug texture");
@@ -6,7 +6,10 @@
 
 #include "core/FPSCamera.h" // As it includes OpenGL headers, import it after glad
 
+#include <cstddef>
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -21,7 +24,47 @@ namespace bonobo
 		normals,       //!< = 1, value of the binding point for normals
 		texcoords,     //!< = 2, value of the binding point for texcoords
 		tangents,      //!< = 3, value of the binding point for tangents
-		binormals      //!< = 4, value of the binding point for binormals
+		binormals,     //!< = 4, value of the binding point for binormals
+		packed_normals, //!< = 5, value of the binding point for octahedral-encoded normals (see `vertex_format::compact`)
+		packed_tangents, //!< = 6, value of the binding point for octahedral-encoded tangents and binormal signs (see `vertex_format::compact`)
+		instance_model_to_world, //!< = 7 to 10, one per column, value of the binding point for per-instance model-to-world matrices (see `render_queue`)
+		instance_normal_model_to_world = 11u //!< = 11 to 13, one per column, value of the binding point for per-instance normal matrices (see `render_queue`)
+	};
+
+	//! \brief Layout of the vertex attributes and indices of meshes on
+	//!        the GPU.
+	enum class vertex_format : unsigned int {
+		//! Every attribute is stored as three floats, and indices as 32-bit
+		//! unsigned integers.
+		full_precision = 0u,
+		//! Positions are stored as three floats; texture coordinates as two
+		//! half-floats; normals as two normalised shorts, at the
+		//! `packed_normals` binding point; tangents as four normalised
+		//! shorts, at the `packed_tangents` binding point, where the first
+		//! two are the octahedral-encoded tangent and the third one is the
+		//! sign to apply to cross(normal, tangent) to get the binormal.
+		//! Indices are stored as 16-bit unsigned integers when there are
+		//! less than 65536 vertices.
+		//!
+		//! Octahedral-encoded vectors can be decoded in GLSL using:
+		//!
+		//!     vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+		//!     float t = max(-n.z, 0.0);
+		//!     n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+		//!     n = normalize(n);
+		compact
+	};
+
+	//! \brief How textures loaded from files are stored on the GPU.
+	//!
+	//! Compressed textures are encoded once, and cached next to their
+	//! image as KTX2 files; see `core/texture_compression.hpp`. When the
+	//! OpenGL implementation does not support the formats used, textures
+	//! are left uncompressed.
+	enum class texture_compression : unsigned int {
+		none = 0u,    //!< RGBA, 8 bits per channel, with the mip chain generated by OpenGL
+		automatic,    //!< BC1 for fully opaque images and BC3 for the other ones, i.e. 4 to 8 times smaller than `none`
+		two_channels  //!< BC5, which only keeps the red and green channels, for example of normal maps whose third component is reconstructed in the shader
 	};
 
 	//! \brief Association of a sampler name used in GLSL to a
@@ -38,6 +81,53 @@ namespace bonobo
 		float opacity{ 1.0f };
 	};
 
+	//! \brief Kind of shader program a material needs, from the cheapest
+	//!        to the most expensive one to draw.
+	enum class program_hint : unsigned int {
+		opaque = 0u,  //!< fully opaque; can be drawn front-to-back with depth writes
+		alpha_tested, //!< has an opacity texture, whose texels are either kept or discarded
+		translucent   //!< has to be blended with what is behind it
+	};
+
+	//! \brief Material shared by all the meshes of a scene referencing it
+	//!        through `mesh_data::material_index`.
+	struct scene_material {
+		std::string name{"un-named material"};
+		texture_bindings bindings{};          //!< textures of the material
+		material_data constants{};            //!< constant values of the material
+		program_hint hint{program_hint::opaque};
+	};
+
+	//! \brief Range of indices making up one level of detail of a mesh.
+	struct mesh_lod {
+		std::uint32_t first_index{0u}; //!< offset of the first index of this level, from the first index of the mesh
+		std::uint32_t indices_nb{0u};  //!< number of indices of this level
+		float error{0.0f};             //!< largest distance to the full-detail mesh, relative to the radius of its bounding sphere
+	};
+
+	//! \brief Sphere enclosing all the vertices of a mesh, in model-space.
+	struct bounding_sphere {
+		glm::vec3 centre{0.0f};
+		float radius{0.0f};
+	};
+
+	//! \brief Axis-aligned box enclosing all the vertices of a mesh, in
+	//!        model-space.
+	struct bounding_box {
+		glm::vec3 min_corner{0.0f};
+		glm::vec3 max_corner{0.0f};
+	};
+
+	//! \brief Group of neighbouring triangles of a mesh, which can be
+	//!        culled as a whole.
+	struct mesh_cluster {
+		std::uint32_t first_index{0u}; //!< offset of the first index of this cluster, from the first index of the mesh
+		std::uint32_t indices_nb{0u};  //!< number of indices of this cluster
+		bounding_sphere sphere{};      //!< bounds of the triangles of this cluster, in model-space
+		glm::vec3 cone_axis{0.0f};     //!< average direction of the normals of the triangles of this cluster
+		float cone_cutoff{1.0f};       //!< sine of the largest angle between |cone_axis| and a triangle normal; 1 if the cluster can not be back-face culled
+	};
+
 	//! \brief Contains the data for a mesh in OpenGL.
 	struct mesh_data {
 		GLuint vao{0u};                          //!< OpenGL name of the Vertex Array Object
@@ -45,10 +135,26 @@ namespace bonobo
 		GLuint ibo{0u};                          //!< OpenGL name of the Buffer Object for indices
 		GLsizei vertices_nb{0};                  //!< number of vertices stored in bo
 		GLsizei indices_nb{0};                   //!< number of indices stored in ibo
+		GLenum indices_type{GL_UNSIGNED_INT};    //!< type of the indices stored in ibo, i.e. GL_UNSIGNED_INT or GL_UNSIGNED_SHORT
+		GLsizei first_index{0};                  //!< index of the first index of this mesh in ibo, when it is shared with other meshes
+		GLint base_vertex{0};                    //!< index of the first vertex of this mesh in bo, when it is shared with other meshes
 		texture_bindings bindings{};             //!< texture bindings for this mesh
 		material_data material{};                //!< constant values for the material of this mesh
+		std::uint32_t material_index{~0u};       //!< index of the material of this mesh in the table filled in by `loadObjects()`, or ~0u if it has none
 		GLenum drawing_mode{GL_TRIANGLES};       //!< OpenGL drawing mode, i.e. GL_TRIANGLES, GL_LINES, etc.
 		std::string name{"un-named mesh"};       //!< Name of the mesh; used for debugging purposes.
+		bounding_box box{};                      //!< bounds of the mesh
+		bounding_sphere sphere{};                //!< bounds of the mesh, used for selecting its level of detail
+		std::vector<mesh_lod> lods;              //!< levels of detail, from the most detailed one; empty if only the full mesh is available
+		std::vector<mesh_cluster> clusters;      //!< clusters making up the most detailed level, for culling parts of the mesh; empty if not built
+	};
+
+	//! \brief Index ranges of a mesh to draw with a single call to
+	//!        glMultiDrawElementsBaseVertex(); see `cullClusters()`.
+	struct cluster_draw_list {
+		std::vector<GLsizei> counts;
+		std::vector<GLvoid const*> offsets;
+		std::vector<GLint> base_vertices;
 	};
 
 	enum class cull_mode_t : unsigned int {
@@ -69,12 +175,379 @@ namespace bonobo
 	//! \brief Deallocate objects allocated by the `init()` function.
 	void deinit();
 
+	//! \brief Options controlling how `loadObjects()` loads a scene.
+	struct mesh_load_options {
+		//! Whether to read the scene from, and save it to, a binary cache
+		//! file stored next to it (see `core/mesh_cache.hpp`); assimp is
+		//! only run when the cache is missing or out-of-date.
+		bool use_cache{true};
+
+		//! How to store the vertex attributes and indices on the GPU.
+		vertex_format vertices_format{vertex_format::full_precision};
+
+		//! Whether all meshes should share a single VAO, vertex and
+		//! index buffer, rather than having their own; each mesh then
+		//! uses `first_index` and `base_vertex` to find its data, and
+		//! has to be drawn with `drawMesh()` or equivalent.
+		bool share_buffers{false};
+
+		//! Whether to reorder the triangles of each mesh to make better
+		//! use of the post-transform vertex cache and reduce overdraw;
+		//! see `bonobo::optimiseTriangleOrder()`. When a cache is used,
+		//! this is only done once, before writing it.
+		bool optimise_triangle_order{true};
+
+		//! How many levels of detail to generate for each mesh, including
+		//! the full-detail one; 1 disables their generation. See
+		//! `bonobo::generateLods()` and `bonobo::selectLod()`.
+		unsigned int lods_nb{4u};
+
+		//! Whether to split the most detailed level of each mesh into
+		//! clusters of neighbouring triangles, to be culled with
+		//! `bonobo::cullClusters()`; see `bonobo::buildClusters()`.
+		bool build_clusters{true};
+
+		//! How to store the textures of the materials on the GPU, as for
+		//! `loadTexture2D()`. Normal maps are always left uncompressed, as
+		//! shaders expect all three of their components and BC1 distorts
+		//! them too much.
+		texture_compression textures_compression{texture_compression::none};
+
+		//! Whether to order the objects by material, so that drawing them
+		//! in order switches programs and textures as rarely as possible;
+		//! otherwise they keep the order of the file, which callers
+		//! picking them by position rely on.
+		bool sort_by_material{false};
+	};
+
 	//! \brief Load objects found in an object/scene file, using assimp.
 	//!
+	//! glTF 2.0 files are read by `importGltfScene()` instead, which maps
+	//! their buffers rather than going through assimp's intermediate
+	//! representation; assimp is only used for those it can not read.
+	//!
+	//! Identical materials are merged, and the materials sorted by
+	//! `program_hint` then textures; if requested with
+	//! `mesh_load_options::sort_by_material`, objects come out sorted the
+	//! same way, so that drawing them in order changes programs and
+	//! textures as rarely as possible.
+	//!
 	//! @param [in] filename of the object/scene file to load.
+	//! @param [in] options controlling how the file is loaded
 	//! @return a vector of filled in `mesh_data` structures, one per
 	//!         object found in the input file
-	std::vector<mesh_data> loadObjects(std::string const& filename);
+	std::vector<mesh_data> loadObjects(std::string const& filename,
+	                                   mesh_load_options const& options = mesh_load_options());
+
+	//! \brief Load objects found in an object/scene file, as well as the
+	//!        table of materials they reference through
+	//!        `mesh_data::material_index`.
+	//!
+	//! The bindings and constants of each material are also copied into
+	//! the `mesh_data::bindings` and `mesh_data::material` of its objects;
+	//! comparing material indices is however enough to know whether
+	//! anything needs rebinding between two objects.
+	//!
+	//! @param [in] filename of the object/scene file to load.
+	//! @param [out] materials filled in with the deduplicated materials
+	//! @param [in] options controlling how the file is loaded
+	//! @return a vector of filled in `mesh_data` structures, one per
+	//!         object found in the input file
+	std::vector<mesh_data> loadObjects(std::string const& filename,
+	                                   std::vector<scene_material>& materials,
+	                                   mesh_load_options const& options = mesh_load_options());
+
+	//! \brief Amount of work `streamed_objects::upload()` may do in one
+	//!        call.
+	//!
+	//! Uploads stop as soon as either limit is reached; at least one
+	//! mesh or texture is uploaded per call whenever one is ready, so
+	//! that loading always progresses.
+	struct upload_budget {
+		std::size_t max_bytes{16u * 1024u * 1024u}; //!< amount of vertex, index and texture data to upload
+		float max_duration{2.0f};                    //!< time to spend uploading, in milliseconds
+	};
+
+	//! \brief Objects of a scene being loaded in the background; see
+	//!        `loadObjectsAsync()`.
+	class streamed_objects
+	{
+	public:
+		//! \brief Wait for the background work to finish, and drop
+		//!        whatever was not uploaded yet.
+		~streamed_objects();
+
+		//! \brief Upload to OpenGL what the background work has made
+		//!        ready since the last call, within the given budget.
+		//!
+		//! Meshes are uploaded in order, and are usable as soon as they
+		//! appear in `get_objects()`; their texture bindings get filled in
+		//! as the textures of their material are uploaded. This has to be
+		//! called from the thread owning the OpenGL context, typically
+		//! once per frame.
+		//!
+		//! @param [in] budget how much to upload during this call
+		//! @return whether objects were added, or their bindings changed
+		bool upload(upload_budget const& budget = upload_budget());
+
+		//! \brief Retrieve the objects uploaded so far.
+		//!
+		//! Once the scene has been read, storage for all of its objects
+		//! is reserved, so references to the elements stay valid while
+		//! more objects get added.
+		std::vector<mesh_data> const& get_objects() const;
+
+		//! \brief Retrieve the materials referenced by the objects through
+		//!        `mesh_data::material_index`.
+		//!
+		//! The table is complete once the scene has been read; the
+		//! bindings of its materials get filled in as their textures are
+		//! uploaded.
+		std::vector<scene_material> const& get_materials() const;
+
+		//! \brief Whether all objects and textures have been uploaded.
+		bool is_complete() const;
+
+		//! \brief Whether the scene could not be read; nothing will be
+		//!        uploaded in that case.
+		bool has_failed() const;
+
+	private:
+		struct state;
+		explicit streamed_objects(std::unique_ptr<state> state);
+		friend std::unique_ptr<streamed_objects> loadObjectsAsync(std::string const&, mesh_load_options const&);
+
+		std::unique_ptr<state> _state;
+	};
+
+	//! \brief Load objects found in an object/scene file, without blocking
+	//!        the calling thread.
+	//!
+	//! Reading the scene (or its mesh cache) and decoding its textures are
+	//! done on worker threads, while the OpenGL uploads are left to
+	//! `streamed_objects::upload()`, so that a render loop can keep
+	//! running and show the objects as they come in. The objects end up
+	//! identical to the ones returned by `loadObjects()`.
+	//!
+	//! @param [in] filename of the object/scene file to load.
+	//! @param [in] options controlling how the file is loaded
+	//! @return the handle through which to upload and retrieve the objects
+	std::unique_ptr<streamed_objects> loadObjectsAsync(std::string const& filename,
+	                                                   mesh_load_options const& options = mesh_load_options());
+
+	//! \brief Texture to load as part of an `asset_batch`; the options
+	//!        are the ones of `loadTexture2D()`.
+	struct texture_request {
+		std::string filename;
+		bool generate_mipmap{true};
+		texture_compression compression{texture_compression::none};
+	};
+
+	//! \brief Scene to load as part of an `asset_batch`; see
+	//!        `loadObjectsAsync()`.
+	struct objects_request {
+		std::string filename;
+		mesh_load_options options{};
+	};
+
+	//! \brief Work done by an `asset_batch`.
+	struct batch_load_report {
+		float duration{0.0f};                //!< in seconds, from the creation of the batch until everything was uploaded
+		float decoding_duration{0.0f};       //!< in milliseconds, decoding the requested textures, summed over all workers
+		std::size_t textures_nb{0u};         //!< textures decoded and uploaded
+		std::size_t shared_textures_nb{0u};  //!< textures already loaded, or requested more than once
+		std::size_t failed_textures_nb{0u};  //!< images which could not be decoded, and were replaced by a placeholder
+		std::size_t scenes_nb{0u};           //!< scenes whose objects were all uploaded
+		std::size_t failed_scenes_nb{0u};    //!< scenes which could not be read
+		std::size_t objects_nb{0u};          //!< objects of all scenes
+	};
+
+	class asset_batch;
+	using asset_batch_callback = std::function<void(asset_batch const&)>;
+
+	//! \brief Independent textures and scenes being loaded together in the
+	//!        background; see `loadAssetsAsync()`.
+	class asset_batch
+	{
+	public:
+		//! \brief Wait for the background work to finish, and drop
+		//!        whatever was not uploaded yet.
+		~asset_batch();
+
+		//! \brief Upload to OpenGL what the background work has made
+		//!        ready since the last call, within the given budget.
+		//!
+		//! Textures are uploaded in the order they were requested, then
+		//! the scenes are given the remaining time. Once everything is
+		//! uploaded, the completion callback gets called from here. This
+		//! has to be called from the thread owning the OpenGL context,
+		//! typically once per frame.
+		//!
+		//! @param [in] budget how much to upload during this call
+		//! @return whether textures or objects were added
+		bool upload(upload_budget const& budget = upload_budget());
+
+		//! \brief Upload everything, blocking until the background work
+		//!        is over; the completion callback gets called before
+		//!        returning.
+		void wait();
+
+		//! \brief Whether all textures and scenes have been uploaded, or
+		//!        have failed to load.
+		bool is_complete() const;
+
+		//! \brief Retrieve the texture of the |index|-th texture request;
+		//!        0 until it has been uploaded.
+		//!
+		//! As with `loadTexture2D()`, it should be given back with
+		//! `releaseTexture()`.
+		GLuint get_texture(std::size_t index) const;
+
+		//! \brief Retrieve the scene of the |index|-th objects request,
+		//!        whose objects appear as they get uploaded.
+		streamed_objects const& get_scene(std::size_t index) const;
+
+		//! \brief Retrieve what was done so far; complete once
+		//!        `is_complete()` returns true.
+		batch_load_report const& get_report() const;
+
+	private:
+		struct state;
+		explicit asset_batch(std::unique_ptr<state> state);
+		friend std::unique_ptr<asset_batch> loadAssetsAsync(std::vector<texture_request> const&,
+		                                                    std::vector<objects_request> const&,
+		                                                    asset_batch_callback);
+
+		std::unique_ptr<state> _state;
+	};
+
+	//! \brief Load several independent textures and scenes at once,
+	//!        without blocking the calling thread.
+	//!
+	//! All images are decoded concurrently on the shared thread pool, each
+	//! scene is read on a thread of its own as with `loadObjectsAsync()`,
+	//! and only the OpenGL uploads are left to `asset_batch::upload()` or
+	//! `asset_batch::wait()`. Textures requested more than once, or which
+	//! were already loaded, are only decoded once.
+	//!
+	//! @param [in] textures textures to load
+	//! @param [in] scenes scenes to load
+	//! @param [in] on_complete called on the OpenGL thread once everything
+	//!             has been uploaded; may be empty
+	//! @return the handle through which to upload and retrieve the assets
+	std::unique_ptr<asset_batch> loadAssetsAsync(std::vector<texture_request> const& textures,
+	                                             std::vector<objects_request> const& scenes,
+	                                             asset_batch_callback on_complete = asset_batch_callback());
+
+	//! \brief Texture of a scene whose compressed version gets cached; see
+	//!        `bakeSceneMeshes()` and `bakeTexture()`.
+	struct texture_bake_job {
+		std::string path;                //!< path to the image
+		std::string type_name;           //!< kind of texture, e.g. "diffuse"; decides how it gets filtered and compressed
+		texture_compression compression; //!< compression requested for the textures of the scene
+	};
+
+	//! \brief Work done by `bakeSceneMeshes()`.
+	struct scene_bake_report {
+		bool was_cached{false};               //!< whether the mesh cache was already up-to-date
+		float reading_duration{0.0f};         //!< in seconds, reading the cache or importing and processing the scene
+		float triangle_order_duration{0.0f};  //!< in milliseconds; 0 if the triangles were not reordered
+		float lods_duration{0.0f};            //!< in milliseconds; 0 if no levels of detail were generated
+		std::size_t meshes_nb{0u};
+		std::size_t vertices_nb{0u};
+		std::size_t triangles_nb{0u};         //!< of the most detailed levels
+		std::vector<texture_bake_job> textures; //!< textures of the scene which get compressed, without duplicates
+	};
+
+	//! \brief Work done by `bakeTexture()`.
+	struct texture_bake_report {
+		bool has_failed{false};          //!< whether the image could not be decoded
+		bool was_cached{false};          //!< whether its cache was already up-to-date
+		float decoding_duration{0.0f};   //!< in milliseconds, reading and decoding the image, or reading its cache
+		float compression_duration{0.0f}; //!< in milliseconds, building the mip chain and compressing all levels
+		std::size_t texels_nb{0u};       //!< of the most detailed level
+		std::size_t compressed_size{0u}; //!< in bytes, all levels included
+	};
+
+	//! \brief Do all the processing `loadObjects()` would do on the CPU
+	//!        for the meshes of a scene, and write their cache.
+	//!
+	//! No OpenGL function is called, so this can run on any thread
+	//! without a context; textures are left to `bakeTexture()`.
+	//!
+	//! @param [in] filename of the object/scene file to bake
+	//! @param [in] options the scene is going to be loaded with; they
+	//!             are part of what makes its caches valid
+	//! @param [out] report filled in with statistics about the scene
+	//! @return whether the scene could be read
+	bool bakeSceneMeshes(std::string const& filename, mesh_load_options const& options,
+	                     scene_bake_report& report);
+
+	//! \brief Build the mip chain of a texture and compress it, exactly as
+	//!        `loadObjects()` would, and write the result to its cache.
+	//!
+	//! No OpenGL function is called, so this can run on any thread
+	//! without a context.
+	texture_bake_report bakeTexture(texture_bake_job const& job);
+
+	//! \brief Draw a mesh, taking into account its index type and its
+	//!        location in buffers shared with other meshes.
+	//!
+	//! The VAO of the mesh is expected to be bound already, so that
+	//! meshes sharing a VAO can be drawn without rebinding it.
+	//!
+	//! @param [in] mesh the mesh to draw
+	//! @param [in] lod which level of detail to draw; see `selectLod()`
+	void drawMesh(mesh_data const& mesh, std::size_t lod = 0u);
+
+	//! \brief Pick the level of detail of a mesh to draw, based on how
+	//!        large its bounding sphere appears on screen.
+	//!
+	//! The coarsest level whose error stays below about a pixel (at
+	//! 1080p) is picked. To avoid flickering between two levels when the
+	//! mesh sits at the boundary, a coarser level is only picked once its
+	//! error gets comfortably below that threshold.
+	//!
+	//! @param [in] lods levels of detail of the mesh
+	//! @param [in] sphere bounding sphere of the mesh
+	//! @param [in] view_projection Matrix transforming from world-space to clip-space
+	//! @param [in] world Matrix transforming from model-space to world-space
+	//! @param [in] current_lod level of detail used for the previous frame
+	//! @return the level of detail to use
+	std::size_t selectLod(std::vector<mesh_lod> const& lods,
+	                      bounding_sphere const& sphere,
+	                      glm::mat4 const& view_projection,
+	                      glm::mat4 const& world,
+	                      std::size_t current_lod);
+
+	//! \brief Gather the clusters of the most detailed level of a mesh
+	//!        which may be visible.
+	//!
+	//! Clusters lying outside of the view frustum, or whose triangles all
+	//! face away from the viewer, are dropped; consecutive clusters which
+	//! are kept get merged into a single index range.
+	//!
+	//! @param [in] mesh the mesh whose clusters to cull
+	//! @param [in] view_projection Matrix transforming from world-space to clip-space
+	//! @param [in] world Matrix transforming from model-space to world-space
+	//! @param [in] viewer_position position of the camera (or light) in
+	//!             world-space, for back-face culling
+	//! @param [out] draws index ranges to draw, replacing its content
+	//! @return how many clusters were kept
+	std::size_t cullClusters(mesh_data const& mesh,
+	                         glm::mat4 const& view_projection,
+	                         glm::mat4 const& world,
+	                         glm::vec3 const& viewer_position,
+	                         cluster_draw_list& draws);
+
+	//! \brief Draw the index ranges gathered by `cullClusters()`.
+	//!
+	//! As for `drawMesh()`, the VAO of the mesh is expected to be bound
+	//! already.
+	//!
+	//! @param [in] mesh the mesh the ranges belong to
+	//! @param [in] draws the index ranges to draw
+	void drawClusters(mesh_data const& mesh, cluster_draw_list const& draws);
 
 	//! \brief Creates an OpenGL texture without any content nor parameters.
 	//!
@@ -97,14 +570,46 @@ namespace bonobo
 
 	//! \brief Load an image into an OpenGL 2D-texture.
 	//!
+	//! If the same file was already loaded with the same options, the
+	//! existing texture is returned instead; use `releaseTexture()`
+	//! rather than `glDeleteTextures()` to free it.
+	//!
 	//! @param [in] filename of the image.
 	//! @param [in] generate_mipmap whether or not to generate a mipmap hierarchy
+	//! @param [in] compression how to store the texture on the GPU
 	//! @return the name of the OpenGL 2D-texture
 	GLuint loadTexture2D(std::string const& filename,
-	                     bool generate_mipmap = true);
+	                     bool generate_mipmap = true,
+	                     texture_compression compression = texture_compression::none);
+
+	//! \brief Give back a texture obtained from `loadTexture2D()` or
+	//!        `loadObjects()`.
+	//!
+	//! Textures loaded from files are shared between all the users of a
+	//! same file (with the same options), so the OpenGL texture is only
+	//! deleted once its last user released it. Any other texture is
+	//! deleted right away.
+	//!
+	//! @param [in] texture the OpenGL name of the texture to release
+	void releaseTexture(GLuint texture);
+
+	//! \brief Statistics about the textures shared by `loadTexture2D()`
+	//!        and `loadObjects()`.
+	struct texture_registry_stats {
+		std::size_t textures_nb{0u};   //!< number of textures currently loaded
+		std::size_t references_nb{0u}; //!< number of users of those textures
+		std::size_t memory_used{0u};   //!< estimated video memory used by those textures, in bytes
+		std::size_t memory_saved{0u};  //!< estimated video memory saved by sharing textures since the start, in bytes
+	};
+
+	//! \brief Retrieve statistics about the textures loaded from files.
+	texture_registry_stats getTextureRegistryStats();
 
 	//! \brief Load six images into an OpenGL cubemap-texture.
 	//!
+	//! The six images are decoded concurrently on the shared thread
+	//! pool, along with their mipmap hierarchies if requested.
+	//!
 	//! @param [in] posx path to the texture on the left of the cubemap
 	//! @param [in] negx path to the texture on the right of the cubemap
 	//! @param [in] posy path to the texture on the top of the cubemap
@@ -112,7 +617,9 @@ namespace bonobo
 	//! @param [in] posz path to the texture on the back of the cubemap
 	//! @param [in] negz path to the texture on the front of the cubemap
 	//! @param [in] generate_mipmap whether or not to generate a mipmap hierarchy
-	//! @return the name of the OpenGL cubemap-texture
+	//! @return the name of the OpenGL cubemap-texture, or 0 if any of the
+	//!         images could not be decoded or they are not all square
+	//!         and of the same size
 	GLuint loadTextureCubeMap(std::string const& posx, std::string const& negx,
                                   std::string const& posy, std::string const& negy,
                                   std::string const& posz, std::string const& negz,
@@ -0,0 +1,494 @@
+#include "mesh_cache.hpp"
+
+#include "core/Log.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Layout of a cache file; all values are stored in the native byte order
+// of the machine that wrote it, as caches are not meant to be shared:
+//
+// * header: magic, format version, assimp and processing flags, and the
+//   number of dependencies, materials and meshes;
+// * dependencies: path (relative to the scene folder when possible),
+//   size, modification time and content hash of every file read during
+//   the import; they come first so that a stale cache is rejected without
+//   touching the rest of the file;
+// * materials: name, constants, and texture references;
+// * meshes: name, material index, drawing mode, counts and present
+//   attributes, followed by each vertex stream, the indices, the levels
+//   of detail and the clusters, each of them aligned on a 16-byte
+//   boundary so they can be uploaded straight from the mapping.
+//
+// Strings are stored as a 32-bit length followed by their characters.
+
+namespace
+{
+	char const cache_magic[8] = { 'B', 'N', 'B', 'O', 'M', 'E', 'S', 'H' };
+
+	//! \brief Version of the cache format; bump it whenever the layout,
+	//!        or the processing applied to the imported data, changes.
+	std::uint32_t const cache_version = 5u;
+
+	std::size_t const cache_alignment = 16u;
+
+	enum attribute_flags : std::uint32_t {
+		has_normals   = 1u << 0,
+		has_texcoords = 1u << 1,
+		has_tangents  = 1u << 2,
+		has_binormals = 1u << 3
+	};
+
+	class cache_writer
+	{
+	public:
+		template<typename T>
+		void write(T const& value)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be written as is.");
+			write_bytes(&value, sizeof(T));
+		}
+
+		void write(std::string const& value)
+		{
+			write(static_cast<std::uint32_t>(value.size()));
+			write_bytes(value.data(), value.size());
+		}
+
+		void write(glm::vec3 const& value)
+		{
+			write(value.x);
+			write(value.y);
+			write(value.z);
+		}
+
+		void write_array(void const* data, std::size_t size)
+		{
+			_buffer.resize((_buffer.size() + cache_alignment - 1u) / cache_alignment * cache_alignment, 0u);
+			write_bytes(data, size);
+		}
+
+		std::vector<std::uint8_t> const& buffer() const noexcept { return _buffer; }
+
+	private:
+		void write_bytes(void const* data, std::size_t size)
+		{
+			auto const bytes = static_cast<std::uint8_t const*>(data);
+			_buffer.insert(_buffer.end(), bytes, bytes + size);
+		}
+
+		std::vector<std::uint8_t> _buffer;
+	};
+
+	//! \brief Bounds-checked reader over a cache file; once a read went
+	//!        out of bounds, all subsequent reads fail.
+	class cache_reader
+	{
+	public:
+		cache_reader(std::uint8_t const* data, std::size_t size, std::size_t offset = 0u)
+			: _data(data), _size(size), _offset(offset)
+		{
+		}
+
+		template<typename T>
+		bool read(T& value)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be read as is.");
+			auto const bytes = read_bytes(sizeof(T));
+			if (bytes != nullptr)
+				std::memcpy(&value, bytes, sizeof(T));
+			return bytes != nullptr;
+		}
+
+		bool read(std::string& value)
+		{
+			std::uint32_t length = 0u;
+			if (!read(length))
+				return false;
+			auto const bytes = read_bytes(length);
+			if (bytes != nullptr)
+				value.assign(reinterpret_cast<char const*>(bytes), length);
+			return bytes != nullptr;
+		}
+
+		bool read(glm::vec3& value)
+		{
+			return read(value.x) && read(value.y) && read(value.z);
+		}
+
+		template<typename T>
+		T const* read_array(std::size_t count)
+		{
+			if (_failed)
+				return nullptr;
+			_offset = (_offset + cache_alignment - 1u) / cache_alignment * cache_alignment;
+			if (count > (std::numeric_limits<std::size_t>::max)() / sizeof(T)) {
+				_failed = true;
+				return nullptr;
+			}
+			return reinterpret_cast<T const*>(read_bytes(count * sizeof(T)));
+		}
+
+		bool failed() const noexcept { return _failed; }
+
+		std::size_t offset() const noexcept { return _offset; }
+
+	private:
+		std::uint8_t const* read_bytes(std::size_t size)
+		{
+			if (_failed || _offset > _size || size > _size - _offset) {
+				_failed = true;
+				return nullptr;
+			}
+			auto const bytes = _data + _offset;
+			_offset += size;
+			return bytes;
+		}
+
+		std::uint8_t const* _data;
+		std::size_t _size;
+		std::size_t _offset;
+		bool _failed{false};
+	};
+
+	std::string get_parent_folder(std::string const& filename)
+	{
+		auto const end_of_basedir = filename.rfind("/");
+		return (end_of_basedir != std::string::npos ? filename.substr(0, end_of_basedir) : ".") + "/";
+	}
+
+	bool hash_file(std::string const& path, std::uint64_t& hash)
+	{
+		utils::mapped_file const file(path);
+		if (!file.is_open())
+			return false;
+		hash = utils::hash_bytes(file.data(), file.size());
+		return true;
+	}
+
+	void write_material(cache_writer& writer, bonobo::material_description const& material)
+	{
+		writer.write(material.name);
+		writer.write(material.constants.diffuse);
+		writer.write(material.constants.specular);
+		writer.write(material.constants.ambient);
+		writer.write(material.constants.emissive);
+		writer.write(material.constants.shininess);
+		writer.write(material.constants.indexOfRefraction);
+		writer.write(material.constants.opacity);
+		writer.write(static_cast<std::uint32_t>(material.textures.size()));
+		for (auto const& texture : material.textures) {
+			writer.write(texture.sampler_name);
+			writer.write(texture.type_name);
+			writer.write(texture.path);
+		}
+	}
+
+	bool read_material(cache_reader& reader, bonobo::material_description& material)
+	{
+		std::uint32_t textures_nb = 0u;
+		if (!reader.read(material.name)
+		 || !reader.read(material.constants.diffuse)
+		 || !reader.read(material.constants.specular)
+		 || !reader.read(material.constants.ambient)
+		 || !reader.read(material.constants.emissive)
+		 || !reader.read(material.constants.shininess)
+		 || !reader.read(material.constants.indexOfRefraction)
+		 || !reader.read(material.constants.opacity)
+		 || !reader.read(textures_nb))
+			return false;
+
+		material.textures.clear();
+		for (std::uint32_t i = 0u; i < textures_nb && !reader.failed(); ++i) {
+			bonobo::texture_reference texture;
+			reader.read(texture.sampler_name);
+			reader.read(texture.type_name);
+			reader.read(texture.path);
+			material.textures.push_back(std::move(texture));
+		}
+		return !reader.failed();
+	}
+
+	void write_mesh(cache_writer& writer, bonobo::mesh_view const& mesh)
+	{
+		std::uint32_t attributes = 0u;
+		attributes |= mesh.normals   != nullptr ? has_normals   : 0u;
+		attributes |= mesh.texcoords != nullptr ? has_texcoords : 0u;
+		attributes |= mesh.tangents  != nullptr ? has_tangents  : 0u;
+		attributes |= mesh.binormals != nullptr ? has_binormals : 0u;
+
+		writer.write(mesh.name);
+		writer.write(mesh.material_index);
+		writer.write(static_cast<std::uint32_t>(mesh.drawing_mode));
+		writer.write(mesh.vertices_nb);
+		writer.write(mesh.indices_nb);
+		writer.write(mesh.lods_nb);
+		writer.write(mesh.clusters_nb);
+		writer.write(attributes);
+
+		auto const stream_size = mesh.vertices_nb * sizeof(glm::vec3);
+		writer.write_array(mesh.vertices, stream_size);
+		if (attributes & has_normals)
+			writer.write_array(mesh.normals, stream_size);
+		if (attributes & has_texcoords)
+			writer.write_array(mesh.texcoords, stream_size);
+		if (attributes & has_tangents)
+			writer.write_array(mesh.tangents, stream_size);
+		if (attributes & has_binormals)
+			writer.write_array(mesh.binormals, stream_size);
+		writer.write_array(mesh.indices, mesh.indices_nb * sizeof(std::uint32_t));
+		if (mesh.lods_nb > 0u)
+			writer.write_array(mesh.lods, mesh.lods_nb * sizeof(bonobo::mesh_lod));
+		if (mesh.clusters_nb > 0u)
+			writer.write_array(mesh.clusters, mesh.clusters_nb * sizeof(bonobo::mesh_cluster));
+	}
+
+	bool read_mesh(cache_reader& reader, bonobo::mesh_view& mesh)
+	{
+		std::uint32_t drawing_mode = 0u, attributes = 0u;
+		if (!reader.read(mesh.name)
+		 || !reader.read(mesh.material_index)
+		 || !reader.read(drawing_mode)
+		 || !reader.read(mesh.vertices_nb)
+		 || !reader.read(mesh.indices_nb)
+		 || !reader.read(mesh.lods_nb)
+		 || !reader.read(mesh.clusters_nb)
+		 || !reader.read(attributes))
+			return false;
+		mesh.drawing_mode = static_cast<GLenum>(drawing_mode);
+
+		mesh.vertices = reader.read_array<glm::vec3>(mesh.vertices_nb);
+		if (attributes & has_normals)
+			mesh.normals = reader.read_array<glm::vec3>(mesh.vertices_nb);
+		if (attributes & has_texcoords)
+			mesh.texcoords = reader.read_array<glm::vec3>(mesh.vertices_nb);
+		if (attributes & has_tangents)
+			mesh.tangents = reader.read_array<glm::vec3>(mesh.vertices_nb);
+		if (attributes & has_binormals)
+			mesh.binormals = reader.read_array<glm::vec3>(mesh.vertices_nb);
+		mesh.indices = reader.read_array<std::uint32_t>(mesh.indices_nb);
+		if (mesh.lods_nb > 0u)
+			mesh.lods = reader.read_array<bonobo::mesh_lod>(mesh.lods_nb);
+		if (mesh.clusters_nb > 0u)
+			mesh.clusters = reader.read_array<bonobo::mesh_cluster>(mesh.clusters_nb);
+		if (reader.failed())
+			return false;
+
+		// Make sure the mesh can not make OpenGL read outside of its
+		// vertex buffer.
+		for (std::uint32_t i = 0u; i < mesh.indices_nb; ++i)
+			if (mesh.indices[i] >= mesh.vertices_nb)
+				return false;
+		for (std::uint32_t i = 0u; i < mesh.lods_nb; ++i)
+			if (mesh.lods[i].first_index > mesh.indices_nb
+			 || mesh.lods[i].indices_nb > mesh.indices_nb - mesh.lods[i].first_index)
+				return false;
+		for (std::uint32_t i = 0u; i < mesh.clusters_nb; ++i)
+			if (mesh.clusters[i].first_index > mesh.indices_nb
+			 || mesh.clusters[i].indices_nb > mesh.indices_nb - mesh.clusters[i].first_index)
+				return false;
+
+		return true;
+	}
+
+	//! \brief Overwrite modification times recorded in a cache file,
+	//!        each given along with its offset within the file.
+	bool update_modification_times(std::string const& cache_path,
+	                               std::vector<std::pair<std::size_t, std::int64_t>> const& times)
+	{
+		std::fstream stream(utils::widen(cache_path), std::ios::binary | std::ios::in | std::ios::out);
+		if (!stream.is_open())
+			return false;
+		for (auto const& time : times) {
+			stream.seekp(static_cast<std::streamoff>(time.first));
+			stream.write(reinterpret_cast<char const*>(&time.second), sizeof(time.second));
+		}
+		return stream.good();
+	}
+}
+
+std::string
+bonobo::getMeshCachePath(std::string const& filename)
+{
+	return filename + ".meshcache";
+}
+
+bool
+bonobo::readMeshCache(std::string const& filename, unsigned int assimp_flags, std::uint32_t processing_flags,
+                      cached_scene& scene)
+{
+	auto const cache_path = getMeshCachePath(filename);
+	scene = cached_scene();
+
+	scene.file = utils::mapped_file(cache_path);
+	if (!scene.file.is_open())
+		return false;
+
+	cache_reader reader(scene.file.data(), scene.file.size());
+
+	char magic[sizeof(cache_magic)];
+	std::uint32_t version = 0u, flags = 0u, processing = 0u;
+	std::uint32_t dependencies_nb = 0u, materials_nb = 0u, meshes_nb = 0u;
+	if (!reader.read(magic) || std::memcmp(magic, cache_magic, sizeof(cache_magic)) != 0) {
+		LogWarning("\"%s\" is not a mesh cache; ignoring it.", cache_path.c_str());
+		return false;
+	}
+	if (!reader.read(version) || version != cache_version) {
+		LogInfo("Mesh cache \"%s\" uses format version %u instead of %u; ignoring it.",
+		        cache_path.c_str(), version, cache_version);
+		return false;
+	}
+	if (!reader.read(flags) || flags != assimp_flags) {
+		LogInfo("Mesh cache \"%s\" was created with different import flags; ignoring it.", cache_path.c_str());
+		return false;
+	}
+	if (!reader.read(processing) || processing != processing_flags) {
+		LogInfo("Mesh cache \"%s\" was created with different processing steps; ignoring it.", cache_path.c_str());
+		return false;
+	}
+	if (!reader.read(dependencies_nb) || !reader.read(materials_nb) || !reader.read(meshes_nb)) {
+		LogWarning("Mesh cache \"%s\" is truncated; ignoring it.", cache_path.c_str());
+		return false;
+	}
+
+	auto const parent_folder = get_parent_folder(filename);
+	std::vector<std::pair<std::size_t, std::int64_t>> touched_dependencies; // offset of their recorded time, and new time
+	for (std::uint32_t i = 0u; i < dependencies_nb; ++i) {
+		std::string path;
+		utils::file_status cached_status;
+		std::uint64_t cached_hash = 0u;
+		auto const is_read = reader.read(path) && reader.read(cached_status.size);
+		auto const modification_time_offset = reader.offset();
+		if (!is_read || !reader.read(cached_status.modification_time) || !reader.read(cached_hash)) {
+			LogWarning("Mesh cache \"%s\" is truncated; ignoring it.", cache_path.c_str());
+			return false;
+		}
+		if (!path.empty() && path.front() != '/' && path.find(':') == std::string::npos)
+			path = parent_folder + path;
+
+		utils::file_status status;
+		if (!utils::get_file_status(path, status) || status.size != cached_status.size) {
+			LogInfo("Mesh cache \"%s\" is out-of-date as \"%s\" changed.", cache_path.c_str(), path.c_str());
+			return false;
+		}
+		if (status.modification_time == cached_status.modification_time)
+			continue;
+
+		std::uint64_t hash = 0u;
+		if (!hash_file(path, hash) || hash != cached_hash) {
+			LogInfo("Mesh cache \"%s\" is out-of-date as \"%s\" changed.", cache_path.c_str(), path.c_str());
+			return false;
+		}
+		touched_dependencies.emplace_back(modification_time_offset, status.modification_time);
+	}
+
+	// Files which were only touched would otherwise get hashed again on
+	// every load; the file has to be unmapped while being updated.
+	if (!touched_dependencies.empty()) {
+		auto const offset = reader.offset();
+		scene.file = utils::mapped_file();
+		if (!update_modification_times(cache_path, touched_dependencies))
+			LogWarning("Failed to update the modification times recorded in mesh cache \"%s\".", cache_path.c_str());
+		scene.file = utils::mapped_file(cache_path);
+		if (!scene.file.is_open())
+			return false;
+		reader = cache_reader(scene.file.data(), scene.file.size(), offset);
+	}
+
+	// Each material and mesh takes at least one byte, so larger counts
+	// can only come from a corrupted file.
+	if (materials_nb > scene.file.size() || meshes_nb > scene.file.size()) {
+		LogWarning("Mesh cache \"%s\" is corrupted; ignoring it.", cache_path.c_str());
+		return false;
+	}
+
+	scene.materials.resize(materials_nb);
+	for (auto& material : scene.materials) {
+		if (!read_material(reader, material)) {
+			LogWarning("Mesh cache \"%s\" is corrupted; ignoring it.", cache_path.c_str());
+			return false;
+		}
+	}
+
+	scene.meshes.resize(meshes_nb);
+	for (auto& mesh : scene.meshes) {
+		if (!read_mesh(reader, mesh)
+		 || (mesh.material_index != ~0u && mesh.material_index >= scene.materials.size())) {
+			LogWarning("Mesh cache \"%s\" is corrupted; ignoring it.", cache_path.c_str());
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool
+bonobo::writeMeshCache(std::string const& filename, unsigned int assimp_flags, std::uint32_t processing_flags,
+                       imported_scene const& scene)
+{
+	auto const cache_path = getMeshCachePath(filename);
+
+	cache_writer writer;
+	writer.write(cache_magic);
+	writer.write(cache_version);
+	writer.write(static_cast<std::uint32_t>(assimp_flags));
+	writer.write(processing_flags);
+	writer.write(static_cast<std::uint32_t>(scene.dependencies.size()));
+	writer.write(static_cast<std::uint32_t>(scene.materials.size()));
+	writer.write(static_cast<std::uint32_t>(scene.meshes.size()));
+
+	auto const parent_folder = get_parent_folder(filename);
+	for (auto const& path : scene.dependencies) {
+		utils::file_status status;
+		std::uint64_t hash = 0u;
+		if (!utils::get_file_status(path, status) || !hash_file(path, hash)) {
+			LogWarning("Failed to inspect \"%s\"; no mesh cache will be written for \"%s\".",
+			           path.c_str(), filename.c_str());
+			return false;
+		}
+
+		auto const is_in_parent_folder = path.compare(0, parent_folder.size(), parent_folder) == 0;
+		writer.write(is_in_parent_folder ? path.substr(parent_folder.size()) : path);
+		writer.write(status.size);
+		writer.write(status.modification_time);
+		writer.write(hash);
+	}
+
+	for (auto const& material : scene.materials)
+		write_material(writer, material);
+
+	for (auto const& mesh : scene.meshes)
+		write_mesh(writer, mesh.view());
+
+	auto const temporary_path = cache_path + ".tmp";
+	{
+		std::ofstream stream(utils::widen(temporary_path), std::ios::binary | std::ios::trunc);
+		if (!stream.is_open()) {
+			LogWarning("Failed to create mesh cache \"%s\".", temporary_path.c_str());
+			return false;
+		}
+		auto const& buffer = writer.buffer();
+		stream.write(reinterpret_cast<char const*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+		if (!stream.good()) {
+			LogWarning("Failed to write mesh cache \"%s\".", temporary_path.c_str());
+			stream.close();
+			std::remove(temporary_path.c_str());
+			return false;
+		}
+	}
+
+	// rename() does not overwrite existing files on all platforms.
+	std::remove(cache_path.c_str());
+	if (std::rename(temporary_path.c_str(), cache_path.c_str()) != 0) {
+		LogWarning("Failed to move mesh cache \"%s\" into place.", cache_path.c_str());
+		std::remove(temporary_path.c_str());
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "core/mesh_import.hpp"
+#include "core/various.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bonobo
+{
+	//! \brief Scene read back from a mesh cache file.
+	//!
+	//! The vertex streams and indices referenced by |meshes| point
+	//! directly into |file|, so they remain valid for as long as this
+	//! structure is alive.
+	struct cached_scene {
+		utils::mapped_file file;
+		std::vector<material_description> materials;
+		std::vector<mesh_view> meshes;
+	};
+
+	//! \brief Processing steps applied to an imported scene before it
+	//!        gets cached, on top of those performed by assimp.
+	enum mesh_processing_flags : std::uint32_t {
+		optimised_triangle_order = 1u << 0, //!< see `bonobo::optimiseTriangleOrder()`
+		generated_lods           = 1u << 1, //!< see `bonobo::generateLods()`; the number of levels is stored from bit `generated_lods_nb_shift` onwards
+		built_clusters           = 1u << 2, //!< see `bonobo::buildClusters()`
+	};
+	std::uint32_t const generated_lods_nb_shift = 8u;
+
+	//! \brief Path of the cache file associated to an object/scene file.
+	std::string getMeshCachePath(std::string const& filename);
+
+	//! \brief Map the cache file associated to |filename|, if it exists
+	//!        and is still up-to-date.
+	//!
+	//! A cache is considered out-of-date if it was written by a different
+	//! version of the cache format, with different import flags or
+	//! processing steps, or if
+	//! any of the files read when importing the scene has changed since;
+	//! a file whose modification time changed but whose content did not
+	//! is still considered up-to-date.
+	//!
+	//! @param [in] filename of the object/scene file the cache was created from
+	//! @param [in] assimp_flags post-processing steps the scene is to be imported with
+	//! @param [in] processing_flags combination of `mesh_processing_flags`
+	//!             the scene is to be processed with
+	//! @param [out] scene filled in with the cached content on success
+	//! @return whether a valid cache could be read
+	bool readMeshCache(std::string const& filename, unsigned int assimp_flags,
+	                   std::uint32_t processing_flags, cached_scene& scene);
+
+	//! \brief Write the cache file associated to |filename|.
+	//!
+	//! The cache is first written to a temporary file which is then
+	//! renamed, so that a partially written cache is never picked up.
+	//!
+	//! @param [in] filename of the object/scene file |scene| was imported from
+	//! @param [in] assimp_flags post-processing steps |scene| was imported with
+	//! @param [in] processing_flags combination of `mesh_processing_flags`
+	//!             |scene| was processed with
+	//! @param [in] scene the imported content to cache
+	//! @return whether the cache could be written
+	bool writeMeshCache(std::string const& filename, unsigned int assimp_flags,
+	                    std::uint32_t processing_flags, imported_scene const& scene);
+}
@@ -0,0 +1,608 @@
+#include "mesh_import.hpp"
+
+#include "core/Log.h"
+#include "core/gl_state.hpp"
+#include "core/mesh_optimisation.hpp"
+#include "core/opengl.hpp"
+
+#include <assimp/DefaultIOSystem.h>
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+	//! \brief IO system recording the path of every file assimp opens,
+	//!        so that caches can be invalidated when any of them changes
+	//!        (e.g. the .mtl file accompanying an .obj).
+	class recording_io_system : public Assimp::DefaultIOSystem
+	{
+	public:
+		explicit recording_io_system(std::vector<std::string>& opened_files) : _opened_files(opened_files)
+		{
+		}
+
+		using Assimp::DefaultIOSystem::Open;
+		Assimp::IOStream* Open(char const* file, char const* mode) override
+		{
+			auto stream = Assimp::DefaultIOSystem::Open(file, mode);
+			if (stream != nullptr && std::find(_opened_files.begin(), _opened_files.end(), file) == _opened_files.end())
+				_opened_files.emplace_back(file);
+			return stream;
+		}
+
+	private:
+		std::vector<std::string>& _opened_files;
+	};
+
+	void copy_stream(aiVector3D const* source, unsigned int count, std::vector<glm::vec3>& destination)
+	{
+		destination.resize(count);
+		for (unsigned int i = 0u; i < count; ++i)
+			destination[i] = glm::vec3(source[i].x, source[i].y, source[i].z);
+	}
+
+	void process_material(aiMaterial const* material, bonobo::material_description& description)
+	{
+		description.name = material->GetName().C_Str();
+
+		auto& constants = description.constants;
+		aiColor3D color;
+		material->Get(AI_MATKEY_COLOR_DIFFUSE, color);
+		constants.diffuse = glm::vec3(color.r, color.g, color.b);
+		material->Get(AI_MATKEY_COLOR_SPECULAR, color);
+		constants.specular = glm::vec3(color.r, color.g, color.b);
+		material->Get(AI_MATKEY_COLOR_AMBIENT, color);
+		constants.ambient = glm::vec3(color.r, color.g, color.b);
+		material->Get(AI_MATKEY_COLOR_EMISSIVE, color);
+		constants.emissive = glm::vec3(color.r, color.g, color.b);
+		material->Get(AI_MATKEY_SHININESS, constants.shininess);
+		material->Get(AI_MATKEY_REFRACTI, constants.indexOfRefraction);
+		material->Get(AI_MATKEY_OPACITY, constants.opacity);
+
+		auto const process_texture = [material, &description](aiTextureType type,
+		                                                      std::string const& type_as_str,
+		                                                      std::string const& name) {
+			if (material->GetTextureCount(type) == 0u)
+				return;
+
+			if (material->GetTextureCount(type) > 1u)
+				LogWarning("Material \"%s\" has more than one %s texture: discarding all but the first one.",
+				           material->GetName().C_Str(), type_as_str.c_str());
+			aiString path;
+			material->GetTexture(type, 0, &path);
+			description.textures.push_back({ name, type_as_str, std::string(path.C_Str()) });
+		};
+		process_texture(aiTextureType_DIFFUSE, "diffuse", "diffuse_texture");
+		process_texture(aiTextureType_SPECULAR, "specular", "specular_texture");
+		process_texture(aiTextureType_NORMALS, "normals", "normals_texture");
+		process_texture(aiTextureType_OPACITY, "opacity", "opacity_texture");
+	}
+
+	std::int16_t to_snorm16(float value)
+	{
+		value = std::min(std::max(value, -1.0f), 1.0f);
+		return static_cast<std::int16_t>(std::round(value * 32767.0f));
+	}
+
+	//! \brief Map a unit vector onto the [-1, 1]² square, by projecting it
+	//!        onto an octahedron whose lower half gets folded over the
+	//!        upper one.
+	glm::vec2 encode_octahedral(glm::vec3 const& v)
+	{
+		auto const l1_norm = std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+		if (l1_norm == 0.0f)
+			return glm::vec2(0.0f, 0.0f);
+
+		auto const x = v.x / l1_norm;
+		auto const y = v.y / l1_norm;
+		if (v.z >= 0.0f)
+			return glm::vec2(x, y);
+
+		return glm::vec2((1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f),
+		                 (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f));
+	}
+
+	//! \brief Whether the binormal is cross(normal, tangent) (+1) or its
+	//!        opposite (-1).
+	float compute_binormal_sign(bonobo::mesh_view const& mesh, std::uint32_t i)
+	{
+		if (mesh.normals == nullptr || mesh.binormals == nullptr)
+			return 1.0f;
+		auto const& n = mesh.normals[i];
+		auto const& t = mesh.tangents[i];
+		auto const& b = mesh.binormals[i];
+		auto const orientation = (n.y * t.z - n.z * t.y) * b.x
+		                       + (n.z * t.x - n.x * t.z) * b.y
+		                       + (n.x * t.y - n.y * t.x) * b.z;
+		return orientation < 0.0f ? -1.0f : 1.0f;
+	}
+
+	//! \brief How a vertex attribute is laid out in a vertex buffer, and
+	//!        how to convert it from a `mesh_view`.
+	struct attribute_layout {
+		bonobo::shader_bindings binding;
+		GLint components_nb;
+		GLenum type;
+		GLboolean normalized;
+		std::size_t element_size; //!< in bytes
+		bool (*is_present)(bonobo::mesh_view const& mesh);
+		//! Data which can be uploaded as is, if any, or null if it needs
+		//! to be converted using |write|.
+		glm::vec3 const* (*get_source)(bonobo::mesh_view const& mesh);
+		void (*write)(bonobo::mesh_view const& mesh, std::uint32_t vertex, std::uint8_t* destination);
+	};
+
+	void write_vec3(glm::vec3 const& value, std::uint8_t* destination)
+	{
+		std::memcpy(destination, &value, sizeof(glm::vec3));
+	}
+
+	void write_octahedral(glm::vec3 const& value, std::uint8_t* destination)
+	{
+		auto const encoded = encode_octahedral(value);
+		std::int16_t const packed[2] = { to_snorm16(encoded.x), to_snorm16(encoded.y) };
+		std::memcpy(destination, packed, sizeof(packed));
+	}
+
+	std::vector<attribute_layout> const& get_attribute_layouts(bonobo::vertex_format format)
+	{
+		using bonobo::mesh_view;
+		using bonobo::shader_bindings;
+
+		static std::vector<attribute_layout> const full_precision_layouts = {
+			{ shader_bindings::vertices, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3),
+			  [](mesh_view const& mesh){ return mesh.vertices != nullptr; },
+			  [](mesh_view const& mesh){ return mesh.vertices; },
+			  [](mesh_view const& mesh, std::uint32_t i, std::uint8_t* destination){ write_vec3(mesh.vertices[i], destination); } },
+			{ shader_bindings::normals, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3),
+			  [](mesh_view const& mesh){ return mesh.normals != nullptr; },
+			  [](mesh_view const& mesh){ return mesh.normals; },
+			  [](mesh_view const& mesh, std::uint32_t i, std::uint8_t* destination){ write_vec3(mesh.normals[i], destination); } },
+			{ shader_bindings::texcoords, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3),
+			  [](mesh_view const& mesh){ return mesh.texcoords != nullptr; },
+			  [](mesh_view const& mesh){ return mesh.texcoords; },
+			  [](mesh_view const& mesh, std::uint32_t i, std::uint8_t* destination){ write_vec3(mesh.texcoords[i], destination); } },
+			{ shader_bindings::tangents, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3),
+			  [](mesh_view const& mesh){ return mesh.tangents != nullptr; },
+			  [](mesh_view const& mesh){ return mesh.tangents; },
+			  [](mesh_view const& mesh, std::uint32_t i, std::uint8_t* destination){ write_vec3(mesh.tangents[i], destination); } },
+			{ shader_bindings::binormals, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3),
+			  [](mesh_view const& mesh){ return mesh.binormals != nullptr; },
+			  [](mesh_view const& mesh){ return mesh.binormals; },
+			  [](mesh_view const& mesh, std::uint32_t i, std::uint8_t* destination){ write_vec3(mesh.binormals[i], destination); } },
+		};
+
+		static std::vector<attribute_layout> const compact_layouts = {
+			full_precision_layouts[0],
+			{ shader_bindings::packed_normals, 2, GL_SHORT, GL_TRUE, 2u * sizeof(std::int16_t),
+			  [](mesh_view const& mesh){ return mesh.normals != nullptr; },
+			  [](mesh_view const&) -> glm::vec3 const* { return nullptr; },
+			  [](mesh_view const& mesh, std::uint32_t i, std::uint8_t* destination){ write_octahedral(mesh.normals[i], destination); } },
+			{ shader_bindings::texcoords, 2, GL_HALF_FLOAT, GL_FALSE, 2u * sizeof(std::uint16_t),
+			  [](mesh_view const& mesh){ return mesh.texcoords != nullptr; },
+			  [](mesh_view const&) -> glm::vec3 const* { return nullptr; },
+			  [](mesh_view const& mesh, std::uint32_t i, std::uint8_t* destination){
+				std::uint16_t const packed[2] = { glm::packHalf1x16(mesh.texcoords[i].x), glm::packHalf1x16(mesh.texcoords[i].y) };
+				std::memcpy(destination, packed, sizeof(packed));
+			  } },
+			// The fourth component is unused, but keeps each element aligned
+			// on 4 bytes.
+			{ shader_bindings::packed_tangents, 4, GL_SHORT, GL_TRUE, 4u * sizeof(std::int16_t),
+			  [](mesh_view const& mesh){ return mesh.tangents != nullptr; },
+			  [](mesh_view const&) -> glm::vec3 const* { return nullptr; },
+			  [](mesh_view const& mesh, std::uint32_t i, std::uint8_t* destination){
+				write_octahedral(mesh.tangents[i], destination);
+				std::int16_t const packed[2] = { to_snorm16(compute_binormal_sign(mesh, i)), 0 };
+				std::memcpy(destination + 2u * sizeof(std::int16_t), packed, sizeof(packed));
+			  } },
+		};
+
+		return format == bonobo::vertex_format::compact ? compact_layouts : full_precision_layouts;
+	}
+
+	//! \brief Convert the attribute described by |layout| for all
+	//!        vertices of |mesh|, and store them in |destination|.
+	void pack_attribute(attribute_layout const& layout, bonobo::mesh_view const& mesh, std::uint8_t* destination)
+	{
+		for (std::uint32_t i = 0u; i < mesh.vertices_nb; ++i)
+			layout.write(mesh, i, destination + i * layout.element_size);
+	}
+
+	void set_up_attribute(attribute_layout const& layout, GLintptr offset)
+	{
+		auto const location = static_cast<unsigned int>(layout.binding);
+		glEnableVertexAttribArray(location);
+		glVertexAttribPointer(location, layout.components_nb, layout.type, layout.normalized, 0, reinterpret_cast<GLvoid const*>(offset));
+	}
+
+	template<typename T>
+	std::vector<std::uint8_t> copy_indices(std::vector<bonobo::mesh_view> const& meshes, std::size_t indices_nb)
+	{
+		std::vector<std::uint8_t> indices(indices_nb * sizeof(T));
+		auto destination = reinterpret_cast<T*>(indices.data());
+		for (auto const& mesh : meshes)
+			for (std::uint32_t i = 0u; i < mesh.indices_nb; ++i)
+				*destination++ = static_cast<T>(mesh.indices[i]);
+		return indices;
+	}
+
+	//! \brief Fill in the bounds, levels of detail and clusters of an
+	//!        object; the number of indices to draw is the one of the
+	//!        first level.
+	void set_up_lods(bonobo::mesh_view const& mesh, bonobo::mesh_data& object)
+	{
+		object.box = bonobo::computeBoundingBox(mesh.vertices, mesh.vertices_nb);
+		object.sphere = bonobo::computeBoundingSphere(mesh.vertices, mesh.vertices_nb, object.box);
+		object.lods.assign(mesh.lods, mesh.lods + mesh.lods_nb);
+		object.clusters.assign(mesh.clusters, mesh.clusters + mesh.clusters_nb);
+		object.indices_nb = static_cast<GLsizei>(object.lods.empty() ? mesh.indices_nb : object.lods.front().indices_nb);
+	}
+
+	bool process_mesh(aiMesh const* assimp_mesh, bonobo::imported_mesh& mesh)
+	{
+		if (!assimp_mesh->HasFaces()) {
+			LogError("Unsupported mesh \"%s\": has no faces", assimp_mesh->mName.C_Str());
+			return false;
+		}
+		if ((assimp_mesh->mPrimitiveTypes & ~static_cast<uint32_t>(aiPrimitiveType_POINT | aiPrimitiveType_NGONEncodingFlag)) != 0u
+		 && (assimp_mesh->mPrimitiveTypes & ~static_cast<uint32_t>(aiPrimitiveType_LINE | aiPrimitiveType_NGONEncodingFlag)) != 0u
+		 && (assimp_mesh->mPrimitiveTypes & ~static_cast<uint32_t>(aiPrimitiveType_TRIANGLE | aiPrimitiveType_NGONEncodingFlag)) != 0u) {
+			LogError("Unsupported mesh \"%s\": uses multiple primitive types", assimp_mesh->mName.C_Str());
+			return false;
+		}
+		if ((assimp_mesh->mPrimitiveTypes & static_cast<uint32_t>(aiPrimitiveType_POLYGON)) == static_cast<uint32_t>(aiPrimitiveType_POLYGON)) {
+			LogError("Unsupported mesh \"%s\": uses polygons", assimp_mesh->mName.C_Str());
+			return false;
+		}
+		if (!assimp_mesh->HasPositions()) {
+			LogError("Unsupported mesh \"%s\": has no positions", assimp_mesh->mName.C_Str());
+			return false;
+		}
+
+		if (assimp_mesh->mName.length != 0)
+			mesh.name = std::string(assimp_mesh->mName.C_Str());
+
+		auto const vertices_nb = assimp_mesh->mNumVertices;
+		copy_stream(assimp_mesh->mVertices, vertices_nb, mesh.vertices);
+		if (assimp_mesh->HasNormals())
+			copy_stream(assimp_mesh->mNormals, vertices_nb, mesh.normals);
+		if (assimp_mesh->HasTextureCoords(0u))
+			copy_stream(assimp_mesh->mTextureCoords[0u], vertices_nb, mesh.texcoords);
+		if (assimp_mesh->HasTangentsAndBitangents()) {
+			copy_stream(assimp_mesh->mTangents, vertices_nb, mesh.tangents);
+			copy_stream(assimp_mesh->mBitangents, vertices_nb, mesh.binormals);
+		}
+
+		auto const num_vertices_per_face = assimp_mesh->mFaces[0u].mNumIndices;
+		switch (num_vertices_per_face) {
+			case 1u: mesh.drawing_mode = GL_POINTS;    break;
+			case 2u: mesh.drawing_mode = GL_LINES;     break;
+			default: mesh.drawing_mode = GL_TRIANGLES; break;
+		}
+		mesh.indices.resize(static_cast<size_t>(assimp_mesh->mNumFaces) * num_vertices_per_face);
+		for (size_t i = 0u; i < assimp_mesh->mNumFaces; ++i) {
+			auto const& face = assimp_mesh->mFaces[i];
+			assert(face.mNumIndices <= 3);
+			for (size_t k = 0u; k < num_vertices_per_face; ++k)
+				mesh.indices[num_vertices_per_face * i + k] = face.mIndices[k];
+		}
+
+		return true;
+	}
+}
+
+bonobo::mesh_view
+bonobo::imported_mesh::view() const
+{
+	auto const stream = [](std::vector<glm::vec3> const& attribute) -> glm::vec3 const* {
+		return attribute.empty() ? nullptr : attribute.data();
+	};
+
+	mesh_view view;
+	view.name = name;
+	view.material_index = material_index;
+	view.drawing_mode = drawing_mode;
+	view.vertices_nb = static_cast<std::uint32_t>(vertices.size());
+	view.indices_nb = static_cast<std::uint32_t>(indices.size());
+	view.lods_nb = static_cast<std::uint32_t>(lods.size());
+	view.lods = lods.empty() ? nullptr : lods.data();
+	view.clusters_nb = static_cast<std::uint32_t>(clusters.size());
+	view.clusters = clusters.empty() ? nullptr : clusters.data();
+	view.vertices = stream(vertices);
+	view.normals = stream(normals);
+	view.texcoords = stream(texcoords);
+	view.tangents = stream(tangents);
+	view.binormals = stream(binormals);
+	view.indices = indices.empty() ? nullptr : indices.data();
+	return view;
+}
+
+bool
+bonobo::importScene(std::string const& filename, unsigned int assimp_flags, imported_scene& scene)
+{
+	scene = imported_scene();
+
+	Assimp::Importer importer;
+	importer.SetIOHandler(new recording_io_system(scene.dependencies)); // owned by the importer
+	auto const assimp_scene = importer.ReadFile(filename, assimp_flags);
+	if (assimp_scene == nullptr || assimp_scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || assimp_scene->mRootNode == nullptr) {
+		LogError("Assimp failed to load \"%s\": %s", filename.c_str(), importer.GetErrorString());
+		return false;
+	}
+
+	if (assimp_scene->mNumMeshes == 0u) {
+		LogError("No mesh available; loading \"%s\" must have had issues", filename.c_str());
+		return false;
+	}
+
+	// Only keep the materials which are referenced by at least one mesh,
+	// and remap the mesh indices accordingly.
+	std::vector<std::uint32_t> material_remapping(assimp_scene->mNumMaterials, ~0u);
+	for (size_t j = 0; j < assimp_scene->mNumMeshes; ++j) {
+		auto const assimp_mesh = assimp_scene->mMeshes[j];
+		auto const material_id = assimp_mesh->mMaterialIndex;
+		if (material_id >= assimp_scene->mNumMaterials) {
+			LogError("Mesh \"%s\" has a material index of %u, but only %u materials are present.",
+			         assimp_mesh->mName.C_Str(), material_id, assimp_scene->mNumMaterials);
+			continue;
+		}
+		if (material_remapping[material_id] != ~0u)
+			continue;
+
+		material_remapping[material_id] = static_cast<std::uint32_t>(scene.materials.size());
+		scene.materials.emplace_back();
+		process_material(assimp_scene->mMaterials[material_id], scene.materials.back());
+	}
+
+	scene.meshes.reserve(assimp_scene->mNumMeshes);
+	for (size_t j = 0; j < assimp_scene->mNumMeshes; ++j) {
+		auto const assimp_mesh = assimp_scene->mMeshes[j];
+
+		imported_mesh mesh;
+		if (!process_mesh(assimp_mesh, mesh))
+			continue;
+
+		auto const material_id = assimp_mesh->mMaterialIndex;
+		if (material_id < material_remapping.size())
+			mesh.material_index = material_remapping[material_id];
+
+		scene.meshes.push_back(std::move(mesh));
+	}
+
+	return true;
+}
+
+bonobo::mesh_data
+bonobo::uploadMesh(mesh_view const& mesh, vertex_format format)
+{
+	bonobo::mesh_data object;
+	object.name = mesh.name;
+	object.drawing_mode = mesh.drawing_mode;
+	object.vertices_nb = static_cast<GLsizei>(mesh.vertices_nb);
+	set_up_lods(mesh, object);
+
+	auto const& layouts = get_attribute_layouts(format);
+
+	glGenVertexArrays(1, &object.vao);
+	assert(object.vao != 0u);
+	bonobo::state::bindVertexArray(object.vao);
+
+	GLsizeiptr bo_size = 0;
+	for (auto const& layout : layouts)
+		if (layout.is_present(mesh))
+			bo_size += static_cast<GLsizeiptr>(mesh.vertices_nb * layout.element_size);
+
+	glGenBuffers(1, &object.bo);
+	assert(object.bo != 0u);
+	glBindBuffer(GL_ARRAY_BUFFER, object.bo);
+	glBufferData(GL_ARRAY_BUFFER, bo_size, nullptr, GL_STATIC_DRAW);
+
+	// Attributes which do not need to be converted are uploaded straight
+	// from their source.
+	GLintptr offset = 0;
+	std::vector<std::uint8_t> packed_attribute;
+	for (auto const& layout : layouts) {
+		if (!layout.is_present(mesh))
+			continue;
+
+		auto const size = static_cast<GLsizeiptr>(mesh.vertices_nb * layout.element_size);
+		GLvoid const* data = layout.get_source(mesh);
+		if (data == nullptr) {
+			packed_attribute.resize(static_cast<std::size_t>(size));
+			pack_attribute(layout, mesh, packed_attribute.data());
+			data = packed_attribute.data();
+		}
+		glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+		set_up_attribute(layout, offset);
+		offset += size;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0u);
+
+	std::vector<std::uint8_t> short_indices;
+	GLvoid const* indices = mesh.indices;
+	std::size_t index_size = sizeof(GLuint);
+	if (format == vertex_format::compact && mesh.vertices_nb <= std::numeric_limits<GLushort>::max()) {
+		short_indices = copy_indices<GLushort>({ mesh }, mesh.indices_nb);
+		indices = short_indices.data();
+		index_size = sizeof(GLushort);
+		object.indices_type = GL_UNSIGNED_SHORT;
+	}
+
+	glGenBuffers(1, &object.ibo);
+	assert(object.ibo != 0u);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, object.ibo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(mesh.indices_nb * index_size),
+	             indices, GL_STATIC_DRAW);
+
+	utils::opengl::debug::nameObject(GL_VERTEX_ARRAY, object.vao, object.name + " VAO");
+	utils::opengl::debug::nameObject(GL_BUFFER, object.bo, object.name + " VBO");
+	utils::opengl::debug::nameObject(GL_BUFFER, object.ibo, object.name + " IBO");
+
+	bonobo::state::bindVertexArray(0u);
+	glBindBuffer(GL_ARRAY_BUFFER, 0u);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0u);
+
+	return object;
+}
+
+std::vector<bonobo::mesh_data>
+bonobo::uploadMeshesToSharedBuffers(std::vector<mesh_view> const& meshes, vertex_format format, std::string const& name)
+{
+	std::vector<bonobo::mesh_data> objects;
+	if (meshes.empty())
+		return objects;
+
+	shared_mesh_buffers const buffers(meshes, format, name);
+	if (!buffers.is_valid())
+		return objects;
+
+	objects.reserve(meshes.size());
+	for (std::size_t j = 0u; j < meshes.size(); ++j)
+		objects.push_back(buffers.upload(j));
+
+	return objects;
+}
+
+bonobo::shared_mesh_buffers::shared_mesh_buffers(std::vector<mesh_view> const& meshes, vertex_format format, std::string const& name)
+	: _meshes(meshes), _format(format)
+{
+	if (meshes.empty())
+		return;
+
+	auto const& layouts = get_attribute_layouts(format);
+
+	// Attributes are laid out one after the other, and an attribute is
+	// present for all meshes as soon as one of them uses it; the other
+	// meshes get zeroes instead.
+	std::size_t vertices_nb = 0u, indices_nb = 0u;
+	std::uint32_t max_mesh_vertices_nb = 0u;
+	std::vector<bool> are_attributes_present(layouts.size(), false);
+	_base_vertices.reserve(meshes.size());
+	_first_indices.reserve(meshes.size());
+	for (auto const& mesh : meshes) {
+		_base_vertices.push_back(static_cast<GLint>(vertices_nb));
+		_first_indices.push_back(static_cast<GLsizei>(indices_nb));
+		vertices_nb += mesh.vertices_nb;
+		indices_nb += mesh.indices_nb;
+		max_mesh_vertices_nb = std::max(max_mesh_vertices_nb, mesh.vertices_nb);
+		for (std::size_t k = 0u; k < layouts.size(); ++k)
+			if (layouts[k].is_present(mesh))
+				are_attributes_present[k] = true;
+	}
+	if (vertices_nb > static_cast<std::size_t>(std::numeric_limits<GLint>::max())
+	 || indices_nb > static_cast<std::size_t>(std::numeric_limits<GLsizei>::max())) {
+		LogError("Too many vertices or indices to share buffers between the meshes of \"%s\".", name.c_str());
+		return;
+	}
+
+	_attribute_offsets.assign(layouts.size(), ~std::size_t(0u));
+	std::size_t bo_size = 0u;
+	for (std::size_t k = 0u; k < layouts.size(); ++k) {
+		if (!are_attributes_present[k])
+			continue;
+		_attribute_offsets[k] = bo_size;
+		bo_size += vertices_nb * layouts[k].element_size;
+	}
+
+	// Indices stay relative to the first vertex of their mesh, so 16-bit
+	// indices can be used as long as no single mesh needs more.
+	_use_short_indices = format == vertex_format::compact
+	                  && max_mesh_vertices_nb <= std::numeric_limits<GLushort>::max();
+	auto const index_size = _use_short_indices ? sizeof(GLushort) : sizeof(GLuint);
+
+	glGenVertexArrays(1, &_vao);
+	assert(_vao != 0u);
+	bonobo::state::bindVertexArray(_vao);
+
+	glGenBuffers(1, &_bo);
+	assert(_bo != 0u);
+	glBindBuffer(GL_ARRAY_BUFFER, _bo);
+	glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(bo_size), nullptr, GL_STATIC_DRAW);
+	for (std::size_t k = 0u; k < layouts.size(); ++k)
+		if (are_attributes_present[k])
+			set_up_attribute(layouts[k], static_cast<GLintptr>(_attribute_offsets[k]));
+	glBindBuffer(GL_ARRAY_BUFFER, 0u);
+
+	glGenBuffers(1, &_ibo);
+	assert(_ibo != 0u);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _ibo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(indices_nb * index_size), nullptr, GL_STATIC_DRAW);
+
+	utils::opengl::debug::nameObject(GL_VERTEX_ARRAY, _vao, name + " shared VAO");
+	utils::opengl::debug::nameObject(GL_BUFFER, _bo, name + " shared VBO");
+	utils::opengl::debug::nameObject(GL_BUFFER, _ibo, name + " shared IBO");
+
+	bonobo::state::bindVertexArray(0u);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0u);
+}
+
+bool
+bonobo::shared_mesh_buffers::is_valid() const
+{
+	return _vao != 0u;
+}
+
+bonobo::mesh_data
+bonobo::shared_mesh_buffers::upload(std::size_t index) const
+{
+	assert(is_valid() && index < _meshes.size());
+	auto const& mesh = _meshes[index];
+	auto const& layouts = get_attribute_layouts(_format);
+
+	bonobo::mesh_data object;
+	object.vao = _vao;
+	object.bo = _bo;
+	object.ibo = _ibo;
+	object.vertices_nb = static_cast<GLsizei>(mesh.vertices_nb);
+	set_up_lods(mesh, object);
+	object.indices_type = _use_short_indices ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+	object.first_index = _first_indices[index];
+	object.base_vertex = _base_vertices[index];
+	object.drawing_mode = mesh.drawing_mode;
+	object.name = mesh.name;
+
+	// The copy targets are used so that neither the bound VAO nor its
+	// index buffer get changed.
+	glBindBuffer(GL_COPY_WRITE_BUFFER, _bo);
+	std::vector<std::uint8_t> packed_attribute;
+	for (std::size_t k = 0u; k < layouts.size(); ++k) {
+		if (_attribute_offsets[k] == ~std::size_t(0u))
+			continue;
+
+		auto const& layout = layouts[k];
+		auto const size = static_cast<std::size_t>(mesh.vertices_nb) * layout.element_size;
+		GLvoid const* data = layout.is_present(mesh) ? layout.get_source(mesh) : nullptr;
+		if (data == nullptr) {
+			packed_attribute.assign(size, 0u);
+			if (layout.is_present(mesh))
+				pack_attribute(layout, mesh, packed_attribute.data());
+			data = packed_attribute.data();
+		}
+		glBufferSubData(GL_COPY_WRITE_BUFFER,
+		                static_cast<GLintptr>(_attribute_offsets[k] + static_cast<std::size_t>(object.base_vertex) * layout.element_size),
+		                static_cast<GLsizeiptr>(size), data);
+	}
+
+	std::vector<std::uint8_t> short_indices;
+	GLvoid const* indices = mesh.indices;
+	std::size_t index_size = sizeof(GLuint);
+	if (_use_short_indices) {
+		short_indices = copy_indices<GLushort>({ mesh }, mesh.indices_nb);
+		indices = short_indices.data();
+		index_size = sizeof(GLushort);
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, _ibo);
+	glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(static_cast<std::size_t>(object.first_index) * index_size),
+	                static_cast<GLsizeiptr>(mesh.indices_nb * index_size), indices);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0u);
+
+	return object;
+}
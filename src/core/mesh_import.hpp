@@ -0,0 +1,168 @@
+#pragma once
+
+#include "core/helpers.hpp"
+
+#include <glm/vec3.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bonobo
+{
+	//! \brief Reference from a material to one of its textures.
+	struct texture_reference {
+		std::string sampler_name; //!< name of the GLSL sampler the texture is bound to, e.g. "diffuse_texture"
+		std::string type_name;    //!< kind of texture, e.g. "diffuse"; used for debugging purposes
+		std::string path;         //!< path to the image, relative to the folder containing the scene file
+	};
+
+	//! \brief CPU-side description of a material, before any of its
+	//!        textures has been loaded.
+	struct material_description {
+		std::string name;                        //!< Name of the material; used for debugging purposes.
+		material_data constants{};               //!< constant values for the material
+		std::vector<texture_reference> textures; //!< textures used by the material, at most one per sampler
+	};
+
+	//! \brief Non-owning view over the vertex streams and indices of a
+	//!        mesh, ready to be uploaded to OpenGL.
+	//!
+	//! Attributes which are not present have a null pointer; when
+	//! present, they contain |vertices_nb| elements. When levels of
+	//! detail are present, |indices| contains all of them one after the
+	//! other.
+	struct mesh_view {
+		std::string name{"un-named mesh"};       //!< Name of the mesh; used for debugging purposes.
+		std::uint32_t material_index{~0u};       //!< index into the material list of the scene, ~0u if none
+		GLenum drawing_mode{GL_TRIANGLES};       //!< OpenGL drawing mode, i.e. GL_TRIANGLES, GL_LINES, etc.
+		std::uint32_t vertices_nb{0u};           //!< number of vertices in each attribute stream
+		std::uint32_t indices_nb{0u};            //!< number of indices
+		glm::vec3 const* vertices{nullptr};
+		glm::vec3 const* normals{nullptr};
+		glm::vec3 const* texcoords{nullptr};
+		glm::vec3 const* tangents{nullptr};
+		glm::vec3 const* binormals{nullptr};
+		std::uint32_t const* indices{nullptr};
+		std::uint32_t lods_nb{0u};               //!< number of levels of detail, 0 if only the full mesh is available
+		mesh_lod const* lods{nullptr};
+		std::uint32_t clusters_nb{0u};           //!< number of clusters of the most detailed level, 0 if they were not built
+		mesh_cluster const* clusters{nullptr};
+	};
+
+	//! \brief Mesh owning its vertex streams and indices.
+	//!
+	//! Attributes which are not present are left empty.
+	struct imported_mesh {
+		std::string name{"un-named mesh"};
+		std::uint32_t material_index{~0u};
+		GLenum drawing_mode{GL_TRIANGLES};
+		std::vector<glm::vec3> vertices;
+		std::vector<glm::vec3> normals;
+		std::vector<glm::vec3> texcoords;
+		std::vector<glm::vec3> tangents;
+		std::vector<glm::vec3> binormals;
+		std::vector<std::uint32_t> indices;
+		std::vector<mesh_lod> lods;
+		std::vector<mesh_cluster> clusters;
+
+		mesh_view view() const;
+	};
+
+	//! \brief Content of an object/scene file, without any OpenGL
+	//!        resources attached to it.
+	struct imported_scene {
+		std::vector<material_description> materials; //!< materials used by at least one mesh
+		std::vector<imported_mesh> meshes;
+		std::vector<std::string> dependencies;       //!< every file read during the import, starting with the scene file
+	};
+
+	//! \brief Read an object/scene file using assimp, and convert it to
+	//!        split vertex streams; no OpenGL call is made.
+	//!
+	//! Meshes which can not be rendered, for example because they mix
+	//! primitive types, are reported and skipped.
+	//!
+	//! @param [in] filename of the object/scene file to load
+	//! @param [in] assimp_flags post-processing steps to ask from assimp
+	//! @param [out] scene filled in with the imported materials and meshes
+	//! @return whether the file could be imported
+	bool importScene(std::string const& filename, unsigned int assimp_flags,
+	                 imported_scene& scene);
+
+	//! \brief Create the VAO, vertex and index buffers for a mesh.
+	//!
+	//! Only the geometry, its bounds, levels of detail and clusters are
+	//! set up: the texture bindings and material constants of the
+	//! returned structure are left empty.
+	//!
+	//! @param [in] mesh the vertex streams and indices to upload
+	//! @param [in] format how to store the vertex attributes and indices
+	//!             on the GPU; see `bonobo::vertex_format`
+	//! @return a filled in `mesh_data` structure
+	mesh_data uploadMesh(mesh_view const& mesh,
+	                     vertex_format format = vertex_format::full_precision);
+
+	//! \brief Create a single VAO, vertex and index buffer holding all the
+	//!        given meshes.
+	//!
+	//! All returned structures share the same OpenGL objects, and use
+	//! `first_index` and `base_vertex` to locate their own data; see
+	//! `bonobo::drawMesh()`. Attributes used by only some of the meshes
+	//! are set to zero for the other ones.
+	//!
+	//! @param [in] meshes the vertex streams and indices to upload
+	//! @param [in] format how to store the vertex attributes and indices
+	//!             on the GPU; see `bonobo::vertex_format`
+	//! @param [in] name used for naming the shared OpenGL objects
+	//! @return a filled in `mesh_data` structure per mesh, or nothing if
+	//!         the meshes could not fit in the shared buffers
+	std::vector<mesh_data> uploadMeshesToSharedBuffers(std::vector<mesh_view> const& meshes,
+	                                                   vertex_format format,
+	                                                   std::string const& name);
+
+	//! \brief Single VAO, vertex and index buffer sized for a set of
+	//!        meshes, whose data is uploaded one mesh at a time.
+	//!
+	//! This allows spreading the upload of large scenes over several
+	//! frames; the layout is the same as for
+	//! `uploadMeshesToSharedBuffers()`. The OpenGL objects are owned by
+	//! the returned `mesh_data` structures, not by this class.
+	class shared_mesh_buffers
+	{
+	public:
+		//! \brief Create the OpenGL objects, without any content yet.
+		//!
+		//! @param [in] meshes the vertex streams and indices to upload;
+		//!             they are only read by `upload()`, and have to stay
+		//!             alive until then
+		//! @param [in] format how to store the vertex attributes and
+		//!             indices on the GPU; see `bonobo::vertex_format`
+		//! @param [in] name used for naming the shared OpenGL objects
+		shared_mesh_buffers(std::vector<mesh_view> const& meshes,
+		                    vertex_format format, std::string const& name);
+
+		//! \brief Whether the meshes fit in the shared buffers; if not,
+		//!        no OpenGL object was created.
+		bool is_valid() const;
+
+		//! \brief Upload the vertices and indices of one of the meshes.
+		//!
+		//! @param [in] index of the mesh, in the list given at creation
+		//! @return a filled in `mesh_data` structure, without texture
+		//!         bindings nor material constants
+		mesh_data upload(std::size_t index) const;
+
+	private:
+		std::vector<mesh_view> _meshes;
+		vertex_format _format;
+		std::vector<std::size_t> _attribute_offsets; //!< in bytes, ~0 for attributes no mesh uses
+		std::vector<GLint> _base_vertices;
+		std::vector<GLsizei> _first_indices;
+		bool _use_short_indices{false};
+		GLuint _vao{0u};
+		GLuint _bo{0u};
+		GLuint _ibo{0u};
+	};
+}
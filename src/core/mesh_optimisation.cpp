@@ -0,0 +1,752 @@
+#include "mesh_optimisation.hpp"
+
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#	define BONOBO_BOUNDS_USE_SSE 1
+#	include <xmmintrin.h>
+#else
+#	define BONOBO_BOUNDS_USE_SSE 0
+#endif
+
+namespace
+{
+	std::uint32_t const no_vertex = ~0u;
+
+	//! \brief Triangles using each vertex, stored contiguously.
+	struct vertex_adjacency {
+		std::vector<std::uint32_t> offsets;   //!< triangles of vertex v are [offsets[v], offsets[v + 1])
+		std::vector<std::uint32_t> triangles;
+	};
+
+	vertex_adjacency compute_adjacency(std::vector<std::uint32_t> const& indices, std::uint32_t vertices_nb)
+	{
+		vertex_adjacency adjacency;
+		adjacency.offsets.assign(vertices_nb + 1u, 0u);
+		for (auto const index : indices)
+			++adjacency.offsets[index + 1u];
+		std::partial_sum(adjacency.offsets.begin(), adjacency.offsets.end(), adjacency.offsets.begin());
+
+		adjacency.triangles.resize(indices.size());
+		std::vector<std::uint32_t> fill(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+		for (std::size_t i = 0u; i < indices.size(); ++i)
+			adjacency.triangles[fill[indices[i]]++] = static_cast<std::uint32_t>(i / 3u);
+		return adjacency;
+	}
+
+	//! \brief Tipsify, from Sander et al.; returns the new triangle order,
+	//!        as well as the positions in that order where the cache was
+	//!        flushed (i.e. where a dead-end had to be skipped).
+	std::vector<std::uint32_t> tipsify(std::vector<std::uint32_t> const& indices, std::uint32_t vertices_nb,
+	                                   std::uint32_t cache_size, std::vector<std::size_t>& hard_boundaries)
+	{
+		auto const triangles_nb = indices.size() / 3u;
+		auto const adjacency = compute_adjacency(indices, vertices_nb);
+
+		std::vector<std::uint32_t> live_triangles_nb(vertices_nb);
+		for (std::uint32_t v = 0u; v < vertices_nb; ++v)
+			live_triangles_nb[v] = adjacency.offsets[v + 1u] - adjacency.offsets[v];
+		std::vector<std::uint32_t> cache_time_stamps(vertices_nb, 0u);
+		std::vector<bool> is_emitted(triangles_nb, false);
+		std::vector<std::uint32_t> dead_ends;
+		std::vector<std::uint32_t> candidates;
+
+		std::vector<std::uint32_t> order;
+		order.reserve(triangles_nb);
+
+		std::uint32_t time_stamp = cache_size + 1u;
+		std::uint32_t cursor = 0u;
+		std::uint32_t fanning_vertex = 0u;
+		while (fanning_vertex != no_vertex) {
+			candidates.clear();
+			for (auto k = adjacency.offsets[fanning_vertex]; k < adjacency.offsets[fanning_vertex + 1u]; ++k) {
+				auto const triangle = adjacency.triangles[k];
+				if (is_emitted[triangle])
+					continue;
+
+				for (std::size_t corner = 0u; corner < 3u; ++corner) {
+					auto const v = indices[3u * triangle + corner];
+					dead_ends.push_back(v);
+					candidates.push_back(v);
+					--live_triangles_nb[v];
+					if (time_stamp - cache_time_stamps[v] > cache_size)
+						cache_time_stamps[v] = time_stamp++;
+				}
+				is_emitted[triangle] = true;
+				order.push_back(triangle);
+			}
+
+			// Pick the candidate which will still be in the cache once all
+			// its remaining triangles are emitted, and which entered it the
+			// earliest.
+			fanning_vertex = no_vertex;
+			int best_priority = -1;
+			for (auto const v : candidates) {
+				if (live_triangles_nb[v] == 0u)
+					continue;
+				int priority = 0;
+				if (time_stamp - cache_time_stamps[v] + 2u * live_triangles_nb[v] <= cache_size)
+					priority = static_cast<int>(time_stamp - cache_time_stamps[v]);
+				if (priority > best_priority) {
+					best_priority = priority;
+					fanning_vertex = v;
+				}
+			}
+			if (fanning_vertex != no_vertex)
+				continue;
+
+			// Dead-end: go back to a recently used vertex, or to the next
+			// one in input order.
+			while (!dead_ends.empty() && fanning_vertex == no_vertex) {
+				auto const v = dead_ends.back();
+				dead_ends.pop_back();
+				if (live_triangles_nb[v] > 0u)
+					fanning_vertex = v;
+			}
+			while (cursor < vertices_nb && fanning_vertex == no_vertex) {
+				if (live_triangles_nb[cursor] > 0u)
+					fanning_vertex = cursor;
+				++cursor;
+			}
+			if (fanning_vertex != no_vertex)
+				hard_boundaries.push_back(order.size());
+		}
+
+		return order;
+	}
+
+	//! \brief Sum of squared distances to a set of planes, weighted by
+	//!        the area of the triangles they come from.
+	struct quadric {
+		double a00{0.0}, a11{0.0}, a22{0.0}, a01{0.0}, a02{0.0}, a12{0.0};
+		double b0{0.0}, b1{0.0}, b2{0.0};
+		double c{0.0};
+		double weight{0.0};
+
+		quadric& operator+=(quadric const& other)
+		{
+			a00 += other.a00; a11 += other.a11; a22 += other.a22;
+			a01 += other.a01; a02 += other.a02; a12 += other.a12;
+			b0 += other.b0; b1 += other.b1; b2 += other.b2;
+			c += other.c;
+			weight += other.weight;
+			return *this;
+		}
+	};
+
+	quadric make_plane_quadric(glm::vec3 const& p0, glm::vec3 const& p1, glm::vec3 const& p2)
+	{
+		quadric q;
+		auto const normal = glm::cross(p1 - p0, p2 - p0);
+		auto const length = glm::length(normal);
+		if (length == 0.0f)
+			return q;
+
+		double const area = 0.5 * static_cast<double>(length);
+		double const x = normal.x / length, y = normal.y / length, z = normal.z / length;
+		double const d = -(x * p0.x + y * p0.y + z * p0.z);
+		q.a00 = area * x * x; q.a11 = area * y * y; q.a22 = area * z * z;
+		q.a01 = area * x * y; q.a02 = area * x * z; q.a12 = area * y * z;
+		q.b0 = area * x * d; q.b1 = area * y * d; q.b2 = area * z * d;
+		q.c = area * d * d;
+		q.weight = area;
+		return q;
+	}
+
+	//! \brief Root mean squared distance from |p| to the planes of |q|.
+	float evaluate_quadric(quadric const& q, glm::vec3 const& p)
+	{
+		if (q.weight <= 0.0)
+			return 0.0f;
+		double const x = p.x, y = p.y, z = p.z;
+		double const squared_distance = q.a00 * x * x + q.a11 * y * y + q.a22 * z * z
+		                              + 2.0 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z)
+		                              + 2.0 * (q.b0 * x + q.b1 * y + q.b2 * z)
+		                              + q.c;
+		return static_cast<float>(std::sqrt(std::max(squared_distance, 0.0) / q.weight));
+	}
+
+	//! \brief For each vertex, the first vertex sharing its position.
+	std::vector<std::uint32_t> compute_position_ids(glm::vec3 const* vertices, std::uint32_t vertices_nb)
+	{
+		struct position_hash {
+			std::size_t operator()(glm::vec3 const& p) const
+			{
+				std::uint32_t bits[3];
+				std::memcpy(bits, &p.x, sizeof(float));
+				std::memcpy(bits + 1, &p.y, sizeof(float));
+				std::memcpy(bits + 2, &p.z, sizeof(float));
+				return (static_cast<std::size_t>(bits[0]) * 73856093u) ^ (static_cast<std::size_t>(bits[1]) * 19349663u) ^ (static_cast<std::size_t>(bits[2]) * 83492791u);
+			}
+		};
+		struct position_equal {
+			bool operator()(glm::vec3 const& lhs, glm::vec3 const& rhs) const
+			{
+				return lhs.x == rhs.x && lhs.y == rhs.y && lhs.z == rhs.z;
+			}
+		};
+
+		std::vector<std::uint32_t> position_ids(vertices_nb);
+		std::unordered_map<glm::vec3, std::uint32_t, position_hash, position_equal> first_vertices;
+		first_vertices.reserve(vertices_nb);
+		for (std::uint32_t v = 0u; v < vertices_nb; ++v)
+			position_ids[v] = first_vertices.emplace(vertices[v], v).first->second;
+		return position_ids;
+	}
+
+	//! \brief Simplify a triangle list down to |target_indices_nb|
+	//!        indices, through half-edge collapses.
+	//!
+	//! @param [inout] quadrics per position ID, updated as vertices get
+	//!                merged
+	//! @param [inout] error largest error of the collapses performed
+	std::vector<std::uint32_t> simplify(glm::vec3 const* vertices, std::uint32_t vertices_nb,
+	                                    std::vector<std::uint32_t> const& position_ids,
+	                                    std::vector<quadric>& quadrics,
+	                                    std::vector<std::uint32_t> const& indices,
+	                                    std::size_t target_indices_nb, float max_error, float& error)
+	{
+		// Vertices sharing their position with others lie on an attribute
+		// seam, and vertices on an edge used by a single triangle (or more
+		// than two) lie on a border: moving any of them would open cracks.
+		std::vector<std::uint32_t> vertices_per_position(vertices_nb, 0u);
+		for (std::uint32_t v = 0u; v < vertices_nb; ++v)
+			++vertices_per_position[position_ids[v]];
+		std::vector<bool> is_position_locked(vertices_nb, false);
+		for (std::uint32_t v = 0u; v < vertices_nb; ++v)
+			is_position_locked[position_ids[v]] = vertices_per_position[position_ids[v]] > 1u;
+		{
+			std::unordered_map<std::uint64_t, std::uint32_t> edge_uses;
+			edge_uses.reserve(indices.size());
+			auto const edge_key = [&position_ids](std::uint32_t a, std::uint32_t b) {
+				auto const pa = position_ids[a], pb = position_ids[b];
+				return (static_cast<std::uint64_t>(std::min(pa, pb)) << 32) | std::max(pa, pb);
+			};
+			for (std::size_t i = 0u; i < indices.size(); i += 3u)
+				for (std::size_t corner = 0u; corner < 3u; ++corner)
+					++edge_uses[edge_key(indices[i + corner], indices[i + (corner + 1u) % 3u])];
+			for (auto const& edge : edge_uses) {
+				if (edge.second == 2u)
+					continue;
+				is_position_locked[static_cast<std::uint32_t>(edge.first >> 32)] = true;
+				is_position_locked[static_cast<std::uint32_t>(edge.first & 0xffffffffu)] = true;
+			}
+		}
+
+		struct collapse {
+			float cost;
+			std::uint32_t from, to;
+		};
+		std::vector<collapse> collapses;
+		std::vector<std::uint32_t> collapse_targets(vertices_nb);
+		std::iota(collapse_targets.begin(), collapse_targets.end(), 0u);
+		std::vector<bool> is_touched(vertices_nb);
+		auto const resolve = [&collapse_targets](std::uint32_t v) {
+			while (collapse_targets[v] != v)
+				v = collapse_targets[v];
+			return v;
+		};
+
+		// Collapses are performed in passes: each pass picks the cheapest
+		// ones touching distinct vertices, and the index list gets
+		// rewritten after each of them.
+		auto current = indices;
+		while (current.size() > target_indices_nb) {
+			auto const adjacency = compute_adjacency(current, vertices_nb);
+
+			collapses.clear();
+			for (std::size_t i = 0u; i < current.size(); i += 3u) {
+				for (std::size_t corner = 0u; corner < 3u; ++corner) {
+					auto const a = current[i + corner], b = current[i + (corner + 1u) % 3u];
+					if (a == b)
+						continue;
+					auto q = quadrics[position_ids[a]];
+					q += quadrics[position_ids[b]];
+					if (!is_position_locked[position_ids[a]])
+						collapses.push_back({ evaluate_quadric(q, vertices[b]), a, b });
+					if (!is_position_locked[position_ids[b]])
+						collapses.push_back({ evaluate_quadric(q, vertices[a]), b, a });
+				}
+			}
+			std::sort(collapses.begin(), collapses.end(), [](collapse const& lhs, collapse const& rhs) {
+				return lhs.cost < rhs.cost;
+			});
+
+			std::fill(is_touched.begin(), is_touched.end(), false);
+			std::size_t const max_removed_triangles_nb = (current.size() - target_indices_nb) / 3u;
+			std::size_t removed_triangles_nb = 0u;
+			std::size_t performed_collapses_nb = 0u;
+			for (auto const& candidate : collapses) {
+				if (candidate.cost > max_error || removed_triangles_nb >= max_removed_triangles_nb)
+					break;
+				if (is_touched[candidate.from] || is_touched[candidate.to])
+					continue;
+
+				// Reject collapses which would flip, or flatten, any of the
+				// triangles moving along.
+				bool is_valid = true;
+				std::size_t collapsing_triangles_nb = 0u;
+				for (auto k = adjacency.offsets[candidate.from]; k < adjacency.offsets[candidate.from + 1u] && is_valid; ++k) {
+					auto const triangle = adjacency.triangles[k];
+					std::uint32_t corners[3];
+					for (std::size_t corner = 0u; corner < 3u; ++corner)
+						corners[corner] = resolve(current[3u * triangle + corner]);
+					if (corners[0] == corners[1] || corners[1] == corners[2] || corners[2] == corners[0])
+						continue;
+					if (corners[0] == candidate.to || corners[1] == candidate.to || corners[2] == candidate.to) {
+						++collapsing_triangles_nb;
+						continue;
+					}
+
+					auto const normal_before = glm::cross(vertices[corners[1]] - vertices[corners[0]], vertices[corners[2]] - vertices[corners[0]]);
+					for (auto& corner : corners)
+						if (corner == candidate.from)
+							corner = candidate.to;
+					auto const normal_after = glm::cross(vertices[corners[1]] - vertices[corners[0]], vertices[corners[2]] - vertices[corners[0]]);
+					is_valid = glm::dot(normal_before, normal_after) > 0.0f;
+				}
+				if (!is_valid)
+					continue;
+
+				collapse_targets[candidate.from] = candidate.to;
+				quadrics[position_ids[candidate.to]] += quadrics[position_ids[candidate.from]];
+				is_touched[candidate.from] = true;
+				is_touched[candidate.to] = true;
+				removed_triangles_nb += collapsing_triangles_nb;
+				error = std::max(error, candidate.cost);
+				++performed_collapses_nb;
+			}
+			if (performed_collapses_nb == 0u)
+				break;
+
+			std::vector<std::uint32_t> simplified;
+			simplified.reserve(current.size());
+			for (std::size_t i = 0u; i < current.size(); i += 3u) {
+				auto const a = resolve(current[i]), b = resolve(current[i + 1u]), c = resolve(current[i + 2u]);
+				if (a == b || b == c || c == a)
+					continue;
+				simplified.push_back(a);
+				simplified.push_back(b);
+				simplified.push_back(c);
+			}
+			current = std::move(simplified);
+		}
+
+		return current;
+	}
+}
+
+bonobo::vertex_cache_statistics
+bonobo::computeVertexCacheStatistics(std::uint32_t const* indices, std::size_t indices_nb,
+                                     std::uint32_t vertices_nb, std::uint32_t cache_size)
+{
+	vertex_cache_statistics statistics;
+	if (indices_nb < 3u || vertices_nb == 0u)
+		return statistics;
+
+	// A vertex is in the cache if fewer than |cache_size| misses happened
+	// since it was last loaded.
+	std::vector<std::uint64_t> load_times(vertices_nb, 0u);
+	std::vector<bool> is_referenced(vertices_nb, false);
+	std::uint64_t misses_nb = 0u;
+	std::uint32_t referenced_vertices_nb = 0u;
+	for (std::size_t i = 0u; i < indices_nb; ++i) {
+		auto const v = indices[i];
+		if (!is_referenced[v]) {
+			is_referenced[v] = true;
+			++referenced_vertices_nb;
+		} else if (misses_nb - load_times[v] < cache_size) {
+			continue;
+		}
+		load_times[v] = ++misses_nb;
+	}
+
+	statistics.acmr = static_cast<float>(misses_nb) / static_cast<float>(indices_nb / 3u);
+	statistics.atvr = static_cast<float>(misses_nb) / static_cast<float>(referenced_vertices_nb);
+	return statistics;
+}
+
+void
+bonobo::optimiseTriangleOrder(imported_mesh& mesh, std::uint32_t cache_size, float overdraw_threshold,
+                              vertex_cache_statistics* before, vertex_cache_statistics* after)
+{
+	auto const vertices_nb = static_cast<std::uint32_t>(mesh.vertices.size());
+	auto const& indices = mesh.indices;
+	if (before != nullptr)
+		*before = computeVertexCacheStatistics(indices.data(), indices.size(), vertices_nb, cache_size);
+	if (mesh.drawing_mode != GL_TRIANGLES || indices.size() < 6u) {
+		if (after != nullptr && before != nullptr)
+			*after = *before;
+		return;
+	}
+
+	std::vector<std::size_t> hard_boundaries;
+	auto const tipsified_order = tipsify(indices, vertices_nb, cache_size, hard_boundaries);
+	hard_boundaries.push_back(tipsified_order.size());
+
+	std::vector<std::uint32_t> tipsified_indices(indices.size());
+	for (std::size_t t = 0u; t < tipsified_order.size(); ++t)
+		for (std::size_t corner = 0u; corner < 3u; ++corner)
+			tipsified_indices[3u * t + corner] = indices[3u * tipsified_order[t] + corner];
+	auto const tipsified_acmr = computeVertexCacheStatistics(tipsified_indices.data(), tipsified_indices.size(),
+	                                                         vertices_nb, cache_size).acmr;
+
+	// Cut the sequence into clusters: at hard boundaries, where the cache
+	// got flushed, and at soft ones, where the ACMR of the cluster so far
+	// is already good enough.
+	std::vector<std::size_t> cluster_starts;
+	{
+		std::vector<std::uint64_t> load_times(vertices_nb, 0u);
+		std::uint64_t misses_nb = 0u;
+		std::uint64_t cluster_misses_nb = 0u;
+		std::size_t cluster_start = 0u;
+		std::size_t next_hard_boundary = 0u;
+		for (std::size_t t = 0u; t < tipsified_order.size(); ++t) {
+			bool const is_hard_boundary = t == hard_boundaries[next_hard_boundary];
+			if (is_hard_boundary)
+				++next_hard_boundary;
+			bool const is_soft_boundary = t > cluster_start
+			                           && static_cast<float>(cluster_misses_nb) <= overdraw_threshold * tipsified_acmr * static_cast<float>(t - cluster_start);
+			if (t == 0u || is_hard_boundary || is_soft_boundary) {
+				cluster_starts.push_back(t);
+				cluster_start = t;
+				cluster_misses_nb = 0u;
+				// Soft boundaries do not flush the cache, but the clusters
+				// could end up in any order, so assume they do.
+				misses_nb += cache_size;
+			}
+			for (std::size_t corner = 0u; corner < 3u; ++corner) {
+				auto const v = tipsified_indices[3u * t + corner];
+				if (load_times[v] != 0u && misses_nb - load_times[v] < cache_size)
+					continue;
+				load_times[v] = ++misses_nb;
+				++cluster_misses_nb;
+			}
+		}
+		cluster_starts.push_back(tipsified_order.size());
+	}
+
+	// Sort the clusters by how much they face away from the centre of the
+	// mesh: those are the most likely to occlude the others.
+	struct cluster {
+		std::size_t start, end;
+		float sort_key;
+	};
+	auto const triangle_area_and_normal = [&mesh, &tipsified_indices](std::size_t t, glm::vec3& centroid) {
+		auto const& a = mesh.vertices[tipsified_indices[3u * t + 0u]];
+		auto const& b = mesh.vertices[tipsified_indices[3u * t + 1u]];
+		auto const& c = mesh.vertices[tipsified_indices[3u * t + 2u]];
+		centroid = (a + b + c) / 3.0f;
+		return glm::cross(b - a, c - a); // its length is twice the area
+	};
+	glm::vec3 mesh_centroid(0.0f);
+	float mesh_area = 0.0f;
+	for (std::size_t t = 0u; t < tipsified_order.size(); ++t) {
+		glm::vec3 centroid;
+		auto const area = glm::length(triangle_area_and_normal(t, centroid));
+		mesh_centroid += centroid * area;
+		mesh_area += area;
+	}
+	if (mesh_area > 0.0f)
+		mesh_centroid /= mesh_area;
+
+	std::vector<cluster> clusters;
+	clusters.reserve(cluster_starts.size() - 1u);
+	for (std::size_t k = 0u; k + 1u < cluster_starts.size(); ++k) {
+		cluster current{ cluster_starts[k], cluster_starts[k + 1u], 0.0f };
+		glm::vec3 cluster_centroid(0.0f), cluster_normal(0.0f);
+		float cluster_area = 0.0f;
+		for (auto t = current.start; t < current.end; ++t) {
+			glm::vec3 centroid;
+			auto const normal = triangle_area_and_normal(t, centroid);
+			auto const area = glm::length(normal);
+			cluster_centroid += centroid * area;
+			cluster_normal += normal;
+			cluster_area += area;
+		}
+		if (cluster_area > 0.0f)
+			cluster_centroid /= cluster_area;
+		current.sort_key = glm::dot(cluster_centroid - mesh_centroid, cluster_normal);
+		clusters.push_back(current);
+	}
+	std::stable_sort(clusters.begin(), clusters.end(), [](cluster const& lhs, cluster const& rhs) {
+		return lhs.sort_key > rhs.sort_key;
+	});
+
+	std::vector<std::uint32_t> optimised_indices;
+	optimised_indices.reserve(indices.size());
+	for (auto const& current : clusters)
+		optimised_indices.insert(optimised_indices.end(),
+		                         tipsified_indices.begin() + static_cast<std::ptrdiff_t>(3u * current.start),
+		                         tipsified_indices.begin() + static_cast<std::ptrdiff_t>(3u * current.end));
+	mesh.indices = std::move(optimised_indices);
+
+	if (after != nullptr)
+		*after = computeVertexCacheStatistics(mesh.indices.data(), mesh.indices.size(), vertices_nb, cache_size);
+}
+
+bonobo::bounding_box
+bonobo::computeBoundingBox(glm::vec3 const* vertices, std::size_t vertices_nb)
+{
+	bounding_box box;
+	if (vertices == nullptr || vertices_nb == 0u)
+		return box;
+
+	auto min_corner = vertices[0], max_corner = vertices[0];
+	std::size_t i = 0u;
+#if BONOBO_BOUNDS_USE_SSE
+	// Four vertices span three registers, holding xyzx, yzxy and zxyz;
+	// each register keeps its own minimum and maximum, which get merged
+	// component-wise at the end.
+	if (vertices_nb >= 4u) {
+		auto const components = &vertices[0].x;
+		__m128 min_values[3], max_values[3];
+		for (std::size_t r = 0u; r < 3u; ++r)
+			min_values[r] = max_values[r] = _mm_loadu_ps(components + 4u * r);
+		for (i = 4u; i + 4u <= vertices_nb; i += 4u) {
+			auto const group = components + 3u * i;
+			for (std::size_t r = 0u; r < 3u; ++r) {
+				auto const values = _mm_loadu_ps(group + 4u * r);
+				min_values[r] = _mm_min_ps(min_values[r], values);
+				max_values[r] = _mm_max_ps(max_values[r], values);
+			}
+		}
+
+		float lowest[12], highest[12];
+		for (std::size_t r = 0u; r < 3u; ++r) {
+			_mm_storeu_ps(lowest + 4u * r, min_values[r]);
+			_mm_storeu_ps(highest + 4u * r, max_values[r]);
+		}
+		for (std::size_t c = 0u; c < 12u; ++c) {
+			min_corner[c % 3u] = std::min(min_corner[c % 3u], lowest[c]);
+			max_corner[c % 3u] = std::max(max_corner[c % 3u], highest[c]);
+		}
+	}
+#endif
+	for (; i < vertices_nb; ++i) {
+		min_corner = glm::min(min_corner, vertices[i]);
+		max_corner = glm::max(max_corner, vertices[i]);
+	}
+
+	box.min_corner = min_corner;
+	box.max_corner = max_corner;
+	return box;
+}
+
+bonobo::bounding_sphere
+bonobo::computeBoundingSphere(glm::vec3 const* vertices, std::size_t vertices_nb)
+{
+	return computeBoundingSphere(vertices, vertices_nb, computeBoundingBox(vertices, vertices_nb));
+}
+
+bonobo::bounding_sphere
+bonobo::computeBoundingSphere(glm::vec3 const* vertices, std::size_t vertices_nb, bounding_box const& box)
+{
+	bounding_sphere sphere;
+	if (vertices == nullptr || vertices_nb == 0u)
+		return sphere;
+
+	sphere.centre = 0.5f * (box.min_corner + box.max_corner);
+
+	float squared_radius = 0.0f;
+	for (std::size_t i = 0u; i < vertices_nb; ++i) {
+		auto const offset = vertices[i] - sphere.centre;
+		squared_radius = std::max(squared_radius, glm::dot(offset, offset));
+	}
+	sphere.radius = std::sqrt(squared_radius);
+	return sphere;
+}
+
+bonobo::bounding_box
+bonobo::transformBoundingBox(bounding_box const& box, glm::mat4 const& transform)
+{
+	// Start from the translation, then add the extreme contributions of
+	// each column of the linear part.
+	bounding_box transformed;
+	transformed.min_corner = transformed.max_corner = glm::vec3(transform[3]);
+	for (glm::length_t column = 0; column < 3; ++column) {
+		auto const a = glm::vec3(transform[column]) * box.min_corner[column];
+		auto const b = glm::vec3(transform[column]) * box.max_corner[column];
+		transformed.min_corner += glm::min(a, b);
+		transformed.max_corner += glm::max(a, b);
+	}
+	return transformed;
+}
+
+bonobo::bounding_box
+bonobo::transformBoundingBox(bounding_box const& box, TRSTransformf const& transform)
+{
+	return transformBoundingBox(box, transform.GetMatrix());
+}
+
+bonobo::bounding_sphere
+bonobo::transformBoundingSphere(bounding_sphere const& sphere, glm::mat4 const& transform)
+{
+	auto const squared_scale = std::max({ glm::dot(glm::vec3(transform[0]), glm::vec3(transform[0])),
+	                                      glm::dot(glm::vec3(transform[1]), glm::vec3(transform[1])),
+	                                      glm::dot(glm::vec3(transform[2]), glm::vec3(transform[2])) });
+	bounding_sphere transformed;
+	transformed.centre = glm::vec3(transform * glm::vec4(sphere.centre, 1.0f));
+	transformed.radius = sphere.radius * std::sqrt(squared_scale);
+	return transformed;
+}
+
+bonobo::bounding_sphere
+bonobo::transformBoundingSphere(bounding_sphere const& sphere, TRSTransformf const& transform)
+{
+	// The rotation preserves lengths, so only the scale matters.
+	auto const scale = glm::abs(transform.GetScale());
+	bounding_sphere transformed;
+	transformed.centre = transform.GetTranslation() + transform.GetRotation() * (transform.GetScale() * sphere.centre);
+	transformed.radius = sphere.radius * std::max({ scale.x, scale.y, scale.z });
+	return transformed;
+}
+
+std::vector<bonobo::mesh_lod>
+bonobo::generateLods(glm::vec3 const* vertices, std::uint32_t vertices_nb, std::vector<std::uint32_t>& indices,
+                     unsigned int lods_nb, float max_error)
+{
+	std::vector<mesh_lod> lods;
+	if (lods_nb < 2u || vertices_nb == 0u || indices.size() < 6u
+	 || indices.size() > static_cast<std::size_t>(std::numeric_limits<std::uint32_t>::max()) / lods_nb)
+		return lods;
+
+	auto const sphere = computeBoundingSphere(vertices, vertices_nb);
+	if (sphere.radius <= 0.0f)
+		return lods;
+
+	auto const position_ids = compute_position_ids(vertices, vertices_nb);
+	std::vector<quadric> quadrics(vertices_nb);
+	for (std::size_t i = 0u; i < indices.size(); i += 3u) {
+		auto const q = make_plane_quadric(vertices[indices[i]], vertices[indices[i + 1u]], vertices[indices[i + 2u]]);
+		for (std::size_t corner = 0u; corner < 3u; ++corner)
+			quadrics[position_ids[indices[i + corner]]] += q;
+	}
+
+	lods.push_back({ 0u, static_cast<std::uint32_t>(indices.size()), 0.0f });
+	auto level = indices;
+	float error = 0.0f;
+	for (unsigned int l = 1u; l < lods_nb; ++l) {
+		auto const target_indices_nb = 3u * (level.size() / 6u);
+		auto simplified = simplify(vertices, vertices_nb, position_ids, quadrics, level, target_indices_nb,
+		                           max_error * sphere.radius, error);
+
+		// Levels which barely reduce the number of triangles are not worth
+		// switching to.
+		if (simplified.empty() || 5u * simplified.size() > 4u * level.size())
+			break;
+
+		lods.push_back({ static_cast<std::uint32_t>(indices.size()), static_cast<std::uint32_t>(simplified.size()),
+		                 error / sphere.radius });
+		indices.insert(indices.end(), simplified.begin(), simplified.end());
+		level = std::move(simplified);
+	}
+
+	if (lods.size() < 2u)
+		lods.clear();
+	return lods;
+}
+
+void
+bonobo::generateLods(imported_mesh& mesh, unsigned int lods_nb, float max_error)
+{
+	if (mesh.drawing_mode != GL_TRIANGLES || !mesh.lods.empty())
+		return;
+
+	mesh.lods = generateLods(mesh.vertices.data(), static_cast<std::uint32_t>(mesh.vertices.size()), mesh.indices,
+	                         lods_nb, max_error);
+}
+
+std::vector<bonobo::mesh_cluster>
+bonobo::buildClusters(glm::vec3 const* vertices, std::uint32_t const* indices, std::size_t indices_nb,
+                      std::size_t max_vertices_nb, std::size_t max_triangles_nb)
+{
+	std::vector<mesh_cluster> clusters;
+	if (indices_nb < 3u || max_vertices_nb < 3u || max_triangles_nb == 0u)
+		return clusters;
+
+	std::vector<glm::vec3> cluster_vertices;
+	cluster_vertices.reserve(max_vertices_nb);
+	std::vector<glm::vec3> cluster_normals;
+	cluster_normals.reserve(max_triangles_nb);
+	auto const finish_cluster = [&](std::size_t first_index, std::size_t end_index) {
+		mesh_cluster cluster;
+		cluster.first_index = static_cast<std::uint32_t>(first_index);
+		cluster.indices_nb = static_cast<std::uint32_t>(end_index - first_index);
+		cluster.sphere = computeBoundingSphere(cluster_vertices.data(), cluster_vertices.size());
+
+		glm::vec3 normals_sum(0.0f);
+		for (auto const& normal : cluster_normals)
+			normals_sum += normal;
+		auto const normals_sum_length = glm::length(normals_sum);
+		if (normals_sum_length > 0.0f) {
+			cluster.cone_axis = normals_sum / normals_sum_length;
+			float min_cosine = 1.0f;
+			for (auto const& normal : cluster_normals)
+				min_cosine = std::min(min_cosine, glm::dot(normal, cluster.cone_axis));
+			// Past 90°, some triangles always face the viewer.
+			cluster.cone_cutoff = min_cosine > 0.0f ? std::sqrt(1.0f - min_cosine * min_cosine) : 1.0f;
+		}
+
+		clusters.push_back(cluster);
+		cluster_vertices.clear();
+		cluster_normals.clear();
+	};
+
+	// Vertices whose stamp matches the current cluster are already part
+	// of it.
+	std::uint32_t max_index = 0u;
+	for (std::size_t i = 0u; i < indices_nb; ++i)
+		max_index = std::max(max_index, indices[i]);
+	std::vector<std::size_t> vertex_stamps(static_cast<std::size_t>(max_index) + 1u, 0u);
+	std::size_t stamp = 1u;
+
+	std::size_t cluster_start = 0u;
+	for (std::size_t i = 0u; i + 2u < indices_nb; i += 3u) {
+		std::size_t new_vertices_nb = 0u;
+		for (std::size_t corner = 0u; corner < 3u; ++corner)
+			new_vertices_nb += vertex_stamps[indices[i + corner]] != stamp ? 1u : 0u;
+		if (cluster_vertices.size() + new_vertices_nb > max_vertices_nb
+		 || (i - cluster_start) / 3u + 1u > max_triangles_nb) {
+			finish_cluster(cluster_start, i);
+			cluster_start = i;
+			++stamp;
+		}
+
+		for (std::size_t corner = 0u; corner < 3u; ++corner) {
+			auto const v = indices[i + corner];
+			if (vertex_stamps[v] == stamp)
+				continue;
+			vertex_stamps[v] = stamp;
+			cluster_vertices.push_back(vertices[v]);
+		}
+		auto const normal = glm::cross(vertices[indices[i + 1u]] - vertices[indices[i]],
+		                               vertices[indices[i + 2u]] - vertices[indices[i]]);
+		auto const normal_length = glm::length(normal);
+		if (normal_length > 0.0f)
+			cluster_normals.push_back(normal / normal_length);
+	}
+	finish_cluster(cluster_start, indices_nb - indices_nb % 3u);
+
+	return clusters;
+}
+
+void
+bonobo::buildClusters(imported_mesh& mesh, std::size_t max_vertices_nb, std::size_t max_triangles_nb)
+{
+	if (mesh.drawing_mode != GL_TRIANGLES || mesh.vertices.empty())
+		return;
+
+	auto const indices_nb = mesh.lods.empty() ? mesh.indices.size() : static_cast<std::size_t>(mesh.lods.front().indices_nb);
+	mesh.clusters = buildClusters(mesh.vertices.data(), mesh.indices.data(), indices_nb,
+	                              max_vertices_nb, max_triangles_nb);
+}
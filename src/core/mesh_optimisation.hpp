@@ -0,0 +1,154 @@
+#pragma once
+
+#include "core/mesh_import.hpp"
+#include "core/TRSTransform.h"
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bonobo
+{
+	//! \brief Efficiency of a triangle order with respect to the
+	//!        post-transform vertex cache.
+	struct vertex_cache_statistics {
+		float acmr{0.0f}; //!< Average Cache Miss Ratio: vertex shader invocations per triangle, between 0.5 and 3
+		float atvr{0.0f}; //!< Average Transform to Vertex Ratio: vertex shader invocations per referenced vertex, 1 at best
+	};
+
+	//! \brief Simulate a FIFO post-transform vertex cache over a list of
+	//!        triangles.
+	//!
+	//! @param [in] indices of the triangles, three per triangle
+	//! @param [in] indices_nb number of indices
+	//! @param [in] vertices_nb number of vertices referenced by |indices|
+	//! @param [in] cache_size number of entries in the simulated cache
+	//! @return the ACMR and ATVR of the given triangle order
+	vertex_cache_statistics computeVertexCacheStatistics(std::uint32_t const* indices,
+	                                                     std::size_t indices_nb,
+	                                                     std::uint32_t vertices_nb,
+	                                                     std::uint32_t cache_size = 16u);
+
+	//! \brief Reorder the triangles of a mesh to make better use of the
+	//!        post-transform vertex cache, and to reduce overdraw.
+	//!
+	//! This follows "Fast Triangle Reordering for Vertex Locality and
+	//! Reduced Overdraw" by Sander, Nehab and Barczak (2007): triangles are
+	//! first ordered using Tipsify, and the resulting sequence is cut into
+	//! clusters wherever the cache was flushed or the local ACMR got close
+	//! enough to the overall one; those clusters are then sorted so that the
+	//! ones facing outwards, and therefore likely to occlude the others,
+	//! are drawn first.
+	//!
+	//! Meshes which are not made of triangles are left untouched.
+	//!
+	//! @param [inout] mesh the mesh whose indices to reorder
+	//! @param [in] cache_size number of entries of the targeted cache
+	//! @param [in] overdraw_threshold a cluster is closed once its ACMR
+	//!             drops below this factor times the ACMR of the Tipsify
+	//!             order; larger values give smaller clusters, and
+	//!             therefore better overdraw sorting, but more cache misses
+	//! @param [out] before if not null, statistics of the original order
+	//! @param [out] after if not null, statistics of the new order
+	void optimiseTriangleOrder(imported_mesh& mesh, std::uint32_t cache_size = 16u,
+	                           float overdraw_threshold = 1.05f,
+	                           vertex_cache_statistics* before = nullptr,
+	                           vertex_cache_statistics* after = nullptr);
+
+	//! \brief Compute the axis-aligned box enclosing the given vertices.
+	//!
+	//! The minimum and maximum are reduced four components at a time
+	//! using SSE where available.
+	bounding_box computeBoundingBox(glm::vec3 const* vertices, std::size_t vertices_nb);
+
+	//! \brief Compute a sphere enclosing the given vertices.
+	//!
+	//! The sphere is centred on the axis-aligned bounding box of the
+	//! vertices, so it is not the smallest one but is cheap to compute.
+	bounding_sphere computeBoundingSphere(glm::vec3 const* vertices, std::size_t vertices_nb);
+
+	//! \brief Same as above, for when the box enclosing the vertices is
+	//!        already known.
+	bounding_sphere computeBoundingSphere(glm::vec3 const* vertices, std::size_t vertices_nb,
+	                                      bounding_box const& box);
+
+	//! \brief Compute the axis-aligned box enclosing a transformed box,
+	//!        e.g. for bringing bounds from model-space to world-space.
+	//!
+	//! This follows "Transforming Axis-Aligned Bounding Boxes" by Arvo
+	//! (1990); the result is not tight if |transform| rotates the box.
+	bounding_box transformBoundingBox(bounding_box const& box, glm::mat4 const& transform);
+	bounding_box transformBoundingBox(bounding_box const& box, TRSTransformf const& transform);
+
+	//! \brief Compute a sphere enclosing a transformed sphere.
+	//!
+	//! With a non-uniform scaling the radius grows by the largest scale
+	//! factor, so the result is not tight.
+	bounding_sphere transformBoundingSphere(bounding_sphere const& sphere, glm::mat4 const& transform);
+	bounding_sphere transformBoundingSphere(bounding_sphere const& sphere, TRSTransformf const& transform);
+
+	//! \brief Generate simplified versions of a triangle mesh, and append
+	//!        their indices to the ones of the mesh.
+	//!
+	//! Each level is obtained from the previous one by collapsing edges
+	//! in order of increasing quadric error (Garland and Heckbert, 1997),
+	//! until half of its triangles are gone or the error would exceed
+	//! |max_error|. Vertices are only ever merged into existing ones, so
+	//! all levels share the original vertex buffer; vertices on borders or
+	//! on attribute seams (i.e. sharing their position with another
+	//! vertex) are never moved, so levels do not crack.
+	//!
+	//! Levels keep the relative triangle order of the one they derive
+	//! from, so any reordering (see `optimiseTriangleOrder()`) should be
+	//! done beforehand.
+	//!
+	//! @param [in] vertices positions of the vertices
+	//! @param [in] vertices_nb number of vertices
+	//! @param [inout] indices of the triangles of the full-detail mesh;
+	//!                the indices of the coarser levels get appended
+	//! @param [in] lods_nb maximum number of levels, including the
+	//!             full-detail one
+	//! @param [in] max_error largest distance allowed between a level
+	//!             and the full-detail mesh, relative to the radius of
+	//!             its bounding sphere
+	//! @return the levels, starting with the full-detail one, or nothing
+	//!         if no coarser level could be generated
+	std::vector<mesh_lod> generateLods(glm::vec3 const* vertices, std::uint32_t vertices_nb,
+	                                   std::vector<std::uint32_t>& indices,
+	                                   unsigned int lods_nb = 4u, float max_error = 0.25f);
+
+	//! \brief Generate the levels of detail of an imported mesh; see the
+	//!        overload above.
+	//!
+	//! Meshes which are not made of triangles are left untouched.
+	void generateLods(imported_mesh& mesh, unsigned int lods_nb = 4u, float max_error = 0.25f);
+
+	//! \brief Split a triangle list into clusters of neighbouring
+	//!        triangles, and compute their bounds and normal cones.
+	//!
+	//! Triangles are grouped in the order they appear in, so reordering
+	//! them beforehand (see `optimiseTriangleOrder()`) gives tighter
+	//! clusters. The defaults match the sizes favoured by mesh shading
+	//! hardware, which also keep CPU culling reasonably cheap.
+	//!
+	//! @param [in] vertices positions of the vertices
+	//! @param [in] indices of the triangles to split
+	//! @param [in] indices_nb number of indices
+	//! @param [in] max_vertices_nb largest number of distinct vertices per cluster
+	//! @param [in] max_triangles_nb largest number of triangles per cluster
+	//! @return the clusters, covering all triangles in order
+	std::vector<mesh_cluster> buildClusters(glm::vec3 const* vertices,
+	                                        std::uint32_t const* indices, std::size_t indices_nb,
+	                                        std::size_t max_vertices_nb = 64u,
+	                                        std::size_t max_triangles_nb = 124u);
+
+	//! \brief Split the most detailed level of an imported mesh into
+	//!        clusters; see the overload above.
+	//!
+	//! Meshes which are not made of triangles are left untouched.
+	void buildClusters(imported_mesh& mesh, std::size_t max_vertices_nb = 64u,
+	                   std::size_t max_triangles_nb = 124u);
+}
@@ -0,0 +1,275 @@
+#include "mipmap.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define BONOBO_MIPMAP_USE_SSE2 1
+#	include <emmintrin.h>
+#else
+#	define BONOBO_MIPMAP_USE_SSE2 0
+#endif
+
+namespace
+{
+	// All four channels of a texel are processed together, which maps
+	// directly onto a 128-bit register.
+#if BONOBO_MIPMAP_USE_SSE2
+	using float4 = __m128;
+	inline float4 load4(float const* source) { return _mm_loadu_ps(source); }
+	inline void store4(float* destination, float4 value) { _mm_storeu_ps(destination, value); }
+	inline float4 zero4() { return _mm_setzero_ps(); }
+	inline float4 add4(float4 a, float4 b) { return _mm_add_ps(a, b); }
+	inline float4 scale4(float4 a, float s) { return _mm_mul_ps(a, _mm_set1_ps(s)); }
+	inline float4 clamp4(float4 a) { return _mm_min_ps(_mm_max_ps(a, _mm_setzero_ps()), _mm_set1_ps(1.0f)); }
+#else
+	struct float4 {
+		float v[4];
+	};
+	inline float4 load4(float const* source) { return { { source[0], source[1], source[2], source[3] } }; }
+	inline void store4(float* destination, float4 value) { std::copy(value.v, value.v + 4, destination); }
+	inline float4 zero4() { return { { 0.0f, 0.0f, 0.0f, 0.0f } }; }
+	inline float4 add4(float4 a, float4 b) { return { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } }; }
+	inline float4 scale4(float4 a, float s) { return { { a.v[0] * s, a.v[1] * s, a.v[2] * s, a.v[3] * s } }; }
+	inline float4 clamp4(float4 a)
+	{
+		for (auto& value : a.v)
+			value = std::min(std::max(value, 0.0f), 1.0f);
+		return a;
+	}
+#endif
+
+	//! \brief Image with four floats per texel.
+	struct float_image {
+		std::uint32_t width{0u};
+		std::uint32_t height{0u};
+		std::vector<float> data;
+
+		float const* texel(std::uint32_t x, std::uint32_t y) const
+		{
+			return data.data() + 4u * (static_cast<std::size_t>(y) * width + x);
+		}
+		float* texel(std::uint32_t x, std::uint32_t y)
+		{
+			return data.data() + 4u * (static_cast<std::size_t>(y) * width + x);
+		}
+	};
+
+	float srgb_to_linear(float value)
+	{
+		return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	float linear_to_srgb(float value)
+	{
+		return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+	}
+
+	std::array<float, 256> const& get_srgb_to_linear_table()
+	{
+		static auto const table = []() {
+			std::array<float, 256> values;
+			for (std::size_t i = 0u; i < values.size(); ++i)
+				values[i] = srgb_to_linear(static_cast<float>(i) / 255.0f);
+			return values;
+		}();
+		return table;
+	}
+
+	//! \brief sRGB-encoded bytes for linear values sampled every 1/4095,
+	//!        which is fine enough to never be off by more than one.
+	std::array<std::uint8_t, 4096> const& get_linear_to_srgb_table()
+	{
+		static auto const table = []() {
+			std::array<std::uint8_t, 4096> values;
+			for (std::size_t i = 0u; i < values.size(); ++i)
+				values[i] = static_cast<std::uint8_t>(linear_to_srgb(static_cast<float>(i) / 4095.0f) * 255.0f + 0.5f);
+			return values;
+		}();
+		return table;
+	}
+
+	float_image to_float(std::uint8_t const* rgba, std::uint32_t width, std::uint32_t height, bool is_srgb)
+	{
+		auto const& srgb_to_linear_table = get_srgb_to_linear_table();
+
+		float_image image;
+		image.width = width;
+		image.height = height;
+		image.data.resize(static_cast<std::size_t>(width) * height * 4u);
+		for (std::size_t i = 0u; i < image.data.size(); ++i) {
+			auto const is_alpha = (i & 0x3u) == 3u;
+			image.data[i] = is_srgb && !is_alpha ? srgb_to_linear_table[rgba[i]] : static_cast<float>(rgba[i]) / 255.0f;
+		}
+		return image;
+	}
+
+	bonobo::image_level to_bytes(float_image const& image, bool is_srgb, float alpha_scale)
+	{
+		auto const& linear_to_srgb_table = get_linear_to_srgb_table();
+
+		bonobo::image_level level;
+		level.width = image.width;
+		level.height = image.height;
+		level.data.resize(image.data.size());
+		for (std::size_t i = 0u; i < image.data.size(); ++i) {
+			auto const is_alpha = (i & 0x3u) == 3u;
+			auto const value = std::min(std::max(is_alpha ? image.data[i] * alpha_scale : image.data[i], 0.0f), 1.0f);
+			level.data[i] = is_srgb && !is_alpha ? linear_to_srgb_table[static_cast<std::size_t>(value * 4095.0f + 0.5f)]
+			                                     : static_cast<std::uint8_t>(value * 255.0f + 0.5f);
+		}
+		return level;
+	}
+
+	float_image downsample_box(float_image const& source)
+	{
+		float_image destination;
+		destination.width = std::max(source.width / 2u, 1u);
+		destination.height = std::max(source.height / 2u, 1u);
+		destination.data.resize(static_cast<std::size_t>(destination.width) * destination.height * 4u);
+
+		// Odd sizes repeat the last row or column.
+		for (std::uint32_t y = 0u; y < destination.height; ++y) {
+			auto const y0 = std::min(2u * y, source.height - 1u), y1 = std::min(2u * y + 1u, source.height - 1u);
+			for (std::uint32_t x = 0u; x < destination.width; ++x) {
+				auto const x0 = std::min(2u * x, source.width - 1u), x1 = std::min(2u * x + 1u, source.width - 1u);
+				auto const sum = add4(add4(load4(source.texel(x0, y0)), load4(source.texel(x1, y0))),
+				                      add4(load4(source.texel(x0, y1)), load4(source.texel(x1, y1))));
+				store4(destination.texel(x, y), scale4(sum, 0.25f));
+			}
+		}
+		return destination;
+	}
+
+	//! \brief Zeroth order modified Bessel function of the first kind.
+	float bessel_i0(float x)
+	{
+		float sum = 1.0f, term = 1.0f;
+		for (int k = 1; k < 32; ++k) {
+			term *= (x / (2.0f * static_cast<float>(k))) * (x / (2.0f * static_cast<float>(k)));
+			sum += term;
+			if (term < sum * 1e-8f)
+				break;
+		}
+		return sum;
+	}
+
+	//! \brief Number of source texels contributing to a destination texel
+	//!        along each axis, for the Kaiser filter.
+	std::size_t const kaiser_taps_nb = 8u;
+
+	//! \brief Weights of the Kaiser-windowed sinc used to halve an
+	//!        image, for source texels 2x - 3 to 2x + 4 of destination
+	//!        texel x.
+	std::array<float, kaiser_taps_nb> const& get_kaiser_weights()
+	{
+		static auto const weights = []() {
+			float const alpha = 4.0f, half_width = 2.0f; // in destination texels
+			auto const pi = 3.14159265358979f;
+			std::array<float, kaiser_taps_nb> values;
+			float sum = 0.0f;
+			for (std::size_t k = 0u; k < kaiser_taps_nb; ++k) {
+				// Distance from the centre of the destination texel, in
+				// destination texels.
+				auto const distance = (static_cast<float>(k) - 3.5f) / 2.0f;
+				auto const sinc = distance == 0.0f ? 1.0f : std::sin(pi * distance) / (pi * distance);
+				auto const ratio = distance / half_width;
+				auto const window = bessel_i0(alpha * std::sqrt(std::max(1.0f - ratio * ratio, 0.0f))) / bessel_i0(alpha);
+				values[k] = sinc * window;
+				sum += values[k];
+			}
+			for (auto& value : values)
+				value /= sum;
+			return values;
+		}();
+		return weights;
+	}
+
+	//! \brief Halve the size of an image along one axis, or copy it if
+	//!        that axis is already a single texel wide.
+	float_image downsample_kaiser_axis(float_image const& source, bool is_horizontal)
+	{
+		auto const& weights = get_kaiser_weights();
+
+		float_image destination;
+		destination.width = is_horizontal ? std::max(source.width / 2u, 1u) : source.width;
+		destination.height = is_horizontal ? source.height : std::max(source.height / 2u, 1u);
+		auto const source_size = static_cast<std::int64_t>(is_horizontal ? source.width : source.height);
+		if (source_size == 1) {
+			destination.data = source.data;
+			return destination;
+		}
+		destination.data.resize(static_cast<std::size_t>(destination.width) * destination.height * 4u);
+
+		for (std::uint32_t y = 0u; y < destination.height; ++y) {
+			for (std::uint32_t x = 0u; x < destination.width; ++x) {
+				auto const position = static_cast<std::int64_t>(is_horizontal ? x : y);
+				auto sum = zero4();
+				for (std::size_t k = 0u; k < kaiser_taps_nb; ++k) {
+					auto const tap = std::min(std::max(2 * position - 3 + static_cast<std::int64_t>(k), std::int64_t(0)), source_size - 1);
+					auto const texel = is_horizontal ? source.texel(static_cast<std::uint32_t>(tap), y)
+					                                 : source.texel(x, static_cast<std::uint32_t>(tap));
+					sum = add4(sum, scale4(load4(texel), weights[k]));
+				}
+				// Negative lobes can overshoot.
+				store4(destination.texel(x, y), clamp4(sum));
+			}
+		}
+		return destination;
+	}
+
+	float compute_alpha_coverage(float_image const& image, float alpha_reference, float alpha_scale)
+	{
+		std::size_t covered_nb = 0u;
+		for (std::size_t i = 3u; i < image.data.size(); i += 4u)
+			if (image.data[i] * alpha_scale > alpha_reference)
+				++covered_nb;
+		return static_cast<float>(covered_nb) / static_cast<float>(image.data.size() / 4u);
+	}
+
+	//! \brief Find the scale to apply to the alpha of |image| so that its
+	//!        coverage matches |coverage|, following Castaño's "Computing
+	//!        Alpha Mipmaps" (2010).
+	float find_alpha_scale(float_image const& image, float alpha_reference, float coverage)
+	{
+		// Search for the threshold giving the desired coverage; coverage
+		// decreases as the threshold increases.
+		float lowest = 0.0f, highest = 1.0f, threshold = alpha_reference;
+		for (int iteration = 0; iteration < 16; ++iteration) {
+			if (compute_alpha_coverage(image, threshold, 1.0f) > coverage)
+				lowest = threshold;
+			else
+				highest = threshold;
+			threshold = (lowest + highest) / 2.0f;
+		}
+		return threshold > 0.0f ? alpha_reference / threshold : 1.0f;
+	}
+}
+
+std::vector<bonobo::image_level>
+bonobo::buildMipChain(std::uint8_t const* rgba, std::uint32_t width, std::uint32_t height, mipmap_options const& options)
+{
+	std::vector<image_level> levels;
+	if (rgba == nullptr || width == 0u || height == 0u)
+		return levels;
+
+	// Each level is computed from the unquantised one above it, so that
+	// rounding errors do not accumulate.
+	auto image = to_float(rgba, width, height, options.is_srgb);
+	auto const coverage = options.preserve_alpha_coverage ? compute_alpha_coverage(image, options.alpha_reference, 1.0f)
+	                                                      : 0.0f;
+	while (image.width > 1u || image.height > 1u) {
+		if (options.filter == mipmap_filter::kaiser)
+			image = downsample_kaiser_axis(downsample_kaiser_axis(image, true), false);
+		else
+			image = downsample_box(image);
+
+		auto const alpha_scale = options.preserve_alpha_coverage ? find_alpha_scale(image, options.alpha_reference, coverage)
+		                                                         : 1.0f;
+		levels.push_back(to_bytes(image, options.is_srgb, alpha_scale));
+	}
+
+	return levels;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace bonobo
+{
+	//! \brief Filter used to compute each level of a mip chain from the
+	//!        one above it.
+	enum class mipmap_filter : std::uint32_t {
+		box = 0u, //!< average of 2×2 texels, as done by most drivers
+		kaiser    //!< 8×8 Kaiser-windowed sinc, which keeps lower levels sharper
+	};
+
+	//! \brief Options controlling how `buildMipChain()` filters an image.
+	struct mipmap_options {
+		mipmap_filter filter{mipmap_filter::box};
+
+		//! Whether the colour channels are sRGB-encoded, in which case
+		//! they get averaged in linear space; alpha is always linear.
+		bool is_srgb{false};
+
+		//! Whether to scale the alpha of each level so that the same
+		//! proportion of texels passes an alpha test against
+		//! |alpha_reference| as in the full-resolution image; this keeps
+		//! alpha-tested foliage and fences from fading away in the
+		//! distance.
+		bool preserve_alpha_coverage{false};
+		float alpha_reference{0.5f};
+	};
+
+	//! \brief One level of a mip chain, four bytes per texel.
+	struct image_level {
+		std::uint32_t width{0u};
+		std::uint32_t height{0u};
+		std::vector<std::uint8_t> data;
+	};
+
+	//! \brief Compute the mip chain of an image on the CPU.
+	//!
+	//! Only the CPU is used, so this can be called from any thread.
+	//! Filtering is done in single precision on all four channels at
+	//! once, using SSE2 where available.
+	//!
+	//! @param [in] rgba texels of the image, four bytes each, row after row
+	//! @param [in] width of the image, in texels
+	//! @param [in] height of the image, in texels
+	//! @param [in] options controlling the filtering
+	//! @return the levels below the full-resolution one, down to a
+	//!         single texel; nothing if the image is already 1×1 or empty
+	std::vector<image_level> buildMipChain(std::uint8_t const* rgba, std::uint32_t width, std::uint32_t height,
+	                                       mipmap_options const& options = mipmap_options());
+}
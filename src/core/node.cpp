@@ -2,11 +2,14 @@
 #include "helpers.hpp"
 
 #include "core/Log.h"
+#include "core/gl_state.hpp"
 #include "core/opengl.hpp"
 
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <cstdint>
+
 void
 Node::render(glm::mat4 const& view_projection, glm::mat4 const& parent_transform) const
 {
@@ -22,62 +25,91 @@ Node::render(glm::mat4 const& view_projection, glm::mat4 const& world, GLuint pr
 
 	utils::opengl::debug::beginDebugGroup(_name);
 
-	glUseProgram(program);
-
-	auto const normal_model_to_world = glm::transpose(glm::inverse(world));
+	bonobo::state::useProgram(program);
 
 	set_uniforms(program);
 
-	glUniformMatrix4fv(glGetUniformLocation(program, "vertex_model_to_world"), 1, GL_FALSE, glm::value_ptr(world));
-	glUniformMatrix4fv(glGetUniformLocation(program, "normal_model_to_world"), 1, GL_FALSE, glm::value_ptr(normal_model_to_world));
-	glUniformMatrix4fv(glGetUniformLocation(program, "vertex_world_to_clip"), 1, GL_FALSE, glm::value_ptr(view_projection));
-
-	for (size_t i = 0u; i < _textures.size(); ++i) {
-		auto const& texture = _textures[i];
-		glActiveTexture(GL_TEXTURE0 + static_cast<GLenum>(i));
-		glBindTexture(std::get<2>(texture), std::get<1>(texture));
-		glUniform1i(glGetUniformLocation(program, std::get<0>(texture).c_str()), static_cast<GLint>(i));
+	auto& locations = utils::opengl::shader::get_uniform_locations(program);
 
-		std::string texture_presence_var_name = "has_" + std::get<0>(texture);
-		glUniform1i(glGetUniformLocation(program, texture_presence_var_name.c_str()), 1);
+	for (size_t i = 0u; i < _texture_bindings.size(); ++i) {
+		auto const& texture = _texture_bindings[i];
+		bonobo::state::bindTextureToUnit(static_cast<GLuint>(i), texture.target, texture.texture);
+		glUniform1i(locations.get(texture.sampler), static_cast<GLint>(i));
+		glUniform1i(locations.get(texture.presence), 1);
 	}
 
-	glUniform3fv(glGetUniformLocation(program, "diffuse_colour"), 1, glm::value_ptr(_constants.diffuse));
-	glUniform3fv(glGetUniformLocation(program, "specular_colour"), 1, glm::value_ptr(_constants.specular));
-	glUniform3fv(glGetUniformLocation(program, "ambient_colour"), 1, glm::value_ptr(_constants.ambient));
-	glUniform3fv(glGetUniformLocation(program, "emissive_colour"), 1, glm::value_ptr(_constants.emissive));
-	glUniform1f(glGetUniformLocation(program, "shininess_value"), _constants.shininess);
-	glUniform1f(glGetUniformLocation(program, "index_of_refraction_value"), _constants.indexOfRefraction);
-	glUniform1f(glGetUniformLocation(program, "opacity_value"), _constants.opacity);
-
-	glBindVertexArray(_vao);
-	if (_has_indices)
-		glDrawElements(_drawing_mode, _indices_nb, GL_UNSIGNED_INT, reinterpret_cast<GLvoid const*>(0x0));
-	else
-		glDrawArrays(_drawing_mode, 0, _vertices_nb);
-	glBindVertexArray(0u);
-
-	for (auto const& texture : _textures) {
-		glBindTexture(std::get<2>(texture), 0);
-		glUniform1i(glGetUniformLocation(program, std::get<0>(texture).c_str()), 0);
-
-		std::string texture_presence_var_name = "has_" + std::get<0>(texture);
-		glUniform1i(glGetUniformLocation(program, texture_presence_var_name.c_str()), 0);
-	}
+	bonobo::state::bindVertexArray(_vao);
+	bonobo::drawPacket(get_packet(view_projection, world, program), view_projection, locations);
 
-	glUseProgram(0u);
+	// The program, textures and vertex array are left bound, so that the
+	// next node using the same ones does not rebind them; the presence
+	// uniforms have to be reset though, for nodes of the same program
+	// without those textures.
+	for (auto const& texture : _texture_bindings)
+		glUniform1i(locations.get(texture.presence), 0);
 
 	utils::opengl::debug::endDebugGroup();
 }
 
+void
+Node::submit(bonobo::render_queue& queue, glm::mat4 const& view_projection,
+             glm::mat4 const& parent_transform, std::uint8_t pass) const
+{
+	if (_program == nullptr || *_program == 0u || _vao == 0u)
+		return;
+
+	auto const world = parent_transform * _transform.GetMatrix();
+	auto packet = get_packet(view_projection, world, *_program);
+	packet.set_uniforms = &_set_uniforms;
+	packet.has_shared_uniforms = _has_shared_uniforms;
+	packet.name = &_name;
+
+	auto const depth = (view_projection * world * glm::vec4(_bounding_sphere.centre, 1.0f)).w;
+	queue.submit(packet, view_projection, depth, pass);
+}
+
+bonobo::draw_packet
+Node::get_packet(glm::mat4 const& view_projection, glm::mat4 const& world, GLuint program) const
+{
+	bonobo::draw_packet packet;
+	packet.program = program;
+	packet.vao = _vao;
+	packet.drawing_mode = _drawing_mode;
+	packet.indices_type = _indices_type;
+	packet.has_indices = _ibo != 0u;
+	packet.world = world;
+	packet.constants = _constants;
+	packet.textures = _texture_bindings.data();
+	packet.textures_nb = _texture_bindings.size();
+	if (_ibo != 0u) {
+		packet.first_index = _first_index;
+		packet.count = _indices_nb;
+		if (!_lods.empty()) {
+			_lod = bonobo::selectLod(_lods, _bounding_sphere, view_projection, world, _lod);
+			packet.first_index += static_cast<GLsizei>(_lods[_lod].first_index);
+			packet.count = static_cast<GLsizei>(_lods[_lod].indices_nb);
+		}
+	} else {
+		packet.count = _vertices_nb;
+	}
+	packet.base_vertex = _base_vertex;
+	return packet;
+}
+
 void
 Node::set_geometry(bonobo::mesh_data const& shape)
 {
 	_vao = shape.vao;
 	_vertices_nb = static_cast<GLsizei>(shape.vertices_nb);
 	_indices_nb = static_cast<GLsizei>(shape.indices_nb);
+	_indices_type = shape.indices_type;
+	_first_index = shape.first_index;
+	_base_vertex = shape.base_vertex;
 	_drawing_mode = shape.drawing_mode;
-	_has_indices = shape.ibo != 0u;
+	_ibo = shape.ibo;
+	_bounding_sphere = shape.sphere;
+	_lods = shape.lods;
+	_lod = 0u;
 	_name = std::string("Render ") + shape.name;
 
 	if (!shape.bindings.empty()) {
@@ -106,6 +138,12 @@ Node::set_program(GLuint const* const program, std::function<void (GLuint)> cons
 	_set_uniforms = set_uniforms;
 }
 
+void
+Node::set_shared_uniforms(bool are_shared)
+{
+	_has_shared_uniforms = are_shared;
+}
+
 void
 Node::set_name(std::string const& name)
 {
@@ -122,6 +160,7 @@ void
 Node::set_indices_nb(size_t const& indices_nb)
 {
 	_indices_nb = static_cast<GLsizei>(indices_nb);
+	_lods.clear();
 }
 
 void
@@ -145,6 +184,56 @@ Node::add_texture(std::string const& name, GLuint tex_id, GLenum type)
 	}
 
 	_textures.emplace_back(name, tex_id, type);
+	bonobo::texture_binding binding;
+	binding.texture = tex_id;
+	binding.target = type;
+	binding.sampler = utils::opengl::shader::intern_uniform_name(name);
+	binding.presence = utils::opengl::shader::intern_uniform_name("has_" + name);
+	_texture_bindings.push_back(binding);
+}
+
+bonobo::mesh_data
+Node::get_geometry() const
+{
+	bonobo::mesh_data shape;
+	shape.vao = _vao;
+	shape.ibo = _ibo;
+	shape.vertices_nb = _vertices_nb;
+	shape.indices_nb = _indices_nb;
+	shape.indices_type = _indices_type;
+	shape.first_index = _first_index;
+	shape.base_vertex = _base_vertex;
+	shape.drawing_mode = _drawing_mode;
+	shape.sphere = _bounding_sphere;
+	shape.lods = _lods;
+	shape.material = _constants;
+	shape.name = get_name();
+	return shape;
+}
+
+bonobo::material_data const&
+Node::get_material_constants() const
+{
+	return _constants;
+}
+
+GLuint const*
+Node::get_program() const
+{
+	return _program;
+}
+
+std::string
+Node::get_name() const
+{
+	std::string const prefix = "Render ";
+	return _name.compare(0, prefix.size(), prefix) == 0 ? _name.substr(prefix.size()) : _name;
+}
+
+std::vector<std::tuple<std::string, GLuint, GLenum>> const&
+Node::get_textures() const
+{
+	return _textures;
 }
 
 void
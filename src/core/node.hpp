@@ -1,12 +1,14 @@
 #pragma once
 
 #include "helpers.hpp"
+#include "render_queue.hpp"
 #include "TRSTransform.h"
 
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 
+#include <cstdint>
 #include <functional>
 #include <string>
 #include <tuple>
@@ -18,6 +20,10 @@ class Node
 public:
 	//! \brief Render this node.
 	//!
+	//! If the geometry has levels of detail, the one to render is picked
+	//! based on how large the node appears through |view_projection|;
+	//! see `bonobo::selectLod()`.
+	//!
 	//! @param [in] view_projection Matrix transforming from world-space to clip-space
 	//! @param [in] parent_transform Matrix transforming from parent-space to
 	//!             world-space
@@ -41,6 +47,21 @@ public:
 	            GLuint program,
 	            std::function<void (GLuint)> const& set_uniforms = [](GLuint /*programID*/){}) const;
 
+	//! \brief Queue this node for rendering, rather than rendering it
+	//!        right away.
+	//!
+	//! The node, its program and its uniforms callback have to stay alive
+	//! until |queue| is flushed.
+	//!
+	//! @param [in] queue the queue to submit the draw to
+	//! @param [in] view_projection Matrix transforming from world-space to clip-space
+	//! @param [in] parent_transform Matrix transforming from parent-space to
+	//!             world-space
+	//! @param [in] pass which pass of |queue| the draw belongs to
+	void submit(bonobo::render_queue& queue, glm::mat4 const& view_projection,
+	            glm::mat4 const& parent_transform = glm::mat4(1.0f),
+	            std::uint8_t pass = 0u) const;
+
 	//! \brief Set the geometry of this node.
 	//!
 	//! It will overwrite any constants provided by an earlier call to
@@ -69,6 +90,8 @@ public:
 
 	//! \brief Set the number of indices to use.
 	//!
+	//! This disables the levels of detail of the geometry, if any.
+	//!
 	//! @param [in] indices_nb how many indices to use when rendering
 	void set_indices_nb(size_t const& indices_nb);
 
@@ -85,6 +108,16 @@ public:
 	void set_program(GLuint const* const program,
 	                 std::function<void (GLuint)> const& set_uniforms = [](GLuint /*programID*/){});
 
+	//! \brief Flag the uniforms set by this node as being the same as
+	//!        those of every other node flagged so, with the same program.
+	//!
+	//! A `render_queue` only calls the uniforms function of the first
+	//! draw of an instanced batch, so it only batches draws of nodes
+	//! flagged this way.
+	//!
+	//! @param [in] are_shared whether the uniforms are shared
+	void set_shared_uniforms(bool are_shared);
+
 	//! \brief Set the name of this node.
 	//!
 	//! This name will be used when pushing debug groups to scope OpenGL
@@ -105,6 +138,30 @@ public:
 	//!                  GL_TEXTURE_CUBE_MAP, etc.
 	void add_texture(std::string const& name, GLuint tex_id, GLenum type);
 
+	//! \brief Retrieve the geometry of this node, as given to
+	//!        `set_geometry()` and possibly changed by
+	//!        `set_indices_nb()`.
+	//!
+	//! Only the VAO references the buffers, so |bo| and |ibo| are left
+	//! to 0 (with |ibo| set to a non-zero value if the geometry is
+	//! indexed), as are the texture bindings, which are part of
+	//! `get_textures()` instead.
+	bonobo::mesh_data get_geometry() const;
+
+	//! \brief Return the material constants used during rendering.
+	bonobo::material_data const& get_material_constants() const;
+
+	//! \brief Return the program set with `set_program()`, or nullptr.
+	GLuint const* get_program() const;
+
+	//! \brief Return the name of this node, without the "Render " prefix
+	//!        added by `set_name()`.
+	std::string get_name() const;
+
+	//! \brief Return the textures added to this node, as sampler name,
+	//!        texture ID and type.
+	std::vector<std::tuple<std::string, GLuint, GLenum>> const& get_textures() const;
+
 	//! \brief Add a child to this node.
 	//!
 	//! @param [in] child pointer to the child to add; the pointer has to
@@ -131,19 +188,29 @@ public:
 	TRSTransformf& get_transform();
 
 private:
+	bonobo::draw_packet get_packet(glm::mat4 const& view_projection, glm::mat4 const& world, GLuint program) const;
+
 	// Geometry data
 	GLuint _vao{ 0u };
 	GLsizei _vertices_nb{ 0u };
 	GLsizei _indices_nb{ 0u };
+	GLenum _indices_type{ GL_UNSIGNED_INT };
+	GLsizei _first_index{ 0 };
+	GLint _base_vertex{ 0 };
 	GLenum _drawing_mode{ GL_TRIANGLES };
-	bool _has_indices{ false };
+	GLuint _ibo{ 0u }; // 0 when not indexed
+	bonobo::bounding_sphere _bounding_sphere;
+	std::vector<bonobo::mesh_lod> _lods;
+	mutable std::size_t _lod{ 0u }; // level of detail picked for the last rendering
 
 	// Program data
 	GLuint const* _program{ nullptr };
 	std::function<void (GLuint)> _set_uniforms;
+	bool _has_shared_uniforms{ false };
 
 	// Material data
 	std::vector<std::tuple<std::string, GLuint, GLenum>> _textures;
+	std::vector<bonobo::texture_binding> _texture_bindings; // same textures, with their sampler and "has_" uniforms
 	bonobo::material_data _constants;
 
 	// Transformation data
@@ -1,4 +1,5 @@
 #include "Log.h"
+#include "gl_state.hpp"
 #include "opengl.hpp"
 #include "various.hpp"
 
@@ -7,6 +8,7 @@
 #include <iostream>
 #include <memory>
 #include <sstream>
+#include <unordered_map>
 
 
 namespace utils
@@ -167,10 +169,19 @@ namespace shader
 bool
 source_and_build_shader(GLuint id, std::string const& source)
 {
-	assert(id > 0u && !source.empty());
+	return source_and_build_shader(id, source.data(), source.size());
+}
+
+bool
+source_and_build_shader(GLuint id, char const* source, std::size_t length)
+{
+	assert(id > 0u && source != nullptr && length > 0u);
 
-	GLchar const* char_source = source.c_str();
-	glShaderSource(id, 1, &char_source, NULL);
+	// The length is passed explicitly, so |source| does not need to be
+	// null-terminated and can point straight into a mapped file.
+	GLchar const* char_source = source;
+	GLint const char_length = static_cast<GLint>(length);
+	glShaderSource(id, 1, &char_source, &char_length);
 
 	glCompileShader(id);
 	GLint state = GLint(0);
@@ -203,10 +214,16 @@ source_and_build_shader(GLuint id, std::string const& source)
 
 GLuint
 generate_shader(GLenum type, std::string const& source)
+{
+	return generate_shader(type, source.data(), source.size());
+}
+
+GLuint
+generate_shader(GLenum type, char const* source, std::size_t length)
 {
 	GLuint id = glCreateShader(type);
 
-	auto const success = source_and_build_shader(id, source);
+	auto const success = source_and_build_shader(id, source, length);
 	if (success) {
 		return id;
 	} else {
@@ -215,10 +232,23 @@ generate_shader(GLenum type, std::string const& source)
 	}
 }
 
+GLuint
+generate_shader_from_file(GLenum type, std::string const& path)
+{
+	utils::mapped_file const file(path);
+	if (!file.is_open() || file.size() == 0u) {
+		LogError("Failed to open \"%s\"", path.c_str());
+		return 0u;
+	}
+
+	return generate_shader(type, reinterpret_cast<char const*>(file.data()), file.size());
+}
+
 bool
 link_program(GLuint id)
 {
 	glLinkProgram(id);
+	get_uniform_locations(id).clear();
 	GLint state = GLint(0);
 	glGetProgramiv(id, GL_LINK_STATUS, &state);
 	auto const wasLinkingSuccessful = state != GL_FALSE;
@@ -273,6 +303,116 @@ generate_program(std::vector<GLuint> const& shaders_id)
 	}
 }
 
+namespace
+{
+	GLint const unresolved_location = -2;
+
+	std::vector<std::string> uniform_names;
+	std::unordered_map<std::string, uniform_name> uniform_name_handles;
+	std::unordered_map<GLuint, uniform_locations> program_uniform_locations;
+}
+
+uniform_name
+intern_uniform_name(std::string const& name)
+{
+	auto const it = uniform_name_handles.find(name);
+	if (it != uniform_name_handles.end())
+		return it->second;
+
+	auto const handle = static_cast<uniform_name>(uniform_names.size());
+	uniform_names.push_back(name);
+	uniform_name_handles.emplace(name, handle);
+	return handle;
+}
+
+uniform_locations::uniform_locations(GLuint program) : _program(program)
+{
+}
+
+GLint
+uniform_locations::get(uniform_name name)
+{
+	if (name >= uniform_names.size())
+		return -1;
+	if (name >= _locations.size())
+		_locations.resize(uniform_names.size(), unresolved_location);
+
+	auto& location = _locations[name];
+	if (location == unresolved_location)
+		location = glGetUniformLocation(_program, uniform_names[name].c_str());
+	return location;
+}
+
+bool
+uniform_locations::bind_block(uniform_name name, GLuint binding, std::size_t size)
+{
+	if (name >= uniform_names.size())
+		return false;
+	if (name >= _block_bindings.size())
+		_block_bindings.resize(uniform_names.size(), unresolved_location);
+
+	auto& block_binding = _block_bindings[name];
+	if (block_binding == unresolved_location) {
+		block_binding = -1;
+		auto const index = glGetUniformBlockIndex(_program, uniform_names[name].c_str());
+		if (index == GL_INVALID_INDEX)
+			return false;
+
+		GLint data_size = 0;
+		glGetActiveUniformBlockiv(_program, index, GL_UNIFORM_BLOCK_DATA_SIZE, &data_size);
+		if (data_size < 0 || static_cast<std::size_t>(data_size) > size) {
+			LogError("Uniform block \"%s\" of program %u takes %d bytes, more than the %zu bytes bound to it; is it out of sync with its C++ counterpart?",
+			         uniform_names[name].c_str(), _program, data_size, size);
+			return false;
+		}
+
+		glUniformBlockBinding(_program, index, binding);
+		block_binding = static_cast<GLint>(binding);
+	} else if (block_binding >= 0 && block_binding != static_cast<GLint>(binding)) {
+		glUniformBlockBinding(_program, glGetUniformBlockIndex(_program, uniform_names[name].c_str()), binding);
+		block_binding = static_cast<GLint>(binding);
+	}
+	return block_binding >= 0;
+}
+
+GLint
+uniform_locations::get_attribute(uniform_name name)
+{
+	if (name >= uniform_names.size())
+		return -1;
+	if (name >= _attributes.size())
+		_attributes.resize(uniform_names.size(), unresolved_location);
+
+	auto& location = _attributes[name];
+	if (location == unresolved_location)
+		location = glGetAttribLocation(_program, uniform_names[name].c_str());
+	return location;
+}
+
+void
+uniform_locations::clear()
+{
+	_locations.clear();
+	_block_bindings.clear();
+	_attributes.clear();
+}
+
+uniform_locations&
+get_uniform_locations(GLuint program)
+{
+	auto const it = program_uniform_locations.find(program);
+	if (it != program_uniform_locations.end())
+		return it->second;
+
+	return program_uniform_locations.emplace(program, uniform_locations(program)).first->second;
+}
+
+void
+forget_uniform_locations(GLuint program)
+{
+	program_uniform_locations.erase(program);
+}
+
 } // end of namespace shader
 
 namespace fullscreen
@@ -290,7 +430,7 @@ init(std::string const& vs_path, std::string const& fs_path, size_t width, size_
 
 	glGenVertexArrays(1, &vao_id);
 	assert(vao_id != 0u);
-	glBindVertexArray(vao_id);
+	bonobo::state::bindVertexArray(vao_id);
 
 	glGenBuffers(1, &vbo_id);
 	assert(vbo_id != 0u);
@@ -305,8 +445,8 @@ init(std::string const& vs_path, std::string const& fs_path, size_t width, size_
 	};
 	glBufferData(GL_ARRAY_BUFFER, 4 * 2 * sizeof(GLfloat), vertices, GL_STATIC_DRAW);
 
-	auto const vs = shader::generate_shader(GL_VERTEX_SHADER,utils::slurp_file(vs_path));
-	auto const fs = shader::generate_shader(GL_FRAGMENT_SHADER,utils::slurp_file(fs_path));
+	auto const vs = shader::generate_shader_from_file(GL_VERTEX_SHADER, vs_path);
+	auto const fs = shader::generate_shader_from_file(GL_FRAGMENT_SHADER, fs_path);
 	program_id = shader::generate_program({ vs, fs });
 	glDeleteShader(vs);
 	glDeleteShader(fs);
@@ -316,12 +456,12 @@ init(std::string const& vs_path, std::string const& fs_path, size_t width, size_
 	glVertexAttribPointer(static_cast<GLuint>(location), 2, GL_FLOAT, GL_FALSE, 0, reinterpret_cast<GLvoid const*>(0x0));
 	glEnableVertexAttribArray(static_cast<GLuint>(location));
 
-	glUseProgram(program_id);
+	bonobo::state::useProgram(program_id);
 
-	glActiveTexture(GL_TEXTURE0);
+	bonobo::state::activeTexture(GL_TEXTURE0);
 	glGenTextures(1, &texture_id);
 	assert(texture_id != 0u);
-	glBindTexture(GL_TEXTURE_2D, texture_id);
+	bonobo::state::bindTexture(GL_TEXTURE_2D, texture_id);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, static_cast<GLsizei>(width), static_cast<GLsizei>(height), 0, GL_RGBA, GL_FLOAT, nullptr);
@@ -332,20 +472,17 @@ deinit()
 {
 	assert(vao_id != 0u && vbo_id != 0u && program_id != 0u && texture_id != 0u);
 
-	GLint param = 0;
-	glGetIntegerv(GL_TEXTURE_BINDING_2D, &param);
-	if (static_cast<GLuint>(param) == texture_id)
-		glBindTexture(GL_TEXTURE_2D, 0u);
-	glDeleteTextures(1, &texture_id);
+	bonobo::state::deleteTextures(1, &texture_id);
 	texture_id = 0u;
 
 	GLint const location = glGetAttribLocation(program_id, "vertex");
 	assert(location >= 0);
 	glDisableVertexAttribArray(static_cast<GLuint>(location));
 
+	GLint param = 0;
 	glGetIntegerv(GL_CURRENT_PROGRAM, &param);
 	if (static_cast<GLuint>(param) == program_id)
-		glUseProgram(0u);
+		bonobo::state::useProgram(0u);
 	glDeleteProgram(program_id);
 	program_id = 0u;
 
@@ -355,10 +492,7 @@ deinit()
 	glDeleteBuffers(1, &vbo_id);
 	vbo_id = 0u;
 
-	glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &param);
-	if (static_cast<GLuint>(param) == vao_id)
-		glBindVertexArray(0u);
-	glDeleteVertexArrays(1, &vao_id);
+	bonobo::state::deleteVertexArrays(1, &vao_id);
 	vao_id = 0u;
 }
 
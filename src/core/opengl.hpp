@@ -3,6 +3,8 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -67,11 +69,85 @@ namespace shader
 {
 
 bool source_and_build_shader(GLuint id, std::string const& source);
+bool source_and_build_shader(GLuint id, char const* source, std::size_t length);
 GLuint generate_shader(GLenum type, std::string const& source);
+GLuint generate_shader(GLenum type, char const* source, std::size_t length);
+
+//! \brief Compile the shader found at |path|, reading its source
+//!        directly from a mapping of the file.
+//!
+//! @param [in] type of the shader, e.g. GL_VERTEX_SHADER
+//! @param [in] path of the file containing the shader source
+//! @return the shader, or 0 if the file could not be read or the shader
+//!         failed to compile
+GLuint generate_shader_from_file(GLenum type, std::string const& path);
 bool link_program(GLuint id);
 void reload_program(GLuint id, std::vector<GLuint> const& ids, std::vector<std::string> const& sources);
 GLuint generate_program(std::vector<GLuint> const& shaders_id);
 
+//! \brief Handle to a uniform name, shared by all programs.
+using uniform_name = std::uint32_t;
+
+//! \brief Return the handle of |name|, registering it on first use.
+//!
+//! Handles are meant to be retrieved once, for example when a texture
+//! is added to a node, rather than for every draw; like the caches
+//! below, they must only be used from the thread owning the OpenGL
+//! context.
+//!
+//! \param [in] name the name of the uniform, as written in the shaders;
+//!            uniform blocks and vertex attributes are named the same way
+//! \return a handle to pass to `uniform_locations::get()`
+uniform_name intern_uniform_name(std::string const& name);
+
+//! \brief Locations of the uniforms of a program, each one looked up
+//!        from the driver the first time it is asked for.
+class uniform_locations
+{
+public:
+	explicit uniform_locations(GLuint program = 0u);
+
+	//! \brief Return the location of |name| in the program, or -1 if
+	//!        it is not an active uniform.
+	GLint get(uniform_name name);
+
+	//! \brief Assign |binding| to the uniform block |name| of the
+	//!        program, unless that was already done.
+	//!
+	//! Blocks larger than |size| are refused with an error, as they
+	//! would read past what gets bound to them; this catches copies of
+	//! a block in the shaders drifting from the C++ structure.
+	//!
+	//! \param [in] size number of bytes that will be bound to the block
+	//! \return whether |name| is an active uniform block which was bound
+	bool bind_block(uniform_name name, GLuint binding, std::size_t size);
+
+	//! \brief Return the location of the vertex attribute |name| in the
+	//!        program, or -1 if it is not an active attribute.
+	GLint get_attribute(uniform_name name);
+
+	//! \brief Forget all resolved locations and block bindings; called
+	//!        when the program is relinked.
+	void clear();
+
+private:
+	GLuint _program;
+	std::vector<GLint> _locations;      // indexed by uniform name
+	std::vector<GLint> _block_bindings; // indexed by uniform name; -1 if not a block
+	std::vector<GLint> _attributes;     // indexed by uniform name
+};
+
+//! \brief Return the location cache of |program|.
+//!
+//! The cache is emptied whenever `link_program()` (re)links |program|,
+//! which includes programs reloaded by `ShaderProgramManager`. The
+//! returned reference stays valid until `forget_uniform_locations()` is
+//! called for |program|.
+uniform_locations& get_uniform_locations(GLuint program);
+
+//! \brief Drop the location cache of |program|, before deleting it.
+void forget_uniform_locations(GLuint program);
+
 } // end of namespace shader
 
 namespace fullscreen
@@ -0,0 +1,455 @@
+#include "render_queue.hpp"
+
+#include "core/Log.h"
+#include "core/gl_state.hpp"
+#include "core/uniform_ring.hpp"
+
+#include <glm/gtc/type_ptr.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <tuple>
+
+namespace
+{
+	std::uint32_t const program_bits = 12u;
+	std::uint32_t const texture_set_bits = 16u;
+	std::uint32_t const vao_bits = 12u;
+	std::uint32_t const depth_bits = 20u;
+
+	//! \brief Give |id| the next number if not seen yet during the frame,
+	//!        saturating at what |bits| can hold.
+	std::uint32_t get_number(std::unordered_map<GLuint, std::uint32_t>& numbers, GLuint id, std::uint32_t bits)
+	{
+		auto const it = numbers.find(id);
+		if (it != numbers.end())
+			return it->second;
+
+		auto const number = std::min(static_cast<std::uint32_t>(numbers.size()), (1u << bits) - 1u);
+		numbers.emplace(id, number);
+		return number;
+	}
+
+	//! \brief Quantise |depth| so that larger depths get larger values.
+	//!
+	//! The bits of a positive IEEE 754 float sort like the float itself,
+	//! and keeping the most significant ones keeps the relative precision
+	//! constant over the whole range, without having to know the far
+	//! plane.
+	std::uint32_t quantise_depth(float depth)
+	{
+		if (!(depth > 0.0f))
+			return 0u;
+		std::uint32_t bits = 0u;
+		std::memcpy(&bits, &depth, sizeof(bits));
+		return bits >> (32u - depth_bits);
+	}
+
+	static_assert(sizeof(bonobo::draw_uniforms) == 256u, "bonobo::draw_uniforms has to match the std140 layout of DrawUniforms");
+
+	// Enough for 4096 draws per frame; past that, the next region gets
+	// used early.
+	std::size_t const uniform_ring_region_size = 4096u * sizeof(bonobo::draw_uniforms);
+	std::unique_ptr<bonobo::uniform_ring> shared_uniform_ring;
+
+	// The instance attributes of a full batch take 40% of a region.
+	std::size_t const max_instances_per_batch = 4096u;
+
+	bonobo::uniform_ring& get_uniform_ring()
+	{
+		if (shared_uniform_ring == nullptr)
+			shared_uniform_ring = std::unique_ptr<bonobo::uniform_ring>(new bonobo::uniform_ring(uniform_ring_region_size));
+		return *shared_uniform_ring;
+	}
+
+	//! \brief Uniforms set by every draw, as `Node::render()` always did.
+	struct node_uniforms {
+		utils::opengl::shader::uniform_name draw_uniforms;
+		utils::opengl::shader::uniform_name instance_model_to_world;
+		utils::opengl::shader::uniform_name instance_normal_model_to_world;
+		utils::opengl::shader::uniform_name vertex_model_to_world;
+		utils::opengl::shader::uniform_name normal_model_to_world;
+		utils::opengl::shader::uniform_name vertex_world_to_clip;
+		utils::opengl::shader::uniform_name diffuse_colour;
+		utils::opengl::shader::uniform_name specular_colour;
+		utils::opengl::shader::uniform_name ambient_colour;
+		utils::opengl::shader::uniform_name emissive_colour;
+		utils::opengl::shader::uniform_name shininess_value;
+		utils::opengl::shader::uniform_name index_of_refraction_value;
+		utils::opengl::shader::uniform_name opacity_value;
+	};
+
+	node_uniforms const& get_node_uniforms()
+	{
+		using utils::opengl::shader::intern_uniform_name;
+		static node_uniforms const uniforms = {
+			intern_uniform_name("DrawUniforms"),
+			intern_uniform_name("instance_model_to_world"),
+			intern_uniform_name("instance_normal_model_to_world"),
+			intern_uniform_name("vertex_model_to_world"),
+			intern_uniform_name("normal_model_to_world"),
+			intern_uniform_name("vertex_world_to_clip"),
+			intern_uniform_name("diffuse_colour"),
+			intern_uniform_name("specular_colour"),
+			intern_uniform_name("ambient_colour"),
+			intern_uniform_name("emissive_colour"),
+			intern_uniform_name("shininess_value"),
+			intern_uniform_name("index_of_refraction_value"),
+			intern_uniform_name("opacity_value")
+		};
+		return uniforms;
+	}
+
+	bonobo::instance_data make_instance(glm::mat4 const& world)
+	{
+		bonobo::instance_data instance;
+		instance.model_to_world = world;
+		instance.normal_model_to_world = glm::transpose(glm::inverse(glm::mat3(world)));
+		return instance;
+	}
+
+	//! \brief Set the transforms and material constants of |packet|,
+	//!        through the `DrawUniforms` block if the program has it.
+	void set_node_uniforms(bonobo::draw_packet const& packet, glm::mat4 const& normal_model_to_world,
+	                       glm::mat4 const& view_projection, utils::opengl::shader::uniform_locations& locations)
+	{
+		auto const& uniforms = get_node_uniforms();
+		if (locations.bind_block(uniforms.draw_uniforms, bonobo::draw_uniforms_binding, sizeof(bonobo::draw_uniforms))) {
+			bonobo::draw_uniforms block;
+			block.vertex_model_to_world = packet.world;
+			block.normal_model_to_world = normal_model_to_world;
+			block.vertex_world_to_clip = view_projection;
+			block.diffuse_colour = packet.constants.diffuse;
+			block.shininess_value = packet.constants.shininess;
+			block.specular_colour = packet.constants.specular;
+			block.index_of_refraction_value = packet.constants.indexOfRefraction;
+			block.ambient_colour = packet.constants.ambient;
+			block.opacity_value = packet.constants.opacity;
+			block.emissive_colour = packet.constants.emissive;
+			block.padding = 0.0f;
+			if (!get_uniform_ring().push(bonobo::draw_uniforms_binding, &block, sizeof(block)))
+				LogError("Failed to push the uniforms of a draw to the uniform ring.");
+			return;
+		}
+
+		glUniformMatrix4fv(locations.get(uniforms.vertex_model_to_world), 1, GL_FALSE, glm::value_ptr(packet.world));
+		glUniformMatrix4fv(locations.get(uniforms.normal_model_to_world), 1, GL_FALSE, glm::value_ptr(normal_model_to_world));
+		glUniformMatrix4fv(locations.get(uniforms.vertex_world_to_clip), 1, GL_FALSE, glm::value_ptr(view_projection));
+
+		glUniform3fv(locations.get(uniforms.diffuse_colour), 1, glm::value_ptr(packet.constants.diffuse));
+		glUniform3fv(locations.get(uniforms.specular_colour), 1, glm::value_ptr(packet.constants.specular));
+		glUniform3fv(locations.get(uniforms.ambient_colour), 1, glm::value_ptr(packet.constants.ambient));
+		glUniform3fv(locations.get(uniforms.emissive_colour), 1, glm::value_ptr(packet.constants.emissive));
+		glUniform1f(locations.get(uniforms.shininess_value), packet.constants.shininess);
+		glUniform1f(locations.get(uniforms.index_of_refraction_value), packet.constants.indexOfRefraction);
+		glUniform1f(locations.get(uniforms.opacity_value), packet.constants.opacity);
+	}
+
+	void issue_draw(bonobo::draw_packet const& packet, GLsizei instances_nb)
+	{
+		if (packet.has_indices) {
+			auto const index_size = packet.indices_type == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+			glDrawElementsInstancedBaseVertex(packet.drawing_mode, packet.count, packet.indices_type,
+			                                  reinterpret_cast<GLvoid const*>(static_cast<std::uintptr_t>(packet.first_index) * index_size),
+			                                  instances_nb, packet.base_vertex);
+		} else {
+			glDrawArraysInstanced(packet.drawing_mode, packet.base_vertex, packet.count, instances_nb);
+		}
+	}
+
+	//! \brief Draw |instances_nb| instances of |packet|, whose attributes
+	//!        are read from |instances|.
+	//!
+	//! |normal_location| is -1 when the program does not read the normal
+	//! matrices.
+	void draw_instances(bonobo::draw_packet const& packet, glm::mat4 const& view_projection,
+	                    utils::opengl::shader::uniform_locations& locations,
+	                    GLuint world_location, GLint normal_location,
+	                    bonobo::instance_data const* instances, std::size_t instances_nb)
+	{
+		set_node_uniforms(packet, glm::mat4(instances[0].normal_model_to_world), view_projection, locations);
+
+		// The arrays of the attributes are disabled outside of batches,
+		// so a lone instance is cheaper to hand over as generic values.
+		if (instances_nb == 1u) {
+			for (GLuint column = 0u; column < 4u; ++column)
+				glVertexAttrib4fv(world_location + column, glm::value_ptr(instances[0].model_to_world[column]));
+			if (normal_location >= 0)
+				for (GLuint column = 0u; column < 3u; ++column)
+					glVertexAttrib3fv(static_cast<GLuint>(normal_location) + column, glm::value_ptr(instances[0].normal_model_to_world[column]));
+			issue_draw(packet, 1);
+			return;
+		}
+
+		auto& ring = get_uniform_ring();
+		auto const offset = ring.write(instances, instances_nb * sizeof(bonobo::instance_data));
+		if (offset < 0) {
+			LogError("Failed to write %zu instances to the uniform ring.", instances_nb);
+			return;
+		}
+
+		// Without OpenGL 4.2 there is no base instance to offset the
+		// attributes with, so they get pointed at this batch directly;
+		// they are disabled afterwards, leaving the vertex array as the
+		// mesh set it up.
+		auto const enable = [offset](GLuint location, GLint size, std::size_t attribute_offset) {
+			glEnableVertexAttribArray(location);
+			glVertexAttribPointer(location, size, GL_FLOAT, GL_FALSE, sizeof(bonobo::instance_data),
+			                      reinterpret_cast<GLvoid const*>(offset + static_cast<GLintptr>(attribute_offset)));
+			glVertexAttribDivisor(location, 1u);
+		};
+		auto const disable = [](GLuint location) {
+			glVertexAttribDivisor(location, 0u);
+			glDisableVertexAttribArray(location);
+		};
+		auto const normal_columns_nb = normal_location >= 0 ? 3u : 0u;
+
+		glBindBuffer(GL_ARRAY_BUFFER, ring.get_buffer());
+		for (GLuint column = 0u; column < 4u; ++column)
+			enable(world_location + column, 4,
+			       offsetof(bonobo::instance_data, model_to_world) + column * sizeof(glm::vec4));
+		for (GLuint column = 0u; column < normal_columns_nb; ++column)
+			enable(static_cast<GLuint>(normal_location) + column, 3,
+			       offsetof(bonobo::instance_data, normal_model_to_world) + column * sizeof(glm::vec3));
+		glBindBuffer(GL_ARRAY_BUFFER, 0u);
+
+		issue_draw(packet, static_cast<GLsizei>(instances_nb));
+
+		for (GLuint column = 0u; column < 4u; ++column)
+			disable(world_location + column);
+		for (GLuint column = 0u; column < normal_columns_nb; ++column)
+			disable(static_cast<GLuint>(normal_location) + column);
+	}
+}
+
+bool
+bonobo::operator<(texture_binding const& lhs, texture_binding const& rhs)
+{
+	return std::tie(lhs.texture, lhs.target, lhs.sampler, lhs.presence)
+	     < std::tie(rhs.texture, rhs.target, rhs.sampler, rhs.presence);
+}
+
+void
+bonobo::render_queue::submit(draw_packet const& packet, glm::mat4 const& view_projection,
+                             float depth, std::uint8_t pass)
+{
+	if (packet.vao == 0u || packet.program == 0u)
+		return;
+
+	queued_packet queued;
+	queued.packet = packet;
+	if (_view_projections.empty() || _view_projections.back() != view_projection)
+		_view_projections.push_back(view_projection);
+	queued.view_projection = static_cast<std::uint32_t>(_view_projections.size() - 1u);
+	queued.texture_set = get_texture_set(packet.textures, packet.textures_nb);
+	queued.is_instanced = utils::opengl::shader::get_uniform_locations(packet.program)
+	                      .get_attribute(get_node_uniforms().instance_model_to_world) >= 0;
+
+	pass &= 0xFu;
+	auto quantised_depth = quantise_depth(depth);
+	if (_translucent_passes & (1u << pass))
+		quantised_depth = ~quantised_depth & ((1u << depth_bits) - 1u);
+	else if (queued.is_instanced)
+		quantised_depth = get_geometry(packet);
+
+	auto const key = (static_cast<std::uint64_t>(pass) << (64u - 4u))
+	               | (static_cast<std::uint64_t>(get_number(_programs, packet.program, program_bits)) << (texture_set_bits + vao_bits + depth_bits))
+	               | (static_cast<std::uint64_t>(std::min(queued.texture_set, (1u << texture_set_bits) - 1u)) << (vao_bits + depth_bits))
+	               | (static_cast<std::uint64_t>(get_number(_vaos, packet.vao, vao_bits)) << depth_bits)
+	               | static_cast<std::uint64_t>(quantised_depth);
+
+	_keys.emplace_back(key, static_cast<std::uint32_t>(_packets.size()));
+	_packets.push_back(queued);
+}
+
+void
+bonobo::render_queue::set_translucent_pass(std::uint8_t pass, bool is_translucent)
+{
+	auto const mask = static_cast<std::uint16_t>(1u << (pass & 0xFu));
+	_translucent_passes = is_translucent ? (_translucent_passes | mask) : (_translucent_passes & ~mask);
+}
+
+void
+bonobo::render_queue::flush()
+{
+	if (_packets.empty()) {
+		clear();
+		return;
+	}
+
+	// Ties keep the submission order, for draws relying on it.
+	std::stable_sort(_keys.begin(), _keys.end(),
+	                 [](std::pair<std::uint64_t, std::uint32_t> const& lhs, std::pair<std::uint64_t, std::uint32_t> const& rhs) {
+	                 	return lhs.first < rhs.first;
+	                 });
+
+	GLuint program = 0u;
+	GLuint vao = 0u;
+	std::uint32_t texture_set = ~0u;
+	utils::opengl::shader::uniform_locations* locations = nullptr;
+
+	auto const unbind_textures = [&]() {
+		if (texture_set == ~0u)
+			return;
+		for (auto const& texture : _texture_sets[texture_set])
+			glUniform1i(locations->get(texture.presence), 0);
+		texture_set = ~0u;
+	};
+
+	for (std::size_t i = 0u; i < _keys.size();) {
+		auto const& queued = _packets[_keys[i].second];
+		auto const& packet = queued.packet;
+
+		if (packet.name != nullptr)
+			utils::opengl::debug::beginDebugGroup(*packet.name);
+
+		if (packet.program != program) {
+			unbind_textures();
+			program = packet.program;
+			bonobo::state::useProgram(program);
+			locations = &utils::opengl::shader::get_uniform_locations(program);
+		}
+
+		if (packet.set_uniforms != nullptr && *packet.set_uniforms)
+			(*packet.set_uniforms)(program);
+
+		if (queued.texture_set != texture_set) {
+			unbind_textures();
+			texture_set = queued.texture_set;
+			auto const& textures = _texture_sets[texture_set];
+			for (std::size_t unit = 0u; unit < textures.size(); ++unit) {
+				bonobo::state::bindTextureToUnit(static_cast<GLuint>(unit), textures[unit].target, textures[unit].texture);
+				glUniform1i(locations->get(textures[unit].sampler), static_cast<GLint>(unit));
+				glUniform1i(locations->get(textures[unit].presence), 1);
+			}
+		}
+
+		if (packet.vao != vao) {
+			vao = packet.vao;
+			bonobo::state::bindVertexArray(vao);
+		}
+
+		auto const& view_projection = _view_projections[queued.view_projection];
+		if (queued.is_instanced) {
+			_instances.clear();
+			_instances.push_back(make_instance(packet.world));
+			for (++i; i < _keys.size() && _instances.size() < max_instances_per_batch; ++i) {
+				auto const& other = _packets[_keys[i].second];
+				if (!can_batch(queued, other))
+					break;
+				_instances.push_back(make_instance(other.packet.world));
+			}
+			auto const& uniforms = get_node_uniforms();
+			auto const world_location = locations->get_attribute(uniforms.instance_model_to_world);
+			auto const normal_location = locations->get_attribute(uniforms.instance_normal_model_to_world);
+			draw_instances(packet, view_projection, *locations, static_cast<GLuint>(world_location), normal_location,
+			               _instances.data(), _instances.size());
+		} else {
+			bonobo::drawPacket(packet, view_projection, *locations);
+			++i;
+		}
+
+		if (packet.name != nullptr)
+			utils::opengl::debug::endDebugGroup();
+	}
+
+	// As with `Node::render()`, bindings are left in place and only the
+	// `has_` uniforms get reset.
+	unbind_textures();
+
+	clear();
+}
+
+void
+bonobo::render_queue::clear()
+{
+	_packets.clear();
+	_keys.clear();
+	_view_projections.clear();
+	_programs.clear();
+	_vaos.clear();
+	_texture_set_ids.clear();
+	_texture_sets.clear();
+	_geometries.clear();
+}
+
+std::uint32_t
+bonobo::render_queue::get_texture_set(texture_binding const* textures, std::size_t textures_nb)
+{
+	_texture_set_scratch.assign(textures, textures + textures_nb);
+	auto const it = _texture_set_ids.find(_texture_set_scratch);
+	if (it != _texture_set_ids.end())
+		return it->second;
+
+	auto const id = static_cast<std::uint32_t>(_texture_sets.size());
+	_texture_sets.push_back(_texture_set_scratch);
+	_texture_set_ids.emplace(_texture_set_scratch, id);
+	return id;
+}
+
+std::uint32_t
+bonobo::render_queue::get_geometry(draw_packet const& packet)
+{
+	auto const geometry = std::make_tuple(packet.drawing_mode, packet.first_index, packet.count, packet.base_vertex);
+	auto const it = _geometries.find(geometry);
+	if (it != _geometries.end())
+		return it->second;
+
+	auto const number = std::min(static_cast<std::uint32_t>(_geometries.size()), (1u << depth_bits) - 1u);
+	_geometries.emplace(geometry, number);
+	return number;
+}
+
+bool
+bonobo::render_queue::can_batch(queued_packet const& first, queued_packet const& other)
+{
+	auto const& lhs = first.packet;
+	auto const& rhs = other.packet;
+	auto const has_uniforms = [](draw_packet const& packet) {
+		return packet.set_uniforms != nullptr && *packet.set_uniforms;
+	};
+	if ((has_uniforms(lhs) || has_uniforms(rhs)) && !(lhs.has_shared_uniforms && rhs.has_shared_uniforms))
+		return false;
+
+	return first.texture_set == other.texture_set
+	    && first.view_projection == other.view_projection
+	    && other.is_instanced
+	    && std::tie(lhs.program, lhs.vao, lhs.drawing_mode, lhs.indices_type, lhs.has_indices, lhs.count, lhs.first_index, lhs.base_vertex)
+	    == std::tie(rhs.program, rhs.vao, rhs.drawing_mode, rhs.indices_type, rhs.has_indices, rhs.count, rhs.first_index, rhs.base_vertex)
+	    && std::tie(lhs.constants.diffuse, lhs.constants.specular, lhs.constants.ambient, lhs.constants.emissive,
+	                lhs.constants.shininess, lhs.constants.indexOfRefraction, lhs.constants.opacity)
+	    == std::tie(rhs.constants.diffuse, rhs.constants.specular, rhs.constants.ambient, rhs.constants.emissive,
+	                rhs.constants.shininess, rhs.constants.indexOfRefraction, rhs.constants.opacity);
+}
+
+void
+bonobo::drawPacket(draw_packet const& packet, glm::mat4 const& view_projection,
+                   utils::opengl::shader::uniform_locations& locations)
+{
+	auto const& uniforms = get_node_uniforms();
+	auto const world_location = locations.get_attribute(uniforms.instance_model_to_world);
+	if (world_location >= 0) {
+		auto const instance = make_instance(packet.world);
+		draw_instances(packet, view_projection, locations, static_cast<GLuint>(world_location),
+		               locations.get_attribute(uniforms.instance_normal_model_to_world), &instance, 1u);
+		return;
+	}
+
+	set_node_uniforms(packet, glm::transpose(glm::inverse(packet.world)), view_projection, locations);
+	issue_draw(packet, 1);
+}
+
+void
+bonobo::beginDrawUniformsFrame()
+{
+	if (shared_uniform_ring != nullptr)
+		shared_uniform_ring->begin_frame();
+}
+
+void
+bonobo::releaseDrawUniforms()
+{
+	shared_uniform_ring.reset();
+}
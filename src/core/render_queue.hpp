@@ -0,0 +1,221 @@
+#pragma once
+
+#include "helpers.hpp"
+#include "opengl.hpp"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace bonobo
+{
+	//! \brief Texture bound for a draw, along with the uniforms telling
+	//!        the shaders which unit it is bound to and that it is there.
+	struct texture_binding {
+		GLuint texture{0u};
+		GLenum target{GL_TEXTURE_2D};
+		utils::opengl::shader::uniform_name sampler{0u};   //!< e.g. `diffuse_texture`
+		utils::opengl::shader::uniform_name presence{0u};  //!< e.g. `has_diffuse_texture`
+	};
+
+	bool operator<(texture_binding const& lhs, texture_binding const& rhs);
+
+	//! \brief Everything needed to issue one draw call, as submitted to a
+	//!        `render_queue`.
+	//!
+	//! The pointed-to data is not copied and has to stay alive until the
+	//! queue is flushed.
+	struct draw_packet {
+		GLuint program{0u};
+		GLuint vao{0u};
+		GLenum drawing_mode{GL_TRIANGLES};
+		GLenum indices_type{GL_UNSIGNED_INT};
+		bool has_indices{false};
+		GLsizei count{0};                 //!< number of indices, or of vertices if |has_indices| is false
+		GLsizei first_index{0};           //!< in indices, including the offset of the level of detail
+		GLint base_vertex{0};             //!< first vertex for non-indexed draws
+		glm::mat4 world{1.0f};
+		material_data constants{};
+		texture_binding const* textures{nullptr};
+		std::size_t textures_nb{0u};
+		std::function<void (GLuint)> const* set_uniforms{nullptr}; //!< called right before the draw, if not null
+		bool has_shared_uniforms{false};                           //!< whether |set_uniforms| sets the same values as that of any draw it could be batched with
+		std::string const* name{nullptr};                          //!< of the debug group wrapping the draw, if not null
+	};
+
+	//! \brief Per-instance attributes of the draws the render queue
+	//!        batches, laid out as they are stored in the instance
+	//!        buffer.
+	struct instance_data {
+		glm::mat4 model_to_world;        //!< read as `instance_model_to_world`
+		glm::mat3 normal_model_to_world; //!< read as `instance_normal_model_to_world`
+	};
+
+	//! \brief Per-draw transforms and material constants, laid out as the
+	//!        std140 `DrawUniforms` block which shaders can declare
+	//!        instead of the individual uniforms:
+	//!
+	//!     layout (std140) uniform DrawUniforms
+	//!     {
+	//!     	mat4 vertex_model_to_world;
+	//!     	mat4 normal_model_to_world;
+	//!     	mat4 vertex_world_to_clip;
+	//!     	vec3 diffuse_colour;
+	//!     	float shininess_value;
+	//!     	vec3 specular_colour;
+	//!     	float index_of_refraction_value;
+	//!     	vec3 ambient_colour;
+	//!     	float opacity_value;
+	//!     	vec3 emissive_colour;
+	//!     };
+	struct draw_uniforms {
+		glm::mat4 vertex_model_to_world;
+		glm::mat4 normal_model_to_world;
+		glm::mat4 vertex_world_to_clip;
+		glm::vec3 diffuse_colour;
+		float shininess_value;
+		glm::vec3 specular_colour;
+		float index_of_refraction_value;
+		glm::vec3 ambient_colour;
+		float opacity_value;
+		glm::vec3 emissive_colour;
+		float padding;
+	};
+
+	//! \brief Uniform buffer binding point the `DrawUniforms` block gets
+	//!        assigned to.
+	GLuint const draw_uniforms_binding = 8u;
+
+	//! \brief Start a new frame for the uniform ring `drawPacket()`
+	//!        writes the `DrawUniforms` blocks to; see `uniform_ring`.
+	//!
+	//! It is called by `WindowManager::NewImGuiFrame()`, which every
+	//! render loop goes through once per frame.
+	void beginDrawUniformsFrame();
+
+	//! \brief Release the uniform ring used by `drawPacket()`, before the
+	//!        OpenGL context goes away; called by `bonobo::deinit()`.
+	void releaseDrawUniforms();
+
+	//! \brief Set the transform and material uniforms of |packet|, then
+	//!        issue its draw call.
+	//!
+	//! If the program declares the `DrawUniforms` block, the uniforms
+	//! are written to a `uniform_ring` and bound by offset; otherwise
+	//! they are set one by one. If it declares the per-instance
+	//! `instance_model_to_world` attribute, the draw is issued as a
+	//! single instance of it, whose attributes are given as generic
+	//! values.
+	//!
+	//! The program, textures and vertex array of |packet| have to be
+	//! bound already.
+	//!
+	//! @param [in] packet the draw to issue
+	//! @param [in] view_projection matrix transforming from world-space to
+	//!             clip-space
+	//! @param [in] locations the uniform locations of the bound program
+	void drawPacket(draw_packet const& packet, glm::mat4 const& view_projection,
+	                utils::opengl::shader::uniform_locations& locations);
+
+	//! \brief Per-frame list of draws, sorted before being issued so that
+	//!        programs, textures and vertex arrays only get bound when
+	//!        they change.
+	//!
+	//! Draws are sorted on a 64-bit key; from the most significant bits
+	//! to the least significant ones:
+	//!
+	//! * 4 bits of pass, given at submission; lower passes come first;
+	//! * 12 bits of program;
+	//! * 16 bits of texture set;
+	//! * 12 bits of vertex array;
+	//! * 20 bits of view depth, front-to-back, or back-to-front for
+	//!   passes flagged as translucent.
+	//!
+	//! Programs, texture sets and vertex arrays are numbered in the order
+	//! they were first submitted during the frame; past what their bits
+	//! can hold, the remaining ones share the last number, which only
+	//! costs some extra state changes.
+	//!
+	//! Programs declaring the `instance_model_to_world` attribute, as a
+	//! `mat4` at `shader_bindings::instance_model_to_world`, get their
+	//! draws instanced: consecutive draws sharing the vertex array, the
+	//! range of vertices or indices, the textures, the material constants
+	//! and the view-projection matrix are issued as a single instanced
+	//! draw, their `instance_data` being packed in a `uniform_ring` and
+	//! read as per-instance attributes; the normal matrices can be read
+	//! as well, by declaring `instance_normal_model_to_world` as a `mat3`
+	//! at `shader_bindings::instance_normal_model_to_world`. For such
+	//! programs, the depth bits of passes not flagged as translucent
+	//! number the ranges of vertices or indices instead, so that
+	//! identical draws end up next to each other. Only the uniforms
+	//! callback of the first draw of a batch gets called, so draws with
+	//! a callback are only batched together if all of them are flagged
+	//! with `draw_packet::has_shared_uniforms`.
+	//!
+	//! The queue uses the same uniforms as `Node::render()`, and leaves
+	//! the `has_` uniforms of the programs to 0 once done, as the nodes
+	//! do; bindings are left in place, see `bonobo::state`.
+	class render_queue
+	{
+	public:
+		//! \brief Add a draw to the queue.
+		//!
+		//! @param [in] packet the draw to issue
+		//! @param [in] view_projection matrix transforming from world-space
+		//!             to clip-space
+		//! @param [in] depth distance to the camera used for sorting, for
+		//!             example the clip-space w of the centre of the
+		//!             bounding sphere
+		//! @param [in] pass which pass the draw belongs to, from 0 to 15
+		void submit(draw_packet const& packet, glm::mat4 const& view_projection,
+		            float depth, std::uint8_t pass = 0u);
+
+		//! \brief Sort the draws depth-wise from back to front, rather than
+		//!        from front to back, for the given pass.
+		void set_translucent_pass(std::uint8_t pass, bool is_translucent = true);
+
+		//! \brief Sort and issue all queued draws, then empty the queue.
+		void flush();
+
+		//! \brief Empty the queue without issuing anything.
+		void clear();
+
+		//! \brief Number of draws currently queued.
+		std::size_t size() const { return _packets.size(); }
+
+	private:
+		struct queued_packet {
+			draw_packet packet;
+			std::uint32_t view_projection{0u};
+			std::uint32_t texture_set{0u};
+			bool is_instanced{false};
+		};
+
+		std::uint32_t get_texture_set(texture_binding const* textures, std::size_t textures_nb);
+		std::uint32_t get_geometry(draw_packet const& packet);
+		static bool can_batch(queued_packet const& first, queued_packet const& other);
+
+		std::vector<queued_packet> _packets;
+		std::vector<std::pair<std::uint64_t, std::uint32_t>> _keys; //!< sort key and index in |_packets|
+		std::vector<glm::mat4> _view_projections;
+
+		std::unordered_map<GLuint, std::uint32_t> _programs;
+		std::unordered_map<GLuint, std::uint32_t> _vaos;
+		std::map<std::vector<texture_binding>, std::uint32_t> _texture_set_ids;
+		std::vector<std::vector<texture_binding>> _texture_sets;
+		std::vector<texture_binding> _texture_set_scratch;
+		std::map<std::tuple<GLenum, GLsizei, GLsizei, GLint>, std::uint32_t> _geometries; //!< by drawing mode, first index, count and base vertex
+		std::vector<instance_data> _instances;
+
+		std::uint16_t _translucent_passes{0u};
+	};
+}
@@ -0,0 +1,1065 @@
+#include "scene_snapshot.hpp"
+
+#include "core/Log.h"
+#include "core/ShaderProgramManager.hpp"
+#include "core/gl_state.hpp"
+#include "core/opengl.hpp"
+#include "core/various.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+
+// Layout of a snapshot archive; all values are stored in the native byte
+// order of the machine that wrote it:
+//
+// * header: magic, format version, alignment of the data blocks, offset
+//   of the first one, and the number of buffers, vertex arrays,
+//   textures, materials, meshes and nodes;
+// * buffers: size and offset of their content;
+// * vertex arrays: element buffer and enabled attributes, buffers being
+//   referenced by index;
+// * textures: target, formats, sampling parameters, and size and offset
+//   of every level of every face;
+// * materials, meshes and nodes, textures and vertex arrays being
+//   referenced by index;
+// * data blocks: the content of the buffers then of the texture levels,
+//   in the order they get uploaded, each starting on a page boundary so
+//   that it can be handed to OpenGL straight from the mapping.
+//
+// Strings are stored as a 32-bit length followed by their characters;
+// offsets are relative to the first data block.
+
+namespace
+{
+	char const snapshot_magic[8] = { 'B', 'N', 'B', 'O', 'S', 'N', 'A', 'P' };
+
+	//! \brief Version of the archive format; bump it whenever the layout
+	//!        changes.
+	std::uint32_t const snapshot_version = 1u;
+
+	std::size_t const page_size = 4096u;
+
+	std::uint32_t const no_index = ~0u;
+
+	std::uint64_t align_to_page(std::uint64_t offset)
+	{
+		return (offset + page_size - 1u) / page_size * page_size;
+	}
+
+	struct buffer_layout {
+		GLuint id{0u};
+		std::uint64_t size{0u};
+		std::uint64_t offset{0u};
+	};
+
+	struct attribute_layout {
+		std::uint32_t index{0u};
+		std::uint32_t buffer{no_index};
+		std::int32_t size{4};
+		std::uint32_t type{GL_FLOAT};
+		std::uint32_t is_normalized{0u};
+		std::uint32_t is_integer{0u};
+		std::int32_t stride{0};
+		std::uint64_t offset{0u};
+		std::uint32_t divisor{0u};
+	};
+
+	struct vertex_array_layout {
+		GLuint id{0u};
+		std::uint32_t element_buffer{no_index};
+		std::vector<attribute_layout> attributes;
+	};
+
+	struct texture_image {
+		std::uint32_t width{0u};
+		std::uint32_t height{0u};
+		std::uint64_t size{0u};
+		std::uint64_t offset{0u};
+	};
+
+	struct texture_layout {
+		GLuint id{0u};
+		std::uint32_t target{GL_TEXTURE_2D};
+		std::uint32_t internal_format{GL_RGBA8};
+		std::uint32_t is_compressed{0u};
+		std::uint32_t type{GL_UNSIGNED_BYTE}; // of the uncompressed texels, which are always RGBA
+		std::int32_t min_filter{GL_LINEAR};
+		std::int32_t mag_filter{GL_LINEAR};
+		std::int32_t wrap_s{GL_REPEAT};
+		std::int32_t wrap_t{GL_REPEAT};
+		std::int32_t wrap_r{GL_REPEAT};
+		std::uint32_t levels_nb{0u};
+		std::vector<texture_image> images; // all levels of the first face, then of the next one, etc.
+	};
+
+	std::uint32_t get_faces_nb(GLenum target)
+	{
+		return target == GL_TEXTURE_CUBE_MAP ? 6u : 1u;
+	}
+
+	GLenum get_face_target(GLenum target, std::uint32_t face)
+	{
+		return target == GL_TEXTURE_CUBE_MAP ? GL_TEXTURE_CUBE_MAP_POSITIVE_X + face : target;
+	}
+
+	std::uint64_t get_uncompressed_size(std::uint32_t width, std::uint32_t height, GLenum type)
+	{
+		return static_cast<std::uint64_t>(width) * height * 4u * (type == GL_FLOAT ? sizeof(GLfloat) : sizeof(GLubyte));
+	}
+
+	class snapshot_writer
+	{
+	public:
+		template<typename T>
+		void write(T const& value)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be written as is.");
+			write_bytes(&value, sizeof(T));
+		}
+
+		void write(std::string const& value)
+		{
+			write(static_cast<std::uint32_t>(value.size()));
+			write_bytes(value.data(), value.size());
+		}
+
+		void write(glm::vec3 const& value)
+		{
+			write(value.x);
+			write(value.y);
+			write(value.z);
+		}
+
+		void write(glm::mat3 const& value)
+		{
+			write(value[0]);
+			write(value[1]);
+			write(value[2]);
+		}
+
+		void write_bytes(void const* data, std::size_t size)
+		{
+			auto const bytes = static_cast<std::uint8_t const*>(data);
+			_buffer.insert(_buffer.end(), bytes, bytes + size);
+		}
+
+		template<typename T>
+		void patch(std::size_t offset, T const& value)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be written as is.");
+			std::memcpy(_buffer.data() + offset, &value, sizeof(T));
+		}
+
+		std::size_t size() const noexcept { return _buffer.size(); }
+		std::vector<std::uint8_t> const& buffer() const noexcept { return _buffer; }
+
+	private:
+		std::vector<std::uint8_t> _buffer;
+	};
+
+	//! \brief Bounds-checked reader over an archive; once a read went out
+	//!        of bounds, all subsequent reads fail.
+	class snapshot_reader
+	{
+	public:
+		snapshot_reader(std::uint8_t const* data, std::size_t size) : _data(data), _size(size)
+		{
+		}
+
+		template<typename T>
+		bool read(T& value)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be read as is.");
+			auto const bytes = read_bytes(sizeof(T));
+			if (bytes != nullptr)
+				std::memcpy(&value, bytes, sizeof(T));
+			return bytes != nullptr;
+		}
+
+		bool read(std::string& value)
+		{
+			std::uint32_t length = 0u;
+			if (!read(length))
+				return false;
+			auto const bytes = read_bytes(length);
+			if (bytes != nullptr)
+				value.assign(reinterpret_cast<char const*>(bytes), length);
+			return bytes != nullptr;
+		}
+
+		bool read(glm::vec3& value)
+		{
+			return read(value.x) && read(value.y) && read(value.z);
+		}
+
+		bool read(glm::mat3& value)
+		{
+			return read(value[0]) && read(value[1]) && read(value[2]);
+		}
+
+		//! \brief Read an element count, rejecting those which could not
+		//!        possibly fit in what is left of the archive.
+		bool read_count(std::uint32_t& count)
+		{
+			if (!read(count))
+				return false;
+			if (count > _size - _offset) {
+				_failed = true;
+				return false;
+			}
+			return true;
+		}
+
+		template<typename T>
+		bool read_array(std::vector<T>& values, std::uint32_t count)
+		{
+			static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable types can be read as is.");
+			if (_failed || count > (std::numeric_limits<std::size_t>::max)() / sizeof(T))
+				return false;
+			auto const bytes = read_bytes(count * sizeof(T));
+			if (bytes == nullptr)
+				return false;
+			values.resize(count);
+			if (count > 0u)
+				std::memcpy(values.data(), bytes, count * sizeof(T));
+			return true;
+		}
+
+		bool failed() const noexcept { return _failed; }
+
+	private:
+		std::uint8_t const* read_bytes(std::size_t size)
+		{
+			if (_failed || _offset > _size || size > _size - _offset) {
+				_failed = true;
+				return nullptr;
+			}
+			auto const bytes = _data + _offset;
+			_offset += size;
+			return bytes;
+		}
+
+		std::uint8_t const* _data;
+		std::size_t _size;
+		std::size_t _offset{0u};
+		bool _failed{false};
+	};
+
+	void write_constants(snapshot_writer& writer, bonobo::material_data const& constants)
+	{
+		writer.write(constants.diffuse);
+		writer.write(constants.specular);
+		writer.write(constants.ambient);
+		writer.write(constants.emissive);
+		writer.write(constants.shininess);
+		writer.write(constants.indexOfRefraction);
+		writer.write(constants.opacity);
+	}
+
+	bool read_constants(snapshot_reader& reader, bonobo::material_data& constants)
+	{
+		return reader.read(constants.diffuse)
+		    && reader.read(constants.specular)
+		    && reader.read(constants.ambient)
+		    && reader.read(constants.emissive)
+		    && reader.read(constants.shininess)
+		    && reader.read(constants.indexOfRefraction)
+		    && reader.read(constants.opacity);
+	}
+
+	//! \brief Textures, vertex arrays and buffers referenced by a scene,
+	//!        each of them given an index in the order they are found.
+	class snapshot_objects
+	{
+	public:
+		std::uint32_t add_texture(GLuint id, GLenum target)
+		{
+			auto const it = _texture_indices.find(id);
+			if (it != _texture_indices.end())
+				return it->second;
+
+			texture_layout texture;
+			if (!query_texture(id, target, texture)) {
+				_texture_indices.emplace(id, no_index);
+				return no_index;
+			}
+			auto const index = static_cast<std::uint32_t>(textures.size());
+			textures.push_back(std::move(texture));
+			_texture_indices.emplace(id, index);
+			return index;
+		}
+
+		std::uint32_t add_vertex_array(GLuint id)
+		{
+			if (id == 0u)
+				return no_index;
+			auto const it = _vertex_array_indices.find(id);
+			if (it != _vertex_array_indices.end())
+				return it->second;
+
+			auto const index = static_cast<std::uint32_t>(vertex_arrays.size());
+			vertex_arrays.push_back(query_vertex_array(id));
+			_vertex_array_indices.emplace(id, index);
+			return index;
+		}
+
+		std::vector<buffer_layout> buffers;
+		std::vector<vertex_array_layout> vertex_arrays;
+		std::vector<texture_layout> textures;
+
+	private:
+		std::uint32_t add_buffer(GLuint id)
+		{
+			if (id == 0u)
+				return no_index;
+			auto const it = _buffer_indices.find(id);
+			if (it != _buffer_indices.end())
+				return it->second;
+
+			buffer_layout buffer;
+			buffer.id = id;
+			GLint size = 0;
+			glBindBuffer(GL_COPY_READ_BUFFER, id);
+			glGetBufferParameteriv(GL_COPY_READ_BUFFER, GL_BUFFER_SIZE, &size);
+			glBindBuffer(GL_COPY_READ_BUFFER, 0u);
+			buffer.size = static_cast<std::uint64_t>(size > 0 ? size : 0);
+
+			auto const index = static_cast<std::uint32_t>(buffers.size());
+			buffers.push_back(buffer);
+			_buffer_indices.emplace(id, index);
+			return index;
+		}
+
+		vertex_array_layout query_vertex_array(GLuint id)
+		{
+			vertex_array_layout vertex_array;
+			vertex_array.id = id;
+			bonobo::state::bindVertexArray(id);
+
+			GLint element_buffer = 0;
+			glGetIntegerv(GL_ELEMENT_ARRAY_BUFFER_BINDING, &element_buffer);
+			vertex_array.element_buffer = add_buffer(static_cast<GLuint>(element_buffer));
+
+			GLint attributes_nb = 0;
+			glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &attributes_nb);
+			for (GLint i = 0; i < attributes_nb; ++i) {
+				auto const index = static_cast<GLuint>(i);
+				GLint is_enabled = GL_FALSE;
+				glGetVertexAttribiv(index, GL_VERTEX_ATTRIB_ARRAY_ENABLED, &is_enabled);
+				if (is_enabled == GL_FALSE)
+					continue;
+
+				attribute_layout attribute;
+				GLint buffer = 0, size = 0, type = 0, is_normalized = 0, is_integer = 0, stride = 0, divisor = 0;
+				glGetVertexAttribiv(index, GL_VERTEX_ATTRIB_ARRAY_BUFFER_BINDING, &buffer);
+				glGetVertexAttribiv(index, GL_VERTEX_ATTRIB_ARRAY_SIZE, &size);
+				glGetVertexAttribiv(index, GL_VERTEX_ATTRIB_ARRAY_TYPE, &type);
+				glGetVertexAttribiv(index, GL_VERTEX_ATTRIB_ARRAY_NORMALIZED, &is_normalized);
+				glGetVertexAttribiv(index, GL_VERTEX_ATTRIB_ARRAY_INTEGER, &is_integer);
+				glGetVertexAttribiv(index, GL_VERTEX_ATTRIB_ARRAY_STRIDE, &stride);
+				glGetVertexAttribiv(index, GL_VERTEX_ATTRIB_ARRAY_DIVISOR, &divisor);
+				GLvoid* offset = nullptr;
+				glGetVertexAttribPointerv(index, GL_VERTEX_ATTRIB_ARRAY_POINTER, &offset);
+
+				attribute.index = index;
+				attribute.buffer = add_buffer(static_cast<GLuint>(buffer));
+				attribute.size = size;
+				attribute.type = static_cast<std::uint32_t>(type);
+				attribute.is_normalized = is_normalized != GL_FALSE ? 1u : 0u;
+				attribute.is_integer = is_integer != GL_FALSE ? 1u : 0u;
+				attribute.stride = stride;
+				attribute.offset = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(offset));
+				attribute.divisor = static_cast<std::uint32_t>(divisor);
+				if (attribute.buffer != no_index)
+					vertex_array.attributes.push_back(attribute);
+			}
+
+			bonobo::state::bindVertexArray(0u);
+			return vertex_array;
+		}
+
+		bool query_texture(GLuint id, GLenum target, texture_layout& texture)
+		{
+			if (glIsTexture(id) == GL_FALSE || (target != GL_TEXTURE_2D && target != GL_TEXTURE_CUBE_MAP)) {
+				LogWarning("Texture %u is not a 2D nor a cube map texture; it will not be saved.", id);
+				return false;
+			}
+
+			texture.id = id;
+			texture.target = target;
+			bonobo::state::bindTexture(target, id);
+			glGetTexParameteriv(target, GL_TEXTURE_MIN_FILTER, &texture.min_filter);
+			glGetTexParameteriv(target, GL_TEXTURE_MAG_FILTER, &texture.mag_filter);
+			glGetTexParameteriv(target, GL_TEXTURE_WRAP_S, &texture.wrap_s);
+			glGetTexParameteriv(target, GL_TEXTURE_WRAP_T, &texture.wrap_t);
+			glGetTexParameteriv(target, GL_TEXTURE_WRAP_R, &texture.wrap_r);
+			GLint max_level = 0;
+			glGetTexParameteriv(target, GL_TEXTURE_MAX_LEVEL, &max_level);
+
+			auto const first_face = get_face_target(target, 0u);
+			GLint internal_format = 0, is_compressed = GL_FALSE, depth_type = GL_NONE, red_type = GL_NONE;
+			glGetTexLevelParameteriv(first_face, 0, GL_TEXTURE_INTERNAL_FORMAT, &internal_format);
+			glGetTexLevelParameteriv(first_face, 0, GL_TEXTURE_COMPRESSED, &is_compressed);
+			glGetTexLevelParameteriv(first_face, 0, GL_TEXTURE_DEPTH_TYPE, &depth_type);
+			glGetTexLevelParameteriv(first_face, 0, GL_TEXTURE_RED_TYPE, &red_type);
+			if (depth_type != GL_NONE) {
+				bonobo::state::bindTexture(target, 0u);
+				LogWarning("Texture %u is a depth texture; it will not be saved.", id);
+				return false;
+			}
+			texture.internal_format = static_cast<std::uint32_t>(internal_format);
+			texture.is_compressed = is_compressed != GL_FALSE ? 1u : 0u;
+			texture.type = red_type == GL_FLOAT ? GL_FLOAT : GL_UNSIGNED_BYTE;
+
+			// Levels are counted on the first face, as all faces of a cube
+			// map have the same ones.
+			for (GLint level = 0; level <= max_level && level < 32; ++level) {
+				GLint width = 0;
+				glGetTexLevelParameteriv(first_face, level, GL_TEXTURE_WIDTH, &width);
+				if (width <= 0)
+					break;
+				++texture.levels_nb;
+			}
+			for (std::uint32_t face = 0u; face < get_faces_nb(target); ++face)
+				for (std::uint32_t level = 0u; level < texture.levels_nb; ++level) {
+					auto const face_target = get_face_target(target, face);
+					GLint width = 0, height = 0, compressed_size = 0;
+					glGetTexLevelParameteriv(face_target, static_cast<GLint>(level), GL_TEXTURE_WIDTH, &width);
+					glGetTexLevelParameteriv(face_target, static_cast<GLint>(level), GL_TEXTURE_HEIGHT, &height);
+					texture_image image;
+					image.width = static_cast<std::uint32_t>(width > 0 ? width : 0);
+					image.height = static_cast<std::uint32_t>(height > 0 ? height : 0);
+					if (texture.is_compressed) {
+						glGetTexLevelParameteriv(face_target, static_cast<GLint>(level), GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &compressed_size);
+						image.size = static_cast<std::uint64_t>(compressed_size > 0 ? compressed_size : 0);
+					} else {
+						image.size = get_uncompressed_size(image.width, image.height, texture.type);
+					}
+					texture.images.push_back(image);
+				}
+			bonobo::state::bindTexture(target, 0u);
+
+			if (texture.levels_nb == 0u) {
+				LogWarning("Texture %u has no content; it will not be saved.", id);
+				return false;
+			}
+			return true;
+		}
+
+		std::unordered_map<GLuint, std::uint32_t> _buffer_indices;
+		std::unordered_map<GLuint, std::uint32_t> _vertex_array_indices;
+		std::unordered_map<GLuint, std::uint32_t> _texture_indices; // no_index for those which can not be saved
+	};
+
+	void write_bindings(snapshot_writer& writer, snapshot_objects& objects, bonobo::texture_bindings const& bindings)
+	{
+		std::vector<std::pair<std::string, std::uint32_t>> saved_bindings;
+		for (auto const& binding : bindings) {
+			auto const texture = objects.add_texture(binding.second, GL_TEXTURE_2D);
+			if (texture != no_index)
+				saved_bindings.emplace_back(binding.first, texture);
+		}
+		writer.write(static_cast<std::uint32_t>(saved_bindings.size()));
+		for (auto const& binding : saved_bindings) {
+			writer.write(binding.first);
+			writer.write(binding.second);
+		}
+	}
+
+	//! \brief Read bindings whose textures are given by index, to be
+	//!        turned into OpenGL names by `resolve_bindings()` once the
+	//!        textures exist.
+	bool read_bindings(snapshot_reader& reader, std::uint32_t textures_nb, bonobo::texture_bindings& bindings)
+	{
+		std::uint32_t bindings_nb = 0u;
+		if (!reader.read_count(bindings_nb))
+			return false;
+		for (std::uint32_t i = 0u; i < bindings_nb; ++i) {
+			std::string sampler_name;
+			std::uint32_t texture = no_index;
+			if (!reader.read(sampler_name) || !reader.read(texture) || texture >= textures_nb)
+				return false;
+			bindings.emplace(sampler_name, texture);
+		}
+		return true;
+	}
+
+	void resolve_bindings(std::vector<GLuint> const& textures, bonobo::texture_bindings& bindings)
+	{
+		for (auto& binding : bindings)
+			binding.second = textures[binding.second];
+	}
+
+	void add_node(bonobo::scene_snapshot& scene, Node const& node, std::uint32_t parent,
+	              ShaderProgramManager const& programs)
+	{
+		bonobo::snapshot_node description;
+		description.name = node.get_name();
+		description.parent = parent;
+		auto const& transform = node.get_transform();
+		description.translation = transform.GetTranslation();
+		description.rotation = transform.GetRotation();
+		description.scale = transform.GetScale();
+		description.constants = node.get_material_constants();
+
+		auto const geometry = node.get_geometry();
+		if (geometry.vao != 0u) {
+			for (std::size_t i = 0u; i < scene.meshes.size() && description.mesh == no_index; ++i) {
+				auto const& mesh = scene.meshes[i];
+				if (mesh.vao == geometry.vao && mesh.first_index == geometry.first_index
+				 && mesh.base_vertex == geometry.base_vertex && mesh.indices_nb == geometry.indices_nb
+				 && mesh.vertices_nb == geometry.vertices_nb && mesh.drawing_mode == geometry.drawing_mode
+				 && mesh.indices_type == geometry.indices_type && (mesh.ibo != 0u) == (geometry.ibo != 0u)
+				 && mesh.lods.size() == geometry.lods.size())
+					description.mesh = static_cast<std::uint32_t>(i);
+			}
+			if (description.mesh == no_index) {
+				description.mesh = static_cast<std::uint32_t>(scene.meshes.size());
+				scene.meshes.push_back(geometry);
+			}
+		}
+
+		if (node.get_program() != nullptr) {
+			auto const program_name = programs.GetProgramName(node.get_program());
+			if (program_name != nullptr)
+				description.program = program_name;
+			else
+				LogWarning("The program of node \"%s\" was not registered; it will be saved without one.",
+				           description.name.c_str());
+		}
+
+		for (auto const& texture : node.get_textures())
+			description.textures.push_back({ std::get<0>(texture), std::get<1>(texture), std::get<2>(texture) });
+
+		auto const index = static_cast<std::uint32_t>(scene.nodes.size());
+		scene.nodes.push_back(std::move(description));
+		for (std::size_t i = 0u; i < node.get_children_nb(); ++i)
+			add_node(scene, *node.get_child(i), index, programs);
+	}
+
+	bool write_padding(std::ofstream& stream, std::uint64_t& position)
+	{
+		static std::uint8_t const zeros[page_size] = {};
+		auto const padding = align_to_page(position) - position;
+		stream.write(reinterpret_cast<char const*>(zeros), static_cast<std::streamsize>(padding));
+		position += padding;
+		return stream.good();
+	}
+
+	bool write_block(std::ofstream& stream, std::uint64_t& position, std::vector<std::uint8_t> const& data)
+	{
+		if (!write_padding(stream, position))
+			return false;
+		stream.write(reinterpret_cast<char const*>(data.data()), static_cast<std::streamsize>(data.size()));
+		position += data.size();
+		return stream.good();
+	}
+}
+
+void
+bonobo::addSnapshotNodes(scene_snapshot& scene, Node const& root, ShaderProgramManager const& programs)
+{
+	add_node(scene, root, no_index, programs);
+}
+
+std::vector<Node>
+bonobo::createSnapshotNodes(scene_snapshot const& scene, ShaderProgramManager const& programs)
+{
+	std::vector<Node> nodes(scene.nodes.size());
+	for (std::size_t i = 0u; i < scene.nodes.size(); ++i) {
+		auto const& description = scene.nodes[i];
+		auto& node = nodes[i];
+		if (description.mesh < scene.meshes.size()) {
+			// The bindings of the node were saved separately.
+			auto geometry = scene.meshes[description.mesh];
+			geometry.bindings.clear();
+			node.set_geometry(geometry);
+		}
+		node.set_name(description.name);
+		node.set_material_constants(description.constants);
+		for (auto const& texture : description.textures)
+			node.add_texture(texture.sampler_name, texture.texture, texture.target);
+		if (!description.program.empty()) {
+			auto const program = programs.GetProgram(description.program);
+			if (program != nullptr)
+				node.set_program(program);
+			else
+				LogWarning("Program \"%s\" of node \"%s\" is not registered; the node is left without a program.",
+				           description.program.c_str(), description.name.c_str());
+		}
+		auto& transform = node.get_transform();
+		transform.SetTranslate(description.translation);
+		transform.SetRotate(description.rotation);
+		transform.SetScale(description.scale);
+		if (description.parent < i)
+			nodes[description.parent].add_child(&node);
+	}
+	return nodes;
+}
+
+bool
+bonobo::saveSceneSnapshot(std::string const& path, scene_snapshot const& scene)
+{
+	// Describe everything first, so that the data blocks can be laid out
+	// before reading them back one at a time.
+	snapshot_objects objects;
+	snapshot_writer materials_writer;
+	for (auto const& material : scene.materials) {
+		materials_writer.write(material.name);
+		write_constants(materials_writer, material.constants);
+		materials_writer.write(static_cast<std::uint32_t>(material.hint));
+		write_bindings(materials_writer, objects, material.bindings);
+	}
+
+	snapshot_writer meshes_writer;
+	for (auto const& mesh : scene.meshes) {
+		meshes_writer.write(mesh.name);
+		meshes_writer.write(objects.add_vertex_array(mesh.vao));
+		meshes_writer.write(static_cast<std::uint32_t>(mesh.ibo != 0u ? 1u : 0u));
+		meshes_writer.write(static_cast<std::int32_t>(mesh.vertices_nb));
+		meshes_writer.write(static_cast<std::int32_t>(mesh.indices_nb));
+		meshes_writer.write(static_cast<std::uint32_t>(mesh.indices_type));
+		meshes_writer.write(static_cast<std::int32_t>(mesh.first_index));
+		meshes_writer.write(static_cast<std::int32_t>(mesh.base_vertex));
+		meshes_writer.write(static_cast<std::uint32_t>(mesh.drawing_mode));
+		meshes_writer.write(mesh.material_index);
+		write_constants(meshes_writer, mesh.material);
+		meshes_writer.write(mesh.box.min_corner);
+		meshes_writer.write(mesh.box.max_corner);
+		meshes_writer.write(mesh.sphere.centre);
+		meshes_writer.write(mesh.sphere.radius);
+		meshes_writer.write(static_cast<std::uint32_t>(mesh.lods.size()));
+		if (!mesh.lods.empty())
+			meshes_writer.write_bytes(mesh.lods.data(), mesh.lods.size() * sizeof(mesh_lod));
+		meshes_writer.write(static_cast<std::uint32_t>(mesh.clusters.size()));
+		if (!mesh.clusters.empty())
+			meshes_writer.write_bytes(mesh.clusters.data(), mesh.clusters.size() * sizeof(mesh_cluster));
+		write_bindings(meshes_writer, objects, mesh.bindings);
+	}
+
+	snapshot_writer nodes_writer;
+	for (auto const& node : scene.nodes) {
+		nodes_writer.write(node.name);
+		nodes_writer.write(node.parent);
+		nodes_writer.write(node.translation);
+		nodes_writer.write(node.rotation);
+		nodes_writer.write(node.scale);
+		nodes_writer.write(node.mesh);
+		nodes_writer.write(node.program);
+		write_constants(nodes_writer, node.constants);
+		std::vector<std::pair<snapshot_texture const*, std::uint32_t>> textures;
+		for (auto const& texture : node.textures) {
+			auto const index = objects.add_texture(texture.texture, texture.target);
+			if (index != no_index)
+				textures.emplace_back(&texture, index);
+		}
+		nodes_writer.write(static_cast<std::uint32_t>(textures.size()));
+		for (auto const& texture : textures) {
+			nodes_writer.write(texture.first->sampler_name);
+			nodes_writer.write(texture.second);
+		}
+	}
+
+	// Lay the data blocks out, in upload order.
+	std::uint64_t blocks_size = 0u;
+	for (auto& buffer : objects.buffers) {
+		buffer.offset = align_to_page(blocks_size);
+		blocks_size = buffer.offset + buffer.size;
+	}
+	for (auto& texture : objects.textures)
+		for (auto& image : texture.images) {
+			image.offset = align_to_page(blocks_size);
+			blocks_size = image.offset + image.size;
+		}
+
+	snapshot_writer writer;
+	writer.write(snapshot_magic);
+	writer.write(snapshot_version);
+	writer.write(static_cast<std::uint32_t>(page_size));
+	auto const blocks_offset_position = writer.size();
+	writer.write(std::uint64_t(0u));
+	writer.write(static_cast<std::uint32_t>(objects.buffers.size()));
+	writer.write(static_cast<std::uint32_t>(objects.vertex_arrays.size()));
+	writer.write(static_cast<std::uint32_t>(objects.textures.size()));
+	writer.write(static_cast<std::uint32_t>(scene.materials.size()));
+	writer.write(static_cast<std::uint32_t>(scene.meshes.size()));
+	writer.write(static_cast<std::uint32_t>(scene.nodes.size()));
+	for (auto const& buffer : objects.buffers) {
+		writer.write(buffer.size);
+		writer.write(buffer.offset);
+	}
+	for (auto const& vertex_array : objects.vertex_arrays) {
+		writer.write(vertex_array.element_buffer);
+		writer.write(static_cast<std::uint32_t>(vertex_array.attributes.size()));
+		for (auto const& attribute : vertex_array.attributes)
+			writer.write(attribute);
+	}
+	for (auto const& texture : objects.textures) {
+		writer.write(texture.target);
+		writer.write(texture.internal_format);
+		writer.write(texture.is_compressed);
+		writer.write(texture.type);
+		writer.write(texture.min_filter);
+		writer.write(texture.mag_filter);
+		writer.write(texture.wrap_s);
+		writer.write(texture.wrap_t);
+		writer.write(texture.wrap_r);
+		writer.write(texture.levels_nb);
+		for (auto const& image : texture.images)
+			writer.write(image);
+	}
+	writer.write_bytes(materials_writer.buffer().data(), materials_writer.size());
+	writer.write_bytes(meshes_writer.buffer().data(), meshes_writer.size());
+	writer.write_bytes(nodes_writer.buffer().data(), nodes_writer.size());
+	auto const blocks_offset = align_to_page(writer.size());
+	writer.patch(blocks_offset_position, blocks_offset);
+
+	auto const temporary_path = path + ".tmp";
+	{
+		std::ofstream stream(utils::widen(temporary_path), std::ios::binary | std::ios::trunc);
+		if (!stream.is_open()) {
+			LogError("Failed to create scene snapshot \"%s\".", temporary_path.c_str());
+			return false;
+		}
+
+		auto const& description = writer.buffer();
+		stream.write(reinterpret_cast<char const*>(description.data()), static_cast<std::streamsize>(description.size()));
+		std::uint64_t description_size = description.size();
+		bool is_written = stream.good() && write_padding(stream, description_size);
+		std::uint64_t position = 0u; // relative to the first data block
+
+		// Read the blocks back one at a time, so that only one of them
+		// is held in memory.
+		std::vector<std::uint8_t> data;
+		for (auto const& buffer : objects.buffers) {
+			if (!is_written)
+				break;
+			data.resize(static_cast<std::size_t>(buffer.size));
+			glBindBuffer(GL_COPY_READ_BUFFER, buffer.id);
+			if (!data.empty())
+				glGetBufferSubData(GL_COPY_READ_BUFFER, 0, static_cast<GLsizeiptr>(data.size()), data.data());
+			glBindBuffer(GL_COPY_READ_BUFFER, 0u);
+			is_written = write_block(stream, position, data);
+		}
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0u);
+		for (auto const& texture : objects.textures) {
+			bonobo::state::bindTexture(texture.target, texture.id);
+			for (std::size_t i = 0u; i < texture.images.size() && is_written; ++i) {
+				auto const& image = texture.images[i];
+				auto const face_target = get_face_target(texture.target, static_cast<std::uint32_t>(i / texture.levels_nb));
+				auto const level = static_cast<GLint>(i % texture.levels_nb);
+				data.resize(static_cast<std::size_t>(image.size));
+				if (data.empty())
+					continue;
+				if (texture.is_compressed)
+					glGetCompressedTexImage(face_target, level, data.data());
+				else
+					glGetTexImage(face_target, level, GL_RGBA, texture.type, data.data());
+				is_written = write_block(stream, position, data);
+			}
+			bonobo::state::bindTexture(texture.target, 0u);
+		}
+
+		if (!is_written) {
+			LogError("Failed to write scene snapshot \"%s\".", temporary_path.c_str());
+			stream.close();
+			std::remove(temporary_path.c_str());
+			return false;
+		}
+	}
+
+	// rename() does not overwrite existing files on all platforms.
+	std::remove(path.c_str());
+	if (std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+		LogError("Failed to move scene snapshot \"%s\" into place.", path.c_str());
+		std::remove(temporary_path.c_str());
+		return false;
+	}
+
+	LogInfo("Scene snapshot \"%s\" written: %zu buffers, %zu textures, %zu meshes and %zu nodes, %.1f MiB of data.",
+	        path.c_str(), objects.buffers.size(), objects.textures.size(), scene.meshes.size(), scene.nodes.size(),
+	        static_cast<double>(blocks_size) / (1024.0 * 1024.0));
+	return true;
+}
+
+bool
+bonobo::loadSceneSnapshot(std::string const& path, scene_snapshot& scene)
+{
+	auto const start_time = std::chrono::high_resolution_clock::now();
+	scene = scene_snapshot();
+
+	utils::mapped_file const file(path);
+	if (!file.is_open()) {
+		LogError("Failed to open scene snapshot \"%s\".", path.c_str());
+		return false;
+	}
+	snapshot_reader reader(file.data(), file.size());
+
+	char magic[sizeof(snapshot_magic)];
+	std::uint32_t version = 0u, alignment = 0u;
+	std::uint64_t blocks_offset = 0u;
+	std::uint32_t buffers_nb = 0u, vertex_arrays_nb = 0u, textures_nb = 0u, materials_nb = 0u, meshes_nb = 0u, nodes_nb = 0u;
+	if (!reader.read(magic) || std::memcmp(magic, snapshot_magic, sizeof(snapshot_magic)) != 0) {
+		LogError("\"%s\" is not a scene snapshot.", path.c_str());
+		return false;
+	}
+	if (!reader.read(version) || version != snapshot_version) {
+		LogError("Scene snapshot \"%s\" uses format version %u instead of %u.", path.c_str(), version, snapshot_version);
+		return false;
+	}
+	if (!reader.read(alignment) || !reader.read(blocks_offset) || blocks_offset > file.size()
+	 || !reader.read_count(buffers_nb) || !reader.read_count(vertex_arrays_nb) || !reader.read_count(textures_nb)
+	 || !reader.read_count(materials_nb) || !reader.read_count(meshes_nb) || !reader.read_count(nodes_nb)) {
+		LogError("Scene snapshot \"%s\" is truncated.", path.c_str());
+		return false;
+	}
+	// Blocks are handed to OpenGL straight from the mapping, so they have
+	// to be laid out as this build expects.
+	if (alignment != page_size || blocks_offset % alignment != 0u) {
+		LogError("Scene snapshot \"%s\" aligns its data blocks to %u bytes instead of %zu.",
+		         path.c_str(), alignment, page_size);
+		return false;
+	}
+
+	// Data blocks have to lie within the file.
+	auto const blocks_size = file.size() - static_cast<std::size_t>(blocks_offset);
+	auto const is_in_file = [blocks_size](std::uint64_t offset, std::uint64_t size) {
+		return offset <= blocks_size && size <= blocks_size - offset;
+	};
+
+	std::vector<buffer_layout> buffers(buffers_nb);
+	for (auto& buffer : buffers)
+		if (!reader.read(buffer.size) || !reader.read(buffer.offset) || !is_in_file(buffer.offset, buffer.size)) {
+			LogError("Scene snapshot \"%s\" is corrupted.", path.c_str());
+			return false;
+		}
+
+	std::vector<vertex_array_layout> vertex_arrays(vertex_arrays_nb);
+	GLint max_attributes_nb = 0;
+	glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &max_attributes_nb);
+	for (auto& vertex_array : vertex_arrays) {
+		std::uint32_t attributes_nb = 0u;
+		bool is_valid = reader.read(vertex_array.element_buffer) && reader.read_count(attributes_nb)
+		             && reader.read_array(vertex_array.attributes, attributes_nb)
+		             && (vertex_array.element_buffer == no_index || vertex_array.element_buffer < buffers_nb);
+		for (auto const& attribute : vertex_array.attributes)
+			is_valid = is_valid && attribute.buffer < buffers_nb
+			                    && attribute.index < static_cast<std::uint32_t>(max_attributes_nb);
+		if (!is_valid) {
+			LogError("Scene snapshot \"%s\" is corrupted.", path.c_str());
+			return false;
+		}
+	}
+
+	std::vector<texture_layout> textures(textures_nb);
+	for (auto& texture : textures) {
+		bool is_valid = reader.read(texture.target) && reader.read(texture.internal_format)
+		             && reader.read(texture.is_compressed) && reader.read(texture.type)
+		             && reader.read(texture.min_filter) && reader.read(texture.mag_filter)
+		             && reader.read(texture.wrap_s) && reader.read(texture.wrap_t) && reader.read(texture.wrap_r)
+		             && reader.read(texture.levels_nb)
+		             && (texture.target == GL_TEXTURE_2D || texture.target == GL_TEXTURE_CUBE_MAP)
+		             && (texture.type == GL_UNSIGNED_BYTE || texture.type == GL_FLOAT)
+		             && texture.levels_nb > 0u && texture.levels_nb <= 32u
+		             && reader.read_array(texture.images, texture.levels_nb * get_faces_nb(texture.target));
+		for (auto const& image : texture.images)
+			is_valid = is_valid && is_in_file(image.offset, image.size)
+			                    && (texture.is_compressed || image.size == get_uncompressed_size(image.width, image.height, texture.type));
+		if (!is_valid) {
+			LogError("Scene snapshot \"%s\" is corrupted.", path.c_str());
+			return false;
+		}
+	}
+
+	auto const corrupted = [&path, &scene]() {
+		LogError("Scene snapshot \"%s\" is corrupted.", path.c_str());
+		scene = scene_snapshot();
+		return false;
+	};
+
+	scene.materials.resize(materials_nb);
+	for (auto& material : scene.materials) {
+		std::uint32_t hint = 0u;
+		if (!reader.read(material.name) || !read_constants(reader, material.constants) || !reader.read(hint)
+		 || hint > static_cast<std::uint32_t>(program_hint::translucent)
+		 || !read_bindings(reader, textures_nb, material.bindings))
+			return corrupted();
+		material.hint = static_cast<program_hint>(hint);
+	}
+
+	std::vector<std::uint32_t> mesh_vertex_arrays(meshes_nb, no_index);
+	std::vector<bool> mesh_has_indices(meshes_nb, false);
+	scene.meshes.resize(meshes_nb);
+	for (std::size_t i = 0u; i < scene.meshes.size(); ++i) {
+		auto& mesh = scene.meshes[i];
+		std::uint32_t vertex_array = no_index, has_indices = 0u, indices_type = 0u, drawing_mode = 0u;
+		std::uint32_t lods_nb = 0u, clusters_nb = 0u;
+		std::int32_t vertices_nb = 0, indices_nb = 0, first_index = 0, base_vertex = 0;
+		if (!reader.read(mesh.name) || !reader.read(vertex_array) || !reader.read(has_indices)
+		 || !reader.read(vertices_nb) || !reader.read(indices_nb) || !reader.read(indices_type)
+		 || !reader.read(first_index) || !reader.read(base_vertex) || !reader.read(drawing_mode)
+		 || !reader.read(mesh.material_index) || !read_constants(reader, mesh.material)
+		 || !reader.read(mesh.box.min_corner) || !reader.read(mesh.box.max_corner)
+		 || !reader.read(mesh.sphere.centre) || !reader.read(mesh.sphere.radius)
+		 || !reader.read_count(lods_nb) || !reader.read_array(mesh.lods, lods_nb)
+		 || !reader.read_count(clusters_nb) || !reader.read_array(mesh.clusters, clusters_nb)
+		 || !read_bindings(reader, textures_nb, mesh.bindings)
+		 || (vertex_array != no_index && vertex_array >= vertex_arrays_nb)
+		 || (mesh.material_index != no_index && mesh.material_index >= materials_nb))
+			return corrupted();
+		mesh_vertex_arrays[i] = vertex_array;
+		mesh_has_indices[i] = has_indices != 0u;
+		mesh.vertices_nb = vertices_nb;
+		mesh.indices_nb = indices_nb;
+		mesh.indices_type = static_cast<GLenum>(indices_type);
+		mesh.first_index = first_index;
+		mesh.base_vertex = base_vertex;
+		mesh.drawing_mode = static_cast<GLenum>(drawing_mode);
+	}
+
+	scene.nodes.resize(nodes_nb);
+	for (std::size_t i = 0u; i < scene.nodes.size(); ++i) {
+		auto& node = scene.nodes[i];
+		std::uint32_t textures_bound_nb = 0u;
+		bool is_valid = reader.read(node.name) && reader.read(node.parent) && reader.read(node.translation)
+		             && reader.read(node.rotation) && reader.read(node.scale) && reader.read(node.mesh)
+		             && reader.read(node.program) && read_constants(reader, node.constants)
+		             && reader.read_count(textures_bound_nb)
+		             && (node.parent == no_index || node.parent < i)
+		             && (node.mesh == no_index || node.mesh < meshes_nb);
+		for (std::uint32_t j = 0u; j < textures_bound_nb && is_valid; ++j) {
+			snapshot_texture texture;
+			std::uint32_t index = no_index;
+			is_valid = reader.read(texture.sampler_name) && reader.read(index) && index < textures_nb;
+			if (!is_valid)
+				break;
+			texture.texture = index;
+			texture.target = static_cast<GLenum>(textures[index].target);
+			node.textures.push_back(std::move(texture));
+		}
+		if (!is_valid)
+			return corrupted();
+	}
+
+	// Only create OpenGL objects once the whole description was checked,
+	// so that a corrupted archive leaves nothing behind; the materials,
+	// meshes and nodes refer to them by index until then.
+	auto const blocks = file.data() + blocks_offset;
+	auto const name = [&path](char const* kind, std::size_t index) {
+		return path + " " + kind + " " + std::to_string(index);
+	};
+
+	std::vector<GLuint> buffer_ids(buffers_nb, 0u);
+	if (!buffer_ids.empty())
+		glGenBuffers(static_cast<GLsizei>(buffer_ids.size()), buffer_ids.data());
+	for (std::size_t i = 0u; i < buffers.size(); ++i) {
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer_ids[i]);
+		glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(buffers[i].size),
+		             reinterpret_cast<GLvoid const*>(blocks + buffers[i].offset), GL_STATIC_DRAW);
+		utils::opengl::debug::nameObject(GL_BUFFER, buffer_ids[i], name("buffer", i));
+	}
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0u);
+
+	std::vector<GLuint> vertex_array_ids(vertex_arrays_nb, 0u);
+	std::vector<GLuint> vertex_buffer_ids(vertex_arrays_nb, 0u);
+	if (!vertex_array_ids.empty())
+		glGenVertexArrays(static_cast<GLsizei>(vertex_array_ids.size()), vertex_array_ids.data());
+	for (std::size_t i = 0u; i < vertex_arrays.size(); ++i) {
+		auto const& vertex_array = vertex_arrays[i];
+		bonobo::state::bindVertexArray(vertex_array_ids[i]);
+		if (vertex_array.element_buffer != no_index)
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer_ids[vertex_array.element_buffer]);
+		for (auto const& attribute : vertex_array.attributes) {
+			auto const offset = reinterpret_cast<GLvoid const*>(static_cast<std::uintptr_t>(attribute.offset));
+			glBindBuffer(GL_ARRAY_BUFFER, buffer_ids[attribute.buffer]);
+			if (attribute.is_integer)
+				glVertexAttribIPointer(attribute.index, attribute.size, attribute.type, attribute.stride, offset);
+			else
+				glVertexAttribPointer(attribute.index, attribute.size, attribute.type,
+				                      attribute.is_normalized ? GL_TRUE : GL_FALSE, attribute.stride, offset);
+			glVertexAttribDivisor(attribute.index, attribute.divisor);
+			glEnableVertexAttribArray(attribute.index);
+			if (attribute.index == static_cast<std::uint32_t>(shader_bindings::vertices))
+				vertex_buffer_ids[i] = buffer_ids[attribute.buffer];
+		}
+		bonobo::state::bindVertexArray(0u);
+		utils::opengl::debug::nameObject(GL_VERTEX_ARRAY, vertex_array_ids[i], name("vertex array", i));
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0u);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0u);
+
+	std::vector<GLuint> texture_ids(textures_nb, 0u);
+	if (!texture_ids.empty())
+		glGenTextures(static_cast<GLsizei>(texture_ids.size()), texture_ids.data());
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0u);
+	for (std::size_t i = 0u; i < textures.size(); ++i) {
+		auto const& texture = textures[i];
+		bonobo::state::bindTexture(texture.target, texture_ids[i]);
+		glTexParameteri(texture.target, GL_TEXTURE_MIN_FILTER, texture.min_filter);
+		glTexParameteri(texture.target, GL_TEXTURE_MAG_FILTER, texture.mag_filter);
+		glTexParameteri(texture.target, GL_TEXTURE_WRAP_S, texture.wrap_s);
+		glTexParameteri(texture.target, GL_TEXTURE_WRAP_T, texture.wrap_t);
+		glTexParameteri(texture.target, GL_TEXTURE_WRAP_R, texture.wrap_r);
+		glTexParameteri(texture.target, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(texture.levels_nb) - 1);
+		for (std::size_t j = 0u; j < texture.images.size(); ++j) {
+			auto const& image = texture.images[j];
+			auto const face_target = get_face_target(texture.target, static_cast<std::uint32_t>(j / texture.levels_nb));
+			auto const level = static_cast<GLint>(j % texture.levels_nb);
+			auto const data = reinterpret_cast<GLvoid const*>(blocks + image.offset);
+			if (texture.is_compressed)
+				glCompressedTexImage2D(face_target, level, texture.internal_format, static_cast<GLsizei>(image.width),
+				                       static_cast<GLsizei>(image.height), 0, static_cast<GLsizei>(image.size), data);
+			else
+				glTexImage2D(face_target, level, static_cast<GLint>(texture.internal_format),
+				             static_cast<GLsizei>(image.width), static_cast<GLsizei>(image.height), 0, GL_RGBA,
+				             texture.type, data);
+		}
+		bonobo::state::bindTexture(texture.target, 0u);
+		utils::opengl::debug::nameObject(GL_TEXTURE, texture_ids[i], name("texture", i));
+	}
+
+	for (auto& material : scene.materials)
+		resolve_bindings(texture_ids, material.bindings);
+	for (std::size_t i = 0u; i < scene.meshes.size(); ++i) {
+		auto& mesh = scene.meshes[i];
+		resolve_bindings(texture_ids, mesh.bindings);
+		auto const vertex_array = mesh_vertex_arrays[i];
+		if (vertex_array == no_index)
+			continue;
+		mesh.vao = vertex_array_ids[vertex_array];
+		mesh.bo = vertex_buffer_ids[vertex_array];
+		auto const element_buffer = vertex_arrays[vertex_array].element_buffer;
+		if (mesh_has_indices[i] && element_buffer != no_index)
+			mesh.ibo = buffer_ids[element_buffer];
+	}
+	for (auto& node : scene.nodes)
+		for (auto& texture : node.textures)
+			texture.texture = texture_ids[texture.texture];
+
+	scene.buffers = std::move(buffer_ids);
+	scene.vertex_arrays = std::move(vertex_array_ids);
+	scene.textures = std::move(texture_ids);
+
+	LogInfo("Scene snapshot \"%s\" loaded in %.3f ms: %zu buffers, %zu textures, %zu meshes and %zu nodes.",
+	        path.c_str(),
+	        std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - start_time).count(),
+	        buffers.size(), textures.size(), scene.meshes.size(), scene.nodes.size());
+	return true;
+}
+
+void
+bonobo::releaseSceneSnapshot(scene_snapshot& scene)
+{
+	if (!scene.vertex_arrays.empty())
+		bonobo::state::deleteVertexArrays(static_cast<GLsizei>(scene.vertex_arrays.size()), scene.vertex_arrays.data());
+	if (!scene.buffers.empty())
+		glDeleteBuffers(static_cast<GLsizei>(scene.buffers.size()), scene.buffers.data());
+	if (!scene.textures.empty())
+		bonobo::state::deleteTextures(static_cast<GLsizei>(scene.textures.size()), scene.textures.data());
+	scene = scene_snapshot();
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "core/helpers.hpp"
+#include "core/node.hpp"
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ShaderProgramManager;
+
+namespace bonobo
+{
+	//! \brief Texture bound to a node of a scene snapshot.
+	struct snapshot_texture {
+		std::string sampler_name;       //!< name of the GLSL sampler it is bound to
+		GLuint texture{0u};             //!< OpenGL name of the texture
+		GLenum target{GL_TEXTURE_2D};   //!< GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP
+	};
+
+	//! \brief Node of a scene snapshot, mirroring what a `Node` holds.
+	struct snapshot_node {
+		std::string name;
+		std::uint32_t parent{~0u};        //!< index of the parent in `scene_snapshot::nodes`, which comes first; ~0u for a root
+		glm::vec3 translation{0.0f};
+		glm::mat3 rotation{1.0f};
+		glm::vec3 scale{1.0f};
+		std::uint32_t mesh{~0u};          //!< index in `scene_snapshot::meshes`, or ~0u if the node has no geometry
+		std::string program;              //!< name the program was registered under in a `ShaderProgramManager`; empty if none
+		material_data constants{};
+		std::vector<snapshot_texture> textures;
+	};
+
+	//! \brief Content of a running scene which can be saved to, and
+	//!        restored from, a single archive; see `saveSceneSnapshot()`.
+	struct scene_snapshot {
+		std::vector<mesh_data> meshes;            //!< geometry, referenced by the nodes or drawn directly
+		std::vector<scene_material> materials;    //!< referenced by `mesh_data::material_index`
+		std::vector<snapshot_node> nodes;
+
+		// OpenGL objects created by `loadSceneSnapshot()`, which
+		// `releaseSceneSnapshot()` deletes; empty otherwise.
+		std::vector<GLuint> buffers;
+		std::vector<GLuint> vertex_arrays;
+		std::vector<GLuint> textures;
+	};
+
+	//! \brief Append |root| and all its descendants to |scene|, as well as
+	//!        their geometry when not already part of |scene|.
+	//!
+	//! The uniforms callbacks given to `Node::set_program()` can not be
+	//! saved; only the name of the program is, which is looked up in
+	//! |programs|.
+	//!
+	//! @param [in,out] scene the snapshot to add the nodes to
+	//! @param [in] root the node to add along with its descendants
+	//! @param [in] programs where the programs of the nodes were registered
+	void addSnapshotNodes(scene_snapshot& scene, Node const& root, ShaderProgramManager const& programs);
+
+	//! \brief Recreate the nodes of a snapshot, for example one read by
+	//!        `loadSceneSnapshot()`.
+	//!
+	//! Children are referenced by pointer, so the returned vector must
+	//! not be resized; moving it is fine.
+	//!
+	//! @param [in] scene the snapshot whose nodes to recreate
+	//! @param [in] programs where to look the programs up by name; nodes
+	//!             whose program is not found are left without one
+	//! @return the nodes, in the order of `scene_snapshot::nodes`
+	std::vector<Node> createSnapshotNodes(scene_snapshot const& scene, ShaderProgramManager const& programs);
+
+	//! \brief Write the meshes, materials, textures and nodes of |scene|
+	//!        to a single archive.
+	//!
+	//! Vertex and index buffers, vertex array layouts and all levels of
+	//! the textures are read back from OpenGL, so whatever was loaded,
+	//! generated or compressed at run time gets saved as is. Each buffer
+	//! and texture level starts on a page boundary, after all of the
+	//! small descriptions, and in the order `loadSceneSnapshot()` uploads
+	//! them. As for the caches, the archive is written to a temporary
+	//! file which is then renamed. Depth textures are not saved.
+	//!
+	//! @param [in] path where to write the archive
+	//! @param [in] scene the content to save
+	//! @return whether the archive could be written
+	bool saveSceneSnapshot(std::string const& path, scene_snapshot const& scene);
+
+	//! \brief Map an archive written by `saveSceneSnapshot()`, and create
+	//!        its buffers, vertex arrays and textures straight from the
+	//!        mapping.
+	//!
+	//! The whole description is checked before any OpenGL object gets
+	//! created, so nothing is left behind when the archive turns out to
+	//! be corrupted. The OpenGL names found in |scene| refer to the newly
+	//! created objects, which `releaseSceneSnapshot()` deletes.
+	//!
+	//! @param [in] path of the archive to load
+	//! @param [out] scene filled in with the content of the archive
+	//! @return whether the archive could be read
+	bool loadSceneSnapshot(std::string const& path, scene_snapshot& scene);
+
+	//! \brief Delete the OpenGL objects created when loading |scene|,
+	//!        and empty it.
+	//!
+	//! Nodes created from |scene| with `createSnapshotNodes()` must not
+	//! be rendered afterwards.
+	//!
+	//! @param [in,out] scene a snapshot filled in by `loadSceneSnapshot()`
+	void releaseSceneSnapshot(scene_snapshot& scene);
+}
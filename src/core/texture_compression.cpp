@@ -0,0 +1,691 @@
+#include "texture_compression.hpp"
+
+#include "core/Log.h"
+#include "core/various.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+// Caches are KTX2 files (see the Khronos KTX 2.0 specification) holding a
+// single 2D image, without supercompression; all values are stored in
+// the native byte order of the machine that wrote them, which is the
+// little-endian one required by the format on all supported platforms.
+// The image they were created from is recorded in a "bonobo.source"
+// key/value entry.
+
+namespace
+{
+	std::uint8_t const ktx2_identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	//! \brief Version of the encoder; bump it whenever its output
+	//!        changes, so that existing caches get rebuilt.
+	std::uint32_t const encoder_version = 2u;
+
+	char const source_key[] = "bonobo.source";
+
+	//! \brief Value of the "bonobo.source" entry of a cache.
+	struct cache_source {
+		std::uint32_t encoder_version{0u};
+		std::uint32_t flip{0u};
+		std::uint32_t mipmap{0u}; //!< see `encode_mipmap_options()`
+		utils::file_status status;
+		std::uint64_t hash{0u};
+	};
+
+	//! \brief Pack the options used to build the mip chain of a cache,
+	//!        so that changing them invalidates it.
+	std::uint32_t encode_mipmap_options(bonobo::mipmap_options const& options)
+	{
+		auto const reference = std::min(std::max(options.alpha_reference, 0.0f), 1.0f);
+		return static_cast<std::uint32_t>(options.filter)
+		     | (options.is_srgb ? 0x100u : 0u)
+		     | (options.preserve_alpha_coverage ? 0x200u : 0u)
+		     | (options.preserve_alpha_coverage ? static_cast<std::uint32_t>(reference * 255.0f + 0.5f) << 16u : 0u);
+	}
+
+	//! \brief Size of the fixed part of a KTX2 file: identifier, header,
+	//!        and index.
+	std::size_t const ktx2_header_size = sizeof(ktx2_identifier) + 9u * sizeof(std::uint32_t)
+	                                   + 4u * sizeof(std::uint32_t) + 2u * sizeof(std::uint64_t);
+
+	// Values from the Vulkan and Khronos Data Format specifications.
+	std::uint32_t get_vk_format(bonobo::block_format format)
+	{
+		switch (format) {
+			case bonobo::block_format::bc1: return 131u; // VK_FORMAT_BC1_RGB_UNORM_BLOCK
+			case bonobo::block_format::bc3: return 137u; // VK_FORMAT_BC3_UNORM_BLOCK
+			case bonobo::block_format::bc5: return 141u; // VK_FORMAT_BC5_UNORM_BLOCK
+		}
+		return 0u;
+	}
+
+	//! \brief Basic data format descriptor of a format: one 64-bit sample
+	//!        per independently encoded part of a block.
+	std::vector<std::uint32_t> get_data_format_descriptor(bonobo::block_format format)
+	{
+		std::uint32_t const khr_df_model_bc1a = 128u, khr_df_model_bc3 = 130u, khr_df_model_bc5 = 132u;
+		std::uint32_t const khr_df_primaries_bt709 = 1u, khr_df_transfer_linear = 1u;
+
+		std::uint32_t model = khr_df_model_bc1a;
+		std::vector<std::uint32_t> channels = { 0u }; // colour
+		switch (format) {
+			case bonobo::block_format::bc1:
+				break;
+			case bonobo::block_format::bc3:
+				model = khr_df_model_bc3;
+				channels = { 15u, 0u }; // alpha, then colour
+				break;
+			case bonobo::block_format::bc5:
+				model = khr_df_model_bc5;
+				channels = { 0u, 1u }; // red, then green
+				break;
+		}
+
+		auto const block_size = static_cast<std::uint32_t>(bonobo::getBlockSize(format));
+		auto const descriptor_size = 24u + 16u * static_cast<std::uint32_t>(channels.size());
+		std::vector<std::uint32_t> words = {
+			4u + descriptor_size,                                       // dfdTotalSize
+			0u,                                                         // vendorId and descriptorType
+			2u | (descriptor_size << 16),                               // versionNumber and descriptorBlockSize
+			model | (khr_df_primaries_bt709 << 8) | (khr_df_transfer_linear << 16),
+			3u | (3u << 8),                                             // 4×4×1×1 texels per block
+			block_size,                                                 // bytesPlane0 to 3
+			0u                                                          // bytesPlane4 to 7
+		};
+		for (std::size_t i = 0u; i < channels.size(); ++i) {
+			words.push_back(static_cast<std::uint32_t>(i * 64u) | (63u << 16) | (channels[i] << 24));
+			words.push_back(0u);          // sample position
+			words.push_back(0u);          // lower
+			words.push_back(0xFFFFFFFFu); // upper
+		}
+		return words;
+	}
+
+	std::size_t align_up(std::size_t value, std::size_t alignment)
+	{
+		return (value + alignment - 1u) / alignment * alignment;
+	}
+
+	bool hash_file(std::string const& path, std::uint64_t& hash)
+	{
+		utils::mapped_file const file(path);
+		if (!file.is_open())
+			return false;
+		hash = utils::hash_bytes(file.data(), file.size());
+		return true;
+	}
+
+	//
+	// Encoding
+	//
+
+	struct colour {
+		float r, g, b;
+	};
+
+	std::uint16_t quantise_565(colour const& c)
+	{
+		auto const quantise = [](float value, float max) {
+			return static_cast<std::uint16_t>(std::min(std::max(value * max / 255.0f + 0.5f, 0.0f), max));
+		};
+		return static_cast<std::uint16_t>((quantise(c.r, 31.0f) << 11) | (quantise(c.g, 63.0f) << 5) | quantise(c.b, 31.0f));
+	}
+
+	colour expand_565(std::uint16_t value)
+	{
+		auto const r = (value >> 11) & 0x1Fu, g = (value >> 5) & 0x3Fu, b = value & 0x1Fu;
+		return { static_cast<float>((r << 3) | (r >> 2)),
+		         static_cast<float>((g << 2) | (g >> 4)),
+		         static_cast<float>((b << 3) | (b >> 2)) };
+	}
+
+	float distance_squared(colour const& a, colour const& b)
+	{
+		return (a.r - b.r) * (a.r - b.r) + (a.g - b.g) * (a.g - b.g) + (a.b - b.b) * (a.b - b.b);
+	}
+
+	//! \brief Pick the closest palette entry for each texel, using the
+	//!        four-colour mode; return the total squared error.
+	float select_colour_indices(colour const (&texels)[16], std::uint16_t c0, std::uint16_t c1,
+	                            std::uint32_t& indices)
+	{
+		auto const e0 = expand_565(c0), e1 = expand_565(c1);
+		colour const palette[4] = {
+			e0, e1,
+			{ (2.0f * e0.r + e1.r) / 3.0f, (2.0f * e0.g + e1.g) / 3.0f, (2.0f * e0.b + e1.b) / 3.0f },
+			{ (e0.r + 2.0f * e1.r) / 3.0f, (e0.g + 2.0f * e1.g) / 3.0f, (e0.b + 2.0f * e1.b) / 3.0f }
+		};
+
+		indices = 0u;
+		float error = 0.0f;
+		for (std::uint32_t i = 0u; i < 16u; ++i) {
+			std::uint32_t best = 0u;
+			float best_distance = distance_squared(texels[i], palette[0]);
+			for (std::uint32_t k = 1u; k < 4u; ++k) {
+				auto const distance = distance_squared(texels[i], palette[k]);
+				if (distance < best_distance) {
+					best = k;
+					best_distance = distance;
+				}
+			}
+			indices |= best << (2u * i);
+			error += best_distance;
+		}
+		return error;
+	}
+
+	//! \brief Least squares endpoints for the given index assignment.
+	bool refine_endpoints(colour const (&texels)[16], std::uint32_t indices, colour& a, colour& b)
+	{
+		float const weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+		float alpha2 = 0.0f, beta2 = 0.0f, alphabeta = 0.0f;
+		colour alphax = { 0.0f, 0.0f, 0.0f }, betax = { 0.0f, 0.0f, 0.0f };
+		for (std::uint32_t i = 0u; i < 16u; ++i) {
+			auto const alpha = weights[(indices >> (2u * i)) & 0x3u];
+			auto const beta = 1.0f - alpha;
+			alpha2 += alpha * alpha;
+			beta2 += beta * beta;
+			alphabeta += alpha * beta;
+			alphax = { alphax.r + alpha * texels[i].r, alphax.g + alpha * texels[i].g, alphax.b + alpha * texels[i].b };
+			betax = { betax.r + beta * texels[i].r, betax.g + beta * texels[i].g, betax.b + beta * texels[i].b };
+		}
+
+		auto const determinant = alpha2 * beta2 - alphabeta * alphabeta;
+		if (std::abs(determinant) < 1e-6f)
+			return false;
+		auto const factor = 1.0f / determinant;
+		a = { (alphax.r * beta2 - betax.r * alphabeta) * factor,
+		      (alphax.g * beta2 - betax.g * alphabeta) * factor,
+		      (alphax.b * beta2 - betax.b * alphabeta) * factor };
+		b = { (betax.r * alpha2 - alphax.r * alphabeta) * factor,
+		      (betax.g * alpha2 - alphax.g * alphabeta) * factor,
+		      (betax.b * alpha2 - alphax.b * alphabeta) * factor };
+		return true;
+	}
+
+	//! \brief Store two endpoints and their indices, making sure the
+	//!        four-colour mode gets used (i.e. c0 > c1).
+	void write_colour_block(std::uint16_t c0, std::uint16_t c1, std::uint32_t indices, std::uint8_t* destination)
+	{
+		if (c0 < c1) {
+			std::swap(c0, c1);
+			// Swap indices 0 ↔ 1 and 2 ↔ 3, i.e. flip the lowest bit of each.
+			indices ^= 0x55555555u;
+		} else if (c0 == c1) {
+			indices = 0u;
+		}
+		std::memcpy(destination, &c0, sizeof(c0));
+		std::memcpy(destination + 2u, &c1, sizeof(c1));
+		std::memcpy(destination + 4u, &indices, sizeof(indices));
+	}
+
+	void encode_colour_block(std::uint8_t const (&rgba)[64], std::uint8_t* destination)
+	{
+		colour texels[16];
+		colour mean = { 0.0f, 0.0f, 0.0f };
+		for (std::uint32_t i = 0u; i < 16u; ++i) {
+			texels[i] = { static_cast<float>(rgba[4u * i + 0u]),
+			              static_cast<float>(rgba[4u * i + 1u]),
+			              static_cast<float>(rgba[4u * i + 2u]) };
+			mean = { mean.r + texels[i].r / 16.0f, mean.g + texels[i].g / 16.0f, mean.b + texels[i].b / 16.0f };
+		}
+
+		// Principal axis of the colours, by power iteration on their
+		// covariance matrix.
+		float covariance[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f }; // rr, rg, rb, gg, gb, bb
+		colour min = texels[0], max = texels[0];
+		for (auto const& texel : texels) {
+			auto const r = texel.r - mean.r, g = texel.g - mean.g, b = texel.b - mean.b;
+			covariance[0] += r * r;
+			covariance[1] += r * g;
+			covariance[2] += r * b;
+			covariance[3] += g * g;
+			covariance[4] += g * b;
+			covariance[5] += b * b;
+			min = { std::min(min.r, texel.r), std::min(min.g, texel.g), std::min(min.b, texel.b) };
+			max = { std::max(max.r, texel.r), std::max(max.g, texel.g), std::max(max.b, texel.b) };
+		}
+		colour axis = { max.r - min.r, max.g - min.g, max.b - min.b };
+		for (int iteration = 0; iteration < 4; ++iteration) {
+			colour const next = { covariance[0] * axis.r + covariance[1] * axis.g + covariance[2] * axis.b,
+			                      covariance[1] * axis.r + covariance[3] * axis.g + covariance[4] * axis.b,
+			                      covariance[2] * axis.r + covariance[4] * axis.g + covariance[5] * axis.b };
+			auto const length = std::max(std::abs(next.r), std::max(std::abs(next.g), std::abs(next.b)));
+			if (length < 1e-6f)
+				break;
+			axis = { next.r / length, next.g / length, next.b / length };
+		}
+
+		// The texels lying the furthest along the axis give the initial
+		// endpoints.
+		std::uint32_t lowest = 0u, highest = 0u;
+		float lowest_projection = std::numeric_limits<float>::max(), highest_projection = std::numeric_limits<float>::lowest();
+		for (std::uint32_t i = 0u; i < 16u; ++i) {
+			auto const projection = texels[i].r * axis.r + texels[i].g * axis.g + texels[i].b * axis.b;
+			if (projection < lowest_projection) {
+				lowest_projection = projection;
+				lowest = i;
+			}
+			if (projection > highest_projection) {
+				highest_projection = projection;
+				highest = i;
+			}
+		}
+
+		auto c0 = quantise_565(texels[highest]), c1 = quantise_565(texels[lowest]);
+		std::uint32_t indices = 0u;
+		auto error = select_colour_indices(texels, c0, c1, indices);
+
+		colour a, b;
+		if (c0 != c1 && refine_endpoints(texels, indices, a, b)) {
+			auto const refined_c0 = quantise_565(a), refined_c1 = quantise_565(b);
+			std::uint32_t refined_indices = 0u;
+			auto const refined_error = select_colour_indices(texels, refined_c0, refined_c1, refined_indices);
+			if (refined_error < error) {
+				c0 = refined_c0;
+				c1 = refined_c1;
+				indices = refined_indices;
+				error = refined_error;
+			}
+		}
+
+		write_colour_block(c0, c1, indices, destination);
+	}
+
+	//! \brief Encode one channel of a block, as done by BC4 and reused by
+	//!        BC3 for alpha and by BC5 for each of its channels.
+	void encode_channel_block(std::uint8_t const (&rgba)[64], std::uint32_t channel, std::uint8_t* destination)
+	{
+		std::uint8_t min = 255u, max = 0u;
+		for (std::uint32_t i = 0u; i < 16u; ++i) {
+			min = std::min(min, rgba[4u * i + channel]);
+			max = std::max(max, rgba[4u * i + channel]);
+		}
+
+		// With the first endpoint strictly greater than the second, the
+		// palette holds both endpoints plus six evenly spaced values in
+		// between; index k ∈ [2, 7] is ((8 - k) * max + (k - 1) * min) / 7.
+		std::uint64_t indices = 0u;
+		if (max > min) {
+			auto const range = static_cast<float>(max - min);
+			for (std::uint32_t i = 0u; i < 16u; ++i) {
+				auto const step = static_cast<std::uint32_t>((rgba[4u * i + channel] - min) * 7.0f / range + 0.5f);
+				std::uint64_t const index = step == 7u ? 0u : (step == 0u ? 1u : 8u - step);
+				indices |= index << (3u * i);
+			}
+		}
+
+		destination[0] = max;
+		destination[1] = min;
+		for (std::uint32_t k = 0u; k < 6u; ++k)
+			destination[2u + k] = static_cast<std::uint8_t>(indices >> (8u * k));
+	}
+
+	//! \brief Encode a single level; texels past the right or bottom
+	//!        edge of the image repeat the edge.
+	std::vector<std::uint8_t> encode_level(std::uint8_t const* rgba, std::uint32_t width, std::uint32_t height,
+	                                       bonobo::block_format format)
+	{
+		auto const block_size = bonobo::getBlockSize(format);
+		auto const blocks_x = (width + 3u) / 4u, blocks_y = (height + 3u) / 4u;
+		std::vector<std::uint8_t> level(static_cast<std::size_t>(blocks_x) * blocks_y * block_size);
+
+		std::uint8_t block[64];
+		for (std::uint32_t by = 0u; by < blocks_y; ++by) {
+			for (std::uint32_t bx = 0u; bx < blocks_x; ++bx) {
+				for (std::uint32_t y = 0u; y < 4u; ++y) {
+					auto const source_y = std::min(by * 4u + y, height - 1u);
+					for (std::uint32_t x = 0u; x < 4u; ++x) {
+						auto const source_x = std::min(bx * 4u + x, width - 1u);
+						std::memcpy(block + 4u * (4u * y + x), rgba + 4u * (static_cast<std::size_t>(source_y) * width + source_x), 4u);
+					}
+				}
+
+				auto destination = level.data() + (static_cast<std::size_t>(by) * blocks_x + bx) * block_size;
+				switch (format) {
+					case bonobo::block_format::bc1:
+						encode_colour_block(block, destination);
+						break;
+					case bonobo::block_format::bc3:
+						encode_channel_block(block, 3u, destination);
+						encode_colour_block(block, destination + 8u);
+						break;
+					case bonobo::block_format::bc5:
+						encode_channel_block(block, 0u, destination);
+						encode_channel_block(block, 1u, destination + 8u);
+						break;
+				}
+			}
+		}
+
+		return level;
+	}
+
+	//
+	// KTX2 writing
+	//
+
+	class ktx2_writer
+	{
+	public:
+		template<typename T>
+		void write(T const& value)
+		{
+			write_bytes(&value, sizeof(T));
+		}
+
+		void write_bytes(void const* data, std::size_t size)
+		{
+			auto const bytes = static_cast<std::uint8_t const*>(data);
+			_buffer.insert(_buffer.end(), bytes, bytes + size);
+		}
+
+		void align(std::size_t alignment)
+		{
+			_buffer.resize(align_up(_buffer.size(), alignment), 0u);
+		}
+
+		template<typename T>
+		void patch(std::size_t offset, T const& value)
+		{
+			std::memcpy(_buffer.data() + offset, &value, sizeof(T));
+		}
+
+		std::size_t size() const noexcept { return _buffer.size(); }
+		std::vector<std::uint8_t> const& buffer() const noexcept { return _buffer; }
+
+	private:
+		std::vector<std::uint8_t> _buffer;
+	};
+
+	void write_key_value(ktx2_writer& writer, char const* key, void const* value, std::size_t value_size)
+	{
+		auto const key_size = std::strlen(key) + 1u;
+		writer.write(static_cast<std::uint32_t>(key_size + value_size));
+		writer.write_bytes(key, key_size);
+		writer.write_bytes(value, value_size);
+		writer.align(4u);
+	}
+
+	//
+	// KTX2 reading
+	//
+
+	template<typename T>
+	bool read_at(utils::mapped_file const& file, std::size_t offset, T& value)
+	{
+		if (offset > file.size() || file.size() - offset < sizeof(T))
+			return false;
+		std::memcpy(&value, file.data() + offset, sizeof(T));
+		return true;
+	}
+
+	//! \brief Look for the "bonobo.source" entry of the key/value data.
+	bool find_source(utils::mapped_file const& file, std::size_t offset, std::size_t size, cache_source& source)
+	{
+		if (offset > file.size() || file.size() - offset < size)
+			return false;
+
+		auto const end = offset + size;
+		while (offset + sizeof(std::uint32_t) <= end) {
+			std::uint32_t entry_size = 0u;
+			read_at(file, offset, entry_size);
+			offset += sizeof(std::uint32_t);
+			if (entry_size > end - offset)
+				return false;
+
+			auto const entry = reinterpret_cast<char const*>(file.data() + offset);
+			auto const key_size = sizeof(source_key);
+			if (entry_size == key_size + sizeof(cache_source) && std::memcmp(entry, source_key, key_size) == 0) {
+				std::memcpy(&source, entry + key_size, sizeof(cache_source));
+				return true;
+			}
+			offset = align_up(offset + entry_size, 4u);
+		}
+		return false;
+	}
+}
+
+std::size_t
+bonobo::getBlockSize(block_format format)
+{
+	return format == block_format::bc1 ? 8u : 16u;
+}
+
+std::size_t
+bonobo::getCompressedLevelSize(block_format format, std::uint32_t width, std::uint32_t height)
+{
+	return static_cast<std::size_t>((width + 3u) / 4u) * ((height + 3u) / 4u) * getBlockSize(format);
+}
+
+char const*
+bonobo::getBlockFormatName(block_format format)
+{
+	switch (format) {
+		case block_format::bc1: return "bc1";
+		case block_format::bc3: return "bc3";
+		case block_format::bc5: return "bc5";
+	}
+	return "unknown";
+}
+
+bonobo::block_format
+bonobo::selectBlockFormat(std::uint8_t const* rgba, std::size_t texels_nb)
+{
+	for (std::size_t i = 0u; i < texels_nb; ++i)
+		if (rgba[4u * i + 3u] != 255u)
+			return block_format::bc3;
+	return block_format::bc1;
+}
+
+bonobo::compressed_texture
+bonobo::compressTexture(std::uint8_t const* rgba, std::uint32_t width, std::uint32_t height,
+                        block_format format, bool generate_mipmap, mipmap_options const& mipmap)
+{
+	compressed_texture texture;
+	if (rgba == nullptr || width == 0u || height == 0u)
+		return texture;
+
+	texture.format = format;
+	texture.width = width;
+	texture.height = height;
+	texture.levels.push_back(encode_level(rgba, width, height, format));
+	if (!generate_mipmap)
+		return texture;
+
+	for (auto const& level : buildMipChain(rgba, width, height, mipmap))
+		texture.levels.push_back(encode_level(level.data.data(), level.width, level.height, format));
+
+	return texture;
+}
+
+std::string
+bonobo::getCompressedTextureCachePath(std::string const& filename, block_format format, bool flip)
+{
+	return filename + (flip ? "." : ".noflip.") + getBlockFormatName(format) + ".ktx2";
+}
+
+bool
+bonobo::readCompressedTextureCache(std::string const& filename, block_format format, bool flip,
+                                   mipmap_options const& mipmap, compressed_texture& texture)
+{
+	auto const cache_path = getCompressedTextureCachePath(filename, format, flip);
+	texture = compressed_texture();
+
+	utils::mapped_file const file(cache_path);
+	if (!file.is_open())
+		return false;
+
+	std::uint32_t header[9];
+	std::uint32_t dfd_offset = 0u, dfd_size = 0u, kvd_offset = 0u, kvd_size = 0u;
+	if (file.size() < ktx2_header_size || std::memcmp(file.data(), ktx2_identifier, sizeof(ktx2_identifier)) != 0) {
+		LogWarning("\"%s\" is not a KTX2 file; ignoring it.", cache_path.c_str());
+		return false;
+	}
+	std::memcpy(header, file.data() + sizeof(ktx2_identifier), sizeof(header));
+	read_at(file, sizeof(ktx2_identifier) + sizeof(header), dfd_offset);
+	read_at(file, sizeof(ktx2_identifier) + sizeof(header) + 4u, dfd_size);
+	read_at(file, sizeof(ktx2_identifier) + sizeof(header) + 8u, kvd_offset);
+	read_at(file, sizeof(ktx2_identifier) + sizeof(header) + 12u, kvd_size);
+
+	auto const vk_format = header[0], type_size = header[1], width = header[2], height = header[3];
+	auto const depth = header[4], layers_nb = header[5], faces_nb = header[6], levels_nb = header[7];
+	auto const supercompression = header[8];
+	if (vk_format != get_vk_format(format) || type_size != 1u || width == 0u || height == 0u || depth != 0u
+	 || layers_nb != 0u || faces_nb != 1u || levels_nb == 0u || levels_nb > 32u || supercompression != 0u) {
+		LogInfo("Texture cache \"%s\" does not hold a %s 2D texture; ignoring it.",
+		        cache_path.c_str(), getBlockFormatName(format));
+		return false;
+	}
+
+	cache_source cached;
+	if (!find_source(file, kvd_offset, kvd_size, cached) || cached.encoder_version != encoder_version
+	 || cached.flip != (flip ? 1u : 0u) || cached.mipmap != encode_mipmap_options(mipmap)) {
+		LogInfo("Texture cache \"%s\" was created by a different encoder; ignoring it.", cache_path.c_str());
+		return false;
+	}
+
+	utils::file_status status;
+	if (!utils::get_file_status(filename, status) || status.size != cached.status.size) {
+		LogInfo("Texture cache \"%s\" is out-of-date as \"%s\" changed.", cache_path.c_str(), filename.c_str());
+		return false;
+	}
+	if (status.modification_time != cached.status.modification_time) {
+		std::uint64_t hash = 0u;
+		if (!hash_file(filename, hash) || hash != cached.hash) {
+			LogInfo("Texture cache \"%s\" is out-of-date as \"%s\" changed.", cache_path.c_str(), filename.c_str());
+			return false;
+		}
+	}
+
+	texture.format = format;
+	texture.width = width;
+	texture.height = height;
+	texture.levels.resize(levels_nb);
+	for (std::uint32_t i = 0u; i < levels_nb; ++i) {
+		std::uint64_t offset = 0u, size = 0u;
+		auto const index_offset = ktx2_header_size + i * 3u * sizeof(std::uint64_t);
+		auto const level_width = std::max(width >> i, 1u), level_height = std::max(height >> i, 1u);
+		if (!read_at(file, index_offset, offset) || !read_at(file, index_offset + sizeof(std::uint64_t), size)
+		 || size != getCompressedLevelSize(format, level_width, level_height)
+		 || offset > file.size() || file.size() - offset < size) {
+			LogWarning("Texture cache \"%s\" is corrupted; ignoring it.", cache_path.c_str());
+			texture = compressed_texture();
+			return false;
+		}
+		auto const data = file.data() + offset;
+		texture.levels[i].assign(data, data + size);
+	}
+
+	return true;
+}
+
+bool
+bonobo::writeCompressedTextureCache(std::string const& filename, bool flip, mipmap_options const& mipmap,
+                                    compressed_texture const& texture)
+{
+	if (texture.levels.empty())
+		return false;
+
+	auto const cache_path = getCompressedTextureCachePath(filename, texture.format, flip);
+
+	cache_source source;
+	source.encoder_version = encoder_version;
+	source.flip = flip ? 1u : 0u;
+	source.mipmap = encode_mipmap_options(mipmap);
+	if (!utils::get_file_status(filename, source.status) || !hash_file(filename, source.hash)) {
+		LogWarning("Failed to inspect \"%s\"; no texture cache will be written for it.", filename.c_str());
+		return false;
+	}
+
+	auto const levels_nb = static_cast<std::uint32_t>(texture.levels.size());
+
+	ktx2_writer writer;
+	writer.write_bytes(ktx2_identifier, sizeof(ktx2_identifier));
+	writer.write(get_vk_format(texture.format));
+	writer.write(std::uint32_t(1u)); // typeSize
+	writer.write(texture.width);
+	writer.write(texture.height);
+	writer.write(std::uint32_t(0u)); // pixelDepth
+	writer.write(std::uint32_t(0u)); // layerCount
+	writer.write(std::uint32_t(1u)); // faceCount
+	writer.write(levels_nb);
+	writer.write(std::uint32_t(0u)); // supercompressionScheme
+
+	// The index gets patched once the offsets are known.
+	auto const index_offset = writer.size();
+	writer.write(std::uint32_t(0u));
+	writer.write(std::uint32_t(0u));
+	writer.write(std::uint32_t(0u));
+	writer.write(std::uint32_t(0u));
+	writer.write(std::uint64_t(0u));
+	writer.write(std::uint64_t(0u));
+	auto const level_index_offset = writer.size();
+	for (std::uint32_t i = 0u; i < levels_nb; ++i) {
+		writer.write(std::uint64_t(0u));
+		writer.write(std::uint64_t(0u));
+		writer.write(std::uint64_t(0u));
+	}
+
+	auto const dfd_offset = writer.size();
+	for (auto const word : get_data_format_descriptor(texture.format))
+		writer.write(word);
+	auto const dfd_size = writer.size() - dfd_offset;
+
+	// Entries have to be sorted by key.
+	auto const kvd_offset = writer.size();
+	char const writer_name[] = "bonobo";
+	write_key_value(writer, "KTXwriter", writer_name, sizeof(writer_name));
+	write_key_value(writer, source_key, &source, sizeof(source));
+	auto const kvd_size = writer.size() - kvd_offset;
+
+	// Levels are stored from the least detailed one, each aligned on
+	// its block size.
+	for (auto i = levels_nb; i-- > 0u;) {
+		writer.align(getBlockSize(texture.format));
+		auto const level_offset = writer.size();
+		auto const& level = texture.levels[i];
+		writer.write_bytes(level.data(), level.size());
+		auto const entry_offset = level_index_offset + i * 3u * sizeof(std::uint64_t);
+		writer.patch(entry_offset, static_cast<std::uint64_t>(level_offset));
+		writer.patch(entry_offset + sizeof(std::uint64_t), static_cast<std::uint64_t>(level.size()));
+		writer.patch(entry_offset + 2u * sizeof(std::uint64_t), static_cast<std::uint64_t>(level.size()));
+	}
+
+	writer.patch(index_offset, static_cast<std::uint32_t>(dfd_offset));
+	writer.patch(index_offset + 4u, static_cast<std::uint32_t>(dfd_size));
+	writer.patch(index_offset + 8u, static_cast<std::uint32_t>(kvd_offset));
+	writer.patch(index_offset + 12u, static_cast<std::uint32_t>(kvd_size));
+
+	auto const temporary_path = cache_path + ".tmp";
+	{
+		std::ofstream stream(utils::widen(temporary_path), std::ios::binary | std::ios::trunc);
+		if (!stream.is_open()) {
+			LogWarning("Failed to create texture cache \"%s\".", temporary_path.c_str());
+			return false;
+		}
+		auto const& buffer = writer.buffer();
+		stream.write(reinterpret_cast<char const*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+		if (!stream.good()) {
+			LogWarning("Failed to write texture cache \"%s\".", temporary_path.c_str());
+			stream.close();
+			std::remove(temporary_path.c_str());
+			return false;
+		}
+	}
+
+	// rename() does not overwrite existing files on all platforms.
+	std::remove(cache_path.c_str());
+	if (std::rename(temporary_path.c_str(), cache_path.c_str()) != 0) {
+		LogWarning("Failed to move texture cache \"%s\" into place.", cache_path.c_str());
+		std::remove(temporary_path.c_str());
+		return false;
+	}
+
+	return true;
+}
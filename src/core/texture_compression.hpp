@@ -0,0 +1,98 @@
+#pragma once
+
+#include "mipmap.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bonobo
+{
+	//! \brief Block-compressed formats an image can be encoded to; all of
+	//!        them store 4×4 texel blocks.
+	enum class block_format : std::uint32_t {
+		bc1 = 0u, //!< opaque RGB at 4 bits per texel (also known as DXT1)
+		bc3,      //!< RGB plus an independently encoded alpha, at 8 bits per texel (also known as DXT5)
+		bc5       //!< two independently encoded channels, red and green, at 8 bits per texel; meant for normal maps whose third component is reconstructed in the shader
+	};
+
+	//! \brief Image encoded in a block-compressed format, along with its
+	//!        mip chain.
+	struct compressed_texture {
+		block_format format{block_format::bc1};
+		std::uint32_t width{0u};                       //!< width of the most detailed level, in texels
+		std::uint32_t height{0u};                      //!< height of the most detailed level, in texels
+		std::vector<std::vector<std::uint8_t>> levels; //!< blocks of each level, from the most detailed one
+	};
+
+	//! \brief Number of bytes used by one 4×4 block.
+	std::size_t getBlockSize(block_format format);
+
+	//! \brief Number of bytes used by a level of |width|×|height| texels.
+	std::size_t getCompressedLevelSize(block_format format, std::uint32_t width, std::uint32_t height);
+
+	//! \brief Name of a format, as used in log messages and file names.
+	char const* getBlockFormatName(block_format format);
+
+	//! \brief Pick BC1 for images which are fully opaque, and BC3 for
+	//!        the other ones.
+	//!
+	//! @param [in] rgba texels of the image, four bytes each
+	//! @param [in] texels_nb number of texels of the image
+	block_format selectBlockFormat(std::uint8_t const* rgba, std::size_t texels_nb);
+
+	//! \brief Encode an image, and optionally its mip chain, into a
+	//!        block-compressed format.
+	//!
+	//! Only the CPU is used, so this can be called from any thread. Lower
+	//! levels are built by `buildMipChain()`, down to a single texel,
+	//! before being encoded. Endpoints of each block are picked along
+	//! the principal axis of its colours, then refined by least squares.
+	//!
+	//! @param [in] rgba texels of the image, four bytes each, row after row
+	//! @param [in] width of the image, in texels
+	//! @param [in] height of the image, in texels
+	//! @param [in] format to encode the image to
+	//! @param [in] generate_mipmap whether to also encode the mip chain
+	//! @param [in] mipmap options used to filter the mip chain
+	//! @return the encoded levels, or nothing if the image is empty
+	compressed_texture compressTexture(std::uint8_t const* rgba, std::uint32_t width, std::uint32_t height,
+	                                   block_format format, bool generate_mipmap = true,
+	                                   mipmap_options const& mipmap = mipmap_options());
+
+	//! \brief Path of the cache file holding the compressed version of an
+	//!        image.
+	std::string getCompressedTextureCachePath(std::string const& filename, block_format format, bool flip);
+
+	//! \brief Read the compressed version of an image from its cache, if
+	//!        it exists and is still up-to-date.
+	//!
+	//! Caches are KTX2 files, which also record the size, modification
+	//! time and hash of the image they were created from, as well as the
+	//! options its mip chain was filtered with; they are only considered
+	//! out-of-date when the content of the image or those options changed.
+	//!
+	//! @param [in] filename of the image the cache was created from
+	//! @param [in] format the image is to be encoded to
+	//! @param [in] flip whether the image is to be flipped vertically
+	//! @param [in] mipmap options the mip chain is to be filtered with
+	//! @param [out] texture filled in with the cached levels on success
+	//! @return whether a valid cache could be read
+	bool readCompressedTextureCache(std::string const& filename, block_format format, bool flip,
+	                                mipmap_options const& mipmap, compressed_texture& texture);
+
+	//! \brief Write the compressed version of an image to its cache.
+	//!
+	//! As for mesh caches, the file is written under a temporary name
+	//! and then renamed, so that a partially written cache is never
+	//! picked up.
+	//!
+	//! @param [in] filename of the image |texture| was created from
+	//! @param [in] flip whether the image was flipped vertically
+	//! @param [in] mipmap options the mip chain was filtered with
+	//! @param [in] texture the encoded levels to cache
+	//! @return whether the cache could be written
+	bool writeCompressedTextureCache(std::string const& filename, bool flip, mipmap_options const& mipmap,
+	                                 compressed_texture const& texture);
+}
@@ -0,0 +1,167 @@
+#include "texture_upload_ring.hpp"
+
+#include "core/Log.h"
+
+#include <cassert>
+
+namespace
+{
+	//! \brief Alignment of each slot within the buffer, which is more
+	//!        than what any texel format needs.
+	std::size_t const slot_alignment = 256u;
+}
+
+bonobo::texture_upload_ring::slot::slot(slot&& other) noexcept
+	: _ring(other._ring), _index(other._index), _data(other._data), _size(other._size)
+{
+	other._ring = nullptr;
+	other._data = nullptr;
+	other._size = 0u;
+}
+
+bonobo::texture_upload_ring::slot&
+bonobo::texture_upload_ring::slot::operator=(slot&& other) noexcept
+{
+	if (this != &other) {
+		release();
+		_ring = other._ring;
+		_index = other._index;
+		_data = other._data;
+		_size = other._size;
+		other._ring = nullptr;
+		other._data = nullptr;
+		other._size = 0u;
+	}
+	return *this;
+}
+
+bonobo::texture_upload_ring::slot::~slot()
+{
+	release();
+}
+
+void
+bonobo::texture_upload_ring::slot::release()
+{
+	if (_ring != nullptr)
+		_ring->give_back(_index);
+	_ring = nullptr;
+	_data = nullptr;
+	_size = 0u;
+}
+
+bonobo::texture_upload_ring::texture_upload_ring(std::size_t slot_size, std::size_t slots_nb)
+	: _slot_size((slot_size + slot_alignment - 1u) / slot_alignment * slot_alignment),
+	  _fences(slots_nb, nullptr),
+	  _states(slots_nb, slot_state::free)
+{
+	if (_slot_size == 0u || slots_nb == 0u)
+		return;
+	if (!GLAD_GL_VERSION_4_4) {
+		LogInfo("OpenGL 4.4 is not available; textures will be uploaded straight from client memory.");
+		return;
+	}
+
+	auto const buffer_size = static_cast<GLsizeiptr>(_slot_size * slots_nb);
+	glGenBuffers(1, &_buffer);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _buffer);
+	// Writes made by the CPU are visible to commands issued after them
+	// without any flushing, thanks to GL_MAP_COHERENT_BIT; the fences take
+	// care of the other direction.
+	GLbitfield const flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glBufferStorage(GL_PIXEL_UNPACK_BUFFER, buffer_size, nullptr, flags);
+	_mapped_data = static_cast<std::uint8_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, buffer_size, flags));
+	if (_mapped_data == nullptr) {
+		LogWarning("Failed to persistently map the texture upload buffer; textures will be uploaded straight from client memory.");
+		glDeleteBuffers(1, &_buffer);
+		_buffer = 0u;
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0u);
+}
+
+bonobo::texture_upload_ring::~texture_upload_ring()
+{
+	for (auto const state : _states) {
+		assert(state != slot_state::staging);
+		(void) state;
+	}
+	for (auto& fence : _fences)
+		if (fence != nullptr)
+			glDeleteSync(fence);
+	if (_mapped_data != nullptr) {
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _buffer);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0u);
+	}
+	glDeleteBuffers(1, &_buffer);
+}
+
+bonobo::texture_upload_ring::slot
+bonobo::texture_upload_ring::acquire(std::size_t size)
+{
+	slot acquired;
+	if (!is_valid() || size == 0u || size > _slot_size)
+		return acquired;
+
+	std::size_t index = 0u;
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		while (index < _states.size() && _states[index] != slot_state::free)
+			++index;
+		if (index == _states.size())
+			return acquired;
+		_states[index] = slot_state::staging;
+	}
+
+	acquired._data = _mapped_data + index * _slot_size;
+	acquired._ring = this;
+	acquired._index = index;
+	acquired._size = size;
+	return acquired;
+}
+
+void
+bonobo::texture_upload_ring::reclaim()
+{
+	for (std::size_t i = 0u; i < _fences.size(); ++i) {
+		if (_fences[i] == nullptr)
+			continue;
+		auto const status = glClientWaitSync(_fences[i], 0, 0u);
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+			continue;
+		glDeleteSync(_fences[i]);
+		_fences[i] = nullptr;
+		give_back(i);
+	}
+}
+
+std::uint8_t const*
+bonobo::texture_upload_ring::bind(slot const& staged)
+{
+	assert(staged._ring == this);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, _buffer);
+	return reinterpret_cast<std::uint8_t const*>(staged._index * _slot_size);
+}
+
+void
+bonobo::texture_upload_ring::submit(slot&& staged)
+{
+	assert(staged._ring == this);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0u);
+
+	auto const index = staged._index;
+	staged._ring = nullptr;
+	staged._data = nullptr;
+	staged._size = 0u;
+
+	_fences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	std::lock_guard<std::mutex> lock(_mutex);
+	_states[index] = slot_state::in_flight;
+}
+
+void
+bonobo::texture_upload_ring::give_back(std::size_t index)
+{
+	std::lock_guard<std::mutex> lock(_mutex);
+	_states[index] = slot_state::free;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace bonobo
+{
+	//! \brief Ring of staging areas, backed by a pixel unpack buffer, for
+	//!        uploading texels to textures without the driver having to
+	//!        synchronously copy them from client memory.
+	//!
+	//! A slot is acquired and filled in on any thread, typically the one
+	//! that decoded the texels; the OpenGL thread then binds it, issues
+	//! the `glTexImage*()` or `glTexSubImage*()` calls reading from it,
+	//! and submits it. A fence is inserted after those calls, and the slot
+	//! only becomes available again once the GPU went past it.
+	//!
+	//! The buffer is allocated with `glBufferStorage()` and stays
+	//! persistently mapped, so slots are filled in directly. Without
+	//! OpenGL 4.4, staging would only add copies on top of uploading
+	//! straight from client memory, so the ring is left invalid and
+	//! callers are expected to do the latter.
+	class texture_upload_ring
+	{
+	public:
+		//! \brief Staging area acquired from the ring.
+		//!
+		//! If a slot is destroyed without having been submitted, it is
+		//! given back to the ring as is.
+		class slot
+		{
+		public:
+			slot() = default;
+			slot(slot&& other) noexcept;
+			slot& operator=(slot&& other) noexcept;
+			~slot();
+
+			slot(slot const&) = delete;
+			slot& operator=(slot const&) = delete;
+
+			//! \brief Whether the slot was successfully acquired.
+			bool is_valid() const { return _data != nullptr; }
+
+			//! \brief Memory to write the texels to; it can be written
+			//!        from any thread, until the slot gets bound.
+			std::uint8_t* data() const { return _data; }
+
+			//! \brief Number of bytes which were requested.
+			std::size_t size() const { return _size; }
+
+		private:
+			friend class texture_upload_ring;
+
+			void release();
+
+			texture_upload_ring* _ring{nullptr};
+			std::size_t _index{0u};
+			std::uint8_t* _data{nullptr};
+			std::size_t _size{0u};
+		};
+
+		//! \brief Create the buffer backing the ring; requires a current
+		//!        OpenGL context.
+		//!
+		//! @param [in] slot_size maximum number of bytes a slot can hold
+		//! @param [in] slots_nb number of slots, i.e. of uploads which can
+		//!             be staged or in flight at the same time
+		texture_upload_ring(std::size_t slot_size, std::size_t slots_nb);
+
+		//! \brief Release the buffer; all slots need to have been
+		//!        submitted or destroyed beforehand.
+		~texture_upload_ring();
+
+		texture_upload_ring(texture_upload_ring const&) = delete;
+		texture_upload_ring& operator=(texture_upload_ring const&) = delete;
+
+		//! \brief Whether the buffer could be created and mapped.
+		bool is_valid() const { return _mapped_data != nullptr; }
+
+		//! \brief Maximum number of bytes a slot can hold.
+		std::size_t get_slot_size() const { return _slot_size; }
+
+		//! \brief Take a free slot, without ever waiting for one; can be
+		//!        called from any thread.
+		//!
+		//! @param [in] size number of bytes to stage
+		//! @return the slot, or an invalid one if |size| is larger than
+		//!         what a slot can hold or if all slots are in use
+		slot acquire(std::size_t size);
+
+		//! \brief Make available the slots whose uploads the GPU went
+		//!        past; to be called on the OpenGL thread.
+		void reclaim();
+
+		//! \brief Bind the buffer to GL_PIXEL_UNPACK_BUFFER, so that it
+		//!        gets read by the following texture uploads; to be
+		//!        called on the OpenGL thread.
+		//!
+		//! @param [in] staged slot holding the texels to upload
+		//! @return the value to pass as the data pointer of upload
+		//!         calls for reading from the start of the slot
+		std::uint8_t const* bind(slot const& staged);
+
+		//! \brief Unbind the buffer, and fence the uploads reading from
+		//!        |staged|; to be called on the OpenGL thread, once all
+		//!        of them were issued.
+		void submit(slot&& staged);
+
+	private:
+		enum class slot_state : std::uint8_t {
+			free,
+			staging,  //!< acquired, being filled in on the CPU
+			in_flight //!< submitted, fenced
+		};
+
+		void give_back(std::size_t index);
+
+		GLuint _buffer{0u};
+		std::size_t _slot_size{0u};
+		std::uint8_t* _mapped_data{nullptr}; //!< null if the buffer could not be mapped
+		std::vector<GLsync> _fences;
+
+		std::mutex _mutex; //!< protects |_states|
+		std::vector<slot_state> _states;
+	};
+}
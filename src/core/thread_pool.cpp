@@ -0,0 +1,53 @@
+#include "thread_pool.hpp"
+
+#include <algorithm>
+
+utils::thread_pool::thread_pool(std::size_t threads_nb)
+{
+	if (threads_nb == 0u) {
+		auto const hardware_threads_nb = static_cast<std::size_t>(std::thread::hardware_concurrency());
+		threads_nb = std::max<std::size_t>(hardware_threads_nb, 2u) - 1u;
+	}
+
+	_workers.reserve(threads_nb);
+	for (std::size_t i = 0u; i < threads_nb; ++i)
+		_workers.emplace_back([this](){ run(); });
+}
+
+utils::thread_pool::~thread_pool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_is_stopping = true;
+	}
+	_condition.notify_all();
+
+	for (auto& worker : _workers)
+		worker.join();
+}
+
+void
+utils::thread_pool::run()
+{
+	for (;;) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_condition.wait(lock, [this](){ return _is_stopping || !_tasks.empty(); });
+			// Drain the queue before stopping, so that no future is left
+			// without a value.
+			if (_tasks.empty())
+				return;
+			task = std::move(_tasks.front());
+			_tasks.pop_front();
+		}
+		task();
+	}
+}
+
+utils::thread_pool&
+utils::get_shared_thread_pool()
+{
+	static thread_pool pool;
+	return pool;
+}
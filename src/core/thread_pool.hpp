@@ -0,0 +1,72 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace utils
+{
+
+//! \brief Fixed-size pool of worker threads running CPU-only tasks, in
+//!        the order they were submitted.
+//!
+//! Tasks must not call into OpenGL, as the context is only current on
+//! the main thread.
+class thread_pool
+{
+public:
+	//! \brief Start |threads_nb| workers; if 0, one less than the number
+	//!        of hardware threads is used (but at least one), leaving
+	//!        one for the main thread.
+	explicit thread_pool(std::size_t threads_nb = 0u);
+
+	//! \brief Wait for all submitted tasks to complete, and stop the
+	//!        workers.
+	~thread_pool();
+
+	thread_pool(thread_pool const&) = delete;
+	thread_pool& operator=(thread_pool const&) = delete;
+
+	//! \brief Queue |task| for execution on one of the workers.
+	//!
+	//! @return a future holding the value returned by |task|, or the
+	//!         exception it threw
+	template<typename F>
+	std::future<typename std::result_of<F()>::type> submit(F&& task)
+	{
+		using result_t = typename std::result_of<F()>::type;
+		auto packaged = std::make_shared<std::packaged_task<result_t()>>(std::forward<F>(task));
+		auto result = packaged->get_future();
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_tasks.emplace_back([packaged](){ (*packaged)(); });
+		}
+		_condition.notify_one();
+		return result;
+	}
+
+	//! \brief Number of worker threads.
+	std::size_t size() const noexcept { return _workers.size(); }
+
+private:
+	void run();
+
+	std::vector<std::thread> _workers;
+	std::deque<std::function<void()>> _tasks;
+	std::mutex _mutex;
+	std::condition_variable _condition;
+	bool _is_stopping{false};
+};
+
+//! \brief Retrieve a pool shared by the whole process, created on first
+//!        use.
+thread_pool& get_shared_thread_pool();
+
+} // end of namespace
@@ -0,0 +1,134 @@
+#include "uniform_ring.hpp"
+
+#include "core/Log.h"
+#include "core/opengl.hpp"
+
+#include <cstring>
+
+namespace
+{
+	GLuint64 const fence_timeout = 1000000000u; // in nanoseconds
+
+	std::size_t align(std::size_t value, std::size_t alignment)
+	{
+		return (value + alignment - 1u) / alignment * alignment;
+	}
+}
+
+bonobo::uniform_ring::uniform_ring(std::size_t region_size, std::size_t regions_nb)
+	: _fences(regions_nb, nullptr)
+{
+	GLint alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	if (alignment > 0)
+		_alignment = static_cast<std::size_t>(alignment);
+	_region_size = align(region_size, _alignment);
+	if (_region_size == 0u || regions_nb == 0u)
+		return;
+
+	auto const buffer_size = static_cast<GLsizeiptr>(_region_size * regions_nb);
+	glGenBuffers(1, &_buffer);
+	glBindBuffer(GL_UNIFORM_BUFFER, _buffer);
+	if (GLAD_GL_VERSION_4_4) {
+		// As for `texture_upload_ring`, coherent mapping makes the CPU
+		// writes visible to the draws issued after them, and the fences
+		// take care of the other direction.
+		GLbitfield const flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_UNIFORM_BUFFER, buffer_size, nullptr, flags);
+		_mapped_data = static_cast<std::uint8_t*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, buffer_size, flags));
+		if (_mapped_data == nullptr) {
+			LogWarning("Failed to persistently map the uniform ring; falling back to glBufferSubData().");
+			glDeleteBuffers(1, &_buffer);
+			glGenBuffers(1, &_buffer);
+			glBindBuffer(GL_UNIFORM_BUFFER, _buffer);
+		}
+	}
+	if (_mapped_data == nullptr)
+		glBufferData(GL_UNIFORM_BUFFER, buffer_size, nullptr, GL_STREAM_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0u);
+	utils::opengl::debug::nameObject(GL_BUFFER, _buffer, "Uniform ring");
+}
+
+bonobo::uniform_ring::~uniform_ring()
+{
+	for (auto& fence : _fences)
+		if (fence != nullptr)
+			glDeleteSync(fence);
+	if (_mapped_data != nullptr) {
+		glBindBuffer(GL_UNIFORM_BUFFER, _buffer);
+		glUnmapBuffer(GL_UNIFORM_BUFFER);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0u);
+	}
+	glDeleteBuffers(1, &_buffer);
+}
+
+void
+bonobo::uniform_ring::begin_frame()
+{
+	// Nothing was written during the previous frame, so the current
+	// region can keep being used.
+	if (!is_valid() || _offset == 0u)
+		return;
+
+	advance();
+}
+
+bool
+bonobo::uniform_ring::push(GLuint binding, void const* data, std::size_t size)
+{
+	auto const offset = write(data, size);
+	if (offset < 0)
+		return false;
+
+	glBindBufferRange(GL_UNIFORM_BUFFER, binding, _buffer, offset, static_cast<GLsizeiptr>(size));
+	return true;
+}
+
+GLintptr
+bonobo::uniform_ring::write(void const* data, std::size_t size)
+{
+	if (!is_valid() || size == 0u || size > _region_size)
+		return -1;
+
+	auto offset = align(_offset, _alignment);
+	if (offset + size > _region_size) {
+		advance();
+		offset = 0u;
+	}
+
+	auto const buffer_offset = _region * _region_size + offset;
+	if (_mapped_data != nullptr) {
+		std::memcpy(_mapped_data + buffer_offset, data, size);
+	} else {
+		// GL_COPY_WRITE_BUFFER is not used for drawing, so binding to it
+		// does not disturb anything.
+		glBindBuffer(GL_COPY_WRITE_BUFFER, _buffer);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(buffer_offset),
+		                static_cast<GLsizeiptr>(size), data);
+	}
+
+	_offset = offset + size;
+	return static_cast<GLintptr>(buffer_offset);
+}
+
+void
+bonobo::uniform_ring::advance()
+{
+	_fences[_region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	_region = (_region + 1u) % _fences.size();
+	_offset = 0u;
+
+	auto& fence = _fences[_region];
+	if (fence == nullptr)
+		return;
+
+	auto status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, fence_timeout);
+	while (status == GL_TIMEOUT_EXPIRED) {
+		LogWarning("Still waiting for the GPU to release a region of the uniform ring.");
+		status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, fence_timeout);
+	}
+	if (status == GL_WAIT_FAILED)
+		LogError("Failed to wait for a region of the uniform ring to be released.");
+	glDeleteSync(fence);
+	fence = nullptr;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bonobo
+{
+	//! \brief Uniform buffer split in regions, typically three, which
+	//!        per-draw uniforms are written to linearly and bound from by
+	//!        offset.
+	//!
+	//! Each frame writes to its own region; when a new frame starts, the
+	//! region of the previous one gets fenced, and the next region is
+	//! only written to once the GPU went past its fence, i.e. finished
+	//! the frame which used it three frames earlier. A region filling
+	//! up within a frame is handled the same way, as if a new frame had
+	//! started.
+	//!
+	//! When OpenGL 4.4 is available, the buffer is allocated with
+	//! `glBufferStorage()` and stays persistently mapped, so each push is
+	//! a copy to mapped memory followed by a `glBindBufferRange()`.
+	//! Otherwise the data is handed over with `glBufferSubData()`; the
+	//! fences still make sure the driver never has to wait for the GPU
+	//! before overwriting a region.
+	//!
+	//! Everything has to happen on the thread owning the OpenGL context.
+	class uniform_ring
+	{
+	public:
+		//! \brief Create the buffer backing the ring; requires a current
+		//!        OpenGL context.
+		//!
+		//! @param [in] region_size number of bytes each region can hold
+		//! @param [in] regions_nb number of regions, i.e. of frames which
+		//!             can be in flight at the same time
+		uniform_ring(std::size_t region_size, std::size_t regions_nb = 3u);
+
+		//! \brief Release the buffer.
+		~uniform_ring();
+
+		uniform_ring(uniform_ring const&) = delete;
+		uniform_ring& operator=(uniform_ring const&) = delete;
+
+		//! \brief Whether the buffer could be created.
+		bool is_valid() const { return _buffer != 0u; }
+
+		//! \brief Whether the buffer is persistently mapped.
+		bool is_persistent() const { return _mapped_data != nullptr; }
+
+		//! \brief Fence the region written to during the previous frame,
+		//!        if any, and move on to the next one.
+		void begin_frame();
+
+		//! \brief Copy |size| bytes from |data| to the ring, and bind them
+		//!        to the uniform buffer binding point |binding|.
+		//!
+		//! @param [in] binding index of the binding point, as given to
+		//!             `glUniformBlockBinding()`
+		//! @param [in] data what to copy, laid out as the block expects it
+		//! @param [in] size number of bytes to copy
+		//! @return whether the data could be pushed; it fails if the ring
+		//!         is not valid or if |size| is larger than a region
+		bool push(GLuint binding, void const* data, std::size_t size);
+
+		//! \brief Copy |size| bytes from |data| to the ring, without
+		//!        binding them anywhere; for per-draw data read in other
+		//!        ways, such as per-instance vertex attributes.
+		//!
+		//! @param [in] data what to copy
+		//! @param [in] size number of bytes to copy
+		//! @return the offset of the copy within the buffer, or -1 if it
+		//!         failed for the same reasons as `push()`
+		GLintptr write(void const* data, std::size_t size);
+
+		//! \brief Return the buffer backing the ring, which `write()`
+		//!        offsets are relative to.
+		GLuint get_buffer() const { return _buffer; }
+
+	private:
+		void advance();
+
+		GLuint _buffer{0u};
+		std::size_t _region_size{0u};
+		std::size_t _alignment{256u};
+		std::uint8_t* _mapped_data{nullptr}; //!< null when not persistently mapped
+		std::vector<GLsync> _fences;         //!< one per region, null when not in flight
+		std::size_t _region{0u};
+		std::size_t _offset{0u};             //!< within the current region
+	};
+}
@@ -2,12 +2,21 @@
 
 #include "core/Log.h"
 
-#include <fstream>
-#include <iostream>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
 #include <limits>
 #include <memory>
+#include <utility>
+#include <sys/stat.h>
+#include <sys/types.h>
 #if defined(_WIN32)
 #include <Windows.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #endif
 
 #if defined(_WIN32)
@@ -72,19 +81,243 @@ utils::widen(std::string const& utf8)
 std::string
 utils::slurp_file(std::string const& path)
 {
-  std::ifstream file = std::ifstream(utils::widen(path));
-  if (!file.is_open()) {
-    LogError("Failed to open \"%s\"", path.c_str());
-    return std::string("");
-  }
+	// Copy straight from the page cache into the string, rather than
+	// through an intermediate buffer.
+	mapped_file const file(path);
+	if (!file.is_open()) {
+		LogError("Failed to open \"%s\"", path.c_str());
+		return std::string("");
+	}
+
+	return std::string(reinterpret_cast<char const*>(file.data()), file.size());
+}
+
+std::string
+utils::get_canonical_path(std::string const& path)
+{
+#if defined(_WIN32)
+	std::unique_ptr<wchar_t, decltype(&std::free)> const full_path(::_wfullpath(nullptr, utils::widen(path).c_str(), 0), &std::free);
+	if (full_path == nullptr)
+		return path;
+
+	int const utf8_length = ::WideCharToMultiByte(CP_UTF8, 0, full_path.get(), -1, nullptr, 0, nullptr, nullptr);
+	if (utf8_length <= 1)
+		return path;
+	std::string utf8(static_cast<size_t>(utf8_length), '\0');
+	::WideCharToMultiByte(CP_UTF8, 0, full_path.get(), -1, &utf8[0], utf8_length, nullptr, nullptr);
+	utf8.resize(static_cast<size_t>(utf8_length - 1)); // drop the null terminator
+	return utf8;
+#else
+	char resolved_path[PATH_MAX];
+	if (::realpath(path.c_str(), resolved_path) == nullptr)
+		return path;
+	return std::string(resolved_path);
+#endif
+}
+
+std::vector<std::string>
+utils::list_files(std::string const& directory)
+{
+	std::vector<std::string> files;
+	std::vector<std::string> directories{ directory };
+	while (!directories.empty()) {
+		auto const current = directories.back();
+		directories.pop_back();
+		auto const prefix = current.empty() || current.back() == '/' ? current : current + "/";
+
+#if defined(_WIN32)
+		WIN32_FIND_DATAW entry;
+		auto const handle = ::FindFirstFileW(utils::widen(prefix + "*").c_str(), &entry);
+		if (handle == INVALID_HANDLE_VALUE)
+			continue;
+		do {
+			std::wstring const wide_name(entry.cFileName);
+			if (wide_name == L"." || wide_name == L"..")
+				continue;
+			int const utf8_length = ::WideCharToMultiByte(CP_UTF8, 0, entry.cFileName, -1, nullptr, 0, nullptr, nullptr);
+			if (utf8_length <= 1)
+				continue;
+			std::string name(static_cast<size_t>(utf8_length), '\0');
+			::WideCharToMultiByte(CP_UTF8, 0, entry.cFileName, -1, &name[0], utf8_length, nullptr, nullptr);
+			name.resize(static_cast<size_t>(utf8_length - 1)); // drop the null terminator
+			if (entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+				directories.push_back(prefix + name);
+			else
+				files.push_back(prefix + name);
+		} while (::FindNextFileW(handle, &entry));
+		::FindClose(handle);
+#else
+		auto const handle = ::opendir(current.c_str());
+		if (handle == nullptr)
+			continue;
+		while (auto const entry = ::readdir(handle)) {
+			std::string const name(entry->d_name);
+			if (name == "." || name == "..")
+				continue;
+			// Not all file systems fill in d_type.
+			struct stat info;
+			if (::stat((prefix + name).c_str(), &info) != 0)
+				continue;
+			if (S_ISDIR(info.st_mode))
+				directories.push_back(prefix + name);
+			else if (S_ISREG(info.st_mode))
+				files.push_back(prefix + name);
+		}
+		::closedir(handle);
+#endif
+	}
+
+	std::sort(files.begin(), files.end());
+	return files;
+}
+
+bool
+utils::get_file_status(std::string const& path, file_status& status)
+{
+#if defined(_WIN32)
+	struct _stat64 info;
+	if (::_wstat64(utils::widen(path).c_str(), &info) != 0)
+		return false;
+#else
+	struct stat info;
+	if (::stat(path.c_str(), &info) != 0)
+		return false;
+#endif
+
+	status.size = static_cast<std::uint64_t>(info.st_size);
+	// Use the sub-second part when available, as a file could otherwise be
+	// modified twice within the same second without it being noticed.
+	status.modification_time = static_cast<std::int64_t>(info.st_mtime) * 1000000000;
+#if defined(__APPLE__)
+	status.modification_time += static_cast<std::int64_t>(info.st_mtimespec.tv_nsec);
+#elif defined(__linux__)
+	status.modification_time += static_cast<std::int64_t>(info.st_mtim.tv_nsec);
+#endif
+	return true;
+}
+
+std::uint64_t
+utils::hash_bytes(void const* data, std::size_t size, std::uint64_t seed)
+{
+	auto const bytes = static_cast<std::uint8_t const*>(data);
+	std::uint64_t hash = seed;
+	for (std::size_t i = 0u; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= 0x100000001b3ull;
+	}
+	return hash;
+}
 
-  file.seekg(0, std::ios::end);
-  auto const size = file.tellg();
-  file.seekg(0, std::ios::beg);
+utils::mapped_file::mapped_file(std::string const& path)
+{
+#if defined(_WIN32)
+	HANDLE const file = ::CreateFileW(utils::widen(path).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+	                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+		return;
+
+	LARGE_INTEGER file_size;
+	if (!::GetFileSizeEx(file, &file_size)) {
+		LogError("Failed to retrieve the size of \"%s\"; GetFileSizeEx generated the error code %d.", path.c_str(), ::GetLastError());
+		::CloseHandle(file);
+		return;
+	}
+	_file_handle = file;
+	_is_open = true;
+	if (file_size.QuadPart == 0)
+		return;
 
-  std::unique_ptr<char[]> content = std::make_unique<char[]>(static_cast<size_t>(size) + 1ll);
-  file.read(content.get(), size);
-  content[static_cast<size_t>(size)] = '\0';
+	HANDLE const mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr) {
+		LogError("Failed to map \"%s\"; CreateFileMappingW generated the error code %d.", path.c_str(), ::GetLastError());
+		close();
+		return;
+	}
+	_mapping_handle = mapping;
+
+	void const* const view = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == nullptr) {
+		LogError("Failed to map \"%s\"; MapViewOfFile generated the error code %d.", path.c_str(), ::GetLastError());
+		close();
+		return;
+	}
+	_data = static_cast<std::uint8_t const*>(view);
+	_size = static_cast<std::size_t>(file_size.QuadPart);
+#else
+	int const file = ::open(path.c_str(), O_RDONLY);
+	if (file < 0)
+		return;
 
-  return std::string(content.get());
+	struct stat info;
+	if (::fstat(file, &info) != 0) {
+		LogError("Failed to retrieve the size of \"%s\".", path.c_str());
+		::close(file);
+		return;
+	}
+	_is_open = true;
+	if (info.st_size == 0) {
+		::close(file);
+		return;
+	}
+
+	void* const view = ::mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	// The mapping keeps its own reference to the file, so the descriptor
+	// is not needed anymore.
+	::close(file);
+	if (view == MAP_FAILED) {
+		LogError("Failed to map \"%s\".", path.c_str());
+		_is_open = false;
+		return;
+	}
+	_data = static_cast<std::uint8_t const*>(view);
+	_size = static_cast<std::size_t>(info.st_size);
+#endif
+}
+
+utils::mapped_file::~mapped_file()
+{
+	close();
+}
+
+utils::mapped_file::mapped_file(mapped_file&& other) noexcept
+{
+	*this = std::move(other);
+}
+
+utils::mapped_file&
+utils::mapped_file::operator=(mapped_file&& other) noexcept
+{
+	if (this == &other)
+		return *this;
+
+	close();
+	std::swap(_data, other._data);
+	std::swap(_size, other._size);
+	std::swap(_is_open, other._is_open);
+#if defined(_WIN32)
+	std::swap(_file_handle, other._file_handle);
+	std::swap(_mapping_handle, other._mapping_handle);
+#endif
+	return *this;
+}
+
+void
+utils::mapped_file::close() noexcept
+{
+#if defined(_WIN32)
+	if (_data != nullptr)
+		::UnmapViewOfFile(_data);
+	if (_mapping_handle != nullptr)
+		::CloseHandle(_mapping_handle);
+	if (_file_handle != nullptr)
+		::CloseHandle(_file_handle);
+	_mapping_handle = nullptr;
+	_file_handle = nullptr;
+#else
+	if (_data != nullptr)
+		::munmap(const_cast<std::uint8_t*>(_data), _size);
+#endif
+	_data = nullptr;
+	_size = 0u;
+	_is_open = false;
 }
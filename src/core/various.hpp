@@ -1,7 +1,10 @@
 #pragma once
 
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 
 namespace utils
@@ -15,6 +18,90 @@ inline char const* widen(char const* utf8) { return utf8; }
 inline std::string const& widen(std::string const& utf8) { return utf8; }
 #endif
 
+//! \brief Read the whole content of a file, through a mapping of it.
+//!
+//! @param [in] path of the file to read
+//! @return the content of the file, or an empty string if it could not
+//!         be opened
 std::string slurp_file(std::string const& path);
 
+//! \brief Turn |path| into an absolute path, with all symbolic links,
+//!        "." and ".." components resolved.
+//!
+//! @param [in] path of an existing file or directory
+//! @return the canonical form of |path|, or |path| itself if it could
+//!         not be resolved (e.g. because it does not exist)
+std::string get_canonical_path(std::string const& path);
+
+//! \brief List the regular files found in a directory and, recursively,
+//!        in its sub-directories.
+//!
+//! @param [in] directory to list
+//! @return the paths of the files, each one starting with |directory|,
+//!         sorted; empty if |directory| could not be opened
+std::vector<std::string> list_files(std::string const& directory);
+
+//! \brief Size and last modification time of a file, as reported by the
+//!        file system.
+struct file_status {
+	std::uint64_t size{0u};             //!< size of the file in bytes
+	std::int64_t modification_time{0};  //!< last modification time, in nanoseconds since the epoch
+};
+
+//! \brief Retrieve the size and last modification time of a file.
+//!
+//! @param [in] path of the file to query
+//! @param [out] status filled in with the file information on success
+//! @return whether the file exists and could be queried
+bool get_file_status(std::string const& path, file_status& status);
+
+//! \brief Compute a 64-bit FNV-1a hash of a block of memory.
+//!
+//! @param [in] data pointer to the first byte to hash
+//! @param [in] size number of bytes to hash
+//! @param [in] seed value to start from; pass the result of a previous
+//!             call to hash several blocks as if they were contiguous
+//! @return the hash of the block
+std::uint64_t hash_bytes(void const* data, std::size_t size,
+                         std::uint64_t seed = 0xcbf29ce484222325ull);
+
+//! \brief Read-only mapping of a whole file into memory.
+//!
+//! The content of the file is paged in by the operating system on
+//! demand, so nothing is read until it is accessed, and nothing is copied
+//! into a user-space buffer.
+class mapped_file
+{
+public:
+	mapped_file() = default;
+
+	//! \brief Map the file found at |path|; use |is_open()| to check
+	//!        whether the operation succeeded.
+	explicit mapped_file(std::string const& path);
+	~mapped_file();
+
+	mapped_file(mapped_file const&) = delete;
+	mapped_file& operator=(mapped_file const&) = delete;
+	mapped_file(mapped_file&& other) noexcept;
+	mapped_file& operator=(mapped_file&& other) noexcept;
+
+	//! \brief Whether a file is currently mapped; an empty file counts
+	//!        as mapped, with a null |data()| and a |size()| of 0.
+	bool is_open() const noexcept { return _is_open; }
+	std::uint8_t const* data() const noexcept { return _data; }
+	std::size_t size() const noexcept { return _size; }
+
+	//! \brief Unmap the file, if any.
+	void close() noexcept;
+
+private:
+	std::uint8_t const* _data{nullptr};
+	std::size_t _size{0u};
+	bool _is_open{false};
+#if defined(_WIN32)
+	void* _file_handle{nullptr};
+	void* _mapping_handle{nullptr};
+#endif
+};
+
 } // end of namespace
@@ -0,0 +1,162 @@
+// Fill in the mesh and texture caches of all scenes found under a
+// directory, by default `res/`, so that loading them later on only has to
+// map those caches. No window nor OpenGL context is created.
+//
+// Usage: bonobo_bake [directory]
+
+#include "config.hpp"
+#include "core/helpers.hpp"
+#include "core/Log.h"
+#include "core/thread_pool.hpp"
+#include "core/various.hpp"
+
+#include <assimp/Importer.hpp>
+
+#include <chrono>
+#include <clocale>
+#include <cstdlib>
+#include <future>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+	using clock_type = std::chrono::high_resolution_clock;
+
+	float seconds_since(clock_type::time_point start_time)
+	{
+		return std::chrono::duration<float>(clock_type::now() - start_time).count();
+	}
+
+	//! \brief Throughput of a stage, given the amount of work it did and
+	//!        the time it took in milliseconds.
+	double per_second(double amount, double duration)
+	{
+		return duration > 0.0 ? amount * 1000.0 / duration : 0.0;
+	}
+
+	std::vector<std::string> find_scenes(std::string const& directory)
+	{
+		Assimp::Importer const importer;
+		std::vector<std::string> scenes;
+		for (auto const& path : utils::list_files(directory)) {
+			auto const extension_start = path.rfind('.');
+			if (extension_start == std::string::npos || path.find('/', extension_start) != std::string::npos)
+				continue;
+			if (importer.IsExtensionSupported(path.substr(extension_start)))
+				scenes.push_back(path);
+		}
+		return scenes;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::setlocale(LC_ALL, "");
+	Log::Init();
+
+	std::string const directory = argc > 1 ? argv[1] : config::resources_path("");
+	auto const scenes = find_scenes(directory);
+	if (scenes.empty()) {
+		LogError("No scene found in \"%s\".", directory.c_str());
+		Log::Destroy();
+		return EXIT_FAILURE;
+	}
+
+	auto& thread_pool = utils::get_shared_thread_pool();
+	LogInfo("Baking %zu scenes found in \"%s\" on %zu worker threads…", scenes.size(), directory.c_str(), thread_pool.size());
+	// Textures are compressed as the assignments loading these scenes
+	// ask for, e.g. EDAN35 for Sponza.
+	bonobo::mesh_load_options options;
+	options.textures_compression = bonobo::texture_compression::automatic;
+	bool has_failed = false;
+
+	// Meshes of all scenes, one scene per task.
+	auto const scenes_start_time = clock_type::now();
+	std::vector<std::future<bonobo::scene_bake_report>> scene_tasks;
+	for (auto const& scene : scenes)
+		scene_tasks.push_back(thread_pool.submit([scene, &options]() {
+			bonobo::scene_bake_report report;
+			if (!bonobo::bakeSceneMeshes(scene, options, report))
+				report.meshes_nb = 0u;
+			return report;
+		}));
+
+	std::vector<bonobo::texture_bake_job> textures;
+	std::unordered_set<std::string> texture_keys;
+	std::size_t imported_nb = 0u, imported_triangles_nb = 0u;
+	float reading_duration = 0.0f, triangle_order_duration = 0.0f, lods_duration = 0.0f;
+	for (std::size_t i = 0u; i < scenes.size(); ++i) {
+		auto const report = scene_tasks[i].get();
+		if (report.meshes_nb == 0u) {
+			LogWarning("╺ Failed to bake \"%s\".", scenes[i].c_str());
+			has_failed = true;
+			continue;
+		}
+		LogTrivia("╺ \"%s\": %zu meshes, %zu triangles, %s in %.3f s", scenes[i].c_str(), report.meshes_nb,
+		          report.triangles_nb, report.was_cached ? "already cached" : "imported", report.reading_duration);
+		if (!report.was_cached) {
+			++imported_nb;
+			imported_triangles_nb += report.triangles_nb;
+			reading_duration += report.reading_duration;
+			triangle_order_duration += report.triangle_order_duration;
+			lods_duration += report.lods_duration;
+		}
+		// Scenes sharing textures only get them baked once.
+		for (auto const& texture : report.textures)
+			if (texture_keys.insert(utils::get_canonical_path(texture.path) + "|" + texture.type_name).second)
+				textures.push_back(texture);
+	}
+	auto const scenes_duration = seconds_since(scenes_start_time);
+
+	// Textures of all scenes, one texture per task.
+	auto const textures_start_time = clock_type::now();
+	std::vector<std::future<bonobo::texture_bake_report>> texture_tasks;
+	for (auto const& texture : textures)
+		texture_tasks.push_back(thread_pool.submit([texture]() {
+			return bonobo::bakeTexture(texture);
+		}));
+
+	std::size_t compressed_nb = 0u, compressed_texels_nb = 0u, compressed_size = 0u;
+	float decoding_duration = 0.0f, compression_duration = 0.0f;
+	for (std::size_t i = 0u; i < textures.size(); ++i) {
+		auto const report = texture_tasks[i].get();
+		if (report.has_failed) {
+			LogWarning("╺ Failed to bake \"%s\".", textures[i].path.c_str());
+			has_failed = true;
+			continue;
+		}
+		if (report.was_cached)
+			continue;
+		++compressed_nb;
+		compressed_texels_nb += report.texels_nb;
+		compressed_size += report.compressed_size;
+		decoding_duration += report.decoding_duration;
+		compression_duration += report.compression_duration;
+	}
+	auto const textures_duration = seconds_since(textures_start_time);
+
+	// Durations of the stages are summed over all tasks, so throughputs
+	// are per worker thread; wall-clock times are for the whole pool.
+	LogInfo("┭ Baking done");
+	LogInfo("│ Scenes: %zu imported, %zu already cached, in %.3f s", imported_nb, scenes.size() - imported_nb,
+	        scenes_duration);
+	LogInfo("│ ├ Import and processing: %.3f s, %.0f triangles/s", reading_duration,
+	        per_second(static_cast<double>(imported_triangles_nb), 1000.0 * reading_duration));
+	LogInfo("│ ├ Triangle reordering: %.3f ms, %.0f triangles/s", triangle_order_duration,
+	        per_second(static_cast<double>(imported_triangles_nb), triangle_order_duration));
+	LogInfo("│ └ Levels of detail: %.3f ms, %.0f triangles/s", lods_duration,
+	        per_second(static_cast<double>(imported_triangles_nb), lods_duration));
+	LogInfo("│ Textures: %zu compressed, %zu already cached, in %.3f s", compressed_nb, textures.size() - compressed_nb,
+	        textures_duration);
+	LogInfo("│ ├ Decoding: %.3f ms, %.2f Mtexels/s", decoding_duration,
+	        per_second(static_cast<double>(compressed_texels_nb) / 1e6, decoding_duration));
+	LogInfo("│ └ Mip chains and compression: %.3f ms, %.2f Mtexels/s, %.1f MiB written", compression_duration,
+	        per_second(static_cast<double>(compressed_texels_nb) / 1e6, compression_duration),
+	        static_cast<double>(compressed_size) / (1024.0 * 1024.0));
+	LogInfo("┕ Total: %.3f s", scenes_duration + textures_duration);
+
+	Log::Destroy();
+	return has_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}